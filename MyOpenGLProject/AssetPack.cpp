@@ -0,0 +1,249 @@
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char kPackMagic[4] = { 'A', 'P', 'A', 'K' };
+static const unsigned int kPackVersion = 1;
+
+AssetPack::AssetPack()
+	: base_(NULL), size_(0), file_handle_(NULL), mapping_handle_(NULL)
+{
+}
+
+AssetPack::~AssetPack()
+{
+	Close();
+}
+
+bool AssetPack::Open(const char* path)
+{
+	Close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER file_size;
+	GetFileSizeEx(file, &file_size);
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (!view)
+	{
+		if (mapping)
+			CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+	file_handle_ = file;
+	mapping_handle_ = mapping;
+	size_ = (size_t)file_size.QuadPart;
+#else
+	int file = open(path, O_RDONLY);
+	if (file < 0)
+		return false;
+	struct stat info;
+	void* view = MAP_FAILED;
+	if (fstat(file, &info) == 0 && info.st_size > 0)
+		view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	// the mapping keeps the file alive on its own
+	close(file);
+	if (view == MAP_FAILED)
+		return false;
+	size_ = (size_t)info.st_size;
+#endif
+	base_ = (const unsigned char*)view;
+
+	// validate everything up front so lookups can trust the table of contents
+	const Header* header = (const Header*)base_;
+	bool valid = size_ >= sizeof(Header) && std::memcmp(header->magic, kPackMagic, 4) == 0
+		&& header->version == kPackVersion
+		&& sizeof(Header) + (size_t)header->entry_count * sizeof(Entry) + header->names_size <= size_;
+	for (unsigned int i = 0; valid && i < header->entry_count; i++)
+	{
+		const Entry& entry = Entries()[i];
+		valid = (size_t)entry.name_offset + entry.name_length < header->names_size
+			&& Names()[entry.name_offset + entry.name_length] == '\0'
+			&& entry.data_offset <= size_ && entry.data_size <= size_ - entry.data_offset;
+	}
+	if (!valid)
+	{
+		std::cout << "ERROR::ASSET_PACK::INVALID_FILE " << path << std::endl;
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void AssetPack::Close()
+{
+	if (!base_)
+		return;
+#ifdef _WIN32
+	UnmapViewOfFile(base_);
+	CloseHandle((HANDLE)mapping_handle_);
+	CloseHandle((HANDLE)file_handle_);
+#else
+	munmap((void*)base_, size_);
+#endif
+	base_ = NULL;
+	size_ = 0;
+	file_handle_ = NULL;
+	mapping_handle_ = NULL;
+}
+
+const AssetPack::Entry* AssetPack::Entries() const
+{
+	return (const Entry*)(base_ + sizeof(Header));
+}
+
+const char* AssetPack::Names() const
+{
+	return (const char*)(Entries() + AssetCount());
+}
+
+size_t AssetPack::AssetCount() const
+{
+	return base_ ? ((const Header*)base_)->entry_count : 0;
+}
+
+AssetSpan AssetPack::Find(const char* name) const
+{
+	AssetSpan span = { NULL, 0 };
+	if (!base_)
+		return span;
+
+	// the table of contents is sorted by name
+	const Entry* entries = Entries();
+	const char* names = Names();
+	size_t lo = 0, hi = AssetCount();
+	while (lo < hi)
+	{
+		size_t mid = (lo + hi) / 2;
+		const Entry& entry = entries[mid];
+		int order = std::strcmp(names + entry.name_offset, name);
+		if (order == 0)
+		{
+			span.data = base_ + entry.data_offset;
+			span.size = (size_t)entry.data_size;
+			return span;
+		}
+		if (order < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return span;
+}
+
+bool AssetPack::Build(const char* pack_path, const std::string& directory, const std::vector<std::string>& files)
+{
+	std::string prefix = directory.empty() || directory == "." ? "" : directory + "/";
+	std::vector<std::string> names(files);
+	std::sort(names.begin(), names.end());
+	names.erase(std::unique(names.begin(), names.end()), names.end());
+
+	// names are stored zero terminated so they can be used as C strings
+	Header header;
+	std::memcpy(header.magic, kPackMagic, 4);
+	header.version = kPackVersion;
+	header.entry_count = (unsigned int)names.size();
+	header.names_size = 0;
+	std::vector<Entry> entries(names.size());
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		entries[i].name_offset = header.names_size;
+		entries[i].name_length = (unsigned int)names[i].size();
+		header.names_size += entries[i].name_length + 1;
+	}
+
+	std::ofstream pack(pack_path, std::ios::binary | std::ios::trunc);
+	if (!pack)
+		return false;
+	// the table of contents is written again once the blob offsets are known
+	pack.write((const char*)&header, sizeof(header));
+	pack.write((const char*)entries.data(), entries.size() * sizeof(Entry));
+	for (size_t i = 0; i < names.size(); i++)
+		pack.write(names[i].c_str(), names[i].size() + 1);
+
+	unsigned long long offset = sizeof(header) + entries.size() * sizeof(Entry) + header.names_size;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		std::ifstream file((prefix + names[i]).c_str(), std::ios::binary);
+		if (!file)
+		{
+			std::cout << "ERROR::ASSET_PACK::FILE_NOT_SUCCESSFULLY_READ " << prefix + names[i] << std::endl;
+			return false;
+		}
+		static const char kPadding[kAlignment] = { 0 };
+		unsigned long long aligned = (offset + kAlignment - 1) / kAlignment * kAlignment;
+		pack.write(kPadding, (std::streamsize)(aligned - offset));
+		std::vector<char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		pack.write(contents.data(), contents.size());
+		entries[i].data_offset = aligned;
+		entries[i].data_size = contents.size();
+		offset = aligned + contents.size();
+	}
+
+	pack.seekp(sizeof(header));
+	pack.write((const char*)entries.data(), entries.size() * sizeof(Entry));
+	return pack.good();
+}
+
+std::vector<std::string> AssetPack::ListAssets(const std::string& directory)
+{
+	static const char* kExtensions[] = { ".vert", ".frag", ".jpg", ".jpeg", ".png", ".ktx2", ".mesh" };
+
+	std::vector<std::string> files;
+	std::string prefix = directory.empty() || directory == "." ? "" : directory + "/";
+#ifdef _WIN32
+	WIN32_FIND_DATAA found;
+	HANDLE search = FindFirstFileA((prefix + "*").c_str(), &found);
+	if (search == INVALID_HANDLE_VALUE)
+		return files;
+	do
+	{
+		if (!(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+			files.push_back(found.cFileName);
+	} while (FindNextFileA(search, &found));
+	FindClose(search);
+#else
+	DIR* dir = opendir(directory.empty() ? "." : directory.c_str());
+	if (!dir)
+		return files;
+	while (dirent* found = readdir(dir))
+	{
+		struct stat info;
+		if (stat((prefix + found->d_name).c_str(), &info) == 0 && S_ISREG(info.st_mode))
+			files.push_back(found->d_name);
+	}
+	closedir(dir);
+#endif
+
+	std::vector<std::string> assets;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		for (size_t e = 0; e < sizeof(kExtensions) / sizeof(kExtensions[0]); e++)
+		{
+			size_t length = std::strlen(kExtensions[e]);
+			if (files[i].size() > length && files[i].compare(files[i].size() - length, length, kExtensions[e]) == 0)
+			{
+				assets.push_back(files[i]);
+				break;
+			}
+		}
+	}
+	return assets;
+}
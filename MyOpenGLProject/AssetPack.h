@@ -0,0 +1,69 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <string>
+#include <vector>
+
+// read-only view into the mapped pack file, valid as long as the AssetPack is open
+struct AssetSpan
+{
+	const unsigned char* data;
+	size_t size;
+
+	bool IsEmpty() const { return data == NULL; }
+	const char* AsChars() const { return (const char*)data; }
+};
+
+// Single archive holding all assets (shaders, textures, meshes) of the project.
+// Layout: header, table of contents sorted by name, name strings, then every blob aligned
+// to kAlignment. The file is memory mapped once and lookups hand out spans into the mapping.
+class AssetPack
+{
+public:
+	static const unsigned int kAlignment = 64;
+
+	AssetPack();
+	~AssetPack();
+	AssetPack(const AssetPack&) = delete;
+	AssetPack& operator=(const AssetPack&) = delete;
+
+	bool Open(const char* path);
+	void Close();
+	bool IsOpen() const { return base_ != NULL; }
+	// empty span if the pack has no asset with that name
+	AssetSpan Find(const char* name) const;
+	size_t AssetCount() const;
+
+	// write a pack of the given files of a directory, each stored under its file name
+	static bool Build(const char* pack_path, const std::string& directory, const std::vector<std::string>& files);
+	// names of the files in a directory (not recursive) with one of the asset extensions
+	static std::vector<std::string> ListAssets(const std::string& directory);
+
+private:
+	struct Header
+	{
+		char magic[4];
+		unsigned int version;
+		unsigned int entry_count;
+		unsigned int names_size;
+	};
+
+	struct Entry
+	{
+		unsigned int name_offset;
+		unsigned int name_length;
+		unsigned long long data_offset;
+		unsigned long long data_size;
+	};
+
+	const Entry* Entries() const;
+	const char* Names() const;
+
+	const unsigned char* base_;
+	size_t size_;
+	// platform handles of the mapping
+	void* file_handle_;
+	void* mapping_handle_;
+};
+
+#endif // !ASSET_PACK_H
@@ -0,0 +1,80 @@
+#include "Tools.h"
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "TextureCache.h"
+#include "VertexFormat.h"
+
+int CookTextures(const std::vector<const char*>& image_paths)
+{
+	int failures = 0;
+	for (size_t i = 0; i < image_paths.size(); i++)
+	{
+		bool cooked = TextureCache::CookFile(image_paths[i], true);
+		std::cout << (cooked ? "Cooked " : "Failed to cook ") << image_paths[i] << std::endl;
+		failures += cooked ? 0 : 1;
+	}
+	return failures == 0 ? 0 : -1;
+}
+
+int PackAssets(const char* pack_path, const char* directory)
+{
+	std::vector<std::string> assets = AssetPack::ListAssets(directory);
+	bool packed = AssetPack::Build(pack_path, directory, assets);
+	std::cout << (packed ? "Packed " : "Failed to pack ") << assets.size() << " assets into " << pack_path << std::endl;
+	return packed ? 0 : -1;
+}
+
+int WriteGridMesh(const char* path, int grid_size)
+{
+	// a grid over the whole viewport, colored by a wave so the triangles can be told apart
+	std::vector<float> grid_vertices;
+	std::vector<unsigned int> grid_indices;
+	for (int y = 0; y <= grid_size; y++)
+	{
+		for (int x = 0; x <= grid_size; x++)
+		{
+			float u = (float)x / grid_size;
+			float v = (float)y / grid_size;
+			float wave = 0.5f + 0.5f * std::sin(u * 12.0f) * std::cos(v * 12.0f);
+			float vertex[8] = { u * 2.0f - 1.0f, v * 2.0f - 1.0f, 0.0f,   wave, 1.0f - wave, 0.5f,   u, v };
+			grid_vertices.insert(grid_vertices.end(), vertex, vertex + 8);
+		}
+	}
+	for (int y = 0; y < grid_size; y++)
+	{
+		for (int x = 0; x < grid_size; x++)
+		{
+			unsigned int corner = y * (grid_size + 1) + x;
+			unsigned int quad[6] = { corner, corner + 1, corner + grid_size + 1, corner + 1, corner + grid_size + 2, corner + grid_size + 1 };
+			grid_indices.insert(grid_indices.end(), quad, quad + 6);
+		}
+	}
+	// the file stores the mesh ready to draw, so it is optimized once here rather than at load time
+	size_t vertex_count = grid_vertices.size() / 8;
+	MeshOptimizer::OptimizeVertexCache(grid_indices.data(), grid_indices.size(), vertex_count);
+	vertex_count = MeshOptimizer::OptimizeVertexFetch(grid_indices.data(), grid_indices.size(), grid_vertices.data(), vertex_count, 8 * sizeof(float));
+
+	// the same 16-byte layout main() uses for the container
+	VertexFormat format;
+	format.Add(0, 3, kVertexHalf).Add(1, 3, kVertexUnorm8).Add(2, 2, kVertexUnorm16);
+	MeshInfo info;
+	if (!MeshFile::Write(path, format, grid_vertices.data(), vertex_count, grid_indices.data(), grid_indices.size())
+		|| !MeshFile::ReadInfo(path, info))
+	{
+		std::cout << "Failed to write mesh " << path << std::endl;
+		return -1;
+	}
+	size_t compressed_size = 0;
+	for (size_t c = 0; c < info.chunks.size(); c++)
+		compressed_size += info.chunks[c].compressed_size;
+	std::cout << "Wrote " << path << ": " << info.vertex_count << " vertices, " << info.index_count / 3 << " triangles, "
+		<< info.chunks.size() << " chunks, " << info.VertexBytes() + info.IndexBytes() << " bytes compressed to "
+		<< compressed_size << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "Tools.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "Camera.h"
+#include "FrustumCuller.h"
+#include "Options.h"
+#include "ThreadPool.h"
+
+int BenchmarkFrustumCuller(int object_count)
+{
+	// objects scattered through a cube around a camera that sees a few percent of them
+	const int kRepetitions = 20;
+	const float kWorldSize = 1000.0f;
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> coordinate(-kWorldSize * 0.5f, kWorldSize * 0.5f);
+	std::uniform_real_distribution<float> size(0.5f, 5.0f);
+	FrustumCuller spheres, boxes;
+	spheres.Reserve(object_count);
+	boxes.Reserve(object_count);
+	for (int i = 0; i < object_count; i++)
+	{
+		float center[3] = { coordinate(random), coordinate(random), coordinate(random) };
+		float extent[3] = { size(random), size(random), size(random) };
+		float min[3] = { center[0] - extent[0], center[1] - extent[1], center[2] - extent[2] };
+		float max[3] = { center[0] + extent[0], center[1] + extent[1], center[2] + extent[2] };
+		spheres.AddSphere(center, extent[0]);
+		boxes.AddBox(min, max);
+	}
+	Camera camera(60.0f, (float)kWindowWidth / kWindowHeight, 0.1f, kWorldSize * 0.5f);
+	const float kEye[3] = { 10.0f, 20.0f, 30.0f };
+	const float kTarget[3] = { 100.0f, 0.0f, -200.0f };
+	const float kUp[3] = { 0.0f, 1.0f, 0.0f };
+	camera.LookAt(kEye, kTarget, kUp);
+	float planes[6][4];
+	camera.FrustumPlanes(planes);
+
+	ThreadPool pool;
+	std::cout << "Frustum culling, " << object_count << " objects, " << FrustumCuller::SimdName()
+		<< " kernels, " << pool.ThreadCount() << " threads" << std::endl;
+	std::vector<unsigned char> reference(object_count), visible(object_count);
+	int failures = 0;
+	for (int volume = kCullSphere; volume <= kCullBox; volume++)
+	{
+		const FrustumCuller& culler = volume == kCullSphere ? spheres : boxes;
+		const char* kPassNames[3] = { "scalar   ", "simd     ", "simd (mt)" };
+		size_t reference_count = 0;
+		for (int pass = 0; pass < 3; pass++)
+		{
+			size_t visible_count = 0;
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (int r = 0; r < kRepetitions; r++)
+			{
+				if (pass == 0)
+					visible_count = culler.CullReference(planes, (CullVolume)volume, reference.data());
+				else
+					visible_count = culler.Cull(planes, (CullVolume)volume, visible.data(), pass == 2 ? &pool : NULL);
+			}
+			double elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / kRepetitions;
+
+			// the kernels add up in the same order as the reference, results must match exactly
+			bool matches = true;
+			if (pass == 0)
+				reference_count = visible_count;
+			else
+				matches = visible_count == reference_count && visible == reference;
+			std::cout << "  " << (volume == kCullSphere ? "spheres" : "boxes  ") << " " << kPassNames[pass] << ": "
+				<< visible_count << " visible, " << elapsed_ns / 1000000.0 << " ms, " << object_count / elapsed_ns
+				<< " objects/ns" << (matches ? "" : ", MISMATCH") << std::endl;
+			failures += matches ? 0 : 1;
+		}
+	}
+	return failures == 0 ? 0 : -1;
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "Tools.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "MeshOptimizer.h"
+#include "ThreadPool.h"
+
+int BenchmarkMeshOptimizer(int grid_size)
+{
+	// a grid with its triangles in random order, like a mesh from an exporter that doesn't care
+	std::vector<float> positions;
+	std::vector<unsigned int> grid_indices;
+	for (int y = 0; y <= grid_size; y++)
+	{
+		for (int x = 0; x <= grid_size; x++)
+		{
+			positions.push_back((float)x);
+			positions.push_back((float)y);
+			positions.push_back(std::sin(x * 0.1f) * std::cos(y * 0.1f) * 4.0f);
+		}
+	}
+	for (int y = 0; y < grid_size; y++)
+	{
+		for (int x = 0; x < grid_size; x++)
+		{
+			unsigned int corner = y * (grid_size + 1) + x;
+			unsigned int quad[6] = { corner, corner + 1, corner + grid_size + 1, corner + 1, corner + grid_size + 2, corner + grid_size + 1 };
+			grid_indices.insert(grid_indices.end(), quad, quad + 6);
+		}
+	}
+	size_t vertex_count = positions.size() / 3;
+	size_t triangle_count = grid_indices.size() / 3;
+	std::vector<size_t> order(triangle_count);
+	for (size_t t = 0; t < triangle_count; t++)
+		order[t] = t;
+	std::shuffle(order.begin(), order.end(), std::mt19937(1234));
+	std::vector<unsigned int> shuffled(grid_indices.size());
+	for (size_t t = 0; t < triangle_count; t++)
+		std::memcpy(&shuffled[t * 3], &grid_indices[order[t] * 3], 3 * sizeof(unsigned int));
+
+	ThreadPool pool;
+	std::cout << "Mesh optimizer, " << triangle_count << " triangles, " << pool.ThreadCount() << " threads" << std::endl;
+	VertexCacheStats stats = MeshOptimizer::AnalyzeVertexCache(shuffled.data(), shuffled.size(), vertex_count);
+	std::cout << "  input            : ACMR " << stats.acmr << ", ATVR " << stats.atvr << std::endl;
+
+	const char* kPassNames[3] = { "vertex cache     ", "vertex cache (mt)", "overdraw         " };
+	for (int pass = 0; pass < 3; pass++)
+	{
+		std::vector<unsigned int> indices = shuffled;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (pass == 2)
+			MeshOptimizer::OptimizeOverdraw(indices.data(), indices.size(), positions.data(), 3, vertex_count);
+		else
+			MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), vertex_count, MeshOptimizer::kDefaultCacheSize, pass == 1 ? &pool : NULL);
+		double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		stats = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertex_count);
+		std::cout << "  " << kPassNames[pass] << ": ACMR " << stats.acmr << ", ATVR " << stats.atvr
+			<< " (" << elapsed_ms << " ms)" << std::endl;
+
+		// vertex fetch order follows the final triangle order
+		if (pass == 2)
+		{
+			std::vector<float> reordered = positions;
+			size_t used = MeshOptimizer::OptimizeVertexFetch(indices.data(), indices.size(), reordered.data(), vertex_count, 3 * sizeof(float));
+			std::cout << "  vertex fetch     : " << used << " of " << vertex_count << " vertices kept, renumbered by first use" << std::endl;
+		}
+	}
+	return 0;
+}
\ No newline at end of file
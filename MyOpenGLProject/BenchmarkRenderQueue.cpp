@@ -0,0 +1,60 @@
+#include "Tools.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "RenderQueue.h"
+
+int BenchmarkRenderQueue(int draw_count)
+{
+	// a scene of objects that share a few materials (program + two textures) and meshes
+	const int kPrograms = 8;
+	const int kMaterials = 32;
+	const int kMeshes = 16;
+	const int kRepetitions = 20;
+	std::mt19937 random(1234);
+	RenderQueue queue;
+	for (int i = 0; i < draw_count; i++)
+	{
+		int material = random() % kMaterials;
+		DrawItem item;
+		item.program = 1 + material % kPrograms;
+		item.textures[0] = 1 + material * 2;
+		item.textures[1] = 2 + material * 2;
+		item.texture_count = 2;
+		item.vertex_array = 1 + random() % kMeshes;
+		item.mode = GL_TRIANGLES;
+		item.index_count = 6;
+		item.index_type = GL_UNSIGNED_INT;
+		item.index_offset = 0;
+		item.base_vertex = 0;
+		RenderQueue::AssignKey(item, 0, (random() % 10000) / 10000.0f);
+		queue.Submit(item);
+	}
+
+	SubmissionStats unsorted = queue.CountStateChanges();
+	double sort_ms = 0.0;
+	for (int r = 0; r < kRepetitions; r++)
+	{
+		// sort a fresh copy every time, sorting an already sorted queue is not representative
+		RenderQueue copy = queue;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		copy.Sort();
+		sort_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (r == kRepetitions - 1)
+			queue = copy;
+	}
+	SubmissionStats sorted = queue.CountStateChanges();
+
+	const char* kLabels[2] = { "unsorted", "sorted  " };
+	SubmissionStats stats[2] = { unsorted, sorted };
+	std::cout << "Render queue, " << draw_count << " draws" << std::endl;
+	for (int i = 0; i < 2; i++)
+	{
+		std::cout << "  " << kLabels[i] << ": " << stats[i].StateChanges() << " state changes ("
+			<< stats[i].program_changes << " program, " << stats[i].texture_changes << " texture, "
+			<< stats[i].vertex_array_changes << " VAO)" << std::endl;
+	}
+	std::cout << "  radix sort: " << sort_ms / kRepetitions << " ms" << std::endl;
+	return sorted.StateChanges() <= unsorted.StateChanges() ? 0 : -1;
+}
\ No newline at end of file
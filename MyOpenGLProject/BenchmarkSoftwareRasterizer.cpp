@@ -0,0 +1,53 @@
+#include "Tools.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "Scenes.h"
+#include "SoftwareRasterizer.h"
+#include "ThreadPool.h"
+
+int BenchmarkSoftwareRasterizer(int triangle_count)
+{
+	const int kWidth = 1920;
+	const int kHeight = 1080;
+	const int kFrames = 20;
+	MipLevel image1, image2;
+	std::vector<MipLevel> mips1, mips2;
+	TextureSampler texture1, texture2;
+	LoadSoftwareTexture("container.jpg", image1, mips1, texture1);
+	LoadSoftwareTexture("container2.jpg", image2, mips2, texture2);
+
+	// the container rectangle over the whole screen, then the floor with the extra triangles
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+	BuildFloorScene(std::max(1, triangle_count / 2), vertices, indices);
+	Matrix4 view_projection = FloorViewProjection(kWidth, kHeight);
+
+	ThreadPool pool;
+	std::cout << "Software rasterizer, " << kWidth << "x" << kHeight << ", " << indices.size() / 3 + 2 << " triangles, "
+		<< SoftwareRasterizer::SimdName() << " edge functions, " << pool.ThreadCount() << " threads" << std::endl;
+	SoftwareRasterizer single(kWidth, kHeight);
+	SoftwareRasterizer multi(kWidth, kHeight, &pool);
+	SoftwareRasterizer* rasterizers[2] = { &single, &multi };
+	const char* kPassNames[2] = { "1 thread ", "all cores" };
+	for (int pass = 0; pass < 2; pass++)
+	{
+		SoftwareRasterizer& rasterizer = *rasterizers[pass];
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < kFrames; frame++)
+		{
+			rasterizer.Clear(0.2f, 0.3f, 0.3f, 1.0f);
+			rasterizer.Draw(kRectangleVertices, 4, kRectangleIndices, 6, texture1, texture2, Matrix4::Identity());
+			rasterizer.Draw(vertices.data(), vertices.size() / 8, indices.data(), indices.size(), texture1, texture2, view_projection);
+		}
+		double frame_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / kFrames;
+		std::cout << "  " << kPassNames[pass] << ": " << frame_ms << " ms/frame, " << 1000.0 / frame_ms << " fps" << std::endl;
+	}
+
+	// every pixel sees the same triangles in the same order however the tiles are scheduled
+	bool matches = std::equal(single.Pixels(), single.Pixels() + (size_t)kWidth * kHeight * 4, multi.Pixels());
+	std::cout << "  multithreaded image " << (matches ? "matches" : "MISMATCH") << std::endl;
+	return matches ? 0 : -1;
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "Tools.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "MipChain.h"
+#include "TextureSampler.h"
+
+int BenchmarkTextureSampler(int sample_count)
+{
+	// a noise image with odd sizes, its mip chain and the same texels as RGB8 and float
+	const int kWidth = 300;
+	const int kHeight = 200;
+	std::mt19937 random(1234);
+	std::vector<unsigned char> rgba((size_t)kWidth * kHeight * 4);
+	for (size_t i = 0; i < rgba.size(); i++)
+		rgba[i] = (unsigned char)(random() & 0xFF);
+	std::vector<MipLevel> chain;
+	MipChain::Build(rgba.data(), kWidth, kHeight, kMipFilterBox, false, chain);
+	int level_count = 1 + (int)chain.size();
+	std::vector<std::vector<unsigned char> > rgb_pixels(level_count);
+	std::vector<std::vector<float> > float_pixels(level_count);
+	std::vector<SamplerLevel> rgba_levels(level_count), rgb_levels(level_count), float_levels(level_count);
+	for (int l = 0; l < level_count; l++)
+	{
+		const unsigned char* source = l == 0 ? rgba.data() : chain[l - 1].pixels.data();
+		int width = l == 0 ? kWidth : chain[l - 1].width;
+		int height = l == 0 ? kHeight : chain[l - 1].height;
+		size_t texels = (size_t)width * height;
+		for (size_t i = 0; i < texels; i++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				if (c < 3)
+					rgb_pixels[l].push_back(source[i * 4 + c]);
+				float_pixels[l].push_back(source[i * 4 + c] / 255.0f);
+			}
+		}
+		SamplerLevel rgba_level = { width, height, source };
+		SamplerLevel rgb_level = { width, height, rgb_pixels[l].data() };
+		SamplerLevel float_level = { width, height, float_pixels[l].data() };
+		rgba_levels[l] = rgba_level;
+		rgb_levels[l] = rgb_level;
+		float_levels[l] = float_level;
+	}
+	const std::vector<SamplerLevel>* kLevels[3] = { &rgb_levels, &rgba_levels, &float_levels };
+	const char* kFormatNames[3] = { "rgb8 ", "rgba8", "float" };
+	const char* kFilterNames[3] = { "nearest  ", "bilinear ", "trilinear" };
+
+	// coordinates a few times around the texture, one level of detail per batch of 16 with
+	// a small spread, so some batches blend two different level pairs
+	std::uniform_real_distribution<float> coordinate(-2.5f, 2.5f);
+	std::uniform_real_distribution<float> detail(-1.0f, (float)level_count);
+	const int kBatch = TextureSampler::kMaxSamples;
+	int batch_count = std::max(1, sample_count / kBatch);
+	std::vector<float> u((size_t)batch_count * kBatch), v(u.size()), lod(u.size());
+	for (int b = 0; b < batch_count; b++)
+	{
+		float batch_lod = detail(random);
+		for (int i = 0; i < kBatch; i++)
+		{
+			u[b * kBatch + i] = coordinate(random);
+			v[b * kBatch + i] = coordinate(random);
+			lod[b * kBatch + i] = batch_lod + i * 0.002f;
+		}
+	}
+
+	std::cout << "Texture sampler, " << batch_count * kBatch << " samples, " << kWidth << "x" << kHeight << " with "
+		<< level_count << " levels, " << TextureSampler::SimdName() << " kernels" << std::endl;
+	int failures = 0;
+	SamplerColors fast, reference;
+	for (int format = kSamplerRGB8; format <= kSamplerFloat; format++)
+	{
+		for (int filter = kSamplerNearest; filter <= kSamplerTrilinear; filter++)
+		{
+			double fast_ns = 0.0, reference_ns = 0.0;
+			size_t mismatches = 0;
+			// all three wrap modes, results summed
+			for (int wrap = kSamplerRepeat; wrap <= kSamplerMirror; wrap++)
+			{
+				TextureSampler sampler;
+				sampler.SetLevels((SamplerFormat)format, kLevels[format]->data(), level_count);
+				sampler.SetFilter((SamplerFilter)filter);
+				sampler.SetWrap((SamplerWrap)wrap, (SamplerWrap)wrap);
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				for (int b = 0; b < batch_count; b++)
+					sampler.Sample(&u[b * kBatch], &v[b * kBatch], &lod[b * kBatch], kBatch, fast);
+				std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+				for (int b = 0; b < batch_count; b++)
+					sampler.SampleReference(&u[b * kBatch], &v[b * kBatch], &lod[b * kBatch], kBatch, reference);
+				std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+				fast_ns += std::chrono::duration<double, std::nano>(middle - start).count();
+				reference_ns += std::chrono::duration<double, std::nano>(end - middle).count();
+
+				// the kernels repeat the reference's operations, results must match exactly
+				for (int b = 0; b < batch_count; b++)
+				{
+					sampler.Sample(&u[b * kBatch], &v[b * kBatch], &lod[b * kBatch], kBatch, fast);
+					sampler.SampleReference(&u[b * kBatch], &v[b * kBatch], &lod[b * kBatch], kBatch, reference);
+					for (int i = 0; i < kBatch; i++)
+					{
+						mismatches += fast.red[i] != reference.red[i] || fast.green[i] != reference.green[i]
+							|| fast.blue[i] != reference.blue[i] || fast.alpha[i] != reference.alpha[i] ? 1 : 0;
+					}
+				}
+			}
+			double samples = 3.0 * batch_count * kBatch;
+			std::cout << "  " << kFormatNames[format] << " " << kFilterNames[filter] << ": " << samples / fast_ns
+				<< " samples/ns (reference " << samples / reference_ns << "), "
+				<< (mismatches == 0 ? "OK" : "MISMATCH") << std::endl;
+			failures += mismatches == 0 ? 0 : 1;
+		}
+	}
+	return failures == 0 ? 0 : -1;
+}
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include "BufferAllocator.h"
+
+#include <algorithm>
+
+BufferAllocator::BufferAllocator(size_t page_size, size_t min_block_size)
+	: page_size_(page_size), min_block_size_(min_block_size), max_order_(0)
+{
+	while (BlockSize(max_order_) < page_size_)
+		max_order_++;
+}
+
+BufferAllocator::~BufferAllocator()
+{
+	for (size_t p = 0; p < pages_.size(); p++)
+		glDeleteBuffers(1, &pages_[p].buffer);
+}
+
+int BufferAllocator::OrderOf(size_t size) const
+{
+	int order = 0;
+	while (BlockSize(order) < size)
+		order++;
+	return order;
+}
+
+size_t BufferAllocator::AddPage(GLState& state)
+{
+	// pages are filled through the copy target so no VAO's element binding gets disturbed
+	Page page;
+	glGenBuffers(1, &page.buffer);
+	state.BindBuffer(GL_COPY_WRITE_BUFFER, page.buffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, page_size_, NULL, GL_STATIC_DRAW);
+	page.free_blocks.resize(max_order_ + 1);
+	page.free_blocks[max_order_].insert(0);
+	pages_.push_back(page);
+	return pages_.size() - 1;
+}
+
+bool BufferAllocator::AllocateBlock(Page& page, int order, size_t& offset)
+{
+	// smallest free block that is large enough, split down to the requested order
+	int found = order;
+	while (found <= max_order_ && page.free_blocks[found].empty())
+		found++;
+	if (found > max_order_)
+		return false;
+
+	offset = *page.free_blocks[found].begin();
+	page.free_blocks[found].erase(page.free_blocks[found].begin());
+	while (found > order)
+	{
+		found--;
+		// keep the lower half, the upper half becomes a free buddy
+		page.free_blocks[found].insert(offset + BlockSize(found));
+	}
+	return true;
+}
+
+void BufferAllocator::FreeBlock(Page& page, int order, size_t offset)
+{
+	// merge with the buddy for as long as it is free too
+	while (order < max_order_)
+	{
+		size_t buddy = offset ^ BlockSize(order);
+		std::set<size_t>::iterator it = page.free_blocks[order].find(buddy);
+		if (it == page.free_blocks[order].end())
+			break;
+		page.free_blocks[order].erase(it);
+		offset = std::min(offset, buddy);
+		order++;
+	}
+	page.free_blocks[order].insert(offset);
+}
+
+BufferAllocator::Handle BufferAllocator::Allocate(GLState& state, size_t size, const void* data)
+{
+	if (size == 0 || size > page_size_)
+		return kInvalidHandle;
+
+	int order = OrderOf(size);
+	size_t page = 0, offset = 0;
+	while (page < pages_.size() && !AllocateBlock(pages_[page], order, offset))
+		page++;
+	if (page == pages_.size())
+	{
+		page = AddPage(state);
+		AllocateBlock(pages_[page], order, offset);
+	}
+
+	if (data)
+	{
+		state.BindBuffer(GL_COPY_WRITE_BUFFER, pages_[page].buffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, offset, size, data);
+	}
+
+	Record record = { page, offset, size, order, true };
+	Handle handle;
+	if (!free_handles_.empty())
+	{
+		handle = free_handles_.back();
+		free_handles_.pop_back();
+		records_[handle] = record;
+	}
+	else
+	{
+		handle = (Handle)records_.size();
+		records_.push_back(record);
+	}
+	return handle;
+}
+
+void BufferAllocator::Free(Handle handle)
+{
+	if (handle >= records_.size() || !records_[handle].live)
+		return;
+	Record& record = records_[handle];
+	FreeBlock(pages_[record.page], record.order, record.offset);
+	record.live = false;
+	free_handles_.push_back(handle);
+}
+
+BufferAllocation BufferAllocator::Get(Handle handle) const
+{
+	BufferAllocation allocation = { 0, 0, 0 };
+	if (handle < records_.size() && records_[handle].live)
+	{
+		const Record& record = records_[handle];
+		allocation.buffer = pages_[record.page].buffer;
+		allocation.offset = record.offset;
+		allocation.size = record.size;
+	}
+	return allocation;
+}
+
+bool BufferAllocator::BaseVertex(Handle handle, size_t stride, int& base_vertex) const
+{
+	if (stride == 0 || min_block_size_ % stride != 0)
+	{
+		std::cout << "ERROR::BUFFER_ALLOCATOR::STRIDE_DOES_NOT_DIVIDE_BLOCK_SIZE " << stride << " " << min_block_size_ << std::endl;
+		return false;
+	}
+	base_vertex = (int)(Get(handle).offset / stride);
+	return true;
+}
+
+size_t BufferAllocator::Defragment(GLState& state)
+{
+	// largest blocks first packs a buddy allocator without holes
+	std::vector<Handle> live;
+	for (Handle h = 0; h < records_.size(); h++)
+	{
+		if (records_[h].live)
+			live.push_back(h);
+	}
+	std::stable_sort(live.begin(), live.end(), [this](Handle a, Handle b) { return records_[a].order > records_[b].order; });
+
+	// build the packed layout in fresh pages, then copy every allocation over
+	std::vector<Page> old_pages;
+	old_pages.swap(pages_);
+	for (size_t i = 0; i < live.size(); i++)
+	{
+		Record& record = records_[live[i]];
+		size_t page = 0, offset = 0;
+		while (page < pages_.size() && !AllocateBlock(pages_[page], record.order, offset))
+			page++;
+		if (page == pages_.size())
+		{
+			page = AddPage(state);
+			AllocateBlock(pages_[page], record.order, offset);
+		}
+		state.BindBuffer(GL_COPY_READ_BUFFER, old_pages[record.page].buffer);
+		state.BindBuffer(GL_COPY_WRITE_BUFFER, pages_[page].buffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, record.offset, offset, record.size);
+		record.page = page;
+		record.offset = offset;
+	}
+
+	for (size_t p = 0; p < old_pages.size(); p++)
+		glDeleteBuffers(1, &old_pages[p].buffer);
+	// the deleted pages may still be bound to the copy targets
+	state.Invalidate();
+	return old_pages.size() > pages_.size() ? old_pages.size() - pages_.size() : 0;
+}
+
+BufferAllocator::Stats BufferAllocator::GetStats() const
+{
+	Stats stats = { pages_.size(), 0, pages_.size() * page_size_, 0, 0, 0, 0.0 };
+	for (size_t r = 0; r < records_.size(); r++)
+	{
+		if (!records_[r].live)
+			continue;
+		stats.allocation_count++;
+		stats.requested_bytes += records_[r].size;
+		stats.block_bytes += BlockSize(records_[r].order);
+	}
+	for (size_t p = 0; p < pages_.size(); p++)
+	{
+		for (int order = max_order_; order >= 0; order--)
+		{
+			if (!pages_[p].free_blocks[order].empty())
+			{
+				stats.largest_free_block = std::max(stats.largest_free_block, BlockSize(order));
+				break;
+			}
+		}
+	}
+	size_t free_bytes = stats.reserved_bytes - stats.block_bytes;
+	if (free_bytes > 0)
+		stats.fragmentation = 1.0 - (double)stats.largest_free_block / free_bytes;
+	return stats;
+}
+
+void BufferAllocator::PrintStats(std::ostream& out) const
+{
+	Stats stats = GetStats();
+	out << "Buffer allocator: " << stats.allocation_count << " allocations in " << stats.page_count
+		<< " pages, " << stats.requested_bytes << " of " << stats.reserved_bytes << " bytes used ("
+		<< stats.block_bytes - stats.requested_bytes << " lost to rounding), largest free block "
+		<< stats.largest_free_block << ", fragmentation " << stats.fragmentation << std::endl;
+}
\ No newline at end of file
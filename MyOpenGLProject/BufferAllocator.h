@@ -0,0 +1,101 @@
+#ifndef BUFFER_ALLOCATOR_H
+#define BUFFER_ALLOCATOR_H
+
+#include <GL/glew.h> // include glew to get all the required OpenGL headers
+
+#include <iostream>
+#include <set>
+#include <vector>
+#include "GLState.h"
+
+// where an allocation currently lives
+struct BufferAllocation
+{
+	unsigned int buffer;
+	size_t offset;
+	size_t size;
+};
+
+// Carves vertex and index data out of a few large buffer objects ("pages") with a buddy
+// allocator; the pages are plain buffers that can be bound to any target.
+// Blocks are powers of two between the minimum block size and the page size,
+// so offsets are aligned to the minimum block size and, for vertex data with a stride that
+// divides it, can be turned into a base vertex. Allocations are referred to by handle because
+// Defragment may move them; look them up again after defragmenting and rebuild whatever was
+// derived from them (VAO buffer bindings, index offsets, base vertices).
+class BufferAllocator
+{
+public:
+	typedef unsigned int Handle;
+	static const Handle kInvalidHandle = 0xFFFFFFFFu;
+
+	struct Stats
+	{
+		size_t page_count;
+		size_t allocation_count;
+		// bytes of all pages
+		size_t reserved_bytes;
+		// bytes requested by the live allocations
+		size_t requested_bytes;
+		// bytes of the blocks handed out, the difference to requested is lost to rounding
+		size_t block_bytes;
+		size_t largest_free_block;
+		// 0 when all free space is one block, close to 1 when it is scattered
+		double fragmentation;
+	};
+
+	// page_size and min_block_size must be powers of two
+	BufferAllocator(size_t page_size, size_t min_block_size = 256);
+	~BufferAllocator();
+	BufferAllocator(const BufferAllocator&) = delete;
+	BufferAllocator& operator=(const BufferAllocator&) = delete;
+
+	// reserve size bytes and upload data into them if it is not NULL.
+	// kInvalidHandle if size is larger than a page
+	Handle Allocate(GLState& state, size_t size, const void* data = NULL);
+	void Free(Handle handle);
+	BufferAllocation Get(Handle handle) const;
+	// base vertex of the vertex data in an allocation, for attributes that point at the start of
+	// its page. false with an error if the stride doesn't divide the minimum block size, the
+	// offsets would not be whole vertices then
+	bool BaseVertex(Handle handle, size_t stride, int& base_vertex) const;
+	// repack every live allocation into as few pages as possible, largest first, and
+	// release the pages that are no longer needed. returns the number of pages released
+	size_t Defragment(GLState& state);
+
+	Stats GetStats() const;
+	void PrintStats(std::ostream& out) const;
+
+private:
+	struct Page
+	{
+		unsigned int buffer;
+		// offsets of the free blocks, one set per order (block size = min_block_size << order)
+		std::vector<std::set<size_t> > free_blocks;
+	};
+
+	struct Record
+	{
+		size_t page;
+		size_t offset;
+		size_t size;
+		int order;
+		bool live;
+	};
+
+	int OrderOf(size_t size) const;
+	size_t BlockSize(int order) const { return min_block_size_ << order; }
+	size_t AddPage(GLState& state);
+	// buddy allocation inside one page, false if the page has no block of that order left
+	bool AllocateBlock(Page& page, int order, size_t& offset);
+	void FreeBlock(Page& page, int order, size_t offset);
+
+	size_t page_size_;
+	size_t min_block_size_;
+	int max_order_;
+	std::vector<Page> pages_;
+	std::vector<Record> records_;
+	std::vector<Handle> free_handles_;
+};
+
+#endif // !BUFFER_ALLOCATOR_H
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "Camera.h"
+
+#include <cmath>
+#include <cstring>
+
+static void Normalize(float* v)
+{
+	float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+	if (length <= 0.0f)
+		return;
+	for (int i = 0; i < 3; i++)
+		v[i] /= length;
+}
+
+static void Cross(const float* a, const float* b, float* result)
+{
+	result[0] = a[1] * b[2] - a[2] * b[1];
+	result[1] = a[2] * b[0] - a[0] * b[2];
+	result[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static float Dot(const float* a, const float* b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+Matrix4 Matrix4::Identity()
+{
+	Matrix4 result;
+	std::memset(result.m, 0, sizeof(result.m));
+	result.m[0] = result.m[5] = result.m[10] = result.m[15] = 1.0f;
+	return result;
+}
+
+Matrix4 Matrix4::Perspective(float fov_y_degrees, float aspect, float near_plane, float far_plane)
+{
+	float focal = 1.0f / std::tan(fov_y_degrees * 3.14159265f / 360.0f);
+	Matrix4 result;
+	std::memset(result.m, 0, sizeof(result.m));
+	result.m[0] = focal / aspect;
+	result.m[5] = focal;
+	result.m[10] = (far_plane + near_plane) / (near_plane - far_plane);
+	result.m[11] = -1.0f;
+	result.m[14] = 2.0f * far_plane * near_plane / (near_plane - far_plane);
+	return result;
+}
+
+Matrix4 Matrix4::LookAt(const float eye[3], const float target[3], const float up[3])
+{
+	float forward[3] = { target[0] - eye[0], target[1] - eye[1], target[2] - eye[2] };
+	Normalize(forward);
+	float side[3], true_up[3];
+	Cross(forward, up, side);
+	Normalize(side);
+	Cross(side, forward, true_up);
+
+	Matrix4 result = Identity();
+	for (int i = 0; i < 3; i++)
+	{
+		result.m[i * 4] = side[i];
+		result.m[i * 4 + 1] = true_up[i];
+		result.m[i * 4 + 2] = -forward[i];
+	}
+	result.m[12] = -Dot(side, eye);
+	result.m[13] = -Dot(true_up, eye);
+	result.m[14] = Dot(forward, eye);
+	return result;
+}
+
+Matrix4 Matrix4::operator*(const Matrix4& other) const
+{
+	Matrix4 result;
+	for (int column = 0; column < 4; column++)
+	{
+		for (int row = 0; row < 4; row++)
+		{
+			float sum = 0.0f;
+			for (int k = 0; k < 4; k++)
+				sum += m[k * 4 + row] * other.m[column * 4 + k];
+			result.m[column * 4 + row] = sum;
+		}
+	}
+	return result;
+}
+
+void Matrix4::Transform(const float point[3], float result[4]) const
+{
+	for (int row = 0; row < 4; row++)
+		result[row] = m[row] * point[0] + m[4 + row] * point[1] + m[8 + row] * point[2] + m[12 + row];
+}
+
+Camera::Camera(float fov_y_degrees, float aspect, float near_plane, float far_plane)
+	: fov_y_degrees_(fov_y_degrees), aspect_(aspect), near_plane_(near_plane), far_plane_(far_plane)
+{
+	// at the origin, looking down -z like OpenGL's default
+	const float kPosition[3] = { 0.0f, 0.0f, 0.0f };
+	const float kTarget[3] = { 0.0f, 0.0f, -1.0f };
+	const float kUp[3] = { 0.0f, 1.0f, 0.0f };
+	LookAt(kPosition, kTarget, kUp);
+}
+
+void Camera::LookAt(const float position[3], const float target[3], const float up[3])
+{
+	std::memcpy(position_, position, sizeof(position_));
+	std::memcpy(target_, target, sizeof(target_));
+	std::memcpy(up_, up, sizeof(up_));
+}
+
+Matrix4 Camera::View() const
+{
+	return Matrix4::LookAt(position_, target_, up_);
+}
+
+Matrix4 Camera::Projection() const
+{
+	return Matrix4::Perspective(fov_y_degrees_, aspect_, near_plane_, far_plane_);
+}
+
+void Camera::FrustumPlanes(float planes[6][4]) const
+{
+	ExtractFrustumPlanes(ViewProjection(), planes);
+}
+
+void Camera::ExtractFrustumPlanes(const Matrix4& view_projection, float planes[6][4])
+{
+	// a point is inside if -w <= x, y, z <= w in clip space, every bound is a plane in world space
+	const float* m = view_projection.m;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int side = 0; side < 2; side++)
+		{
+			float sign = side == 0 ? 1.0f : -1.0f;
+			float* plane = planes[axis * 2 + side];
+			for (int i = 0; i < 4; i++)
+				plane[i] = m[i * 4 + 3] + sign * m[i * 4 + axis];
+			float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+			if (length > 0.0f)
+			{
+				for (int i = 0; i < 4; i++)
+					plane[i] /= length;
+			}
+		}
+	}
+}
\ No newline at end of file
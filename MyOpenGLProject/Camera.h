@@ -0,0 +1,49 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+// column-major 4x4 matrix (m[column * 4 + row]), the layout glUniformMatrix4fv takes untransposed
+struct Matrix4
+{
+	float m[16];
+
+	static Matrix4 Identity();
+	// OpenGL style projection, clip space z from -1 (near) to 1 (far)
+	static Matrix4 Perspective(float fov_y_degrees, float aspect, float near_plane, float far_plane);
+	// right-handed view matrix looking from eye at target
+	static Matrix4 LookAt(const float eye[3], const float target[3], const float up[3]);
+	Matrix4 operator*(const Matrix4& other) const;
+	// homogeneous transform of (point, 1)
+	void Transform(const float point[3], float result[4]) const;
+};
+
+// Perspective camera producing the view and projection matrices for shader.vert and the
+// frustum planes for culling.
+class Camera
+{
+public:
+	Camera(float fov_y_degrees, float aspect, float near_plane, float far_plane);
+
+	void LookAt(const float position[3], const float target[3], const float up[3]);
+	void SetAspect(float aspect) { aspect_ = aspect; }
+	const float* Position() const { return position_; }
+
+	Matrix4 View() const;
+	Matrix4 Projection() const;
+	Matrix4 ViewProjection() const { return Projection() * View(); }
+	// planes (a, b, c, d) with a * x + b * y + c * z + d >= 0 inside, normalized so that this
+	// is the distance to the plane. order: left, right, bottom, top, near, far
+	void FrustumPlanes(float planes[6][4]) const;
+	// the same for any view-projection matrix (Gribb and Hartmann)
+	static void ExtractFrustumPlanes(const Matrix4& view_projection, float planes[6][4]);
+
+private:
+	float position_[3];
+	float target_[3];
+	float up_[3];
+	float fov_y_degrees_;
+	float aspect_;
+	float near_plane_;
+	float far_plane_;
+};
+
+#endif // !CAMERA_H
\ No newline at end of file
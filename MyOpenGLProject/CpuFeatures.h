@@ -0,0 +1,18 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+// Instruction sets the CPU offers beyond the build's baseline (SSE2 on x86, NEON on ARM).
+// The AVX2 kernels live in their own *Avx2.cpp files, the only ones compiled with /arch:AVX2;
+// the modules call into them when HasAvx2 is true and take their SSE2 paths otherwise. The Avx2
+// files are empty on other architectures and stop with an error on x86 without the switch.
+// Code in the Avx2 files must not call inline functions or templates from shared headers
+// (std::min, std::vector, ...): the linker keeps one copy of each, and it could be the one
+// compiled for AVX2.
+class CpuFeatures
+{
+public:
+	// AVX2 supported by the CPU and its YMM registers saved by the OS. false on other architectures
+	static bool HasAvx2();
+};
+
+#endif // !CPU_FEATURES_H
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "Framebuffer.h"
+
+Framebuffer::Framebuffer(GLState& state, int width, int height)
+	: id_(0), color_texture_(0), depth_stencil_(0), width_(width), height_(height)
+{
+	glGenFramebuffers(1, &id_);
+	state.BindFramebuffer(id_);
+
+	// color attachment is a texture so the result can be sampled or read back later
+	glGenTextures(1, &color_texture_);
+	state.BindTexture(0, GL_TEXTURE_2D, color_texture_);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width_, height_, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_texture_, 0);
+
+	// depth and stencil are never sampled, a renderbuffer is enough
+	glGenRenderbuffers(1, &depth_stencil_);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth_stencil_);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width_, height_);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_stencil_);
+
+	if (!IsComplete(state))
+		std::cout << "ERROR::FRAMEBUFFER::NOT_COMPLETE" << std::endl;
+
+	state.BindTexture(0, GL_TEXTURE_2D, 0);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	state.BindFramebuffer(0);
+}
+
+Framebuffer::~Framebuffer()
+{
+	glDeleteRenderbuffers(1, &depth_stencil_);
+	glDeleteTextures(1, &color_texture_);
+	glDeleteFramebuffers(1, &id_);
+}
+
+bool Framebuffer::IsComplete(GLState& state) const
+{
+	state.BindFramebuffer(id_);
+	return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+void Framebuffer::Bind(GLState& state) const
+{
+	state.BindFramebuffer(id_);
+	state.Viewport(0, 0, width_, height_);
+}
+
+void Framebuffer::BindDefault(GLState& state)
+{
+	state.BindFramebuffer(0);
+}
@@ -0,0 +1,34 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <GL/glew.h> // include glew to get all the required OpenGL headers
+
+#include <iostream>
+#include "GLState.h"
+
+class Framebuffer
+{
+public:
+	// the framebuffer object ID and its attachments
+	unsigned int id_;
+	unsigned int color_texture_;
+	unsigned int depth_stencil_;
+	int width_;
+	int height_;
+
+	// constructor creates an RGBA8 color texture and a depth/stencil renderbuffer.
+	// the binds go through the state cache, the default framebuffer is bound afterwards
+	Framebuffer(GLState& state, int width, int height);
+	~Framebuffer();
+	Framebuffer(const Framebuffer&) = delete;
+	Framebuffer& operator=(const Framebuffer&) = delete;
+
+	// true if all attachments are valid and the framebuffer can be rendered into
+	bool IsComplete(GLState& state) const;
+	// bind as the current draw/read target and match the viewport to its size
+	void Bind(GLState& state) const;
+	// go back to rendering into the window's default framebuffer
+	static void BindDefault(GLState& state);
+};
+
+#endif // !FRAMEBUFFER_H
@@ -0,0 +1,258 @@
+#include "FrustumCuller.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include "CpuFeatures.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRUSTUM_CULLER_SSE2
+// the AVX2 kernel is built in FrustumCullerAvx2.cpp and picked at runtime
+#define FRUSTUM_CULLER_AVX2
+#include <emmintrin.h>
+#include "FrustumCullerAvx2.h"
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define FRUSTUM_CULLER_NEON
+#include <arm_neon.h>
+#endif
+#if defined(_MSC_VER)
+// no fused multiply-adds in CullReference, objects touching a plane must land on the same side
+#pragma fp_contract(off)
+#endif
+
+// objects per task when culling on a pool, a multiple of 8 so the vector loops stay aligned
+static const size_t kCullGrain = 64 * 1024;
+
+// turn the visibility bit masks of the vector loops into one byte per object
+struct MaskTables
+{
+	unsigned char bytes[256][8];
+	unsigned char bit_count[256];
+
+	MaskTables()
+	{
+		for (int mask = 0; mask < 256; mask++)
+		{
+			bit_count[mask] = 0;
+			for (int bit = 0; bit < 8; bit++)
+			{
+				bytes[mask][bit] = (unsigned char)((mask >> bit) & 1);
+				bit_count[mask] += bytes[mask][bit];
+			}
+		}
+	}
+};
+
+static const MaskTables& Tables()
+{
+	static const MaskTables tables;
+	return tables;
+}
+
+FrustumCuller::FrustumCuller()
+{
+}
+
+void FrustumCuller::Clear()
+{
+	center_x_.clear();
+	center_y_.clear();
+	center_z_.clear();
+	extent_x_.clear();
+	extent_y_.clear();
+	extent_z_.clear();
+	radius_.clear();
+}
+
+void FrustumCuller::Reserve(size_t count)
+{
+	center_x_.reserve(count);
+	center_y_.reserve(count);
+	center_z_.reserve(count);
+	extent_x_.reserve(count);
+	extent_y_.reserve(count);
+	extent_z_.reserve(count);
+	radius_.reserve(count);
+}
+
+size_t FrustumCuller::AddBox(const float min[3], const float max[3])
+{
+	float extent[3] = { (max[0] - min[0]) * 0.5f, (max[1] - min[1]) * 0.5f, (max[2] - min[2]) * 0.5f };
+	center_x_.push_back((min[0] + max[0]) * 0.5f);
+	center_y_.push_back((min[1] + max[1]) * 0.5f);
+	center_z_.push_back((min[2] + max[2]) * 0.5f);
+	extent_x_.push_back(extent[0]);
+	extent_y_.push_back(extent[1]);
+	extent_z_.push_back(extent[2]);
+	radius_.push_back(std::sqrt(extent[0] * extent[0] + extent[1] * extent[1] + extent[2] * extent[2]));
+	return center_x_.size() - 1;
+}
+
+size_t FrustumCuller::AddSphere(const float center[3], float radius)
+{
+	center_x_.push_back(center[0]);
+	center_y_.push_back(center[1]);
+	center_z_.push_back(center[2]);
+	extent_x_.push_back(radius);
+	extent_y_.push_back(radius);
+	extent_z_.push_back(radius);
+	radius_.push_back(radius);
+	return center_x_.size() - 1;
+}
+
+size_t FrustumCuller::Cull(const float planes[6][4], CullVolume volume, unsigned char* visible, ThreadPool* pool) const
+{
+	size_t count = Count();
+	if (!pool || count <= kCullGrain)
+		return CullRange(planes, volume, visible, 0, count);
+
+	std::atomic<size_t> visible_count(0);
+	pool->ParallelFor(count, kCullGrain, [&](size_t begin, size_t end)
+	{
+		visible_count += CullRange(planes, volume, visible, begin, end);
+	});
+	return visible_count;
+}
+
+// the scalar test, also used for the objects the vector loops leave over. the sums are formed
+// in the same order as in the kernels, so every path gives the same result
+static bool IsVisible(const float planes[6][4], bool box, float center_x, float center_y, float center_z,
+	float extent_x, float extent_y, float extent_z, float radius)
+{
+	for (int p = 0; p < 6; p++)
+	{
+		const float* plane = planes[p];
+		float distance = plane[0] * center_x + plane[1] * center_y + plane[2] * center_z + plane[3];
+		// a box reaches furthest towards the plane's inside with its most positive corner
+		if (box)
+			distance = distance + std::fabs(plane[0]) * extent_x + std::fabs(plane[1]) * extent_y + std::fabs(plane[2]) * extent_z;
+		else
+			distance = distance + radius;
+		if (distance < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+size_t FrustumCuller::CullReference(const float planes[6][4], CullVolume volume, unsigned char* visible) const
+{
+	size_t visible_count = 0;
+	for (size_t i = 0; i < Count(); i++)
+	{
+		visible[i] = IsVisible(planes, volume == kCullBox, center_x_[i], center_y_[i], center_z_[i],
+			extent_x_[i], extent_y_[i], extent_z_[i], radius_[i]) ? 1 : 0;
+		visible_count += visible[i];
+	}
+	return visible_count;
+}
+
+size_t FrustumCuller::CullRange(const float planes[6][4], CullVolume volume, unsigned char* visible, size_t begin, size_t end) const
+{
+	const MaskTables& tables = Tables();
+	bool box = volume == kCullBox;
+	size_t visible_count = 0;
+	size_t i = begin;
+
+#if defined(FRUSTUM_CULLER_AVX2)
+	if (CpuFeatures::HasAvx2())
+	{
+		i = FrustumCullerAvx2::CullRange(planes, box, center_x_.data(), center_y_.data(), center_z_.data(),
+			extent_x_.data(), extent_y_.data(), extent_z_.data(), radius_.data(), tables.bytes, tables.bit_count,
+			visible, i, end, visible_count);
+	}
+#endif
+#if defined(FRUSTUM_CULLER_SSE2)
+	{
+		__m128 normal[6][3], magnitude[6][3], offset[6];
+		for (int p = 0; p < 6; p++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				normal[p][k] = _mm_set1_ps(planes[p][k]);
+				magnitude[p][k] = _mm_set1_ps(std::fabs(planes[p][k]));
+			}
+			offset[p] = _mm_set1_ps(planes[p][3]);
+		}
+		const __m128 zero = _mm_setzero_ps();
+		for (; i + 4 <= end; i += 4)
+		{
+			__m128 x = _mm_loadu_ps(&center_x_[i]);
+			__m128 y = _mm_loadu_ps(&center_y_[i]);
+			__m128 z = _mm_loadu_ps(&center_z_[i]);
+			__m128 outside = zero;
+			for (int p = 0; p < 6; p++)
+			{
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(normal[p][0], x),
+					_mm_mul_ps(normal[p][1], y)), _mm_mul_ps(normal[p][2], z)), offset[p]);
+				if (box)
+				{
+					distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(magnitude[p][0], _mm_loadu_ps(&extent_x_[i]))),
+						_mm_mul_ps(magnitude[p][1], _mm_loadu_ps(&extent_y_[i]))), _mm_mul_ps(magnitude[p][2], _mm_loadu_ps(&extent_z_[i])));
+				}
+				else
+				{
+					distance = _mm_add_ps(distance, _mm_loadu_ps(&radius_[i]));
+				}
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, zero));
+			}
+			int mask = ~_mm_movemask_ps(outside) & 0xF;
+			std::memcpy(visible + i, tables.bytes[mask], 4);
+			visible_count += tables.bit_count[mask];
+		}
+	}
+#elif defined(FRUSTUM_CULLER_NEON)
+	{
+		const float32x4_t zero = vdupq_n_f32(0.0f);
+		for (; i + 4 <= end; i += 4)
+		{
+			float32x4_t x = vld1q_f32(&center_x_[i]);
+			float32x4_t y = vld1q_f32(&center_y_[i]);
+			float32x4_t z = vld1q_f32(&center_z_[i]);
+			uint32x4_t outside = vdupq_n_u32(0);
+			for (int p = 0; p < 6; p++)
+			{
+				float32x4_t distance = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(x, planes[p][0]),
+					vmulq_n_f32(y, planes[p][1])), vmulq_n_f32(z, planes[p][2])), vdupq_n_f32(planes[p][3]));
+				if (box)
+				{
+					distance = vaddq_f32(vaddq_f32(vaddq_f32(distance, vmulq_n_f32(vld1q_f32(&extent_x_[i]), std::fabs(planes[p][0]))),
+						vmulq_n_f32(vld1q_f32(&extent_y_[i]), std::fabs(planes[p][1]))), vmulq_n_f32(vld1q_f32(&extent_z_[i]), std::fabs(planes[p][2])));
+				}
+				else
+				{
+					distance = vaddq_f32(distance, vld1q_f32(&radius_[i]));
+				}
+				outside = vorrq_u32(outside, vcltq_f32(distance, zero));
+			}
+			unsigned int lanes[4];
+			vst1q_u32(lanes, outside);
+			int mask = (~((lanes[0] & 1) | (lanes[1] & 2) | (lanes[2] & 4) | (lanes[3] & 8))) & 0xF;
+			std::memcpy(visible + i, tables.bytes[mask], 4);
+			visible_count += tables.bit_count[mask];
+		}
+	}
+#endif
+
+	for (; i < end; i++)
+	{
+		visible[i] = IsVisible(planes, box, center_x_[i], center_y_[i], center_z_[i],
+			extent_x_[i], extent_y_[i], extent_z_[i], radius_[i]) ? 1 : 0;
+		visible_count += visible[i];
+	}
+	return visible_count;
+}
+
+const char* FrustumCuller::SimdName()
+{
+#if defined(FRUSTUM_CULLER_AVX2)
+	if (CpuFeatures::HasAvx2())
+		return "AVX2";
+#endif
+#if defined(FRUSTUM_CULLER_SSE2)
+	return "SSE2";
+#elif defined(FRUSTUM_CULLER_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
\ No newline at end of file
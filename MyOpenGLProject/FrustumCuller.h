@@ -0,0 +1,52 @@
+#ifndef FRUSTUM_CULLER_H
+#define FRUSTUM_CULLER_H
+
+#include <vector>
+#include "ThreadPool.h"
+
+// what Cull tests against the planes
+enum CullVolume
+{
+	kCullSphere,
+	kCullBox
+};
+
+// Tests large numbers of objects against the six frustum planes. Bounds are kept as a
+// structure of arrays (one array per coordinate), so the AVX2/SSE/NEON kernels test 8 or 4
+// objects per instruction with plain loads. Cull splits the objects across the pool's workers;
+// CullReference is the scalar version the kernels are verified against.
+class FrustumCuller
+{
+public:
+	FrustumCuller();
+
+	void Clear();
+	void Reserve(size_t count);
+	// axis aligned box, its bounding sphere is stored too. returns the object index
+	size_t AddBox(const float min[3], const float max[3]);
+	// sphere, its bounding cube is stored as the box
+	size_t AddSphere(const float center[3], float radius);
+	size_t Count() const { return center_x_.size(); }
+
+	// visible[i] = 1 if object i is at least partly inside the frustum (conservatively: an object
+	// outside near a frustum corner may be kept), 0 otherwise. returns the number of visible objects.
+	// planes are (a, b, c, d) with a * x + b * y + c * z + d >= 0 inside, see Camera::FrustumPlanes
+	size_t Cull(const float planes[6][4], CullVolume volume, unsigned char* visible, ThreadPool* pool = NULL) const;
+	size_t CullReference(const float planes[6][4], CullVolume volume, unsigned char* visible) const;
+	// name of the instruction set the kernels run with on this CPU
+	static const char* SimdName();
+
+private:
+	size_t CullRange(const float planes[6][4], CullVolume volume, unsigned char* visible, size_t begin, size_t end) const;
+
+	std::vector<float> center_x_;
+	std::vector<float> center_y_;
+	std::vector<float> center_z_;
+	// half the box size along each axis
+	std::vector<float> extent_x_;
+	std::vector<float> extent_y_;
+	std::vector<float> extent_z_;
+	std::vector<float> radius_;
+};
+
+#endif // !FRUSTUM_CULLER_H
\ No newline at end of file
@@ -0,0 +1,66 @@
+#include "FrustumCullerAvx2.h"
+
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+size_t FrustumCullerAvx2::CullRange(const float planes[6][4], bool box, const float* center_x, const float* center_y,
+	const float* center_z, const float* extent_x, const float* extent_y, const float* extent_z, const float* radius,
+	const unsigned char (*mask_bytes)[8], const unsigned char* bit_count, unsigned char* visible,
+	size_t begin, size_t end, size_t& visible_count)
+{
+	// plane normals, their absolute values and offsets, broadcast once
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+	__m256 normal[6][3], magnitude[6][3], offset[6];
+	for (int p = 0; p < 6; p++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			normal[p][k] = _mm256_set1_ps(planes[p][k]);
+			magnitude[p][k] = _mm256_andnot_ps(sign, normal[p][k]);
+		}
+		offset[p] = _mm256_set1_ps(planes[p][3]);
+	}
+	const __m256 zero = _mm256_setzero_ps();
+	size_t i = begin;
+	for (; i + 8 <= end; i += 8)
+	{
+		__m256 x = _mm256_loadu_ps(center_x + i);
+		__m256 y = _mm256_loadu_ps(center_y + i);
+		__m256 z = _mm256_loadu_ps(center_z + i);
+		__m256 outside = zero;
+		if (box)
+		{
+			__m256 ex = _mm256_loadu_ps(extent_x + i);
+			__m256 ey = _mm256_loadu_ps(extent_y + i);
+			__m256 ez = _mm256_loadu_ps(extent_z + i);
+			for (int p = 0; p < 6; p++)
+			{
+				__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(normal[p][0], x),
+					_mm256_mul_ps(normal[p][1], y)), _mm256_mul_ps(normal[p][2], z)), offset[p]);
+				distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(distance, _mm256_mul_ps(magnitude[p][0], ex)),
+					_mm256_mul_ps(magnitude[p][1], ey)), _mm256_mul_ps(magnitude[p][2], ez));
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, zero, _CMP_LT_OQ));
+			}
+		}
+		else
+		{
+			__m256 r = _mm256_loadu_ps(radius + i);
+			for (int p = 0; p < 6; p++)
+			{
+				__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(normal[p][0], x),
+					_mm256_mul_ps(normal[p][1], y)), _mm256_mul_ps(normal[p][2], z)), offset[p]);
+				distance = _mm256_add_ps(distance, r);
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, zero, _CMP_LT_OQ));
+			}
+		}
+		int mask = ~_mm256_movemask_ps(outside) & 0xFF;
+		std::memcpy(visible + i, mask_bytes[mask], 8);
+		visible_count += bit_count[mask];
+	}
+	return i;
+}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#error FrustumCullerAvx2.cpp must be compiled with /arch:AVX2
+#endif
\ No newline at end of file
@@ -0,0 +1,21 @@
+#ifndef FRUSTUM_CULLER_AVX2_H
+#define FRUSTUM_CULLER_AVX2_H
+
+#include <cstddef>
+
+// FrustumCuller's AVX2 kernel, 8 objects per instruction. Only called when
+// CpuFeatures::HasAvx2() is true, see CpuFeatures.h
+class FrustumCullerAvx2
+{
+public:
+	// the groups of 8 objects in [begin, end) of the bounds arrays (box: centers and extents,
+	// otherwise centers and radii), one visibility byte per object as mask_bytes gives it for
+	// the mask of visible lanes. returns the first object left over; bit_count of every mask is
+	// added to visible_count
+	static size_t CullRange(const float planes[6][4], bool box, const float* center_x, const float* center_y,
+		const float* center_z, const float* extent_x, const float* extent_y, const float* extent_z, const float* radius,
+		const unsigned char (*mask_bytes)[8], const unsigned char* bit_count, unsigned char* visible,
+		size_t begin, size_t end, size_t& visible_count);
+};
+
+#endif // !FRUSTUM_CULLER_AVX2_H
\ No newline at end of file
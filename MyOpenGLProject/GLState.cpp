@@ -0,0 +1,269 @@
+#include "GLState.h"
+
+static const GLenum kTextureTargets[GLState::kTextureTargetCount] = {
+	GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_3D
+};
+// GL_ELEMENT_ARRAY_BUFFER has to stay at index 1, see BindVertexArray
+static const GLenum kBufferTargets[GLState::kBufferTargetCount] = {
+	GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_PIXEL_PACK_BUFFER,
+	GL_PIXEL_UNPACK_BUFFER, GL_DRAW_INDIRECT_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER
+};
+static const GLenum kCapabilities[GLState::kCapabilityCount] = {
+	GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST, GL_STENCIL_TEST
+};
+static const char* const kCallNames[GLState::kCallCount] = {
+	"UseProgram", "BindVertexArray", "ActiveTexture", "BindTexture", "BindBuffer", "BindFramebuffer",
+	"Viewport", "ClearColor", "Enable/Disable", "BlendFunc", "DepthFunc", "DepthMask"
+};
+
+GLState::GLState()
+{
+	Invalidate();
+	ResetCounters();
+}
+
+void GLState::Invalidate()
+{
+	program_ = kUnknown;
+	vertex_array_ = kUnknown;
+	active_unit_ = -1;
+	for (int u = 0; u < kMaxTextureUnits; u++)
+	{
+		for (int t = 0; t < kTextureTargetCount; t++)
+			textures_[u][t] = kUnknown;
+	}
+	for (int b = 0; b < kBufferTargetCount; b++)
+		buffers_[b] = kUnknown;
+	framebuffer_ = kUnknown;
+	viewport_known_ = false;
+	clear_color_known_ = false;
+	for (int c = 0; c < kCapabilityCount; c++)
+		capabilities_[c] = -1;
+	blend_source_ = blend_destination_ = kUnknown;
+	depth_func_ = kUnknown;
+	depth_mask_ = -1;
+}
+
+bool GLState::Changed(Call call, bool changed)
+{
+	if (changed)
+		issued_[call]++;
+	else
+		elided_[call]++;
+	return changed;
+}
+
+void GLState::UseProgram(unsigned int program)
+{
+	if (!Changed(kCallProgram, program_ != program))
+		return;
+	glUseProgram(program);
+	program_ = program;
+}
+
+void GLState::BindVertexArray(unsigned int vao)
+{
+	if (!Changed(kCallVertexArray, vertex_array_ != vao))
+		return;
+	glBindVertexArray(vao);
+	vertex_array_ = vao;
+	// the new VAO brings its own element array buffer
+	buffers_[1] = kUnknown;
+}
+
+void GLState::ActiveTexture(int unit)
+{
+	if (!Changed(kCallActiveTexture, active_unit_ != unit))
+		return;
+	glActiveTexture(GL_TEXTURE0 + unit);
+	active_unit_ = unit;
+}
+
+void GLState::BindTexture(GLenum target, unsigned int texture)
+{
+	if (active_unit_ < 0)
+	{
+		// the active unit is unknown, so is whatever is bound to it
+		Changed(kCallTexture, true);
+		glBindTexture(target, texture);
+		return;
+	}
+	BindTexture(active_unit_, target, texture);
+}
+
+void GLState::BindTexture(int unit, GLenum target, unsigned int texture)
+{
+	int index = TextureTargetIndex(target);
+	if (unit < 0 || unit >= kMaxTextureUnits || index < 0)
+	{
+		ActiveTexture(unit);
+		Changed(kCallTexture, true);
+		glBindTexture(target, texture);
+		return;
+	}
+	if (!Changed(kCallTexture, textures_[unit][index] != texture))
+		return;
+	ActiveTexture(unit);
+	glBindTexture(target, texture);
+	textures_[unit][index] = texture;
+}
+
+void GLState::BindBuffer(GLenum target, unsigned int buffer)
+{
+	int index = BufferTargetIndex(target);
+	if (index < 0)
+	{
+		Changed(kCallBuffer, true);
+		glBindBuffer(target, buffer);
+		return;
+	}
+	if (!Changed(kCallBuffer, buffers_[index] != buffer))
+		return;
+	glBindBuffer(target, buffer);
+	buffers_[index] = buffer;
+}
+
+void GLState::BindFramebuffer(unsigned int framebuffer)
+{
+	if (!Changed(kCallFramebuffer, framebuffer_ != framebuffer))
+		return;
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	framebuffer_ = framebuffer;
+}
+
+void GLState::Viewport(int x, int y, int width, int height)
+{
+	bool same = viewport_known_ && viewport_[0] == x && viewport_[1] == y && viewport_[2] == width && viewport_[3] == height;
+	if (!Changed(kCallViewport, !same))
+		return;
+	glViewport(x, y, width, height);
+	viewport_[0] = x;
+	viewport_[1] = y;
+	viewport_[2] = width;
+	viewport_[3] = height;
+	viewport_known_ = true;
+}
+
+void GLState::ClearColor(float red, float green, float blue, float alpha)
+{
+	bool same = clear_color_known_ && clear_color_[0] == red && clear_color_[1] == green
+		&& clear_color_[2] == blue && clear_color_[3] == alpha;
+	if (!Changed(kCallClearColor, !same))
+		return;
+	glClearColor(red, green, blue, alpha);
+	clear_color_[0] = red;
+	clear_color_[1] = green;
+	clear_color_[2] = blue;
+	clear_color_[3] = alpha;
+	clear_color_known_ = true;
+}
+
+void GLState::Enable(GLenum capability)
+{
+	SetCapability(capability, true);
+}
+
+void GLState::Disable(GLenum capability)
+{
+	SetCapability(capability, false);
+}
+
+void GLState::SetCapability(GLenum capability, bool enabled)
+{
+	int index = CapabilityIndex(capability);
+	if (!Changed(kCallCapability, index < 0 || capabilities_[index] != (enabled ? 1 : 0)))
+		return;
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+	if (index >= 0)
+		capabilities_[index] = enabled ? 1 : 0;
+}
+
+void GLState::BlendFunc(GLenum source, GLenum destination)
+{
+	if (!Changed(kCallBlendFunc, blend_source_ != source || blend_destination_ != destination))
+		return;
+	glBlendFunc(source, destination);
+	blend_source_ = source;
+	blend_destination_ = destination;
+}
+
+void GLState::DepthFunc(GLenum func)
+{
+	if (!Changed(kCallDepthFunc, depth_func_ != func))
+		return;
+	glDepthFunc(func);
+	depth_func_ = func;
+}
+
+void GLState::DepthMask(bool write)
+{
+	if (!Changed(kCallDepthMask, depth_mask_ != (write ? 1 : 0)))
+		return;
+	glDepthMask(write ? GL_TRUE : GL_FALSE);
+	depth_mask_ = write ? 1 : 0;
+}
+
+size_t GLState::TotalIssued() const
+{
+	size_t total = 0;
+	for (int c = 0; c < kCallCount; c++)
+		total += issued_[c];
+	return total;
+}
+
+size_t GLState::TotalElided() const
+{
+	size_t total = 0;
+	for (int c = 0; c < kCallCount; c++)
+		total += elided_[c];
+	return total;
+}
+
+void GLState::ResetCounters()
+{
+	for (int c = 0; c < kCallCount; c++)
+		issued_[c] = elided_[c] = 0;
+}
+
+void GLState::PrintCounters(std::ostream& out) const
+{
+	out << "GL state calls: " << TotalIssued() << " issued, " << TotalElided() << " elided" << std::endl;
+	for (int c = 0; c < kCallCount; c++)
+	{
+		if (issued_[c] + elided_[c] > 0)
+			out << "  " << kCallNames[c] << ": " << issued_[c] << " issued, " << elided_[c] << " elided" << std::endl;
+	}
+}
+
+int GLState::TextureTargetIndex(GLenum target)
+{
+	for (int i = 0; i < kTextureTargetCount; i++)
+	{
+		if (kTextureTargets[i] == target)
+			return i;
+	}
+	return -1;
+}
+
+int GLState::BufferTargetIndex(GLenum target)
+{
+	for (int i = 0; i < kBufferTargetCount; i++)
+	{
+		if (kBufferTargets[i] == target)
+			return i;
+	}
+	return -1;
+}
+
+int GLState::CapabilityIndex(GLenum capability)
+{
+	for (int i = 0; i < kCapabilityCount; i++)
+	{
+		if (kCapabilities[i] == capability)
+			return i;
+	}
+	return -1;
+}
\ No newline at end of file
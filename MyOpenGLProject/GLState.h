@@ -0,0 +1,101 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <GL/glew.h> // include glew to get all the required OpenGL headers
+
+#include <iostream>
+
+// Shadows the GL binding and fixed-function state and drops calls that would not change it.
+// Everything starts out unknown, so the first call of each kind always reaches the driver.
+// Code that changes state behind the cache's back (or deletes a bound object, which unbinds it)
+// must call Invalidate() afterwards.
+class GLState
+{
+public:
+	// call kinds the counters are kept for
+	enum Call
+	{
+		kCallProgram,
+		kCallVertexArray,
+		kCallActiveTexture,
+		kCallTexture,
+		kCallBuffer,
+		kCallFramebuffer,
+		kCallViewport,
+		kCallClearColor,
+		kCallCapability,
+		kCallBlendFunc,
+		kCallDepthFunc,
+		kCallDepthMask,
+		kCallCount
+	};
+
+	// texture units and buffer targets beyond these are passed straight through
+	static const int kMaxTextureUnits = 32;
+	static const int kTextureTargetCount = 4;
+	static const int kBufferTargetCount = 8;
+	static const int kCapabilityCount = 5;
+
+	GLState();
+
+	// forget everything, the next call of each kind goes to the driver again
+	void Invalidate();
+
+	void UseProgram(unsigned int program);
+	// the element array binding is part of the VAO, changing the VAO forgets it
+	void BindVertexArray(unsigned int vao);
+	void ActiveTexture(int unit);
+	// bind on the currently active unit
+	void BindTexture(GLenum target, unsigned int texture);
+	// bind on the given unit, only switching the active unit if the binding changes
+	void BindTexture(int unit, GLenum target, unsigned int texture);
+	void BindBuffer(GLenum target, unsigned int buffer);
+	void BindFramebuffer(unsigned int framebuffer);
+	void Viewport(int x, int y, int width, int height);
+	void ClearColor(float red, float green, float blue, float alpha);
+	// GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_SCISSOR_TEST and GL_STENCIL_TEST are cached
+	void Enable(GLenum capability);
+	void Disable(GLenum capability);
+	void BlendFunc(GLenum source, GLenum destination);
+	void DepthFunc(GLenum func);
+	void DepthMask(bool write);
+
+	size_t IssuedCount(Call call) const { return issued_[call]; }
+	size_t ElidedCount(Call call) const { return elided_[call]; }
+	size_t TotalIssued() const;
+	size_t TotalElided() const;
+	void ResetCounters();
+	void PrintCounters(std::ostream& out) const;
+
+private:
+	// returns true if the call has to be issued and updates the counters
+	bool Changed(Call call, bool changed);
+	void SetCapability(GLenum capability, bool enabled);
+	static int TextureTargetIndex(GLenum target);
+	static int BufferTargetIndex(GLenum target);
+	static int CapabilityIndex(GLenum capability);
+
+	// unknown bindings hold kUnknown, unknown tri-state values hold -1
+	static const unsigned int kUnknown = 0xFFFFFFFFu;
+
+	unsigned int program_;
+	unsigned int vertex_array_;
+	int active_unit_;
+	unsigned int textures_[kMaxTextureUnits][kTextureTargetCount];
+	unsigned int buffers_[kBufferTargetCount];
+	unsigned int framebuffer_;
+	int viewport_[4];
+	bool viewport_known_;
+	float clear_color_[4];
+	bool clear_color_known_;
+	int capabilities_[kCapabilityCount];
+	GLenum blend_source_;
+	GLenum blend_destination_;
+	GLenum depth_func_;
+	int depth_mask_;
+
+	size_t issued_[kCallCount];
+	size_t elided_[kCallCount];
+};
+
+#endif // !GL_STATE_H
\ No newline at end of file
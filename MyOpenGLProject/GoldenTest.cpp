@@ -0,0 +1,134 @@
+#include "GoldenTest.h"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+// the line of a timings file that holds its tolerance instead of a frame time
+static const char* kSlowdownEntry = "allowed_slowdown";
+
+const double GoldenTest::kAllowedSlowdown = 1.5;
+
+GoldenTest::GoldenTest(const char* directory, bool update, const char* machine_class)
+	: directory_(directory), update_(update), failures_(0), checks_(0), allowed_slowdown_(kAllowedSlowdown)
+{
+	if (!machine_class || !*machine_class)
+		return;
+	timings_file_ = std::string("timings.") + machine_class + ".txt";
+	// a missing file is not an error, it just has no timings to check yet
+	std::ifstream file(PathOf(timings_file_).c_str());
+	std::string name;
+	double frame_ms;
+	while (file >> name >> frame_ms)
+	{
+		if (name == kSlowdownEntry)
+			allowed_slowdown_ = frame_ms;
+		else
+			timings_[name] = frame_ms;
+	}
+}
+
+std::string GoldenTest::PathOf(const std::string& file) const
+{
+	if (directory_.empty())
+		return file;
+	char last = directory_[directory_.size() - 1];
+	return last == '/' || last == '\\' ? directory_ + file : directory_ + "/" + file;
+}
+
+bool GoldenTest::CheckImage(const char* name, const unsigned char* rgba, int width, int height,
+	const ImageDiffSettings& settings)
+{
+	checks_++;
+	std::string reference_path = PathOf(std::string(name) + ".ppm");
+	if (update_)
+	{
+		bool written = ImageDiff::WritePpm(reference_path.c_str(), rgba, width, height);
+		std::cout << "  " << name << ": " << (written ? "updated " : "FAILED to write ") << reference_path << std::endl;
+		failures_ += written ? 0 : 1;
+		return written;
+	}
+
+	std::vector<unsigned char> reference;
+	int reference_width = 0, reference_height = 0;
+	bool passed = false;
+	if (!ImageDiff::ReadPpm(reference_path.c_str(), reference, reference_width, reference_height))
+	{
+		std::cout << "  " << name << ": FAILED, no reference " << reference_path << " (create it with --update-golden)" << std::endl;
+	}
+	else if (reference_width != width || reference_height != height)
+	{
+		std::cout << "  " << name << ": FAILED, " << width << "x" << height << " image, reference is "
+			<< reference_width << "x" << reference_height << std::endl;
+	}
+	else
+	{
+		ImageDiffResult result = ImageDiff::Compare(rgba, reference.data(), width, height, settings);
+		passed = result.passed;
+		std::cout << "  " << name << ": " << (passed ? "OK" : "FAILED") << ", " << result.differing_pixels
+			<< " pixels beyond tolerance, max difference " << result.max_difference << ", SSIM " << result.ssim << std::endl;
+		if (!passed)
+		{
+			std::vector<unsigned char> diff;
+			ImageDiff::MakeDiffImage(rgba, reference.data(), width, height, settings.tolerance, diff);
+			ImageDiff::WritePpm(PathOf(std::string(name) + ".diff.ppm").c_str(), diff.data(), width, height);
+		}
+	}
+	if (!passed)
+	{
+		ImageDiff::WritePpm(PathOf(std::string(name) + ".actual.ppm").c_str(), rgba, width, height);
+		failures_++;
+	}
+	return passed;
+}
+
+bool GoldenTest::CheckTiming(const char* name, double frame_ms)
+{
+	// a time recorded on one machine says nothing about another, so nothing is checked without a class
+	if (timings_file_.empty())
+	{
+		std::cout << "  " << name << ": " << frame_ms << " ms/frame, not checked without a machine class (--golden-machine)" << std::endl;
+		return true;
+	}
+	if (update_)
+	{
+		checks_++;
+		timings_[name] = frame_ms;
+		std::cout << "  " << name << ": recorded " << frame_ms << " ms/frame in " << timings_file_ << std::endl;
+		return true;
+	}
+
+	std::map<std::string, double>::const_iterator recorded = timings_.find(name);
+	if (recorded == timings_.end())
+	{
+		std::cout << "  " << name << ": " << frame_ms << " ms/frame, not checked, no timing in " << timings_file_
+			<< " (record it with --update-golden)" << std::endl;
+		return true;
+	}
+	checks_++;
+	bool passed = frame_ms <= recorded->second * allowed_slowdown_;
+	std::cout << "  " << name << ": " << (passed ? "OK" : "FAILED") << ", " << frame_ms << " ms/frame (recorded "
+		<< recorded->second << " in " << timings_file_ << ", allowed " << allowed_slowdown_ << "x)" << std::endl;
+	failures_ += passed ? 0 : 1;
+	return passed;
+}
+
+bool GoldenTest::Finish()
+{
+	if (update_ && !timings_file_.empty())
+	{
+		// rewritten as a whole, timings of scenes that didn't run this time and the tolerance are kept
+		std::string path = PathOf(timings_file_);
+		std::ofstream file(path.c_str(), std::ios::trunc);
+		file << kSlowdownEntry << " " << allowed_slowdown_ << "\n";
+		for (std::map<std::string, double>::const_iterator i = timings_.begin(); i != timings_.end(); ++i)
+			file << i->first << " " << i->second << "\n";
+		if (!file)
+		{
+			std::cout << "ERROR::GOLDEN_TEST::FILE_NOT_SUCCESSFULLY_WRITTEN " << path << std::endl;
+			failures_++;
+		}
+	}
+	std::cout << "Golden tests: " << checks_ - failures_ << " of " << checks_ << " passed" << std::endl;
+	return failures_ == 0;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef GOLDEN_TEST_H
+#define GOLDEN_TEST_H
+
+#include <map>
+#include <string>
+#include "ImageDiff.h"
+
+// Regression checks against a directory of reference images (<name>.ppm) and recorded frame
+// times. Frame times depend on the machine, so they are only checked for a named machine class,
+// against timings.<class>.txt: one "<name> <ms>" per line plus an optional "allowed_slowdown <factor>"
+// line. Without a class only the images are checked, and so are timings with no recorded entry.
+// In update mode the references are rewritten from the current results instead, which is how
+// they are created in the first place.
+class GoldenTest
+{
+public:
+	// a frame may take this much longer than its recorded time before it counts as a regression,
+	// unless the timings file sets its own factor
+	static const double kAllowedSlowdown;
+
+	// machine_class NULL or empty skips the timing checks
+	GoldenTest(const char* directory, bool update, const char* machine_class = NULL);
+
+	// on failure the image is written next to the reference as <name>.actual.ppm, with a
+	// <name>.diff.ppm marking the pixels beyond the tolerance
+	bool CheckImage(const char* name, const unsigned char* rgba, int width, int height,
+		const ImageDiffSettings& settings = ImageDiff::DefaultSettings());
+	// true without a machine class or a recorded timing, the time is only printed then
+	bool CheckTiming(const char* name, double frame_ms);
+	// writes the timings in update mode, prints the summary. false if anything failed
+	bool Finish();
+	int FailureCount() const { return failures_; }
+	const char* Directory() const { return directory_.c_str(); }
+
+private:
+	std::string PathOf(const std::string& file) const;
+
+	std::string directory_;
+	// empty without a machine class
+	std::string timings_file_;
+	bool update_;
+	int failures_;
+	int checks_;
+	std::map<std::string, double> timings_;
+	double allowed_slowdown_;
+};
+
+#endif // !GOLDEN_TEST_H
\ No newline at end of file
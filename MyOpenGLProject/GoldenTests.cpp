@@ -0,0 +1,87 @@
+#include "Tools.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "GoldenTest.h"
+#include "Scenes.h"
+#include "SoftwareRasterizer.h"
+#include "ThreadPool.h"
+
+int RunSoftwareGoldenTests(GoldenTest& golden)
+{
+	// rendered at the window size, like the GL frames read back in --headless
+	const int kFrames = 15;
+	const int kFloorQuads = 2000;
+	MipLevel image1, image2;
+	std::vector<MipLevel> mips1, mips2;
+	TextureSampler texture1, texture2;
+	LoadSoftwareTexture("container.jpg", image1, mips1, texture1);
+	LoadSoftwareTexture("container2.jpg", image2, mips2, texture2);
+	std::vector<float> floor_vertices;
+	std::vector<unsigned int> floor_indices;
+	BuildFloorScene(kFloorQuads, floor_vertices, floor_indices);
+	Matrix4 floor_view_projection = FloorViewProjection(kWindowWidth, kWindowHeight);
+
+	ThreadPool pool;
+	SoftwareRasterizer rasterizer(kWindowWidth, kWindowHeight, &pool);
+	std::cout << "Golden tests in " << golden.Directory() << ", software rasterizer, " << kWindowWidth << "x" << kWindowHeight
+		<< ", " << pool.ThreadCount() << " threads" << std::endl;
+	const char* kSceneNames[2] = { "container", "floor" };
+	for (int scene = 0; scene < 2; scene++)
+	{
+		// one untimed frame to warm up the caches and the workers, then the median frame, which
+		// a single descheduled frame doesn't move
+		std::vector<double> frame_ms(kFrames);
+		for (int frame = -1; frame < kFrames; frame++)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			rasterizer.Clear(0.2f, 0.3f, 0.3f, 1.0f);
+			if (scene == 0)
+				rasterizer.Draw(kRectangleVertices, 4, kRectangleIndices, 6, texture1, texture2, Matrix4::Identity());
+			else
+				rasterizer.Draw(floor_vertices.data(), floor_vertices.size() / 8, floor_indices.data(), floor_indices.size(),
+					texture1, texture2, floor_view_projection);
+			if (frame >= 0)
+				frame_ms[frame] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		}
+		std::nth_element(frame_ms.begin(), frame_ms.begin() + kFrames / 2, frame_ms.end());
+		golden.CheckImage(kSceneNames[scene], rasterizer.Pixels(), kWindowWidth, kWindowHeight);
+		golden.CheckTiming((std::string(kSceneNames[scene]) + ".software").c_str(), frame_ms[kFrames / 2]);
+	}
+	return golden.Finish() ? 0 : -1;
+}
+
+// --headless where no OpenGL context can be created (no display, no driver, a CI machine): there is
+// no offscreen context in the dependencies, so the container scene is rendered on the CPU instead
+int RenderHeadlessSoftware(const Options& options)
+{
+	std::cout << "No OpenGL context, rendering the headless frames with the software rasterizer" << std::endl;
+	if (options.sprite_count > 0 || options.batch_draws > 0 || options.mesh_path || options.meshlet_segments > 0)
+		std::cout << "Only the container scene is rendered, sprites, batches, meshes and meshlets need GL" << std::endl;
+	if (options.golden_path)
+	{
+		GoldenTest golden(options.golden_path, options.update_golden, options.golden_machine);
+		return RunSoftwareGoldenTests(golden);
+	}
+
+	MipLevel image1, image2;
+	std::vector<MipLevel> mips1, mips2;
+	TextureSampler texture1, texture2;
+	LoadSoftwareTexture("container.jpg", image1, mips1, texture1);
+	LoadSoftwareTexture("container2.jpg", image2, mips2, texture2);
+	ThreadPool pool;
+	SoftwareRasterizer rasterizer(kWindowWidth, kWindowHeight, &pool);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < options.frame_count; frame++)
+	{
+		rasterizer.Clear(0.2f, 0.3f, 0.3f, 1.0f);
+		rasterizer.Draw(kRectangleVertices, 4, kRectangleIndices, 6, texture1, texture2, Matrix4::Identity());
+	}
+	double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "Rendered " << options.frame_count << " frames in " << elapsed_ms << " ms ("
+		<< elapsed_ms / std::max(options.frame_count, 1) << " ms/frame)" << std::endl;
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include "ImageDecoder.h"
+
+#include <fstream>
+#include <vector>
+#include "JpegDecoder.h"
+#include "stb_image.h"
+
+unsigned char* ImageDecoder::Load(const unsigned char* data, size_t size, int& width, int& height, int& channels,
+	int desired_channels, bool flip_vertically, ThreadPool* pool)
+{
+	JpegDecoder jpeg;
+	if (jpeg.ReadHeader(data, size))
+	{
+		unsigned char* pixels = jpeg.Decode(desired_channels, flip_vertically, pool);
+		if (pixels)
+		{
+			width = jpeg.Width();
+			height = jpeg.Height();
+			channels = jpeg.Components();
+			return pixels;
+		}
+	}
+	// stb_image gets the last word on anything unusual, including corrupt files
+	stbi_set_flip_vertically_on_load_thread(flip_vertically);
+	return stbi_load_from_memory(data, (int)size, &width, &height, &channels, desired_channels);
+}
+
+unsigned char* ImageDecoder::LoadFile(const char* path, int& width, int& height, int& channels,
+	int desired_channels, bool flip_vertically, ThreadPool* pool)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		return NULL;
+	std::vector<unsigned char> contents((size_t)file.tellg());
+	file.seekg(0);
+	if (contents.empty() || !file.read((char*)contents.data(), contents.size()))
+		return NULL;
+	return Load(contents.data(), contents.size(), width, height, channels, desired_channels, flip_vertically, pool);
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef IMAGE_DECODER_H
+#define IMAGE_DECODER_H
+
+#include <cstddef>
+#include "ThreadPool.h"
+
+// Drop-in for stbi_load: baseline JPEG files go through JpegDecoder on the pool, everything
+// JpegDecoder turns down (progressive JPEG, PNG and the other formats) through stb_image, with
+// identical pixels either way. PNG stays on stb_image because its filters chain every row to
+// the one above and the zlib stream has no points to split it at.
+class ImageDecoder
+{
+public:
+	// same arguments and result as stbi_load_from_memory, with the flip passed explicitly
+	// instead of stb_image's per thread flag. free the pixels with stbi_image_free
+	static unsigned char* Load(const unsigned char* data, size_t size, int& width, int& height, int& channels,
+		int desired_channels, bool flip_vertically, ThreadPool* pool);
+	static unsigned char* LoadFile(const char* path, int& width, int& height, int& channels,
+		int desired_channels, bool flip_vertically, ThreadPool* pool);
+};
+
+#endif // !IMAGE_DECODER_H
\ No newline at end of file
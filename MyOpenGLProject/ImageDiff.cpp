@@ -0,0 +1,204 @@
+#include "ImageDiff.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// SSIM window size and the step between windows
+static const int kSsimWindow = 8;
+static const int kSsimStep = 4;
+
+ImageDiffSettings ImageDiff::DefaultSettings()
+{
+	// GPUs filter with fewer bits of weight precision than the CPU sampler, which moves
+	// bilinear results by a few levels
+	ImageDiffSettings settings;
+	settings.tolerance = 8;
+	settings.max_differing_fraction = 0.001;
+	settings.min_ssim = 0.98;
+	return settings;
+}
+
+ImageDiffResult ImageDiff::Compare(const unsigned char* rgba, const unsigned char* reference, int width, int height,
+	const ImageDiffSettings& settings)
+{
+	ImageDiffResult result;
+	result.differing_pixels = 0;
+	result.max_difference = 0;
+	size_t pixel_count = (size_t)width * height;
+	for (size_t i = 0; i < pixel_count; i++)
+	{
+		int difference = 0;
+		for (int c = 0; c < 3; c++)
+			difference = std::max(difference, std::abs(rgba[i * 4 + c] - reference[i * 4 + c]));
+		result.max_difference = std::max(result.max_difference, difference);
+		result.differing_pixels += difference > settings.tolerance ? 1 : 0;
+	}
+	result.ssim = Ssim(rgba, reference, width, height);
+	result.passed = result.differing_pixels <= settings.max_differing_fraction * pixel_count && result.ssim >= settings.min_ssim;
+	return result;
+}
+
+void ImageDiff::MakeDiffImage(const unsigned char* rgba, const unsigned char* reference, int width, int height,
+	int tolerance, std::vector<unsigned char>& diff)
+{
+	size_t pixel_count = (size_t)width * height;
+	diff.resize(pixel_count * 4);
+	for (size_t i = 0; i < pixel_count; i++)
+	{
+		int difference = 0;
+		for (int c = 0; c < 3; c++)
+			difference = std::max(difference, std::abs(rgba[i * 4 + c] - reference[i * 4 + c]));
+		if (difference > tolerance)
+		{
+			// brighter for larger differences, never too dark to spot
+			diff[i * 4] = (unsigned char)std::min(255, 128 + difference);
+			diff[i * 4 + 1] = 0;
+			diff[i * 4 + 2] = 0;
+		}
+		else
+		{
+			for (int c = 0; c < 3; c++)
+				diff[i * 4 + c] = reference[i * 4 + c] / 4;
+		}
+		diff[i * 4 + 3] = 255;
+	}
+}
+
+static std::vector<float> Luma(const unsigned char* rgba, size_t pixel_count)
+{
+	std::vector<float> luma(pixel_count);
+	for (size_t i = 0; i < pixel_count; i++)
+		luma[i] = 0.299f * rgba[i * 4] + 0.587f * rgba[i * 4 + 1] + 0.114f * rgba[i * 4 + 2];
+	return luma;
+}
+
+double ImageDiff::Ssim(const unsigned char* rgba, const unsigned char* reference, int width, int height)
+{
+	if (width <= 0 || height <= 0)
+		return 1.0;
+	std::vector<float> a = Luma(rgba, (size_t)width * height);
+	std::vector<float> b = Luma(reference, (size_t)width * height);
+	// stabilizing constants for 8-bit values (Wang et al.)
+	const double kC1 = (0.01 * 255.0) * (0.01 * 255.0);
+	const double kC2 = (0.03 * 255.0) * (0.03 * 255.0);
+	int window_w = std::min(kSsimWindow, width);
+	int window_h = std::min(kSsimWindow, height);
+
+	double total = 0.0;
+	size_t windows = 0;
+	for (int y = 0; y + window_h <= height; y += kSsimStep)
+	{
+		for (int x = 0; x + window_w <= width; x += kSsimStep)
+		{
+			double sum_a = 0.0, sum_b = 0.0, sum_aa = 0.0, sum_bb = 0.0, sum_ab = 0.0;
+			for (int wy = 0; wy < window_h; wy++)
+			{
+				size_t row = (size_t)(y + wy) * width + x;
+				for (int wx = 0; wx < window_w; wx++)
+				{
+					double va = a[row + wx], vb = b[row + wx];
+					sum_a += va;
+					sum_b += vb;
+					sum_aa += va * va;
+					sum_bb += vb * vb;
+					sum_ab += va * vb;
+				}
+			}
+			double n = (double)window_w * window_h;
+			double mean_a = sum_a / n, mean_b = sum_b / n;
+			double variance_a = sum_aa / n - mean_a * mean_a;
+			double variance_b = sum_bb / n - mean_b * mean_b;
+			double covariance = sum_ab / n - mean_a * mean_b;
+			total += ((2.0 * mean_a * mean_b + kC1) * (2.0 * covariance + kC2))
+				/ ((mean_a * mean_a + mean_b * mean_b + kC1) * (variance_a + variance_b + kC2));
+			windows++;
+		}
+	}
+	return windows > 0 ? total / windows : 1.0;
+}
+
+bool ImageDiff::WritePpm(const char* path, const unsigned char* rgba, int width, int height)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "ERROR::IMAGE_DIFF::FILE_NOT_SUCCESSFULLY_WRITTEN " << path << std::endl;
+		return false;
+	}
+	file << "P6\n" << width << " " << height << "\n255\n";
+	std::vector<unsigned char> row((size_t)width * 3);
+	for (int y = height - 1; y >= 0; y--)
+	{
+		const unsigned char* source = rgba + (size_t)y * width * 4;
+		for (int x = 0; x < width; x++)
+		{
+			for (int c = 0; c < 3; c++)
+				row[x * 3 + c] = source[x * 4 + c];
+		}
+		file.write((const char*)row.data(), row.size());
+	}
+	return (bool)file;
+}
+
+// next number of a PPM header, skipping whitespace and comments
+static bool ReadHeaderNumber(std::istream& file, int& value)
+{
+	for (;;)
+	{
+		int next = file.peek();
+		if (next == '#')
+		{
+			std::string comment;
+			std::getline(file, comment);
+		}
+		else if (next == ' ' || next == '\t' || next == '\r' || next == '\n')
+		{
+			file.get();
+		}
+		else
+		{
+			break;
+		}
+	}
+	return (bool)(file >> value);
+}
+
+bool ImageDiff::ReadPpm(const char* path, std::vector<unsigned char>& rgba, int& width, int& height)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+	char magic[2] = { 0, 0 };
+	file.read(magic, 2);
+	int max_value = 0;
+	if (magic[0] != 'P' || magic[1] != '6' || !ReadHeaderNumber(file, width) || !ReadHeaderNumber(file, height)
+		|| !ReadHeaderNumber(file, max_value) || max_value != 255 || width <= 0 || height <= 0)
+	{
+		std::cout << "ERROR::IMAGE_DIFF::UNSUPPORTED_PPM " << path << std::endl;
+		return false;
+	}
+	// exactly one whitespace byte separates the header from the pixels
+	file.get();
+
+	rgba.resize((size_t)width * height * 4);
+	std::vector<unsigned char> row((size_t)width * 3);
+	for (int y = height - 1; y >= 0; y--)
+	{
+		if (!file.read((char*)row.data(), row.size()))
+		{
+			std::cout << "ERROR::IMAGE_DIFF::TRUNCATED_PPM " << path << std::endl;
+			return false;
+		}
+		unsigned char* destination = &rgba[(size_t)y * width * 4];
+		for (int x = 0; x < width; x++)
+		{
+			for (int c = 0; c < 3; c++)
+				destination[x * 4 + c] = row[x * 3 + c];
+			destination[x * 4 + 3] = 255;
+		}
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#ifndef IMAGE_DIFF_H
+#define IMAGE_DIFF_H
+
+#include <cstddef>
+#include <vector>
+
+// how far an image may be from its reference
+struct ImageDiffSettings
+{
+	// largest difference of any channel for a pixel to still count as equal
+	int tolerance;
+	// share of the pixels allowed beyond the tolerance
+	double max_differing_fraction;
+	// lowest acceptable mean structural similarity (SSIM) of the luma, 1 for identical images
+	double min_ssim;
+};
+
+struct ImageDiffResult
+{
+	size_t differing_pixels;
+	int max_difference;
+	double ssim;
+	bool passed;
+};
+
+// Compares rendered images with reference images. The per-pixel test catches localized breakage
+// (a missing triangle, a wrong texel), SSIM catches changes spread thinly over the whole image
+// (blur, a shifted color balance) that each pixel alone would still tolerate. Images are RGBA8
+// with row 0 at the bottom, as glReadPixels and the software rasterizer produce them; alpha is
+// ignored, references are binary PPM files stored top row first.
+class ImageDiff
+{
+public:
+	// tolerant enough for GPU and CPU rasterizers to share one reference
+	static ImageDiffSettings DefaultSettings();
+
+	static ImageDiffResult Compare(const unsigned char* rgba, const unsigned char* reference, int width, int height,
+		const ImageDiffSettings& settings);
+	// red where pixels are beyond the tolerance, the dimmed reference elsewhere
+	static void MakeDiffImage(const unsigned char* rgba, const unsigned char* reference, int width, int height,
+		int tolerance, std::vector<unsigned char>& diff);
+	// mean SSIM of the luma over 8x8 windows
+	static double Ssim(const unsigned char* rgba, const unsigned char* reference, int width, int height);
+
+	static bool WritePpm(const char* path, const unsigned char* rgba, int width, int height);
+	static bool ReadPpm(const char* path, std::vector<unsigned char>& rgba, int& width, int& height);
+};
+
+#endif // !IMAGE_DIFF_H
\ No newline at end of file
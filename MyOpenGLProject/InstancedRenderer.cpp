@@ -0,0 +1,155 @@
+#include "InstancedRenderer.h"
+
+#include <cstring>
+#include <iostream>
+#include "ImageDecoder.h"
+#include "stb_image.h"
+
+InstancedRenderer::InstancedRenderer(GLState& state, const VertexFormat& format, unsigned int vertex_buffer, unsigned int index_buffer, int index_count,
+	size_t index_offset, int base_vertex, size_t max_instances)
+	: instance_stream_(state, GL_ARRAY_BUFFER, max_instances * sizeof(QuadInstance)), index_count_(index_count),
+	index_offset_(index_offset), base_vertex_(base_vertex), max_instances_(max_instances)
+{
+	instances_.reserve(max_instances);
+
+	glGenVertexArrays(1, &vao_);
+	state.BindVertexArray(vao_);
+
+	state.BindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+	state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+	format.Apply();
+
+	// per-instance attributes advance once per instance instead of once per vertex
+	state.BindBuffer(GL_ARRAY_BUFFER, instance_stream_.Buffer());
+	InstanceFormat().Apply();
+	glVertexAttribDivisor(3, 1);
+	glVertexAttribDivisor(4, 1);
+}
+
+InstancedRenderer::~InstancedRenderer()
+{
+	glDeleteVertexArrays(1, &vao_);
+}
+
+void InstancedRenderer::Clear()
+{
+	instances_.clear();
+}
+
+bool InstancedRenderer::Add(const QuadInstance& instance)
+{
+	if (instances_.size() >= max_instances_)
+		return false;
+	instances_.push_back(instance);
+	return true;
+}
+
+void InstancedRenderer::Draw(GLState& state, unsigned int program, unsigned int texture_array)
+{
+	if (instances_.empty())
+		return;
+	size_t size = instances_.size() * sizeof(QuadInstance);
+	size_t offset;
+	void* mapped = instance_stream_.Map(size, sizeof(float), offset);
+	if (!mapped)
+		return;
+	std::memcpy(mapped, instances_.data(), size);
+	instance_stream_.Unmap(state);
+
+	state.UseProgram(program);
+	state.BindTexture(0, GL_TEXTURE_2D_ARRAY, texture_array);
+	state.BindVertexArray(vao_);
+	// the instances sit somewhere else in the ring every frame
+	state.BindBuffer(GL_ARRAY_BUFFER, instance_stream_.Buffer());
+	InstanceFormat().Apply(offset);
+	glDrawElementsInstancedBaseVertex(GL_TRIANGLES, index_count_, GL_UNSIGNED_INT, (void*)index_offset_,
+		(GLsizei)instances_.size(), base_vertex_);
+	instance_stream_.EndFrame();
+}
+
+const VertexFormat& InstancedRenderer::InstanceFormat()
+{
+	static const VertexFormat format = VertexFormat().Add(3, 4, kVertexFloat).Add(4, 1, kVertexFloat);
+	return format;
+}
+
+unsigned int InstancedRenderer::CreateIdentityInstance(GLState& state)
+{
+	static const QuadInstance kIdentity = { 0.0f, 0.0f, 1.0f, 1.0f, 0.0f };
+	unsigned int buffer;
+	glGenBuffers(1, &buffer);
+	state.BindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(kIdentity), &kIdentity, GL_STATIC_DRAW);
+	return buffer;
+}
+
+void InstancedRenderer::ApplyIdentityInstance(GLState& state, unsigned int identity_instance)
+{
+	state.BindBuffer(GL_ARRAY_BUFFER, identity_instance);
+	InstanceFormat().Apply();
+	glVertexAttribDivisor(3, 1);
+	glVertexAttribDivisor(4, 1);
+}
+
+unsigned int InstancedRenderer::LoadTextureArray(GLState& state, const AssetPack* pack, const char* const* paths, int count,
+	int width, int height, bool flip_vertically)
+{
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	state.BindTexture(0, GL_TEXTURE_2D_ARRAY, texture);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, count, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	std::vector<unsigned char> layer((size_t)width * height * 4);
+	for (int l = 0; l < count; l++)
+	{
+		int image_width, image_height, channels;
+		unsigned char* data = NULL;
+		if (pack && pack->IsOpen())
+		{
+			AssetSpan source = pack->Find(paths[l]);
+			if (!source.IsEmpty())
+				data = ImageDecoder::Load(source.data, source.size, image_width, image_height, channels, 4, flip_vertically, NULL);
+		}
+		else
+		{
+			data = ImageDecoder::LoadFile(paths[l], image_width, image_height, channels, 4, flip_vertically, NULL);
+		}
+		for (size_t p = 0; p < layer.size(); p += 4)
+		{
+			// magenta marks a layer that could not be loaded
+			layer[p] = 255;
+			layer[p + 1] = 0;
+			layer[p + 2] = 255;
+			layer[p + 3] = 255;
+		}
+		if (data)
+		{
+			for (int y = 0; y < height; y++)
+			{
+				const unsigned char* row = data + (size_t)(y * image_height / height) * image_width * 4;
+				for (int x = 0; x < width; x++)
+				{
+					const unsigned char* texel = row + (size_t)(x * image_width / width) * 4;
+					unsigned char* out = &layer[((size_t)y * width + x) * 4];
+					out[0] = texel[0];
+					out[1] = texel[1];
+					out[2] = texel[2];
+					out[3] = texel[3];
+				}
+			}
+			stbi_image_free(data);
+		}
+		else
+		{
+			std::cout << "Failed to load texture " << paths[l] << std::endl;
+		}
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, l, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, layer.data());
+	}
+
+	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	return texture;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#ifndef INSTANCED_RENDERER_H
+#define INSTANCED_RENDERER_H
+
+#include <GL/glew.h> // include glew to get all the required OpenGL headers
+
+#include <vector>
+#include "AssetPack.h"
+#include "GLState.h"
+#include "StreamBuffer.h"
+#include "VertexFormat.h"
+
+// per-instance data, read by shader.vert at locations 3 (offset and scale) and 4 (layer)
+struct QuadInstance
+{
+	float offset_x;
+	float offset_y;
+	float scale_x;
+	float scale_y;
+	// layer of the sprite texture array
+	float layer;
+};
+
+// Draws many copies of one indexed mesh with a single glDrawElementsInstanced call.
+// The mesh can be in any vertex format, the instances are written into the next region of a
+// stream buffer every draw.
+class InstancedRenderer
+{
+public:
+	// the VAO is set up through the state cache, which ends up with it bound
+	// the mesh is index_count indices at index_offset bytes into the index buffer, offset by base_vertex
+	InstancedRenderer(GLState& state, const VertexFormat& format, unsigned int vertex_buffer, unsigned int index_buffer, int index_count,
+		size_t index_offset, int base_vertex, size_t max_instances);
+	~InstancedRenderer();
+	InstancedRenderer(const InstancedRenderer&) = delete;
+	InstancedRenderer& operator=(const InstancedRenderer&) = delete;
+
+	void Clear();
+	// returns false once max_instances has been reached
+	bool Add(const QuadInstance& instance);
+	size_t InstanceCount() const { return instances_.size(); }
+	// the program must read the instance attributes and sample a sampler2DArray on unit 0.
+	// meant to be called once per frame, every call uses up one region of the stream buffer
+	void Draw(GLState& state, unsigned int program, unsigned int texture_array);
+
+	// layout of QuadInstance
+	static const VertexFormat& InstanceFormat();
+	// a buffer holding one QuadInstance that leaves the mesh as it is: no offset, unit scale, layer 0
+	static unsigned int CreateIdentityInstance(GLState& state);
+	// point the instance attributes of the bound VAO at that buffer, advancing once per instance.
+	// meshes drawn without instancing then read the identity instead of the attributes' current
+	// values, which are undefined after any draw that had their arrays enabled
+	static void ApplyIdentityInstance(GLState& state, unsigned int identity_instance);
+
+	// decode images into the layers of a 2D array texture, scaling any of a different size
+	// (nearest neighbour) to width x height. layers that fail to load stay magenta.
+	// with an open pack the images are read out of it, otherwise from loose files.
+	// the array ends up bound on unit 0
+	static unsigned int LoadTextureArray(GLState& state, const AssetPack* pack, const char* const* paths, int count,
+		int width, int height, bool flip_vertically = true);
+
+private:
+	unsigned int vao_;
+	StreamBuffer instance_stream_;
+	int index_count_;
+	size_t index_offset_;
+	int base_vertex_;
+	size_t max_instances_;
+	std::vector<QuadInstance> instances_;
+};
+
+#endif // !INSTANCED_RENDERER_H
\ No newline at end of file
@@ -0,0 +1,1187 @@
+#include "JpegDecoder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include "CpuFeatures.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JPEG_DECODER_SSE2
+// the AVX2 color conversion is built in JpegDecoderAvx2.cpp and picked at runtime
+#define JPEG_DECODER_AVX2
+#include <emmintrin.h>
+#include "JpegDecoderAvx2.h"
+#endif
+
+// Huffman codes up to this many bits are decoded with one table lookup
+static const int kFastBits = 9;
+// stb_image's limit, larger files go to stb_image and fail there the same way
+static const int kMaxDimension = 1 << 24;
+// output rows per task for upsampling and color conversion
+static const size_t kRowGrain = 32;
+
+// position in the 8x8 block of the nth coefficient in zigzag order. the tail lets corrupt run
+// lengths run past the end without reading outside the table
+static const unsigned char kDezigzag[64 + 15] = {
+	 0,  1,  8, 16,  9,  2,  3, 10,
+	17, 24, 32, 25, 18, 11,  4,  5,
+	12, 19, 26, 33, 40, 48, 41, 34,
+	27, 20, 13,  6,  7, 14, 21, 28,
+	35, 42, 49, 56, 57, 50, 43, 36,
+	29, 22, 15, 23, 30, 37, 44, 51,
+	58, 59, 52, 45, 38, 31, 39, 46,
+	53, 60, 61, 54, 47, 55, 62, 63,
+	63, 63, 63, 63, 63, 63, 63, 63,
+	63, 63, 63, 63, 63, 63, 63
+};
+
+// (1 << n) - 1
+static const unsigned int kBitMask[17] = { 0, 1, 3, 7, 15, 31, 63, 127, 255, 511, 1023, 2047, 4095, 8191, 16383, 32767, 65535 };
+// (-1 << n) + 1
+static const int kExtendBias[16] = { 0, -1, -3, -7, -15, -31, -63, -127, -255, -511, -1023, -2047, -4095, -8191, -16383, -32767 };
+
+static unsigned int RotateLeft(unsigned int x, int n)
+{
+	return (x << n) | (x >> (-n & 31));
+}
+
+// ---------------------------------------------------------------------------------------------
+// Huffman tables and the entropy decoder. the lookups, the bit buffer and its refill follow
+// stb_image exactly, including how a marker inside the data ends it with zero bits
+
+static bool BuildHuffman(JpegDecoder::Huffman& huffman, const int counts[16])
+{
+	int k = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		for (int j = 0; j < counts[i]; j++)
+			huffman.size[k++] = (unsigned char)(i + 1);
+	}
+	huffman.size[k] = 0;
+
+	// canonical codes, as in the JPEG spec
+	unsigned int code = 0;
+	k = 0;
+	int j;
+	for (j = 1; j <= 16; j++)
+	{
+		huffman.delta[j] = k - (int)code;
+		if (huffman.size[k] == j)
+		{
+			while (huffman.size[k] == j)
+				huffman.code[k++] = (unsigned short)(code++);
+			if (code - 1 >= (1u << j))
+				return false;
+		}
+		// largest code + 1 of this length, shifted to 16 bits for the slow path
+		huffman.maxcode[j] = code << (16 - j);
+		code <<= 1;
+	}
+	huffman.maxcode[j] = 0xffffffff;
+
+	std::memset(huffman.fast, 255, sizeof(huffman.fast));
+	for (int i = 0; i < k; i++)
+	{
+		int s = huffman.size[i];
+		if (s <= kFastBits)
+		{
+			int c = huffman.code[i] << (kFastBits - s);
+			int m = 1 << (kFastBits - s);
+			for (int f = 0; f < m; f++)
+				huffman.fast[c + f] = (unsigned char)i;
+		}
+	}
+	return true;
+}
+
+static void BuildFastAc(JpegDecoder::Huffman& huffman)
+{
+	for (int i = 0; i < (1 << kFastBits); i++)
+	{
+		unsigned char fast = huffman.fast[i];
+		huffman.fast_ac[i] = 0;
+		if (fast == 255)
+			continue;
+		int rs = huffman.values[fast];
+		int run = (rs >> 4) & 15;
+		int magnitude_bits = rs & 15;
+		int length = huffman.size[fast];
+		if (magnitude_bits && length + magnitude_bits <= kFastBits)
+		{
+			// the code is followed by the magnitude bits, both fit in the lookup
+			int k = ((i << length) & ((1 << kFastBits) - 1)) >> (kFastBits - magnitude_bits);
+			int m = 1 << (magnitude_bits - 1);
+			if (k < m)
+				k += (int)(~0U << magnitude_bits) + 1;
+			if (k >= -128 && k <= 127)
+				huffman.fast_ac[i] = (short)((k * 256) + (run * 16) + (length + magnitude_bits));
+		}
+	}
+}
+
+struct BitReader
+{
+	const unsigned char* next;
+	const unsigned char* end;
+	unsigned int buffer;
+	int bits;
+	// a marker was reached, everything after it reads as zero bits
+	bool at_marker;
+	unsigned char marker;
+
+	BitReader(const unsigned char* begin, const unsigned char* data_end)
+		: next(begin), end(data_end), buffer(0), bits(0), at_marker(false), marker(0)
+	{
+	}
+
+	unsigned int Byte()
+	{
+		return next < end ? *next++ : 0;
+	}
+
+	void Fill()
+	{
+		do
+		{
+			unsigned int b = at_marker ? 0 : Byte();
+			if (b == 0xff)
+			{
+				unsigned int c = Byte();
+				while (c == 0xff)
+					c = Byte();
+				if (c != 0)
+				{
+					marker = (unsigned char)c;
+					at_marker = true;
+					return;
+				}
+			}
+			buffer |= b << (24 - bits);
+			bits += 8;
+		} while (bits <= 24);
+	}
+
+	int Decode(const JpegDecoder::Huffman& huffman)
+	{
+		if (bits < 16)
+			Fill();
+		int c = (buffer >> (32 - kFastBits)) & ((1 << kFastBits) - 1);
+		int k = huffman.fast[c];
+		if (k < 255)
+		{
+			int s = huffman.size[k];
+			if (s > bits)
+				return -1;
+			buffer <<= s;
+			bits -= s;
+			return huffman.values[k];
+		}
+
+		// longer codes: compare against the largest code of each length
+		unsigned int temp = buffer >> 16;
+		for (k = kFastBits + 1; ; k++)
+		{
+			if (temp < huffman.maxcode[k])
+				break;
+		}
+		if (k == 17)
+		{
+			bits -= 16;
+			return -1;
+		}
+		if (k > bits)
+			return -1;
+		c = ((buffer >> (32 - k)) & kBitMask[k]) + huffman.delta[k];
+		bits -= k;
+		buffer <<= k;
+		return huffman.values[c];
+	}
+
+	// read n bits and sign extend them the JPEG way
+	int Extend(int n)
+	{
+		if (bits < n)
+			Fill();
+		int sign = (int)buffer >> 31;
+		unsigned int k = RotateLeft(buffer, n);
+		if (n < 0 || n >= 17)
+			return 0;
+		buffer = k & ~kBitMask[n];
+		k &= kBitMask[n];
+		bits -= n;
+		return (int)k + (kExtendBias[n] & ~sign);
+	}
+};
+
+static bool DecodeBlock(BitReader& reader, short data[64], const JpegDecoder::Huffman& dc, const JpegDecoder::Huffman& ac,
+	int& dc_prediction, const unsigned short* dequant)
+{
+	if (reader.bits < 16)
+		reader.Fill();
+	int t = reader.Decode(dc);
+	if (t < 0)
+		return false;
+	std::memset(data, 0, 64 * sizeof(data[0]));
+
+	int diff = t ? reader.Extend(t) : 0;
+	dc_prediction += diff;
+	data[0] = (short)(dc_prediction * dequant[0]);
+
+	int k = 1;
+	do
+	{
+		if (reader.bits < 16)
+			reader.Fill();
+		int c = (reader.buffer >> (32 - kFastBits)) & ((1 << kFastBits) - 1);
+		int r = ac.fast_ac[c];
+		if (r)
+		{
+			// run, value and length from one lookup
+			k += (r >> 4) & 15;
+			int s = r & 15;
+			reader.buffer <<= s;
+			reader.bits -= s;
+			unsigned int zig = kDezigzag[k++];
+			data[zig] = (short)((r >> 8) * dequant[zig]);
+		}
+		else
+		{
+			int rs = reader.Decode(ac);
+			if (rs < 0)
+				return false;
+			int s = rs & 15;
+			r = rs >> 4;
+			if (s == 0)
+			{
+				// end of block, or a run of 16 zeros
+				if (rs != 0xf0)
+					break;
+				k += 16;
+			}
+			else
+			{
+				k += r;
+				unsigned int zig = kDezigzag[k++];
+				data[zig] = (short)(reader.Extend(s) * dequant[zig]);
+			}
+		}
+	} while (k < 64);
+	return true;
+}
+
+// ---------------------------------------------------------------------------------------------
+// inverse DCT, the integer jidctint (DCT_ISLOW) variant stb_image uses. the SSE2 version is
+// stb_image's, which gives the same results as the scalar one
+
+static int Fixed(float x)
+{
+	return (int)(x * 4096 + 0.5);
+}
+
+static unsigned char ClampByte(int x)
+{
+	if ((unsigned int)x > 255)
+		return x < 0 ? 0 : 255;
+	return (unsigned char)x;
+}
+
+struct Idct1D
+{
+	int t0, t1, t2, t3, x0, x1, x2, x3;
+
+	Idct1D(int s0, int s1, int s2, int s3, int s4, int s5, int s6, int s7)
+	{
+		// even part
+		int p2 = s2;
+		int p3 = s6;
+		int p1 = (p2 + p3) * Fixed(0.5411961f);
+		t2 = p1 + p3 * Fixed(-1.847759065f);
+		t3 = p1 + p2 * Fixed(0.765366865f);
+		p2 = s0;
+		p3 = s4;
+		t0 = (p2 + p3) * 4096;
+		t1 = (p2 - p3) * 4096;
+		x0 = t0 + t3;
+		x3 = t0 - t3;
+		x1 = t1 + t2;
+		x2 = t1 - t2;
+		// odd part
+		t0 = s7;
+		t1 = s5;
+		t2 = s3;
+		t3 = s1;
+		p3 = t0 + t2;
+		int p4 = t1 + t3;
+		p1 = t0 + t3;
+		p2 = t1 + t2;
+		int p5 = (p3 + p4) * Fixed(1.175875602f);
+		t0 = t0 * Fixed(0.298631336f);
+		t1 = t1 * Fixed(2.053119869f);
+		t2 = t2 * Fixed(3.072711026f);
+		t3 = t3 * Fixed(1.501321110f);
+		p1 = p5 + p1 * Fixed(-0.899976223f);
+		p2 = p5 + p2 * Fixed(-2.562915447f);
+		p3 = p3 * Fixed(-1.961570560f);
+		p4 = p4 * Fixed(-0.390180644f);
+		t3 += p1 + p4;
+		t2 += p2 + p3;
+		t1 += p2 + p4;
+		t0 += p1 + p3;
+	}
+};
+
+#if !defined(JPEG_DECODER_SSE2)
+static void IdctBlockScalar(unsigned char* out, int out_stride, const short data[64])
+{
+	int values[64];
+	for (int i = 0; i < 8; i++)
+	{
+		const short* d = data + i;
+		int* v = values + i;
+		if (d[8] == 0 && d[16] == 0 && d[24] == 0 && d[32] == 0 && d[40] == 0 && d[48] == 0 && d[56] == 0)
+		{
+			// only the DC term: the column is flat
+			int dc = d[0] * 4;
+			v[0] = v[8] = v[16] = v[24] = v[32] = v[40] = v[48] = v[56] = dc;
+			continue;
+		}
+		Idct1D c(d[0], d[8], d[16], d[24], d[32], d[40], d[48], d[56]);
+		// the constants are scaled by 1 << 12, keep 2 bits of it for the row pass
+		c.x0 += 512; c.x1 += 512; c.x2 += 512; c.x3 += 512;
+		v[0] = (c.x0 + c.t3) >> 10;
+		v[56] = (c.x0 - c.t3) >> 10;
+		v[8] = (c.x1 + c.t2) >> 10;
+		v[48] = (c.x1 - c.t2) >> 10;
+		v[16] = (c.x2 + c.t1) >> 10;
+		v[40] = (c.x2 - c.t1) >> 10;
+		v[24] = (c.x3 + c.t0) >> 10;
+		v[32] = (c.x3 - c.t0) >> 10;
+	}
+	for (int i = 0; i < 8; i++, out += out_stride)
+	{
+		const int* v = values + i * 8;
+		Idct1D r(v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7]);
+		// 1 << 17 to remove: 12 bits of constants, 2 kept from the column pass, 3 from the two
+		// sqrt(8) scales. round, and move -128..127 to 0..255 on the way
+		const int kBias = 65536 + (128 << 17);
+		r.x0 += kBias; r.x1 += kBias; r.x2 += kBias; r.x3 += kBias;
+		out[0] = ClampByte((r.x0 + r.t3) >> 17);
+		out[7] = ClampByte((r.x0 - r.t3) >> 17);
+		out[1] = ClampByte((r.x1 + r.t2) >> 17);
+		out[6] = ClampByte((r.x1 - r.t2) >> 17);
+		out[2] = ClampByte((r.x2 + r.t1) >> 17);
+		out[5] = ClampByte((r.x2 - r.t1) >> 17);
+		out[3] = ClampByte((r.x3 + r.t0) >> 17);
+		out[4] = ClampByte((r.x3 - r.t0) >> 17);
+	}
+}
+#endif
+
+#if defined(JPEG_DECODER_SSE2)
+// 32-bit intermediates of 8 columns
+struct Wide
+{
+	__m128i low;
+	__m128i high;
+};
+
+static Wide WideAdd(const Wide& a, const Wide& b)
+{
+	Wide out = { _mm_add_epi32(a.low, b.low), _mm_add_epi32(a.high, b.high) };
+	return out;
+}
+
+static Wide WideSub(const Wide& a, const Wide& b)
+{
+	Wide out = { _mm_sub_epi32(a.low, b.low), _mm_sub_epi32(a.high, b.high) };
+	return out;
+}
+
+// in << 12, 16 to 32 bits
+static Wide Widen(__m128i in)
+{
+	Wide out = {
+		_mm_srai_epi32(_mm_unpacklo_epi16(_mm_setzero_si128(), in), 4),
+		_mm_srai_epi32(_mm_unpackhi_epi16(_mm_setzero_si128(), in), 4)
+	};
+	return out;
+}
+
+// out0 = c0.even * x + c0.odd * y, out1 the same with c1
+static void Rotate(__m128i x, __m128i y, __m128i c0, __m128i c1, Wide& out0, Wide& out1)
+{
+	__m128i low = _mm_unpacklo_epi16(x, y);
+	__m128i high = _mm_unpackhi_epi16(x, y);
+	out0.low = _mm_madd_epi16(low, c0);
+	out0.high = _mm_madd_epi16(high, c0);
+	out1.low = _mm_madd_epi16(low, c1);
+	out1.high = _mm_madd_epi16(high, c1);
+}
+
+// a + b and a - b, biased, shifted and packed back to 16 bits
+static void Butterfly(const Wide& a, const Wide& b, __m128i bias, __m128i shift, __m128i& out0, __m128i& out1)
+{
+	Wide biased = { _mm_add_epi32(a.low, bias), _mm_add_epi32(a.high, bias) };
+	Wide sum = WideAdd(biased, b);
+	Wide difference = WideSub(biased, b);
+	out0 = _mm_packs_epi32(_mm_sra_epi32(sum.low, shift), _mm_sra_epi32(sum.high, shift));
+	out1 = _mm_packs_epi32(_mm_sra_epi32(difference.low, shift), _mm_sra_epi32(difference.high, shift));
+}
+
+static __m128i PairConstant(int x, int y)
+{
+	return _mm_setr_epi16((short)x, (short)y, (short)x, (short)y, (short)x, (short)y, (short)x, (short)y);
+}
+
+static void IdctPass(__m128i row[8], __m128i bias, __m128i shift)
+{
+	const __m128i rot0_0 = PairConstant(Fixed(0.5411961f), Fixed(0.5411961f) + Fixed(-1.847759065f));
+	const __m128i rot0_1 = PairConstant(Fixed(0.5411961f) + Fixed(0.765366865f), Fixed(0.5411961f));
+	const __m128i rot1_0 = PairConstant(Fixed(1.175875602f) + Fixed(-0.899976223f), Fixed(1.175875602f));
+	const __m128i rot1_1 = PairConstant(Fixed(1.175875602f), Fixed(1.175875602f) + Fixed(-2.562915447f));
+	const __m128i rot2_0 = PairConstant(Fixed(-1.961570560f) + Fixed(0.298631336f), Fixed(-1.961570560f));
+	const __m128i rot2_1 = PairConstant(Fixed(-1.961570560f), Fixed(-1.961570560f) + Fixed(3.072711026f));
+	const __m128i rot3_0 = PairConstant(Fixed(-0.390180644f) + Fixed(2.053119869f), Fixed(-0.390180644f));
+	const __m128i rot3_1 = PairConstant(Fixed(-0.390180644f), Fixed(-0.390180644f) + Fixed(1.501321110f));
+
+	// even part
+	Wide t2e, t3e;
+	Rotate(row[2], row[6], rot0_0, rot0_1, t2e, t3e);
+	Wide t0e = Widen(_mm_add_epi16(row[0], row[4]));
+	Wide t1e = Widen(_mm_sub_epi16(row[0], row[4]));
+	Wide x0 = WideAdd(t0e, t3e);
+	Wide x3 = WideSub(t0e, t3e);
+	Wide x1 = WideAdd(t1e, t2e);
+	Wide x2 = WideSub(t1e, t2e);
+	// odd part
+	Wide y0o, y1o, y2o, y3o, y4o, y5o;
+	Rotate(row[7], row[3], rot2_0, rot2_1, y0o, y2o);
+	Rotate(row[5], row[1], rot3_0, rot3_1, y1o, y3o);
+	Rotate(_mm_add_epi16(row[1], row[7]), _mm_add_epi16(row[3], row[5]), rot1_0, rot1_1, y4o, y5o);
+	Wide x4 = WideAdd(y0o, y4o);
+	Wide x5 = WideAdd(y1o, y5o);
+	Wide x6 = WideAdd(y2o, y5o);
+	Wide x7 = WideAdd(y3o, y4o);
+	Butterfly(x0, x7, bias, shift, row[0], row[7]);
+	Butterfly(x1, x6, bias, shift, row[1], row[6]);
+	Butterfly(x2, x5, bias, shift, row[2], row[5]);
+	Butterfly(x3, x4, bias, shift, row[3], row[4]);
+}
+
+static void Interleave16(__m128i& a, __m128i& b)
+{
+	__m128i low = _mm_unpacklo_epi16(a, b);
+	b = _mm_unpackhi_epi16(a, b);
+	a = low;
+}
+
+static void Interleave8(__m128i& a, __m128i& b)
+{
+	__m128i low = _mm_unpacklo_epi8(a, b);
+	b = _mm_unpackhi_epi8(a, b);
+	a = low;
+}
+
+static void IdctBlockSse2(unsigned char* out, int out_stride, const short data[64])
+{
+	__m128i row[8];
+	for (int i = 0; i < 8; i++)
+		row[i] = _mm_loadu_si128((const __m128i*)(data + i * 8));
+
+	// columns, then transpose and the rows
+	IdctPass(row, _mm_set1_epi32(512), _mm_cvtsi32_si128(10));
+	Interleave16(row[0], row[4]);
+	Interleave16(row[1], row[5]);
+	Interleave16(row[2], row[6]);
+	Interleave16(row[3], row[7]);
+	Interleave16(row[0], row[2]);
+	Interleave16(row[1], row[3]);
+	Interleave16(row[4], row[6]);
+	Interleave16(row[5], row[7]);
+	Interleave16(row[0], row[1]);
+	Interleave16(row[2], row[3]);
+	Interleave16(row[4], row[5]);
+	Interleave16(row[6], row[7]);
+	IdctPass(row, _mm_set1_epi32(65536 + (128 << 17)), _mm_cvtsi32_si128(17));
+
+	// saturate to bytes and transpose back
+	__m128i p0 = _mm_packus_epi16(row[0], row[1]);
+	__m128i p1 = _mm_packus_epi16(row[2], row[3]);
+	__m128i p2 = _mm_packus_epi16(row[4], row[5]);
+	__m128i p3 = _mm_packus_epi16(row[6], row[7]);
+	Interleave8(p0, p2);
+	Interleave8(p1, p3);
+	Interleave8(p0, p1);
+	Interleave8(p2, p3);
+	Interleave8(p0, p2);
+	Interleave8(p1, p3);
+	const __m128i kRows[4] = { p0, p2, p1, p3 };
+	for (int i = 0; i < 4; i++)
+	{
+		_mm_storel_epi64((__m128i*)out, kRows[i]);
+		out += out_stride;
+		_mm_storel_epi64((__m128i*)out, _mm_shuffle_epi32(kRows[i], 0x4e));
+		out += out_stride;
+	}
+}
+#endif
+
+static void IdctBlock(unsigned char* out, int out_stride, const short data[64])
+{
+#if defined(JPEG_DECODER_SSE2)
+	IdctBlockSse2(out, out_stride, data);
+#else
+	IdctBlockScalar(out, out_stride, data);
+#endif
+}
+
+// ---------------------------------------------------------------------------------------------
+// upsampling of subsampled chroma, stb_image's filters: triangle for 2x, repeated samples
+// otherwise. each returns the upsampled row, which is near itself when nothing is scaled
+
+typedef const unsigned char* (*ResampleRow)(unsigned char* out, const unsigned char* near, const unsigned char* far, int w, int hs);
+
+static const unsigned char* ResampleRow1(unsigned char*, const unsigned char* near, const unsigned char*, int, int)
+{
+	return near;
+}
+
+static const unsigned char* ResampleRowV2(unsigned char* out, const unsigned char* near, const unsigned char* far, int w, int)
+{
+	for (int i = 0; i < w; i++)
+		out[i] = (unsigned char)((3 * near[i] + far[i] + 2) >> 2);
+	return out;
+}
+
+static const unsigned char* ResampleRowH2(unsigned char* out, const unsigned char* near, const unsigned char*, int w, int)
+{
+	if (w == 1)
+	{
+		out[0] = out[1] = near[0];
+		return out;
+	}
+	out[0] = near[0];
+	out[1] = (unsigned char)((near[0] * 3 + near[1] + 2) >> 2);
+	int i;
+	for (i = 1; i < w - 1; i++)
+	{
+		int n = 3 * near[i] + 2;
+		out[i * 2] = (unsigned char)((n + near[i - 1]) >> 2);
+		out[i * 2 + 1] = (unsigned char)((n + near[i + 1]) >> 2);
+	}
+	out[i * 2] = (unsigned char)((near[w - 2] * 3 + near[w - 1] + 2) >> 2);
+	out[i * 2 + 1] = near[w - 1];
+	return out;
+}
+
+static const unsigned char* ResampleRowHV2(unsigned char* out, const unsigned char* near, const unsigned char* far, int w, int)
+{
+	if (w == 1)
+	{
+		out[0] = out[1] = (unsigned char)((3 * near[0] + far[0] + 2) >> 2);
+		return out;
+	}
+	int i = 0;
+	int t1 = 3 * near[0] + far[0];
+#if defined(JPEG_DECODER_SSE2)
+	// 8 input samples at a time, the last one always goes through the scalar boundary case
+	for (; i < ((w - 1) & ~7); i += 8)
+	{
+		// vertical pass: 3 * near + far = 4 * near + (far - near)
+		__m128i zero = _mm_setzero_si128();
+		__m128i far_words = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(far + i)), zero);
+		__m128i near_words = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(near + i)), zero);
+		__m128i current = _mm_add_epi16(_mm_slli_epi16(near_words, 2), _mm_sub_epi16(far_words, near_words));
+		// horizontal pass on the row shifted by one sample each way
+		__m128i previous = _mm_insert_epi16(_mm_slli_si128(current, 2), t1, 0);
+		__m128i next = _mm_insert_epi16(_mm_srli_si128(current, 2), 3 * near[i + 8] + far[i + 8], 7);
+		__m128i biased = _mm_add_epi16(_mm_slli_epi16(current, 2), _mm_set1_epi16(8));
+		__m128i even = _mm_add_epi16(_mm_sub_epi16(previous, current), biased);
+		__m128i odd = _mm_add_epi16(_mm_sub_epi16(next, current), biased);
+		__m128i low = _mm_srli_epi16(_mm_unpacklo_epi16(even, odd), 4);
+		__m128i high = _mm_srli_epi16(_mm_unpackhi_epi16(even, odd), 4);
+		_mm_storeu_si128((__m128i*)(out + i * 2), _mm_packus_epi16(low, high));
+		t1 = 3 * near[i + 7] + far[i + 7];
+	}
+	int t0 = t1;
+	t1 = 3 * near[i] + far[i];
+	out[i * 2] = (unsigned char)((3 * t1 + t0 + 8) >> 4);
+	i++;
+#else
+	out[0] = (unsigned char)((t1 + 2) >> 2);
+	i = 1;
+#endif
+	for (; i < w; i++)
+	{
+		int previous = t1;
+		t1 = 3 * near[i] + far[i];
+		out[i * 2 - 1] = (unsigned char)((3 * previous + t1 + 8) >> 4);
+		out[i * 2] = (unsigned char)((3 * t1 + previous + 8) >> 4);
+	}
+	out[w * 2 - 1] = (unsigned char)((t1 + 2) >> 2);
+	return out;
+}
+
+static const unsigned char* ResampleRowGeneric(unsigned char* out, const unsigned char* near, const unsigned char*, int w, int hs)
+{
+	for (int i = 0; i < w; i++)
+	{
+		for (int j = 0; j < hs; j++)
+			out[i * hs + j] = near[i];
+	}
+	return out;
+}
+
+// ---------------------------------------------------------------------------------------------
+// YCbCr to RGB in stb_image's reduced precision, which the 16-bit SIMD lanes reproduce exactly
+
+static int FixedColor(float x)
+{
+	return ((int)(x * 4096.0f + 0.5f)) << 8;
+}
+
+static void YCbCrToRgbScalar(unsigned char* out, const unsigned char* y, const unsigned char* cb, const unsigned char* cr,
+	int count, int step)
+{
+	for (int i = 0; i < count; i++, out += step)
+	{
+		int y_fixed = (y[i] << 20) + (1 << 19);
+		int red_chroma = cr[i] - 128;
+		int blue_chroma = cb[i] - 128;
+		int r = y_fixed + red_chroma * FixedColor(1.40200f);
+		int g = y_fixed + red_chroma * -FixedColor(0.71414f) + ((blue_chroma * -FixedColor(0.34414f)) & 0xffff0000);
+		int b = y_fixed + blue_chroma * FixedColor(1.77200f);
+		out[0] = ClampByte(r >> 20);
+		out[1] = ClampByte(g >> 20);
+		out[2] = ClampByte(b >> 20);
+		if (step == 4)
+			out[3] = 255;
+	}
+}
+
+static void YCbCrToRgb(unsigned char* out, const unsigned char* y, const unsigned char* cb, const unsigned char* cr,
+	int count, int step)
+{
+	int i = 0;
+	// RGBA only, 3-byte pixels don't interleave cheaply
+#if defined(JPEG_DECODER_AVX2)
+	if (step == 4 && CpuFeatures::HasAvx2())
+		i = JpegDecoderAvx2::YCbCrToRgba(out, y, cb, cr, count);
+#endif
+#if defined(JPEG_DECODER_SSE2)
+	if (step == 4)
+	{
+		const __m128i sign_flip = _mm_set1_epi8(-0x80);
+		const __m128i cr_red = _mm_set1_epi16((short)(1.40200f * 4096.0f + 0.5f));
+		const __m128i cr_green = _mm_set1_epi16(-(short)(0.71414f * 4096.0f + 0.5f));
+		const __m128i cb_green = _mm_set1_epi16(-(short)(0.34414f * 4096.0f + 0.5f));
+		const __m128i cb_blue = _mm_set1_epi16((short)(1.77200f * 4096.0f + 0.5f));
+		const __m128i y_bias = _mm_set1_epi8((char)(unsigned char)128);
+		const __m128i alpha = _mm_set1_epi16(255);
+		for (; i + 7 < count; i += 8)
+		{
+			__m128i cr_biased = _mm_xor_si128(_mm_loadl_epi64((const __m128i*)(cr + i)), sign_flip);
+			__m128i cb_biased = _mm_xor_si128(_mm_loadl_epi64((const __m128i*)(cb + i)), sign_flip);
+			__m128i y_words = _mm_unpacklo_epi8(y_bias, _mm_loadl_epi64((const __m128i*)(y + i)));
+			__m128i cr_words = _mm_unpacklo_epi8(_mm_setzero_si128(), cr_biased);
+			__m128i cb_words = _mm_unpacklo_epi8(_mm_setzero_si128(), cb_biased);
+
+			__m128i y_scaled = _mm_srli_epi16(y_words, 4);
+			__m128i r = _mm_srai_epi16(_mm_add_epi16(_mm_mulhi_epi16(cr_red, cr_words), y_scaled), 4);
+			__m128i g = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mulhi_epi16(cb_green, cb_words), y_scaled),
+				_mm_mulhi_epi16(cr_words, cr_green)), 4);
+			__m128i b = _mm_srai_epi16(_mm_add_epi16(y_scaled, _mm_mulhi_epi16(cb_words, cb_blue)), 4);
+
+			__m128i rb = _mm_packus_epi16(r, b);
+			__m128i ga = _mm_packus_epi16(g, alpha);
+			__m128i rg = _mm_unpacklo_epi8(rb, ga);
+			__m128i ba = _mm_unpackhi_epi8(rb, ga);
+			_mm_storeu_si128((__m128i*)(out + i * 4), _mm_unpacklo_epi16(rg, ba));
+			_mm_storeu_si128((__m128i*)(out + i * 4 + 16), _mm_unpackhi_epi16(rg, ba));
+		}
+	}
+#endif
+	YCbCrToRgbScalar(out + i * step, y + i, cb + i, cr + i, count - i, step);
+}
+
+// ---------------------------------------------------------------------------------------------
+
+static unsigned int ReadUint16(const unsigned char* p)
+{
+	return (unsigned int)p[0] << 8 | p[1];
+}
+
+JpegDecoder::JpegDecoder()
+	: data_(NULL), size_(0), width_(0), height_(0), max_h_(1), max_v_(1), mcu_columns_(0), mcu_rows_(0),
+	restart_interval_(0), jfif_(false), adobe_transform_(-1), rgb_ids_(false)
+{
+	std::memset(quant_, 0, sizeof(quant_));
+	for (int i = 0; i < 4; i++)
+		dc_defined_[i] = ac_defined_[i] = false;
+}
+
+bool JpegDecoder::ReadHeader(const unsigned char* data, size_t size)
+{
+	data_ = data;
+	size_ = size;
+	components_.clear();
+	order_.clear();
+	intervals_.clear();
+	restart_interval_ = 0;
+	jfif_ = false;
+	adobe_transform_ = -1;
+	rgb_ids_ = false;
+	for (int i = 0; i < 4; i++)
+		dc_defined_[i] = ac_defined_[i] = false;
+	if (size < 4 || data[0] != 0xff || data[1] != 0xd8)
+		return false;
+	size_t position = 2;
+	return ReadMarkers(position) && FindIntervals(position);
+}
+
+bool JpegDecoder::ReadMarkers(size_t& position)
+{
+	bool have_frame = false;
+	for (;;)
+	{
+		// stb_image skips padding between the segments before the frame header, so do we
+		while (position < size_ && data_[position] != 0xff && !have_frame)
+			position++;
+		if (position + 1 >= size_ || data_[position] != 0xff)
+			return false;
+		while (position < size_ && data_[position] == 0xff)
+			position++;
+		if (position >= size_)
+			return false;
+		unsigned char marker = data_[position++];
+		// every marker before the scan carries a length
+		if (position + 2 > size_)
+			return false;
+		int length = (int)ReadUint16(data_ + position) - 2;
+		const unsigned char* segment = data_ + position + 2;
+		if (length < 0 || position + 2 + length > size_)
+			return false;
+		position += 2 + length;
+
+		if (marker == 0xc0 || marker == 0xc1)
+		{
+			if (have_frame || !ReadFrame(segment, length))
+				return false;
+			have_frame = true;
+		}
+		else if (marker == 0xda)
+		{
+			return have_frame && ReadScan(segment, length);
+		}
+		else if (marker == 0xdd)
+		{
+			if (length != 2)
+				return false;
+			restart_interval_ = (int)ReadUint16(segment);
+		}
+		else if (marker == 0xdb)
+		{
+			// quantization tables, 8 or 16 bits per entry
+			int offset = 0;
+			while (offset < length)
+			{
+				int precision = segment[offset] >> 4;
+				int table = segment[offset] & 15;
+				int entry_size = precision ? 2 : 1;
+				if (precision > 1 || table > 3 || offset + 1 + 64 * entry_size > length)
+					return false;
+				for (int i = 0; i < 64; i++)
+				{
+					const unsigned char* entry = segment + offset + 1 + i * entry_size;
+					quant_[table][kDezigzag[i]] = (unsigned short)(precision ? ReadUint16(entry) : entry[0]);
+				}
+				offset += 1 + 64 * entry_size;
+			}
+		}
+		else if (marker == 0xc4)
+		{
+			int offset = 0;
+			while (offset < length)
+			{
+				if (offset + 17 > length)
+					return false;
+				int table_class = segment[offset] >> 4;
+				int table = segment[offset] & 15;
+				if (table_class > 1 || table > 3)
+					return false;
+				int counts[16];
+				int total = 0;
+				for (int i = 0; i < 16; i++)
+				{
+					counts[i] = segment[offset + 1 + i];
+					total += counts[i];
+				}
+				offset += 17;
+				if (total > 256 || offset + total > length)
+					return false;
+				Huffman& huffman = table_class == 0 ? dc_[table] : ac_[table];
+				if (!BuildHuffman(huffman, counts))
+					return false;
+				std::memcpy(huffman.values, segment + offset, total);
+				if (table_class == 0)
+				{
+					dc_defined_[table] = true;
+				}
+				else
+				{
+					BuildFastAc(huffman);
+					ac_defined_[table] = true;
+				}
+				offset += total;
+			}
+		}
+		else if (marker == 0xe0)
+		{
+			if (length >= 5 && std::memcmp(segment, "JFIF\0", 5) == 0)
+				jfif_ = true;
+		}
+		else if (marker == 0xee)
+		{
+			// Adobe: the last byte says whether the components are YCbCr (1) or not (0)
+			if (length >= 12 && std::memcmp(segment, "Adobe\0", 6) == 0)
+				adobe_transform_ = segment[11];
+		}
+		else if (!((marker >= 0xe1 && marker <= 0xef) || marker == 0xfe))
+		{
+			// progressive, arithmetic coded, hierarchical or broken
+			return false;
+		}
+	}
+}
+
+bool JpegDecoder::ReadFrame(const unsigned char* segment, int length)
+{
+	if (length < 6 || segment[0] != 8)
+		return false;
+	height_ = (int)ReadUint16(segment + 1);
+	width_ = (int)ReadUint16(segment + 3);
+	int count = segment[5];
+	// no CMYK, and a height of 0 (defined later by DNL) isn't supported by stb_image either
+	if (width_ == 0 || height_ == 0 || width_ > kMaxDimension || height_ > kMaxDimension || (count != 1 && count != 3))
+		return false;
+	if (length != 6 + 3 * count)
+		return false;
+
+	components_.resize(count);
+	max_h_ = max_v_ = 1;
+	int rgb_matches = 0;
+	for (int i = 0; i < count; i++)
+	{
+		Component& component = components_[i];
+		const unsigned char* entry = segment + 6 + i * 3;
+		component.id = entry[0];
+		component.h = entry[1] >> 4;
+		component.v = entry[1] & 15;
+		component.quant = entry[2];
+		if (component.h < 1 || component.h > 4 || component.v < 1 || component.v > 4 || component.quant > 3)
+			return false;
+		rgb_matches += count == 3 && component.id == "RGB"[i] ? 1 : 0;
+		max_h_ = std::max(max_h_, component.h);
+		max_v_ = std::max(max_v_, component.v);
+	}
+	rgb_ids_ = rgb_matches == 3;
+
+	mcu_columns_ = (width_ + max_h_ * 8 - 1) / (max_h_ * 8);
+	mcu_rows_ = (height_ + max_v_ * 8 - 1) / (max_v_ * 8);
+	for (int i = 0; i < count; i++)
+	{
+		// planes cover whole MCUs, the samples past the image edge are dropped on conversion
+		Component& component = components_[i];
+		component.x = (width_ * component.h + max_h_ - 1) / max_h_;
+		component.y = (height_ * component.v + max_v_ - 1) / max_v_;
+		component.plane_width = mcu_columns_ * component.h * 8;
+		component.plane_height = mcu_rows_ * component.v * 8;
+	}
+	return true;
+}
+
+bool JpegDecoder::ReadScan(const unsigned char* segment, int length)
+{
+	int count = length > 0 ? segment[0] : 0;
+	// one scan with every component, anything else is a multi-scan file
+	if (count != (int)components_.size() || length != 4 + 2 * count)
+		return false;
+	for (int i = 0; i < count; i++)
+	{
+		int id = segment[1 + i * 2];
+		int tables = segment[2 + i * 2];
+		int which = 0;
+		while (which < count && components_[which].id != id)
+			which++;
+		if (which == count || std::find(order_.begin(), order_.end(), which) != order_.end())
+			return false;
+		components_[which].dc_table = tables >> 4;
+		components_[which].ac_table = tables & 15;
+		if (components_[which].dc_table > 3 || components_[which].ac_table > 3
+			|| !dc_defined_[components_[which].dc_table] || !ac_defined_[components_[which].ac_table])
+			return false;
+		order_.push_back(which);
+	}
+	// spectral selection and successive approximation must be the baseline values
+	const unsigned char* tail = segment + 1 + 2 * count;
+	return tail[0] == 0 && (tail[2] >> 4) == 0 && (tail[2] & 15) == 0;
+}
+
+bool JpegDecoder::FindIntervals(size_t position)
+{
+	size_t begin = position;
+	while (position < size_)
+	{
+		if (data_[position] != 0xff)
+		{
+			position++;
+			continue;
+		}
+		size_t marker_start = position;
+		while (position < size_ && data_[position] == 0xff)
+			position++;
+		if (position >= size_)
+			break;
+		unsigned char marker = data_[position++];
+		// a stuffed zero byte is data
+		if (marker == 0)
+			continue;
+		intervals_.push_back(std::make_pair(begin, marker_start));
+		begin = position;
+		if (marker >= 0xd0 && marker <= 0xd7)
+			continue;
+
+		// the scan must be followed by the end of the image, and must have been cut exactly where
+		// the restart interval says
+		size_t units = order_.size() == 1
+			? (size_t)((components_[0].x + 7) >> 3) * ((components_[0].y + 7) >> 3)
+			: (size_t)mcu_columns_ * mcu_rows_;
+		size_t expected = restart_interval_ > 0 ? (units + restart_interval_ - 1) / restart_interval_ : 1;
+		return marker == 0xd9 && intervals_.size() == expected;
+	}
+	return false;
+}
+
+bool JpegDecoder::DecodeInterval(size_t interval)
+{
+	size_t units_per_interval = restart_interval_ > 0 ? (size_t)restart_interval_ : ~(size_t)0;
+	size_t first = interval * (restart_interval_ > 0 ? (size_t)restart_interval_ : 0);
+	BitReader reader(data_ + intervals_[interval].first, data_ + size_);
+	int dc_prediction[4] = { 0, 0, 0, 0 };
+	short block[64];
+
+	if (order_.size() == 1)
+	{
+		// one component: blocks in plain raster order over the samples the image covers
+		Component& component = components_[order_[0]];
+		size_t blocks_x = (size_t)(component.x + 7) >> 3;
+		size_t blocks = blocks_x * ((size_t)(component.y + 7) >> 3);
+		size_t end = std::min(blocks, first + std::min(units_per_interval, blocks));
+		for (size_t b = first; b < end; b++)
+		{
+			if (!DecodeBlock(reader, block, dc_[component.dc_table], ac_[component.ac_table], dc_prediction[0], quant_[component.quant]))
+				return false;
+			size_t x = b % blocks_x, y = b / blocks_x;
+			IdctBlock(&component.plane[(y * component.plane_width + x) * 8], component.plane_width, block);
+		}
+	}
+	else
+	{
+		size_t mcus = (size_t)mcu_columns_ * mcu_rows_;
+		size_t end = std::min(mcus, first + std::min(units_per_interval, mcus));
+		for (size_t m = first; m < end; m++)
+		{
+			int mcu_x = (int)(m % mcu_columns_), mcu_y = (int)(m / mcu_columns_);
+			for (size_t k = 0; k < order_.size(); k++)
+			{
+				Component& component = components_[order_[k]];
+				for (int y = 0; y < component.v; y++)
+				{
+					for (int x = 0; x < component.h; x++)
+					{
+						if (!DecodeBlock(reader, block, dc_[component.dc_table], ac_[component.ac_table], dc_prediction[k],
+							quant_[component.quant]))
+							return false;
+						size_t x2 = (size_t)(mcu_x * component.h + x) * 8;
+						size_t y2 = (size_t)(mcu_y * component.v + y) * 8;
+						IdctBlock(&component.plane[y2 * component.plane_width + x2], component.plane_width, block);
+					}
+				}
+			}
+		}
+	}
+
+	// stb_image stops the whole scan when an interval isn't followed right away by its
+	// restart marker. let it do that itself
+	if (interval + 1 < intervals_.size())
+	{
+		if (reader.bits < 24)
+			reader.Fill();
+		if (!reader.at_marker || reader.marker < 0xd0 || reader.marker > 0xd7)
+			return false;
+	}
+	return true;
+}
+
+// where stb_image's upsampler is for one component: the two source rows it blends
+struct ResampleState
+{
+	int step;
+	int row;
+	int line0;
+	int line1;
+	int vs;
+	int rows;
+
+	ResampleState(int vertical_scale, int component_rows)
+		: step(vertical_scale >> 1), row(0), line0(0), line1(0), vs(vertical_scale), rows(component_rows)
+	{
+	}
+
+	void Advance()
+	{
+		if (++step >= vs)
+		{
+			step = 0;
+			line0 = line1;
+			if (++row < rows)
+				line1++;
+		}
+	}
+};
+
+void JpegDecoder::ConvertRows(unsigned char* pixels, int channels, int decode_count, bool flip_vertically, int first_row, int end_row)
+{
+	bool is_rgb = components_.size() == 3 && (rgb_ids_ || (adobe_transform_ == 0 && !jfif_));
+	std::vector<unsigned char> line_buffers[3];
+	std::vector<ResampleState> states;
+	ResampleRow resample[3];
+	int hs[3], w_lores[3];
+	for (int k = 0; k < decode_count; k++)
+	{
+		const Component& component = components_[k];
+		hs[k] = max_h_ / component.h;
+		int vs = max_v_ / component.v;
+		w_lores[k] = (width_ + hs[k] - 1) / hs[k];
+		// room for upsampling by up to 4 past the right edge
+		line_buffers[k].resize(width_ + 3);
+		if (hs[k] == 1 && vs == 1)
+			resample[k] = ResampleRow1;
+		else if (hs[k] == 1 && vs == 2)
+			resample[k] = ResampleRowV2;
+		else if (hs[k] == 2 && vs == 1)
+			resample[k] = ResampleRowH2;
+		else if (hs[k] == 2 && vs == 2)
+			resample[k] = ResampleRowHV2;
+		else
+			resample[k] = ResampleRowGeneric;
+		states.push_back(ResampleState(vs, component.y));
+		for (int j = 0; j < first_row; j++)
+			states[k].Advance();
+	}
+
+	const unsigned char* rows[3];
+	for (int j = first_row; j < end_row; j++)
+	{
+		for (int k = 0; k < decode_count; k++)
+		{
+			const Component& component = components_[k];
+			ResampleState& state = states[k];
+			bool bottom = state.step >= (state.vs >> 1);
+			const unsigned char* line0 = &component.plane[(size_t)state.line0 * component.plane_width];
+			const unsigned char* line1 = &component.plane[(size_t)state.line1 * component.plane_width];
+			rows[k] = resample[k](line_buffers[k].data(), bottom ? line1 : line0, bottom ? line0 : line1, w_lores[k], hs[k]);
+			state.Advance();
+		}
+
+		unsigned char* out = pixels + (size_t)channels * width_ * (flip_vertically ? height_ - 1 - j : j);
+		if (channels >= 3 && components_.size() == 3 && !is_rgb)
+		{
+			YCbCrToRgb(out, rows[0], rows[1], rows[2], width_, channels);
+		}
+		else if (channels >= 3)
+		{
+			// RGB components as they are, or gray spread over the channels
+			const unsigned char* green = decode_count == 3 ? rows[1] : rows[0];
+			const unsigned char* blue = decode_count == 3 ? rows[2] : rows[0];
+			for (int i = 0; i < width_; i++, out += channels)
+			{
+				out[0] = rows[0][i];
+				out[1] = green[i];
+				out[2] = blue[i];
+				if (channels == 4)
+					out[3] = 255;
+			}
+		}
+		else if (decode_count == 3)
+		{
+			// gray from RGB components, stb_image's weights
+			for (int i = 0; i < width_; i++)
+				out[i] = (unsigned char)((rows[0][i] * 77 + rows[1][i] * 150 + rows[2][i] * 29) >> 8);
+		}
+		else
+		{
+			std::memcpy(out, rows[0], width_);
+		}
+	}
+}
+
+unsigned char* JpegDecoder::Decode(int desired_channels, bool flip_vertically, ThreadPool* pool)
+{
+	if (intervals_.empty() || desired_channels < 0 || desired_channels > 4 || desired_channels == 2)
+		return NULL;
+	for (size_t k = 0; k < components_.size(); k++)
+		components_[k].plane.assign((size_t)components_[k].plane_width * components_[k].plane_height, 0);
+
+	// the restart intervals share nothing but the tables, and write to separate blocks
+	std::atomic<bool> failed(false);
+	std::function<void(size_t, size_t)> decode_intervals = [this, &failed](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end && !failed; i++)
+		{
+			if (!DecodeInterval(i))
+				failed = true;
+		}
+	};
+	if (pool && intervals_.size() > 1)
+		pool->ParallelFor(intervals_.size(), 1, decode_intervals);
+	else
+		decode_intervals(0, intervals_.size());
+	if (failed)
+		return NULL;
+
+	int channels = desired_channels ? desired_channels : (int)components_.size();
+	bool is_rgb = components_.size() == 3 && (rgb_ids_ || (adobe_transform_ == 0 && !jfif_));
+	// gray from YCbCr is just the luma
+	int decode_count = components_.size() == 3 && channels < 3 && !is_rgb ? 1 : (int)components_.size();
+	// the same allocator as stb_image, so the caller frees either result with stbi_image_free
+	unsigned char* pixels = (unsigned char*)std::malloc((size_t)channels * width_ * height_);
+	if (!pixels)
+		return NULL;
+	std::function<void(size_t, size_t)> convert = [=](size_t begin, size_t end)
+	{
+		ConvertRows(pixels, channels, decode_count, flip_vertically, (int)begin, (int)end);
+	};
+	if (pool && (size_t)height_ > kRowGrain)
+		pool->ParallelFor(height_, kRowGrain, convert);
+	else
+		convert(0, height_);
+
+	for (size_t k = 0; k < components_.size(); k++)
+		std::vector<unsigned char>().swap(components_[k].plane);
+	return pixels;
+}
+
+const char* JpegDecoder::SimdName()
+{
+#if defined(JPEG_DECODER_AVX2)
+	if (CpuFeatures::HasAvx2())
+		return "AVX2";
+#endif
+#if defined(JPEG_DECODER_SSE2)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
\ No newline at end of file
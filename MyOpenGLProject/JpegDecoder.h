@@ -0,0 +1,102 @@
+#ifndef JPEG_DECODER_H
+#define JPEG_DECODER_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "ThreadPool.h"
+
+// Multithreaded decoder for baseline JPEG files, bit for bit the same as stb_image. The entropy
+// coded data is split at its restart markers and the intervals are decoded and transformed on
+// the pool in parallel; upsampling and color conversion then run in bands of rows. The IDCT,
+// upsampling and YCbCr conversion are the stb_image kernels (SSE2, AVX2 for the conversion), so
+// every pixel rounds the same way. Files without restart markers only get the parallel color
+// conversion.
+//
+// Only what textures are normally saved as is handled: 8-bit Huffman coded baseline with one
+// scan, gray or three components. ReadHeader rejects everything else (progressive, CMYK, several
+// scans) and the caller falls back to stb_image; ImageDecoder does that.
+class JpegDecoder
+{
+public:
+	JpegDecoder();
+
+	// parse the markers up to the scan and find the restart intervals. the data must outlive Decode
+	bool ReadHeader(const unsigned char* data, size_t size);
+	int Width() const { return width_; }
+	int Height() const { return height_; }
+	// components in the file, 1 or 3
+	int Components() const { return (int)components_.size(); }
+	// pieces of entropy coded data that decode independently, 1 without restart markers
+	size_t IntervalCount() const { return intervals_.size(); }
+
+	// pixels with desired_channels (0 for the file's own: 1 or 3, otherwise 1, 3 or 4) per pixel,
+	// top row first unless flipped, in a buffer for stbi_image_free. NULL if the data is corrupt
+	// or desired_channels is 2. a NULL pool decodes on the calling thread
+	unsigned char* Decode(int desired_channels, bool flip_vertically, ThreadPool* pool);
+
+	// name of the instruction set the kernels run with on this CPU
+	static const char* SimdName();
+
+	struct Huffman
+	{
+		// first FAST_BITS bits of a code to the symbol index, 255 for longer codes
+		unsigned char fast[1 << 9];
+		unsigned short code[256];
+		unsigned char values[256];
+		unsigned char size[257];
+		unsigned int maxcode[18];
+		int delta[17];
+		// small AC coefficients decoded in one lookup: value << 8 | run << 4 | total length
+		short fast_ac[1 << 9];
+	};
+
+	struct Component
+	{
+		int id;
+		int h;
+		int v;
+		int quant;
+		int dc_table;
+		int ac_table;
+		// samples covered by the image, and the padded plane of whole MCUs
+		int x;
+		int y;
+		int plane_width;
+		int plane_height;
+		std::vector<unsigned char> plane;
+	};
+
+private:
+	bool ReadMarkers(size_t& position);
+	bool ReadFrame(const unsigned char* segment, int length);
+	bool ReadScan(const unsigned char* segment, int length);
+	bool FindIntervals(size_t position);
+	bool DecodeInterval(size_t interval);
+	void ConvertRows(unsigned char* pixels, int channels, int decode_count, bool flip_vertically, int first_row, int end_row);
+
+	const unsigned char* data_;
+	size_t size_;
+	int width_;
+	int height_;
+	std::vector<Component> components_;
+	int max_h_;
+	int max_v_;
+	int mcu_columns_;
+	int mcu_rows_;
+	// the scan: component indices in coding order
+	std::vector<int> order_;
+	int restart_interval_;
+	bool jfif_;
+	int adobe_transform_;
+	bool rgb_ids_;
+	unsigned short quant_[4][64];
+	Huffman dc_[4];
+	Huffman ac_[4];
+	bool dc_defined_[4];
+	bool ac_defined_[4];
+	// [begin, end) of each restart interval's entropy coded bytes
+	std::vector<std::pair<size_t, size_t>> intervals_;
+};
+
+#endif // !JPEG_DECODER_H
\ No newline at end of file
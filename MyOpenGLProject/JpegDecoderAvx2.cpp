@@ -0,0 +1,42 @@
+#include "JpegDecoderAvx2.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+int JpegDecoderAvx2::YCbCrToRgba(unsigned char* out, const unsigned char* y, const unsigned char* cb, const unsigned char* cr,
+	int count)
+{
+	int i = 0;
+	const __m256i cr_red = _mm256_set1_epi16((short)(1.40200f * 4096.0f + 0.5f));
+	const __m256i cr_green = _mm256_set1_epi16(-(short)(0.71414f * 4096.0f + 0.5f));
+	const __m256i cb_green = _mm256_set1_epi16(-(short)(0.34414f * 4096.0f + 0.5f));
+	const __m256i cb_blue = _mm256_set1_epi16((short)(1.77200f * 4096.0f + 0.5f));
+	const __m256i bias = _mm256_set1_epi16(128);
+	const __m256i alpha = _mm256_set1_epi16(255);
+	for (; i + 15 < count; i += 16)
+	{
+		// y * 16 + 8 is the SSE2 kernel's (y << 8 | 128) >> 4, chroma is (c - 128) << 8
+		__m256i y_words = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(y + i)));
+		__m256i cr_words = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(cr + i))), bias), 8);
+		__m256i cb_words = _mm256_slli_epi16(_mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(cb + i))), bias), 8);
+		__m256i y_scaled = _mm256_add_epi16(_mm256_slli_epi16(y_words, 4), _mm256_set1_epi16(8));
+		__m256i r = _mm256_srai_epi16(_mm256_add_epi16(_mm256_mulhi_epi16(cr_red, cr_words), y_scaled), 4);
+		__m256i g = _mm256_srai_epi16(_mm256_add_epi16(_mm256_add_epi16(_mm256_mulhi_epi16(cb_green, cb_words), y_scaled),
+			_mm256_mulhi_epi16(cr_words, cr_green)), 4);
+		__m256i b = _mm256_srai_epi16(_mm256_add_epi16(y_scaled, _mm256_mulhi_epi16(cb_words, cb_blue)), 4);
+
+		// per 128-bit lane: pixels 0-7 and 8-15
+		__m256i rb = _mm256_packus_epi16(r, b);
+		__m256i ga = _mm256_packus_epi16(g, alpha);
+		__m256i rg = _mm256_unpacklo_epi8(rb, ga);
+		__m256i ba = _mm256_unpackhi_epi8(rb, ga);
+		__m256i first = _mm256_unpacklo_epi16(rg, ba);
+		__m256i second = _mm256_unpackhi_epi16(rg, ba);
+		_mm256_storeu_si256((__m256i*)(out + i * 4), _mm256_permute2x128_si256(first, second, 0x20));
+		_mm256_storeu_si256((__m256i*)(out + i * 4 + 32), _mm256_permute2x128_si256(first, second, 0x31));
+	}
+	return i;
+}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#error JpegDecoderAvx2.cpp must be compiled with /arch:AVX2
+#endif
\ No newline at end of file
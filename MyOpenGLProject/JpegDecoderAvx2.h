@@ -0,0 +1,15 @@
+#ifndef JPEG_DECODER_AVX2_H
+#define JPEG_DECODER_AVX2_H
+
+// JpegDecoder's AVX2 color conversion, 16 pixels at a time. Only called when
+// CpuFeatures::HasAvx2() is true, see CpuFeatures.h
+class JpegDecoderAvx2
+{
+public:
+	// YCbCr to RGBA like stb_image's SSE2 kernel, for the groups of 16 of count pixels. returns
+	// the number of pixels converted
+	static int YCbCrToRgba(unsigned char* out, const unsigned char* y, const unsigned char* cb, const unsigned char* cr,
+		int count);
+};
+
+#endif // !JPEG_DECODER_AVX2_H
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "LZ4.h"
+
+#include <cstring>
+#include <vector>
+
+// format constants: matches are at least 4 bytes, the last 5 bytes are always literals
+// and the last match has to start at least 12 bytes before the end of the block
+static const size_t kMinMatch = 4;
+static const size_t kLastLiterals = 5;
+static const size_t kMatchFindLimit = 12;
+static const size_t kMaxOffset = 65535;
+static const int kHashBits = 16;
+
+static unsigned int Read32(const unsigned char* p)
+{
+	unsigned int value;
+	std::memcpy(&value, p, 4);
+	return value;
+}
+
+// hashing 5 bytes instead of 4 makes the candidates more likely to extend into long matches
+static unsigned int Hash(const unsigned char* p)
+{
+	unsigned long long value;
+	std::memcpy(&value, p, 8);
+	return (unsigned int)(((value << 24) * 889523592379ull) >> (64 - kHashBits));
+}
+
+// 15 in the token nibble, then 255s and the remainder
+static unsigned char* WriteLength(unsigned char* out, size_t length)
+{
+	while (length >= 255)
+	{
+		*out++ = 255;
+		length -= 255;
+	}
+	*out++ = (unsigned char)length;
+	return out;
+}
+
+size_t LZ4::MaxCompressedSize(size_t size)
+{
+	return size + size / 255 + 16;
+}
+
+size_t LZ4::Compress(const unsigned char* source, size_t source_size, unsigned char* destination, size_t capacity)
+{
+	if (capacity < MaxCompressedSize(source_size))
+		return 0;
+
+	unsigned char* out = destination;
+	size_t anchor = 0;
+	if (source_size > kMatchFindLimit)
+	{
+		// positions + 1 of the last occurrence of each hashed 5-byte sequence, 0 = none
+		std::vector<unsigned int> table((size_t)1 << kHashBits, 0);
+		size_t match_limit = source_size - kLastLiterals;
+		size_t position = 0;
+		size_t misses = 0;
+		while (position + kMatchFindLimit < source_size)
+		{
+			unsigned int sequence = Read32(source + position);
+			unsigned int& slot = table[Hash(source + position)];
+			size_t candidate = slot;
+			slot = (unsigned int)(position + 1);
+			if (candidate == 0 || position - (candidate - 1) > kMaxOffset || Read32(source + candidate - 1) != sequence)
+			{
+				// skip faster through data that doesn't compress
+				position += 1 + (misses++ >> 6);
+				continue;
+			}
+			misses = 0;
+			size_t reference = candidate - 1;
+
+			// extend backwards over literals, then forwards
+			while (position > anchor && reference > 0 && source[position - 1] == source[reference - 1])
+			{
+				position--;
+				reference--;
+			}
+			size_t length = kMinMatch;
+			while (position + length < match_limit && source[position + length] == source[reference + length])
+				length++;
+
+			size_t literals = position - anchor;
+			unsigned char* token = out++;
+			*token = (unsigned char)((literals >= 15 ? 15 : literals) << 4);
+			if (literals >= 15)
+				out = WriteLength(out, literals - 15);
+			std::memcpy(out, source + anchor, literals);
+			out += literals;
+			size_t offset = position - reference;
+			*out++ = (unsigned char)(offset & 0xFF);
+			*out++ = (unsigned char)(offset >> 8);
+			size_t match_code = length - kMinMatch;
+			*token |= (unsigned char)(match_code >= 15 ? 15 : match_code);
+			if (match_code >= 15)
+				out = WriteLength(out, match_code - 15);
+
+			position += length;
+			anchor = position;
+			// the end of the match is a good place to look for the next one
+			if (position + kMatchFindLimit < source_size)
+				table[Hash(source + position - 2)] = (unsigned int)(position - 1);
+		}
+	}
+
+	// everything after the last match goes out as literals
+	size_t literals = source_size - anchor;
+	*out++ = (unsigned char)((literals >= 15 ? 15 : literals) << 4);
+	if (literals >= 15)
+		out = WriteLength(out, literals - 15);
+	std::memcpy(out, source + anchor, literals);
+	out += literals;
+	return out - destination;
+}
+
+bool LZ4::Decompress(const unsigned char* source, size_t source_size, unsigned char* destination, size_t destination_size)
+{
+	const unsigned char* in = source;
+	const unsigned char* in_end = source + source_size;
+	unsigned char* out = destination;
+	unsigned char* out_end = destination + destination_size;
+
+	while (in < in_end)
+	{
+		unsigned int token = *in++;
+		size_t literals = token >> 4;
+		if (literals == 15)
+		{
+			unsigned char extra;
+			do
+			{
+				if (in >= in_end)
+					return false;
+				extra = *in++;
+				literals += extra;
+			} while (extra == 255);
+		}
+		if ((size_t)(in_end - in) < literals || (size_t)(out_end - out) < literals)
+			return false;
+		std::memcpy(out, in, literals);
+		in += literals;
+		out += literals;
+
+		// the last sequence has no match
+		if (in == in_end)
+			break;
+
+		if (in_end - in < 2)
+			return false;
+		size_t offset = in[0] | (in[1] << 8);
+		in += 2;
+		if (offset == 0 || offset > (size_t)(out - destination))
+			return false;
+		size_t length = (token & 15) + kMinMatch;
+		if ((token & 15) == 15)
+		{
+			unsigned char extra;
+			do
+			{
+				if (in >= in_end)
+					return false;
+				extra = *in++;
+				length += extra;
+			} while (extra == 255);
+		}
+		if ((size_t)(out_end - out) < length)
+			return false;
+
+		// byte by byte when the match overlaps what it is copying
+		const unsigned char* match = out - offset;
+		if (offset >= length)
+		{
+			std::memcpy(out, match, length);
+			out += length;
+		}
+		else
+		{
+			for (size_t i = 0; i < length; i++)
+				*out++ = match[i];
+		}
+	}
+	return out == out_end;
+}
\ No newline at end of file
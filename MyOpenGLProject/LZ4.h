@@ -0,0 +1,20 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+#include <stddef.h>
+
+// Compressor and decompressor for the LZ4 block format (no frame header, no checksums),
+// compatible with the reference implementation. Compression is greedy and single pass,
+// decompression checks every read and write against the buffer sizes.
+class LZ4
+{
+public:
+	// worst case size of compressing size bytes (incompressible input)
+	static size_t MaxCompressedSize(size_t size);
+	// returns the compressed size, 0 if destination is too small
+	static size_t Compress(const unsigned char* source, size_t source_size, unsigned char* destination, size_t capacity);
+	// true if source decodes to exactly destination_size bytes
+	static bool Decompress(const unsigned char* source, size_t source_size, unsigned char* destination, size_t destination_size);
+};
+
+#endif // !LZ4_H
\ No newline at end of file
@@ -0,0 +1,96 @@
+#ifndef LOCK_FREE_QUEUE_H
+#define LOCK_FREE_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Bounded multi-producer/multi-consumer queue (Dmitry Vyukov's design).
+// Every slot carries a sequence number telling producers and consumers whose turn it is,
+// so neither side ever takes a lock. Capacity must be a power of two.
+template <typename T>
+class LockFreeQueue
+{
+public:
+	explicit LockFreeQueue(size_t capacity)
+		: slots_(capacity), mask_(capacity - 1), enqueue_pos_(0), dequeue_pos_(0)
+	{
+		for (size_t i = 0; i < capacity; i++)
+			slots_[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	// false if the queue is full
+	bool TryPush(const T& value)
+	{
+		size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Slot& slot = slots_[pos & mask_];
+			size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			std::ptrdiff_t diff = (std::ptrdiff_t)sequence - (std::ptrdiff_t)pos;
+			if (diff == 0)
+			{
+				if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					slot.value = value;
+					slot.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = enqueue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// false if the queue is empty
+	bool TryPop(T& value)
+	{
+		size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			Slot& slot = slots_[pos & mask_];
+			size_t sequence = slot.sequence.load(std::memory_order_acquire);
+			std::ptrdiff_t diff = (std::ptrdiff_t)sequence - (std::ptrdiff_t)(pos + 1);
+			if (diff == 0)
+			{
+				if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					value = slot.value;
+					slot.sequence.store(pos + mask_ + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (diff < 0)
+			{
+				return false;
+			}
+			else
+			{
+				pos = dequeue_pos_.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+private:
+	struct Slot
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	std::vector<Slot> slots_;
+	size_t mask_;
+	// keep producers and consumers off each other's cache line
+	char pad0_[64];
+	std::atomic<size_t> enqueue_pos_;
+	char pad1_[64 - sizeof(std::atomic<size_t>)];
+	std::atomic<size_t> dequeue_pos_;
+};
+
+#endif // !LOCK_FREE_QUEUE_H
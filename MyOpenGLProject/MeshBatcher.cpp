@@ -0,0 +1,180 @@
+#include "MeshBatcher.h"
+
+MeshBatcher::MeshBatcher(GLState& state, const VertexFormat& format, size_t max_vertices, size_t max_indices, size_t max_draws)
+	: format_(format), max_vertices_(max_vertices), max_indices_(max_indices), max_draws_(max_draws),
+	vertex_count_(0), index_count_(0), draw_count_(0), last_call_count_(0)
+{
+	// the base instance field of the commands is only honoured with ARB_base_instance (GL 4.2)
+	base_instance_ = GLEW_ARB_base_instance != 0;
+	multi_draw_ = GLEW_ARB_multi_draw_indirect != 0 && base_instance_;
+
+	glGenVertexArrays(1, &vao_);
+	state.BindVertexArray(vao_);
+
+	glGenBuffers(1, &vertex_buffer_);
+	state.BindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+	glBufferData(GL_ARRAY_BUFFER, max_vertices * format_.Stride(), NULL, GL_STATIC_DRAW);
+	format_.Apply();
+
+	glGenBuffers(1, &index_buffer_);
+	state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, max_indices * sizeof(unsigned int), NULL, GL_STATIC_DRAW);
+
+	// one instance per draw, selected by the base instance of its command
+	glGenBuffers(1, &instance_buffer_);
+	state.BindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+	glBufferData(GL_ARRAY_BUFFER, max_draws * sizeof(QuadInstance), NULL, GL_STREAM_DRAW);
+	PointInstanceAttributes(0);
+	glVertexAttribDivisor(3, 1);
+	glVertexAttribDivisor(4, 1);
+
+	glGenBuffers(1, &indirect_buffer_);
+	if (multi_draw_)
+	{
+		state.BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, max_draws * sizeof(DrawElementsIndirectCommand), NULL, GL_STREAM_DRAW);
+	}
+}
+
+MeshBatcher::~MeshBatcher()
+{
+	glDeleteVertexArrays(1, &vao_);
+	glDeleteBuffers(1, &vertex_buffer_);
+	glDeleteBuffers(1, &index_buffer_);
+	glDeleteBuffers(1, &instance_buffer_);
+	glDeleteBuffers(1, &indirect_buffer_);
+}
+
+int MeshBatcher::AddMesh(GLState& state, const float* vertices, size_t vertex_count, const unsigned int* indices, size_t index_count)
+{
+	if (vertex_count_ + vertex_count > max_vertices_ || index_count_ + index_count > max_indices_)
+		return -1;
+
+	// indices stay relative to the mesh, base_vertex offsets them at draw time
+	state.BindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+	std::vector<unsigned char> packed = format_.Pack(vertices, vertex_count);
+	glBufferSubData(GL_ARRAY_BUFFER, vertex_count_ * format_.Stride(), packed.size(), packed.data());
+	state.BindVertexArray(vao_);
+	state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, index_count_ * sizeof(unsigned int), index_count * sizeof(unsigned int), indices);
+
+	MeshRange range;
+	range.first_index = (unsigned int)index_count_;
+	range.index_count = (unsigned int)index_count;
+	range.base_vertex = (int)vertex_count_;
+	meshes_.push_back(range);
+	vertex_count_ += vertex_count;
+	index_count_ += index_count;
+	return (int)meshes_.size() - 1;
+}
+
+void MeshBatcher::Clear()
+{
+	for (size_t b = 0; b < buckets_.size(); b++)
+	{
+		buckets_[b].draws.clear();
+		buckets_[b].command_count = 0;
+	}
+	draw_count_ = 0;
+}
+
+bool MeshBatcher::AddDraw(int bucket, int mesh, const QuadInstance& instance)
+{
+	if (draw_count_ >= max_draws_)
+		return false;
+	if ((size_t)bucket >= buckets_.size())
+	{
+		Bucket empty;
+		empty.first_command = empty.command_count = 0;
+		buckets_.resize(bucket + 1, empty);
+	}
+	PendingDraw draw = { mesh, instance };
+	buckets_[bucket].draws.push_back(draw);
+	draw_count_++;
+	return true;
+}
+
+void MeshBatcher::Upload(GLState& state)
+{
+	// lay the buckets out back to back, command i uses instance i
+	commands_.clear();
+	instances_.clear();
+	for (size_t b = 0; b < buckets_.size(); b++)
+	{
+		Bucket& bucket = buckets_[b];
+		bucket.first_command = commands_.size();
+		bucket.command_count = bucket.draws.size();
+		for (size_t d = 0; d < bucket.draws.size(); d++)
+		{
+			const MeshRange& mesh = meshes_[bucket.draws[d].mesh];
+			DrawElementsIndirectCommand command;
+			command.count = mesh.index_count;
+			command.instance_count = 1;
+			command.first_index = mesh.first_index;
+			command.base_vertex = mesh.base_vertex;
+			command.base_instance = (unsigned int)commands_.size();
+			commands_.push_back(command);
+			instances_.push_back(bucket.draws[d].instance);
+		}
+	}
+	if (commands_.empty())
+		return;
+
+	// orphan both stream buffers so the previous frame's draws can keep reading theirs
+	state.BindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+	glBufferData(GL_ARRAY_BUFFER, max_draws_ * sizeof(QuadInstance), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, instances_.size() * sizeof(QuadInstance), instances_.data());
+	if (multi_draw_)
+	{
+		state.BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, max_draws_ * sizeof(DrawElementsIndirectCommand), NULL, GL_STREAM_DRAW);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands_.size() * sizeof(DrawElementsIndirectCommand), commands_.data());
+	}
+}
+
+void MeshBatcher::Draw(GLState& state, int bucket_index)
+{
+	last_call_count_ = 0;
+	if ((size_t)bucket_index >= buckets_.size() || buckets_[bucket_index].command_count == 0)
+		return;
+	const Bucket& bucket = buckets_[bucket_index];
+	state.BindVertexArray(vao_);
+
+	if (multi_draw_)
+	{
+		state.BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_);
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+			(void*)(bucket.first_command * sizeof(DrawElementsIndirectCommand)), (GLsizei)bucket.command_count, 0);
+		last_call_count_ = 1;
+		return;
+	}
+
+	// fallback: the same commands, issued from the CPU
+	for (size_t c = bucket.first_command; c < bucket.first_command + bucket.command_count; c++)
+	{
+		const DrawElementsIndirectCommand& command = commands_[c];
+		void* offset = (void*)(command.first_index * sizeof(unsigned int));
+		if (base_instance_)
+		{
+			glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, offset,
+				command.instance_count, command.base_vertex, command.base_instance);
+		}
+		else
+		{
+			// GL 3.3 has no base instance, move the instance attributes to the draw's instance instead
+			state.BindBuffer(GL_ARRAY_BUFFER, instance_buffer_);
+			PointInstanceAttributes(command.base_instance);
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, offset,
+				command.instance_count, command.base_vertex);
+		}
+		last_call_count_++;
+	}
+	if (!base_instance_)
+		PointInstanceAttributes(0);
+}
+
+void MeshBatcher::PointInstanceAttributes(size_t first_instance)
+{
+	// the instance buffer has to be bound to GL_ARRAY_BUFFER
+	InstancedRenderer::InstanceFormat().Apply(first_instance * sizeof(QuadInstance));
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#ifndef MESH_BATCHER_H
+#define MESH_BATCHER_H
+
+#include <GL/glew.h> // include glew to get all the required OpenGL headers
+
+#include <vector>
+#include "GLState.h"
+#include "InstancedRenderer.h"
+#include "VertexFormat.h"
+
+// command layout read by glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+	unsigned int count;
+	unsigned int instance_count;
+	unsigned int first_index;
+	int base_vertex;
+	unsigned int base_instance;
+};
+
+// Merges meshes that share one vertex format into one vertex and one index megabuffer, and draws each bucket of draws (typically one per material) with a
+// single glMultiDrawElementsIndirect. Every draw has a QuadInstance that shader.vert picks
+// up through the command's base instance, so draws keep their own transform and layer.
+// Without multi-draw indirect the commands are issued one by one from the CPU.
+class MeshBatcher
+{
+public:
+	// where a mesh ended up inside the megabuffers
+	struct MeshRange
+	{
+		unsigned int first_index;
+		unsigned int index_count;
+		int base_vertex;
+	};
+
+	// the VAO is set up through the state cache, which ends up with it bound
+	MeshBatcher(GLState& state, const VertexFormat& format, size_t max_vertices, size_t max_indices, size_t max_draws);
+	~MeshBatcher();
+	MeshBatcher(const MeshBatcher&) = delete;
+	MeshBatcher& operator=(const MeshBatcher&) = delete;
+
+	// pack a mesh (float vertices, see VertexFormat::Pack) into the megabuffers, -1 if it doesn't fit
+	int AddMesh(GLState& state, const float* vertices, size_t vertex_count, const unsigned int* indices, size_t index_count);
+	const MeshRange& Mesh(int mesh) const { return meshes_[mesh]; }
+
+	// forget the draws of the previous frame
+	void Clear();
+	// returns false once max_draws has been reached
+	bool AddDraw(int bucket, int mesh, const QuadInstance& instance);
+	// upload the commands and instances of all buckets, once per frame before the first Draw
+	void Upload(GLState& state);
+	// draw one bucket, the caller binds its program and textures
+	void Draw(GLState& state, int bucket);
+	size_t BucketCount() const { return buckets_.size(); }
+	// GL calls the last Draw needed, 1 with multi-draw indirect
+	size_t LastCallCount() const { return last_call_count_; }
+	bool IsMultiDrawSupported() const { return multi_draw_; }
+
+private:
+	struct PendingDraw
+	{
+		int mesh;
+		QuadInstance instance;
+	};
+
+	// range of the indirect buffer that belongs to one bucket, filled in by Upload
+	struct Bucket
+	{
+		std::vector<PendingDraw> draws;
+		size_t first_command;
+		size_t command_count;
+	};
+
+	void PointInstanceAttributes(size_t first_instance);
+
+	VertexFormat format_;
+	unsigned int vao_;
+	unsigned int vertex_buffer_;
+	unsigned int index_buffer_;
+	unsigned int instance_buffer_;
+	unsigned int indirect_buffer_;
+	size_t max_vertices_;
+	size_t max_indices_;
+	size_t max_draws_;
+	size_t vertex_count_;
+	size_t index_count_;
+	size_t draw_count_;
+	std::vector<MeshRange> meshes_;
+	std::vector<Bucket> buckets_;
+	std::vector<DrawElementsIndirectCommand> commands_;
+	std::vector<QuadInstance> instances_;
+	bool multi_draw_;
+	bool base_instance_;
+	size_t last_call_count_;
+};
+
+#endif // !MESH_BATCHER_H
\ No newline at end of file
@@ -0,0 +1,314 @@
+#include "MeshFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "LZ4.h"
+
+static const char kMeshMagic[4] = { 'M', 'E', 'S', 'H' };
+static const unsigned int kMaxAttributes = 16;
+
+struct MeshFileHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int vertex_count;
+	unsigned int index_count;
+	unsigned int vertex_stride;
+	unsigned int index_size;
+	unsigned int attribute_count;
+	unsigned int chunk_count;
+	MeshBounds bounds;
+};
+
+struct MeshFileAttribute
+{
+	unsigned int location;
+	unsigned int components;
+	unsigned int type;
+	unsigned int offset;
+};
+
+static void ResetBounds(MeshBounds& bounds)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		bounds.min[i] = 1e30f;
+		bounds.max[i] = -1e30f;
+	}
+}
+
+static void GrowBounds(MeshBounds& bounds, const float* position)
+{
+	for (int i = 0; i < 3; i++)
+	{
+		bounds.min[i] = std::min(bounds.min[i], position[i]);
+		bounds.max[i] = std::max(bounds.max[i], position[i]);
+	}
+}
+
+// an empty box is stored as all zeros rather than inverted
+static void FinishBounds(MeshBounds& bounds)
+{
+	if (bounds.min[0] > bounds.max[0])
+		std::memset(&bounds, 0, sizeof(bounds));
+}
+
+// compress a chunk and append it to the payload, storing it raw if LZ4 doesn't make it smaller
+static void AppendChunk(const unsigned char* data, MeshChunk& chunk, std::vector<unsigned char>& payload, size_t payload_start)
+{
+	size_t raw_size = (size_t)chunk.raw_size;
+	size_t start = payload.size();
+	payload.resize(start + LZ4::MaxCompressedSize(raw_size));
+	size_t compressed_size = LZ4::Compress(data, raw_size, &payload[start], payload.size() - start);
+	if (compressed_size == 0 || compressed_size >= raw_size)
+	{
+		std::memcpy(&payload[start], data, raw_size);
+		compressed_size = raw_size;
+	}
+	payload.resize(start + compressed_size);
+	chunk.compressed_size = (unsigned int)compressed_size;
+	chunk.file_offset = payload_start + start;
+}
+
+bool MeshFile::Write(const char* path, const VertexFormat& format, const float* vertices, size_t vertex_count,
+	const unsigned int* indices, size_t index_count)
+{
+	int source_floats = format.SourceFloats();
+	if (source_floats < 3 || format.Attributes().size() > kMaxAttributes || index_count % 3 != 0)
+	{
+		std::cout << "ERROR::MESH_FILE::UNSUPPORTED_MESH " << path << std::endl;
+		return false;
+	}
+	for (size_t i = 0; i < index_count; i++)
+	{
+		if (indices[i] >= vertex_count)
+		{
+			std::cout << "ERROR::MESH_FILE::INDEX_OUT_OF_RANGE " << path << std::endl;
+			return false;
+		}
+	}
+
+	std::vector<unsigned char> packed = format.Pack(vertices, vertex_count);
+	unsigned int index_size = vertex_count <= 65536 ? 2 : 4;
+	std::vector<unsigned char> index_data(index_count * index_size);
+	for (size_t i = 0; i < index_count; i++)
+	{
+		if (index_size == 2)
+		{
+			unsigned short index = (unsigned short)indices[i];
+			std::memcpy(&index_data[i * 2], &index, 2);
+		}
+		else
+		{
+			std::memcpy(&index_data[i * 4], &indices[i], 4);
+		}
+	}
+
+	// chunks hold whole vertices and whole triangles, so each has meaningful bounds
+	size_t stride = format.Stride();
+	size_t chunk_vertices = std::max((size_t)1, kChunkSize / stride);
+	size_t chunk_indices = std::max((size_t)3, kChunkSize / index_size / 3 * 3);
+	size_t vertex_chunks = (vertex_count + chunk_vertices - 1) / chunk_vertices;
+	size_t index_chunks = (index_count + chunk_indices - 1) / chunk_indices;
+
+	MeshFileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, kMeshMagic, sizeof(kMeshMagic));
+	header.version = kVersion;
+	header.vertex_count = (unsigned int)vertex_count;
+	header.index_count = (unsigned int)index_count;
+	header.vertex_stride = (unsigned int)stride;
+	header.index_size = index_size;
+	header.attribute_count = (unsigned int)format.Attributes().size();
+	header.chunk_count = (unsigned int)(vertex_chunks + index_chunks);
+	ResetBounds(header.bounds);
+	for (size_t v = 0; v < vertex_count; v++)
+		GrowBounds(header.bounds, &vertices[v * source_floats]);
+	FinishBounds(header.bounds);
+
+	std::vector<MeshFileAttribute> attributes(header.attribute_count);
+	for (size_t a = 0; a < attributes.size(); a++)
+	{
+		const VertexAttribute& attribute = format.Attributes()[a];
+		attributes[a].location = attribute.location;
+		attributes[a].components = attribute.components;
+		attributes[a].type = attribute.type;
+		attributes[a].offset = (unsigned int)attribute.offset;
+	}
+
+	size_t payload_start = sizeof(header) + attributes.size() * sizeof(MeshFileAttribute) + header.chunk_count * sizeof(MeshChunk);
+	std::vector<MeshChunk> chunks(header.chunk_count);
+	std::vector<unsigned char> payload;
+	for (size_t c = 0; c < vertex_chunks; c++)
+	{
+		size_t first = c * chunk_vertices;
+		size_t count = std::min(chunk_vertices, vertex_count - first);
+		MeshChunk& chunk = chunks[c];
+		chunk.kind = kMeshChunkVertices;
+		chunk.raw_offset = first * stride;
+		chunk.raw_size = count * stride;
+		ResetBounds(chunk.bounds);
+		for (size_t v = first; v < first + count; v++)
+			GrowBounds(chunk.bounds, &vertices[v * source_floats]);
+		FinishBounds(chunk.bounds);
+		AppendChunk(&packed[first * stride], chunk, payload, payload_start);
+	}
+	for (size_t c = 0; c < index_chunks; c++)
+	{
+		size_t first = c * chunk_indices;
+		size_t count = std::min(chunk_indices, index_count - first);
+		MeshChunk& chunk = chunks[vertex_chunks + c];
+		chunk.kind = kMeshChunkIndices;
+		chunk.raw_offset = first * index_size;
+		chunk.raw_size = count * index_size;
+		ResetBounds(chunk.bounds);
+		for (size_t i = first; i < first + count; i++)
+			GrowBounds(chunk.bounds, &vertices[indices[i] * source_floats]);
+		FinishBounds(chunk.bounds);
+		AppendChunk(&index_data[first * index_size], chunk, payload, payload_start);
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)attributes.data(), attributes.size() * sizeof(MeshFileAttribute));
+	file.write((const char*)chunks.data(), chunks.size() * sizeof(MeshChunk));
+	file.write((const char*)payload.data(), payload.size());
+	return file.good();
+}
+
+bool MeshFile::ReadInfo(const unsigned char* contents, size_t size, unsigned long long file_size, MeshInfo& info)
+{
+	MeshFileHeader header;
+	if (size < sizeof(header))
+		return false;
+	std::memcpy(&header, contents, sizeof(header));
+	if (std::memcmp(header.magic, kMeshMagic, sizeof(kMeshMagic)) != 0 || header.version != kVersion
+		|| (header.index_size != 2 && header.index_size != 4)
+		|| header.attribute_count == 0 || header.attribute_count > kMaxAttributes)
+		return false;
+	unsigned long long tables_end = sizeof(header) + (unsigned long long)header.attribute_count * sizeof(MeshFileAttribute)
+		+ (unsigned long long)header.chunk_count * sizeof(MeshChunk);
+	if (tables_end > size)
+		return false;
+
+	// rebuilding the layout from the descriptors has to give the offsets the file was written with
+	info.format = VertexFormat();
+	const unsigned char* attributes = contents + sizeof(header);
+	for (unsigned int a = 0; a < header.attribute_count; a++)
+	{
+		MeshFileAttribute attribute;
+		std::memcpy(&attribute, attributes + a * sizeof(attribute), sizeof(attribute));
+		if (attribute.components < 1 || attribute.components > 4 || attribute.type > kVertexSnorm10_10_10_2
+			|| attribute.offset != info.format.Stride())
+			return false;
+		info.format.Add((int)attribute.location, (int)attribute.components, (VertexType)attribute.type);
+	}
+	if (info.format.Stride() != header.vertex_stride)
+		return false;
+
+	info.vertex_count = header.vertex_count;
+	info.index_count = header.index_count;
+	info.index_size = header.index_size;
+	info.bounds = header.bounds;
+	info.chunks.resize(header.chunk_count);
+	if (header.chunk_count > 0)
+		std::memcpy(info.chunks.data(), attributes + header.attribute_count * sizeof(MeshFileAttribute), header.chunk_count * sizeof(MeshChunk));
+
+	// every chunk has to lie inside its buffer and the file, index chunks hold whole indices
+	unsigned long long buffer_sizes[2] = { info.VertexBytes(), info.IndexBytes() };
+	std::vector<const MeshChunk*> by_kind[2];
+	for (size_t c = 0; c < info.chunks.size(); c++)
+	{
+		const MeshChunk& chunk = info.chunks[c];
+		if (chunk.kind > kMeshChunkIndices || chunk.raw_size > kChunkSize || chunk.compressed_size > chunk.raw_size
+			|| chunk.raw_offset > buffer_sizes[chunk.kind] || chunk.raw_size > buffer_sizes[chunk.kind] - chunk.raw_offset
+			|| chunk.file_offset < tables_end || chunk.file_offset + chunk.compressed_size > file_size)
+			return false;
+		if (chunk.kind == kMeshChunkIndices && (chunk.raw_offset % info.index_size != 0 || chunk.raw_size % info.index_size != 0))
+			return false;
+		by_kind[chunk.kind].push_back(&chunk);
+	}
+
+	// sorted by offset, each chunk has to start where the previous one ended. adding up the sizes
+	// isn't enough, overlapping chunks could leave a gap of uninitialized buffer memory
+	for (int kind = 0; kind < 2; kind++)
+	{
+		std::sort(by_kind[kind].begin(), by_kind[kind].end(), [](const MeshChunk* a, const MeshChunk* b)
+		{
+			return a->raw_offset < b->raw_offset;
+		});
+		unsigned long long end = 0;
+		for (size_t c = 0; c < by_kind[kind].size(); c++)
+		{
+			if (by_kind[kind][c]->raw_offset != end)
+				return false;
+			end += by_kind[kind][c]->raw_size;
+		}
+		if (end != buffer_sizes[kind])
+			return false;
+	}
+	return true;
+}
+
+bool MeshFile::ReadInfo(const char* path, MeshInfo& info)
+{
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		return false;
+	unsigned long long file_size = (unsigned long long)file.tellg();
+	file.seekg(0);
+
+	// the header says how large the tables after it are
+	MeshFileHeader header;
+	if (!file.read((char*)&header, sizeof(header)))
+		return false;
+	if (header.attribute_count > kMaxAttributes)
+		return false;
+	unsigned long long tables_end = sizeof(header) + (unsigned long long)header.attribute_count * sizeof(MeshFileAttribute)
+		+ (unsigned long long)header.chunk_count * sizeof(MeshChunk);
+	if (tables_end > file_size)
+		return false;
+	std::vector<unsigned char> tables((size_t)tables_end);
+	std::memcpy(tables.data(), &header, sizeof(header));
+	if (!file.read((char*)&tables[sizeof(header)], tables.size() - sizeof(header)))
+		return false;
+	return ReadInfo(tables.data(), tables.size(), file_size, info);
+}
+
+bool MeshFile::DecompressChunk(const MeshChunk& chunk, const unsigned char* compressed, unsigned char* destination)
+{
+	if (chunk.compressed_size == chunk.raw_size)
+	{
+		std::memcpy(destination, compressed, (size_t)chunk.raw_size);
+		return true;
+	}
+	return LZ4::Decompress(compressed, chunk.compressed_size, destination, (size_t)chunk.raw_size);
+}
+
+bool MeshFile::IndicesInRange(const MeshInfo& info, const unsigned char* indices, size_t size)
+{
+	size_t count = size / info.index_size;
+	if (info.index_size == 2)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			unsigned short index;
+			std::memcpy(&index, indices + i * 2, 2);
+			if (index >= info.vertex_count)
+				return false;
+		}
+		return true;
+	}
+	for (size_t i = 0; i < count; i++)
+	{
+		unsigned int index;
+		std::memcpy(&index, indices + i * 4, 4);
+		if (index >= info.vertex_count)
+			return false;
+	}
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef MESH_FILE_H
+#define MESH_FILE_H
+
+#include <GL/glew.h> // include glew to get all the required OpenGL headers
+
+#include <vector>
+#include "VertexFormat.h"
+
+// axis aligned box around positions
+struct MeshBounds
+{
+	float min[3];
+	float max[3];
+};
+
+enum MeshChunkKind
+{
+	kMeshChunkVertices,
+	kMeshChunkIndices
+};
+
+// one independently compressed piece of the vertex or index buffer, stored in the file as is
+struct MeshChunk
+{
+	unsigned int kind;
+	// equal to raw_size if the chunk didn't compress and is stored uncompressed
+	unsigned int compressed_size;
+	// where the chunk goes in the vertex or index buffer
+	unsigned long long raw_offset;
+	unsigned long long raw_size;
+	unsigned long long file_offset;
+	// positions of the chunk's vertices, or of the vertices its triangles use
+	MeshBounds bounds;
+};
+
+// everything in a mesh file except the vertex and index data
+struct MeshInfo
+{
+	unsigned int vertex_count;
+	unsigned int index_count;
+	// 2 or 4 bytes, 16-bit indices are used whenever the vertex count allows it
+	unsigned int index_size;
+	VertexFormat format;
+	MeshBounds bounds;
+	std::vector<MeshChunk> chunks;
+
+	size_t VertexBytes() const { return (size_t)vertex_count * format.Stride(); }
+	size_t IndexBytes() const { return (size_t)index_count * index_size; }
+	GLenum IndexType() const { return index_size == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT; }
+};
+
+// Binary mesh file: versioned header, vertex layout, chunk table, then the vertex and index
+// buffers split into chunks of about kChunkSize bytes that are LZ4 compressed one by one,
+// so a loader can decompress them in parallel straight into buffer memory. Nothing has to
+// be parsed or converted at load time, the data is already in the GPU vertex layout.
+class MeshFile
+{
+public:
+	static const unsigned int kVersion = 1;
+	static const size_t kChunkSize = 256 * 1024;
+
+	// pack the float vertices into the format and write the file. the first three source floats
+	// of every vertex are taken as its position for the bounding boxes
+	static bool Write(const char* path, const VertexFormat& format, const float* vertices, size_t vertex_count,
+		const unsigned int* indices, size_t index_count);
+	// parse the header and tables at the start of the file. size is how much of the file
+	// is available, chunks are checked against file_size
+	static bool ReadInfo(const unsigned char* contents, size_t size, unsigned long long file_size, MeshInfo& info);
+	// same, reading only the start of the file from disk
+	static bool ReadInfo(const char* path, MeshInfo& info);
+	// decompress one chunk, compressed holds its compressed_size bytes and destination its raw_size bytes
+	static bool DecompressChunk(const MeshChunk& chunk, const unsigned char* compressed, unsigned char* destination);
+	// true if every index of a decompressed index chunk refers to one of the mesh's vertices.
+	// ReadInfo only checks the tables, the indices themselves are not trusted until this passes
+	static bool IndicesInRange(const MeshInfo& info, const unsigned char* indices, size_t size);
+};
+
+#endif // !MESH_FILE_H
\ No newline at end of file
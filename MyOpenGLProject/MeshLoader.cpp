@@ -0,0 +1,238 @@
+#include "MeshLoader.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "InstancedRenderer.h"
+
+// room for this many parsed headers in flight between the workers and the GL thread
+static const size_t kParsedQueueCapacity = 256;
+// chunks decompressed by one task, enough to make opening the file per task cheap
+static const size_t kChunksPerTask = 8;
+
+MeshLoader::MeshLoader(unsigned int identity_instance, unsigned int worker_count)
+	: workers_(worker_count), parsed_(kParsedQueueCapacity), pending_(0), identity_instance_(identity_instance)
+{
+}
+
+MeshLoader::~MeshLoader()
+{
+	// the workers may still be writing into mapped buffers
+	workers_.WaitIdle();
+	PendingMesh* mesh;
+	while (parsed_.TryPop(mesh))
+		delete mesh;
+	for (size_t i = 0; i < streaming_.size(); i++)
+		delete streaming_[i];
+	// deleting a mapped buffer unmaps it
+	for (size_t m = 0; m < meshes_.size(); m++)
+	{
+		glDeleteVertexArrays(1, &meshes_[m].vertex_array);
+		glDeleteBuffers(1, &meshes_[m].vertex_buffer);
+		glDeleteBuffers(1, &meshes_[m].index_buffer);
+	}
+}
+
+MeshLoader::Handle MeshLoader::Load(const char* path)
+{
+	AssetSpan from_disk = { NULL, 0 };
+	return Submit(path, from_disk);
+}
+
+MeshLoader::Handle MeshLoader::Load(const AssetPack& pack, const char* name)
+{
+	AssetSpan source = pack.Find(name);
+	if (source.IsEmpty())
+		std::cout << "ERROR::MESH_LOADER::NOT_IN_ASSET_PACK " << name << std::endl;
+	return Submit(name, source);
+}
+
+MeshLoader::Handle MeshLoader::Submit(const char* path, AssetSpan source)
+{
+	LoadedMesh loaded;
+	std::memset(&loaded, 0, sizeof(loaded));
+	meshes_.push_back(loaded);
+
+	PendingMesh* mesh = new PendingMesh();
+	mesh->handle = meshes_.size() - 1;
+	mesh->path = path;
+	mesh->source = source;
+	mesh->info_valid = false;
+	mesh->vertex_memory = mesh->index_memory = NULL;
+	mesh->chunks_left = 0;
+	mesh->chunk_failed = false;
+	pending_++;
+	workers_.Enqueue([this, mesh] { ReadInfo(mesh); });
+	return mesh->handle;
+}
+
+void MeshLoader::ReadInfo(PendingMesh* mesh)
+{
+	if (!mesh->source.IsEmpty())
+		mesh->info_valid = MeshFile::ReadInfo(mesh->source.data, mesh->source.size, mesh->source.size, mesh->info);
+	else
+		mesh->info_valid = MeshFile::ReadInfo(mesh->path.c_str(), mesh->info);
+	// the GL thread drains the queue every frame, so a full queue only means waiting a little
+	while (!parsed_.TryPush(mesh))
+		std::this_thread::yield();
+}
+
+void MeshLoader::Update(GLState& state)
+{
+	PendingMesh* mesh;
+	while (parsed_.TryPop(mesh))
+	{
+		if (!mesh->info_valid || mesh->info.vertex_count == 0 || mesh->info.index_count == 0)
+			Fail(state, mesh);
+		else
+			Map(state, mesh);
+	}
+
+	for (size_t i = 0; i < streaming_.size();)
+	{
+		mesh = streaming_[i];
+		if (mesh->chunks_left.load(std::memory_order_acquire) > 0)
+		{
+			i++;
+			continue;
+		}
+		streaming_[i] = streaming_.back();
+		streaming_.pop_back();
+		Complete(state, mesh);
+	}
+}
+
+void MeshLoader::Finish(GLState& state)
+{
+	while (pending_ > 0)
+	{
+		Update(state);
+		if (pending_ > 0)
+			std::this_thread::yield();
+	}
+}
+
+void MeshLoader::Map(GLState& state, PendingMesh* mesh)
+{
+	LoadedMesh& loaded = meshes_[mesh->handle];
+	const MeshInfo& info = mesh->info;
+	loaded.index_count = info.index_count;
+	loaded.index_type = info.IndexType();
+	loaded.bounds = info.bounds;
+
+	// the index buffer binding is part of the VAO, so the VAO has to be bound first
+	glGenVertexArrays(1, &loaded.vertex_array);
+	glGenBuffers(1, &loaded.vertex_buffer);
+	glGenBuffers(1, &loaded.index_buffer);
+	state.BindVertexArray(loaded.vertex_array);
+	state.BindBuffer(GL_ARRAY_BUFFER, loaded.vertex_buffer);
+	glBufferData(GL_ARRAY_BUFFER, info.VertexBytes(), NULL, GL_STATIC_DRAW);
+	mesh->vertex_memory = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, info.VertexBytes(),
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, loaded.index_buffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, info.IndexBytes(), NULL, GL_STATIC_DRAW);
+	mesh->index_memory = (unsigned char*)glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, info.IndexBytes(),
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (!mesh->vertex_memory || !mesh->index_memory)
+	{
+		std::cout << "ERROR::MESH_LOADER::MAP_FAILED " << mesh->path << std::endl;
+		Fail(state, mesh);
+		return;
+	}
+
+	// the mapped pointers are plain memory, any thread may write them until the buffers are unmapped
+	mesh->chunks_left = info.chunks.size();
+	streaming_.push_back(mesh);
+	for (size_t first = 0; first < info.chunks.size(); first += kChunksPerTask)
+	{
+		size_t count = info.chunks.size() - first < kChunksPerTask ? info.chunks.size() - first : kChunksPerTask;
+		workers_.Enqueue([this, mesh, first, count] { DecompressChunks(mesh, first, count); });
+	}
+}
+
+void MeshLoader::DecompressChunks(PendingMesh* mesh, size_t first, size_t count)
+{
+	// from disk every task reads its own chunks, so the reads are spread over the workers too
+	std::ifstream file;
+	std::vector<unsigned char> compressed, indices;
+	if (mesh->source.IsEmpty())
+		file.open(mesh->path.c_str(), std::ios::binary);
+
+	bool failed = false;
+	for (size_t c = first; c < first + count && !failed; c++)
+	{
+		const MeshChunk& chunk = mesh->info.chunks[c];
+		const unsigned char* input;
+		if (mesh->source.IsEmpty())
+		{
+			compressed.resize(chunk.compressed_size);
+			file.seekg((std::streamoff)chunk.file_offset);
+			if (!file.read((char*)compressed.data(), compressed.size()))
+			{
+				failed = true;
+				break;
+			}
+			input = compressed.data();
+		}
+		else
+		{
+			input = mesh->source.data + chunk.file_offset;
+		}
+		if (chunk.kind == kMeshChunkVertices)
+		{
+			failed = !MeshFile::DecompressChunk(chunk, input, mesh->vertex_memory + chunk.raw_offset);
+			continue;
+		}
+		// indices are checked against the vertex count before they reach the GPU. mapped memory
+		// is write-only (and often uncached), so the check runs on a copy
+		indices.resize((size_t)chunk.raw_size);
+		failed = !MeshFile::DecompressChunk(chunk, input, indices.data())
+			|| !MeshFile::IndicesInRange(mesh->info, indices.data(), indices.size());
+		if (!failed)
+			std::memcpy(mesh->index_memory + chunk.raw_offset, indices.data(), indices.size());
+	}
+
+	if (failed)
+		mesh->chunk_failed = true;
+	mesh->chunks_left.fetch_sub(count, std::memory_order_release);
+}
+
+void MeshLoader::Complete(GLState& state, PendingMesh* mesh)
+{
+	LoadedMesh& loaded = meshes_[mesh->handle];
+	state.BindVertexArray(loaded.vertex_array);
+	state.BindBuffer(GL_ARRAY_BUFFER, loaded.vertex_buffer);
+	state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, loaded.index_buffer);
+	// unmapping returns false if the contents were lost while mapped (e.g. a mode switch)
+	bool vertices_intact = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+	bool indices_intact = glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) == GL_TRUE;
+	if (mesh->chunk_failed || !vertices_intact || !indices_intact)
+	{
+		Fail(state, mesh);
+		return;
+	}
+
+	mesh->info.format.Apply();
+	InstancedRenderer::ApplyIdentityInstance(state, identity_instance_);
+	loaded.ready = true;
+	pending_--;
+	delete mesh;
+}
+
+void MeshLoader::Fail(GLState& state, PendingMesh* mesh)
+{
+	std::cout << "Failed to load mesh " << mesh->path << std::endl;
+	LoadedMesh& loaded = meshes_[mesh->handle];
+	if (loaded.vertex_array)
+	{
+		glDeleteVertexArrays(1, &loaded.vertex_array);
+		glDeleteBuffers(1, &loaded.vertex_buffer);
+		glDeleteBuffers(1, &loaded.index_buffer);
+		// deleting bound objects unbinds them behind the cache's back
+		state.Invalidate();
+	}
+	std::memset(&loaded, 0, sizeof(loaded));
+	loaded.failed = true;
+	pending_--;
+	delete mesh;
+}
\ No newline at end of file
@@ -0,0 +1,90 @@
+#ifndef MESH_LOADER_H
+#define MESH_LOADER_H
+
+#include <GL/glew.h> // include glew to get all the required OpenGL headers
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+#include "GLState.h"
+#include "LockFreeQueue.h"
+#include "MeshFile.h"
+#include "ThreadPool.h"
+
+// GL objects of a mesh, the VAO has the vertex layout and the index buffer set up
+struct LoadedMesh
+{
+	unsigned int vertex_array;
+	unsigned int vertex_buffer;
+	unsigned int index_buffer;
+	unsigned int index_count;
+	GLenum index_type;
+	MeshBounds bounds;
+	// set once the data is in the buffers, nothing may be drawn before
+	bool ready;
+	bool failed;
+};
+
+// Streams mesh files into GL buffers. A worker reads the header, the GL thread creates the
+// buffers and maps them, then the workers decompress the chunks straight into the mapped
+// memory and the GL thread unmaps once the last chunk is in. Every mesh gets its own buffers
+// because a buffer can only be mapped once at a time. The loader owns the GL objects.
+class MeshLoader
+{
+public:
+	typedef size_t Handle;
+
+	// identity_instance is InstancedRenderer::CreateIdentityInstance's buffer, the meshes are drawn
+	// without instancing. 0 workers starts one per hardware thread
+	explicit MeshLoader(unsigned int identity_instance, unsigned int worker_count = 0);
+	~MeshLoader();
+	MeshLoader(const MeshLoader&) = delete;
+	MeshLoader& operator=(const MeshLoader&) = delete;
+
+	Handle Load(const char* path);
+	// same, decompressing from the pack's mapping (the pack must stay open until the mesh is ready)
+	Handle Load(const AssetPack& pack, const char* name);
+	// GL thread, once per frame: map the buffers of meshes whose header has been read and
+	// finish the meshes whose chunks are all decompressed
+	void Update(GLState& state);
+	// GL thread: block until every queued mesh is ready or has failed
+	void Finish(GLState& state);
+	LoadedMesh Get(Handle handle) const { return meshes_[handle]; }
+	// number of meshes that are not ready yet
+	size_t PendingCount() const { return pending_; }
+
+private:
+	// a mesh on its way from the file to the buffers
+	struct PendingMesh
+	{
+		Handle handle;
+		std::string path;
+		// the whole file when loading from an asset pack, NULL when loading from disk
+		AssetSpan source;
+		bool info_valid;
+		MeshInfo info;
+		unsigned char* vertex_memory;
+		unsigned char* index_memory;
+		std::atomic<size_t> chunks_left;
+		std::atomic<bool> chunk_failed;
+	};
+
+	Handle Submit(const char* path, AssetSpan source);
+	void ReadInfo(PendingMesh* mesh);
+	void Map(GLState& state, PendingMesh* mesh);
+	void DecompressChunks(PendingMesh* mesh, size_t first, size_t count);
+	void Complete(GLState& state, PendingMesh* mesh);
+	void Fail(GLState& state, PendingMesh* mesh);
+
+	ThreadPool workers_;
+	// meshes whose header has been read, waiting for their buffers
+	LockFreeQueue<PendingMesh*> parsed_;
+	// meshes with mapped buffers that the workers are decompressing into
+	std::vector<PendingMesh*> streaming_;
+	std::vector<LoadedMesh> meshes_;
+	size_t pending_;
+	unsigned int identity_instance_;
+};
+
+#endif // !MESH_LOADER_H
\ No newline at end of file
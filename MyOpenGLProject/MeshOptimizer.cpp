@@ -0,0 +1,298 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// below this many triangles a single Tipsify pass is faster than splitting the mesh
+static const size_t kParallelTriangles = 1 << 18;
+static const size_t kChunkTriangles = 1 << 16;
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const unsigned int* indices, size_t index_count,
+	size_t vertex_count, int cache_size)
+{
+	// FIFO cache: a vertex is in the cache if it was transformed within the last cache_size misses
+	std::vector<size_t> time_stamps(vertex_count, 0);
+	std::vector<char> referenced(vertex_count, 0);
+	size_t time = cache_size + 1;
+	size_t referenced_count = 0;
+	VertexCacheStats stats = { 0, 0.0f, 0.0f };
+	for (size_t i = 0; i < index_count; i++)
+	{
+		unsigned int v = indices[i];
+		if (time - time_stamps[v] > (size_t)cache_size)
+		{
+			time_stamps[v] = time++;
+			stats.vertices_transformed++;
+		}
+		if (!referenced[v])
+		{
+			referenced[v] = 1;
+			referenced_count++;
+		}
+	}
+	if (index_count > 0)
+		stats.acmr = (float)stats.vertices_transformed / (index_count / 3);
+	if (referenced_count > 0)
+		stats.atvr = (float)stats.vertices_transformed / referenced_count;
+	return stats;
+}
+
+void MeshOptimizer::Tipsify(const unsigned int* indices, size_t index_count, size_t vertex_count,
+	int cache_size, unsigned int* destination, std::vector<size_t>* hard_boundaries)
+{
+	size_t triangle_count = index_count / 3;
+
+	// triangles using each vertex, and how many of them are not emitted yet
+	std::vector<unsigned int> live(vertex_count, 0);
+	for (size_t i = 0; i < index_count; i++)
+		live[indices[i]]++;
+	std::vector<size_t> adjacency_offsets(vertex_count + 1, 0);
+	for (size_t v = 0; v < vertex_count; v++)
+		adjacency_offsets[v + 1] = adjacency_offsets[v] + live[v];
+	std::vector<unsigned int> adjacency(index_count);
+	std::vector<size_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+	for (size_t t = 0; t < triangle_count; t++)
+	{
+		for (int c = 0; c < 3; c++)
+			adjacency[fill[indices[t * 3 + c]]++] = (unsigned int)t;
+	}
+
+	std::vector<size_t> time_stamps(vertex_count, 0);
+	std::vector<char> emitted(triangle_count, 0);
+	std::vector<unsigned int> dead_end;
+	std::vector<unsigned int> candidates;
+	size_t time = cache_size + 1;
+	size_t cursor = 0;
+	size_t output = 0;
+	bool cold = true;
+	long long fanning = vertex_count > 0 ? 0 : -1;
+
+	while (fanning >= 0)
+	{
+		// emit every remaining triangle around the fanning vertex
+		candidates.clear();
+		unsigned int f = (unsigned int)fanning;
+		for (size_t a = adjacency_offsets[f]; a < adjacency_offsets[f + 1]; a++)
+		{
+			unsigned int t = adjacency[a];
+			if (emitted[t])
+				continue;
+			if (cold && hard_boundaries)
+				hard_boundaries->push_back(output / 3);
+			cold = false;
+			for (int c = 0; c < 3; c++)
+			{
+				unsigned int v = indices[t * 3 + c];
+				destination[output++] = v;
+				dead_end.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				if (time - time_stamps[v] > (size_t)cache_size)
+					time_stamps[v] = time++;
+			}
+			emitted[t] = 1;
+		}
+
+		// next fanning vertex: the one with live triangles that stays in the cache longest
+		long long best = -1;
+		long long best_priority = -1;
+		for (size_t n = 0; n < candidates.size(); n++)
+		{
+			unsigned int v = candidates[n];
+			if (live[v] == 0)
+				continue;
+			long long priority = 0;
+			if (time - time_stamps[v] + 2 * live[v] <= (size_t)cache_size)
+				priority = (long long)(time - time_stamps[v]);
+			if (priority > best_priority)
+			{
+				best = v;
+				best_priority = priority;
+			}
+		}
+
+		if (best < 0)
+		{
+			// dead end: back up through recently used vertices, then scan in index order
+			while (!dead_end.empty() && best < 0)
+			{
+				unsigned int v = dead_end.back();
+				dead_end.pop_back();
+				if (live[v] > 0)
+					best = v;
+			}
+			while (best < 0 && cursor < vertex_count)
+			{
+				if (live[cursor] > 0)
+					best = (long long)cursor;
+				cursor++;
+			}
+			// nothing recent is left, whatever comes next starts with an empty cache
+			cold = true;
+		}
+		fanning = best;
+	}
+}
+
+void MeshOptimizer::OptimizeVertexCache(unsigned int* indices, size_t index_count, size_t vertex_count,
+	int cache_size, ThreadPool* pool)
+{
+	size_t triangle_count = index_count / 3;
+	std::vector<unsigned int> result(index_count);
+	if (!pool || triangle_count < kParallelTriangles)
+	{
+		Tipsify(indices, index_count, vertex_count, cache_size, result.data(), NULL);
+		std::memcpy(indices, result.data(), index_count * sizeof(unsigned int));
+		return;
+	}
+
+	// counting sort of the triangles by their lowest vertex index. exported meshes number their
+	// vertices with some locality, so consecutive triangles in that order form connected patches
+	std::vector<size_t> bucket_offsets(vertex_count + 1, 0);
+	for (size_t t = 0; t < triangle_count; t++)
+	{
+		const unsigned int* tri = indices + t * 3;
+		bucket_offsets[std::min(tri[0], std::min(tri[1], tri[2])) + 1]++;
+	}
+	for (size_t v = 0; v < vertex_count; v++)
+		bucket_offsets[v + 1] += bucket_offsets[v];
+	std::vector<unsigned int> sorted(index_count);
+	for (size_t t = 0; t < triangle_count; t++)
+	{
+		const unsigned int* tri = indices + t * 3;
+		size_t slot = bucket_offsets[std::min(tri[0], std::min(tri[1], tri[2]))]++;
+		std::memcpy(&sorted[slot * 3], tri, 3 * sizeof(unsigned int));
+	}
+
+	// each chunk is optimized on its own, with its vertices renumbered to a compact range
+	size_t chunk_count = (triangle_count + kChunkTriangles - 1) / kChunkTriangles;
+	pool->ParallelFor(chunk_count, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t chunk = begin; chunk < end; chunk++)
+		{
+			size_t first = chunk * kChunkTriangles * 3;
+			size_t count = std::min(kChunkTriangles * 3, index_count - first);
+			std::vector<unsigned int> vertices(sorted.begin() + first, sorted.begin() + first + count);
+			std::sort(vertices.begin(), vertices.end());
+			vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+			std::vector<unsigned int> local(count);
+			for (size_t i = 0; i < count; i++)
+				local[i] = (unsigned int)(std::lower_bound(vertices.begin(), vertices.end(), sorted[first + i]) - vertices.begin());
+			std::vector<unsigned int> optimized(count);
+			Tipsify(local.data(), count, vertices.size(), cache_size, optimized.data(), NULL);
+			for (size_t i = 0; i < count; i++)
+				result[first + i] = vertices[optimized[i]];
+		}
+	});
+	std::memcpy(indices, result.data(), index_count * sizeof(unsigned int));
+}
+
+void MeshOptimizer::OptimizeOverdraw(unsigned int* indices, size_t index_count, const float* positions,
+	size_t position_stride, size_t vertex_count, int cache_size)
+{
+	size_t triangle_count = index_count / 3;
+	if (triangle_count == 0)
+		return;
+
+	// the clusters are the runs Tipsify emits between two cold starts
+	std::vector<unsigned int> ordered(index_count);
+	std::vector<size_t> boundaries;
+	Tipsify(indices, index_count, vertex_count, cache_size, ordered.data(), &boundaries);
+	boundaries.push_back(triangle_count);
+
+	// mesh centroid, weighted by triangle area
+	double mesh_centroid[3] = { 0.0, 0.0, 0.0 };
+	double mesh_area = 0.0;
+	std::vector<float> triangle_data(triangle_count * 7);
+	for (size_t t = 0; t < triangle_count; t++)
+	{
+		const float* p[3];
+		for (int c = 0; c < 3; c++)
+			p[c] = positions + (size_t)ordered[t * 3 + c] * position_stride;
+		float e1[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+		float e2[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+		// the cross product's length is twice the area, keeping it unnormalized weights by area
+		float* data = &triangle_data[t * 7];
+		data[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		data[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		data[2] = e1[0] * e2[1] - e1[1] * e2[0];
+		data[6] = std::sqrt(data[0] * data[0] + data[1] * data[1] + data[2] * data[2]);
+		for (int k = 0; k < 3; k++)
+		{
+			data[3 + k] = (p[0][k] + p[1][k] + p[2][k]) / 3.0f;
+			mesh_centroid[k] += data[3 + k] * data[6];
+		}
+		mesh_area += data[6];
+	}
+	for (int k = 0; k < 3; k++)
+		mesh_centroid[k] /= mesh_area > 0.0 ? mesh_area : 1.0;
+
+	// sort key: how far the cluster faces away from the mesh center
+	struct Cluster
+	{
+		size_t begin;
+		size_t end;
+		double key;
+	};
+	std::vector<Cluster> clusters;
+	for (size_t b = 0; b + 1 < boundaries.size(); b++)
+	{
+		double normal[3] = { 0.0, 0.0, 0.0 };
+		double centroid[3] = { 0.0, 0.0, 0.0 };
+		double area = 0.0;
+		for (size_t t = boundaries[b]; t < boundaries[b + 1]; t++)
+		{
+			const float* data = &triangle_data[t * 7];
+			for (int k = 0; k < 3; k++)
+			{
+				normal[k] += data[k];
+				centroid[k] += data[3 + k] * data[6];
+			}
+			area += data[6];
+		}
+		double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		double key = 0.0;
+		for (int k = 0; k < 3; k++)
+		{
+			double offset = centroid[k] / (area > 0.0 ? area : 1.0) - mesh_centroid[k];
+			key += offset * (length > 0.0 ? normal[k] / length : 0.0);
+		}
+		Cluster cluster = { boundaries[b], boundaries[b + 1], key };
+		clusters.push_back(cluster);
+	}
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.key > b.key; });
+
+	size_t output = 0;
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		size_t count = (clusters[c].end - clusters[c].begin) * 3;
+		std::memcpy(indices + output, &ordered[clusters[c].begin * 3], count * sizeof(unsigned int));
+		output += count;
+	}
+}
+
+size_t MeshOptimizer::OptimizeVertexFetch(unsigned int* indices, size_t index_count, void* vertices,
+	size_t vertex_count, size_t vertex_size)
+{
+	const unsigned int kUnused = 0xFFFFFFFFu;
+	std::vector<unsigned int> remap(vertex_count, kUnused);
+	unsigned int next = 0;
+	for (size_t i = 0; i < index_count; i++)
+	{
+		unsigned int& slot = remap[indices[i]];
+		if (slot == kUnused)
+			slot = next++;
+		indices[i] = slot;
+	}
+
+	std::vector<unsigned char> reordered((size_t)next * vertex_size);
+	const unsigned char* source = (const unsigned char*)vertices;
+	for (size_t v = 0; v < vertex_count; v++)
+	{
+		if (remap[v] != kUnused)
+			std::memcpy(&reordered[(size_t)remap[v] * vertex_size], source + v * vertex_size, vertex_size);
+	}
+	std::memcpy(vertices, reordered.data(), reordered.size());
+	return next;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <vector>
+#include "ThreadPool.h"
+
+// post-transform vertex cache behaviour of an index buffer, simulated with a FIFO cache
+struct VertexCacheStats
+{
+	size_t vertices_transformed;
+	// average cache miss ratio: transformed vertices per triangle, 0.5 at best on large grids, 3 at worst
+	float acmr;
+	// average transform to vertex ratio: transformed vertices per referenced vertex, 1 at best
+	float atvr;
+};
+
+// Reorders triangle lists for the GPU: triangles for the post-transform vertex cache
+// (Tipsify, Sander et al. 2007), then clusters of them for less overdraw, then vertices
+// for fetch locality. All functions work on 32-bit triangle lists in place.
+class MeshOptimizer
+{
+public:
+	static const int kDefaultCacheSize = 16;
+
+	// Tipsify. meshes larger than a few hundred thousand triangles are split into chunks of
+	// triangles with nearby vertex indices that are optimized on the pool's workers in parallel
+	static void OptimizeVertexCache(unsigned int* indices, size_t index_count, size_t vertex_count,
+		int cache_size = kDefaultCacheSize, ThreadPool* pool = NULL);
+	// Tipsify, then split its output into clusters where the cache runs cold and sort them so
+	// outward facing clusters, which tend to occlude the rest, are drawn first. clusters keep
+	// their cache friendly order, so this replaces OptimizeVertexCache at about the same ACMR.
+	// positions are 3 floats every position_stride floats
+	static void OptimizeOverdraw(unsigned int* indices, size_t index_count, const float* positions,
+		size_t position_stride, size_t vertex_count, int cache_size = kDefaultCacheSize);
+	// renumber vertices in order of first use and move them accordingly, dropping unreferenced
+	// ones. returns the new vertex count
+	static size_t OptimizeVertexFetch(unsigned int* indices, size_t index_count, void* vertices,
+		size_t vertex_count, size_t vertex_size);
+
+	static VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, size_t index_count,
+		size_t vertex_count, int cache_size = kDefaultCacheSize);
+
+private:
+	static void Tipsify(const unsigned int* indices, size_t index_count, size_t vertex_count,
+		int cache_size, unsigned int* destination, std::vector<size_t>* hard_boundaries);
+};
+
+#endif // !MESH_OPTIMIZER_H
\ No newline at end of file
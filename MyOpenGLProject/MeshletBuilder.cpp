@@ -0,0 +1,267 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+
+static void Subtract(const float* a, const float* b, float* result)
+{
+	for (int i = 0; i < 3; i++)
+		result[i] = a[i] - b[i];
+}
+
+static float Dot(const float* a, const float* b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static float Length(const float* v)
+{
+	return std::sqrt(Dot(v, v));
+}
+
+// bounding sphere and normal cone of the meshlet's triangles
+static void ComputeBounds(Meshlet& meshlet, const unsigned int* mesh_indices, const float* positions, size_t position_stride)
+{
+	const unsigned int* indices = mesh_indices + meshlet.first_index;
+	size_t index_count = meshlet.triangle_count * 3;
+
+	// the center of the box is close enough to the optimal center for clusters this small
+	float low[3] = { 1e30f, 1e30f, 1e30f };
+	float high[3] = { -1e30f, -1e30f, -1e30f };
+	for (size_t i = 0; i < index_count; i++)
+	{
+		const float* position = &positions[indices[i] * position_stride];
+		for (int k = 0; k < 3; k++)
+		{
+			low[k] = std::min(low[k], position[k]);
+			high[k] = std::max(high[k], position[k]);
+		}
+	}
+	float radius = 0.0f;
+	for (int k = 0; k < 3; k++)
+		meshlet.center[k] = (low[k] + high[k]) * 0.5f;
+	for (size_t i = 0; i < index_count; i++)
+	{
+		float offset[3];
+		Subtract(&positions[indices[i] * position_stride], meshlet.center, offset);
+		radius = std::max(radius, Length(offset));
+	}
+	meshlet.radius = radius;
+
+	// the axis is the average of the unit normals, the cone has to reach the one furthest from it
+	std::vector<float> normals;
+	normals.reserve(meshlet.triangle_count * 3);
+	float axis[3] = { 0.0f, 0.0f, 0.0f };
+	for (size_t t = 0; t < meshlet.triangle_count; t++)
+	{
+		const float* a = &positions[indices[t * 3] * position_stride];
+		const float* b = &positions[indices[t * 3 + 1] * position_stride];
+		const float* c = &positions[indices[t * 3 + 2] * position_stride];
+		float ab[3], ac[3];
+		Subtract(b, a, ab);
+		Subtract(c, a, ac);
+		float normal[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+		float length = Length(normal);
+		// degenerate triangles produce no pixels, their direction doesn't matter
+		if (length <= 0.0f)
+			continue;
+		for (int k = 0; k < 3; k++)
+		{
+			normal[k] /= length;
+			axis[k] += normal[k];
+			normals.push_back(normal[k]);
+		}
+	}
+	float axis_length = Length(axis);
+	meshlet.cone_axis[0] = meshlet.cone_axis[1] = meshlet.cone_axis[2] = 0.0f;
+	meshlet.cone_cutoff = 1.0f;
+	if (axis_length <= 0.0f)
+		return;
+	for (int k = 0; k < 3; k++)
+		meshlet.cone_axis[k] = axis[k] / axis_length;
+	float min_dot = 1.0f;
+	for (size_t n = 0; n < normals.size(); n += 3)
+		min_dot = std::min(min_dot, Dot(&normals[n], meshlet.cone_axis));
+	// normals spread over more than a hemisphere: some triangle always faces the camera
+	if (min_dot <= 0.0f)
+		return;
+	meshlet.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+}
+
+static void TriangleNormal(const unsigned int* triangle, const float* positions, size_t position_stride, float* normal)
+{
+	const float* a = &positions[triangle[0] * position_stride];
+	float ab[3], ac[3];
+	Subtract(&positions[triangle[1] * position_stride], a, ab);
+	Subtract(&positions[triangle[2] * position_stride], a, ac);
+	normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+	normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+	normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+	float length = Length(normal);
+	for (int k = 0; k < 3; k++)
+		normal[k] = length > 0.0f ? normal[k] / length : 0.0f;
+}
+
+void MeshletBuilder::Build(unsigned int* indices, size_t index_count, const float* positions, size_t position_stride,
+	size_t vertex_count, std::vector<Meshlet>& meshlets)
+{
+	meshlets.clear();
+	size_t triangle_count = index_count / 3;
+	std::vector<unsigned int> source(indices, indices + triangle_count * 3);
+
+	// triangles around each vertex, in compressed rows
+	std::vector<unsigned int> adjacency_start(vertex_count + 1, 0);
+	for (size_t i = 0; i < triangle_count * 3; i++)
+		adjacency_start[source[i] + 1]++;
+	for (size_t v = 0; v < vertex_count; v++)
+		adjacency_start[v + 1] += adjacency_start[v];
+	std::vector<unsigned int> adjacency(triangle_count * 3);
+	std::vector<unsigned int> fill(adjacency_start.begin(), adjacency_start.end() - 1);
+	for (size_t i = 0; i < triangle_count * 3; i++)
+		adjacency[fill[source[i]]++] = (unsigned int)(i / 3);
+
+	std::vector<float> normals(triangle_count * 3);
+	for (size_t t = 0; t < triangle_count; t++)
+		TriangleNormal(&source[t * 3], positions, position_stride, &normals[t * 3]);
+
+	// meshlet that last used each vertex, so a vertex is counted once per meshlet
+	std::vector<unsigned int> last_meshlet(vertex_count, 0xFFFFFFFFu);
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<unsigned int> meshlet_vertices;
+	meshlet_vertices.reserve(kMaxVertices);
+	float normal_sum[3] = { 0.0f, 0.0f, 0.0f };
+	Meshlet meshlet = {};
+	unsigned int id = 0;
+	size_t next_in_order = 0;
+	size_t written = 0;
+
+	for (size_t emitted_count = 0; emitted_count < triangle_count; emitted_count++)
+	{
+		// grow the meshlet over its own border: prefer triangles that add the fewest vertices,
+		// then the ones closest to the meshlet's average direction so its normal cone stays narrow
+		size_t best = triangle_count;
+		float best_score = 1e30f;
+		float sum_length = Length(normal_sum);
+		for (size_t mv = 0; mv < meshlet_vertices.size(); mv++)
+		{
+			unsigned int vertex = meshlet_vertices[mv];
+			for (unsigned int a = adjacency_start[vertex]; a < adjacency_start[vertex + 1]; a++)
+			{
+				unsigned int t = adjacency[a];
+				if (emitted[t])
+					continue;
+				int new_vertices = 0;
+				for (int k = 0; k < 3; k++)
+					new_vertices += last_meshlet[source[t * 3 + k]] != id ? 1 : 0;
+				float alignment = sum_length > 0.0f ? Dot(&normals[t * 3], normal_sum) / sum_length : 1.0f;
+				float score = new_vertices + (1.0f - alignment);
+				if (score < best_score)
+				{
+					best_score = score;
+					best = t;
+				}
+			}
+		}
+		// nothing left around the meshlet, carry on where the input order left off
+		if (best == triangle_count)
+		{
+			while (emitted[next_in_order])
+				next_in_order++;
+			best = next_in_order;
+		}
+
+		const unsigned int* triangle = &source[best * 3];
+		unsigned int new_vertices = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			// a vertex repeated within a degenerate triangle is only new once
+			bool repeated = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+			if (last_meshlet[triangle[k]] != id && !repeated)
+				new_vertices++;
+		}
+		if (meshlet.vertex_count + new_vertices > kMaxVertices || meshlet.triangle_count == kMaxTriangles)
+		{
+			ComputeBounds(meshlet, indices, positions, position_stride);
+			meshlets.push_back(meshlet);
+			meshlet = Meshlet();
+			meshlet.first_index = (unsigned int)written;
+			meshlet_vertices.clear();
+			normal_sum[0] = normal_sum[1] = normal_sum[2] = 0.0f;
+			id++;
+			// the border is gone with the old meshlet, start the new one from the input order
+			while (emitted[next_in_order])
+				next_in_order++;
+			best = next_in_order;
+			triangle = &source[best * 3];
+		}
+
+		for (int k = 0; k < 3; k++)
+		{
+			if (last_meshlet[triangle[k]] != id)
+			{
+				last_meshlet[triangle[k]] = id;
+				meshlet_vertices.push_back(triangle[k]);
+				meshlet.vertex_count++;
+			}
+			normal_sum[k] += normals[best * 3 + k];
+			indices[written++] = triangle[k];
+		}
+		emitted[best] = true;
+		meshlet.triangle_count++;
+	}
+	if (meshlet.triangle_count > 0)
+	{
+		ComputeBounds(meshlet, indices, positions, position_stride);
+		meshlets.push_back(meshlet);
+	}
+}
+
+bool MeshletBuilder::IsBackfacing(const Meshlet& meshlet, const float camera_position[3])
+{
+	// the view direction to any point of the sphere is within the cone's complement angle of
+	// the axis, so every normal in the cone points away from the camera
+	float view[3];
+	Subtract(meshlet.center, camera_position, view);
+	return Dot(view, meshlet.cone_axis) >= meshlet.cone_cutoff * Length(view) + meshlet.radius;
+}
+
+bool MeshletBuilder::IsOutsideFrustum(const Meshlet& meshlet, const float planes[6][4])
+{
+	for (int p = 0; p < 6; p++)
+	{
+		if (Dot(planes[p], meshlet.center) + planes[p][3] < -meshlet.radius)
+			return true;
+	}
+	return false;
+}
+
+MeshletCullStats MeshletBuilder::Cull(const std::vector<Meshlet>& meshlets, const float camera_position[3], const float planes[6][4],
+	unsigned int first_index, int base_vertex, std::vector<DrawElementsIndirectCommand>& commands)
+{
+	MeshletCullStats stats = {};
+	for (size_t m = 0; m < meshlets.size(); m++)
+	{
+		const Meshlet& meshlet = meshlets[m];
+		// the frustum test is cheaper and drops more in a typical scene
+		if (IsOutsideFrustum(meshlet, planes))
+		{
+			stats.outside_triangles += meshlet.triangle_count;
+			continue;
+		}
+		if (IsBackfacing(meshlet, camera_position))
+		{
+			stats.backfacing_triangles += meshlet.triangle_count;
+			continue;
+		}
+		DrawElementsIndirectCommand command;
+		command.count = meshlet.triangle_count * 3;
+		command.instance_count = 1;
+		command.first_index = first_index + meshlet.first_index;
+		command.base_vertex = base_vertex;
+		command.base_instance = 0;
+		commands.push_back(command);
+		stats.visible_meshlets++;
+		stats.visible_triangles += meshlet.triangle_count;
+	}
+	return stats;
+}
\ No newline at end of file
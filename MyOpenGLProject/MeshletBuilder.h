@@ -0,0 +1,63 @@
+#ifndef MESHLET_BUILDER_H
+#define MESHLET_BUILDER_H
+
+#include <vector>
+#include "MeshBatcher.h"
+
+// a small cluster of triangles with the bounds needed to cull it as a whole
+struct Meshlet
+{
+	// the meshlet's triangles start at this index of the mesh's index buffer
+	unsigned int first_index;
+	unsigned int triangle_count;
+	// distinct vertices the triangles use, at most MeshletBuilder::kMaxVertices
+	unsigned int vertex_count;
+	// bounding sphere of the vertices
+	float center[3];
+	float radius;
+	// cone containing every triangle normal, cone_cutoff is the sine of its half angle.
+	// it is 1 when the normals spread too far for the meshlet ever to be backfacing
+	float cone_axis[3];
+	float cone_cutoff;
+};
+
+// triangles kept and dropped by MeshletBuilder::Cull
+struct MeshletCullStats
+{
+	size_t visible_meshlets;
+	size_t visible_triangles;
+	size_t backfacing_triangles;
+	size_t outside_triangles;
+};
+
+// Partitions a triangle list into meshlets of at most kMaxVertices vertices and kMaxTriangles
+// triangles, with a bounding sphere and a normal cone each, so whole clusters that face away
+// from the camera or lie outside the frustum can be dropped before the draw list is built.
+// Meshlets are consecutive ranges of the mesh's own index buffer, so they are drawn from the
+// same VAO and element buffer as the whole mesh, one range per surviving meshlet.
+class MeshletBuilder
+{
+public:
+	static const size_t kMaxVertices = 64;
+	static const size_t kMaxTriangles = 124;
+
+	// reorders the triangles in place so every meshlet is one range of the index buffer. meshlets
+	// grow over neighbouring triangles and start new ones in input order, so an index buffer
+	// optimized for the vertex cache gives compact meshlets. positions are 3 floats every
+	// position_stride floats
+	static void Build(unsigned int* indices, size_t index_count, const float* positions, size_t position_stride,
+		size_t vertex_count, std::vector<Meshlet>& meshlets);
+
+	// true if every triangle of the meshlet faces away from a camera at camera_position.
+	// front faces wind counterclockwise, as GL expects by default
+	static bool IsBackfacing(const Meshlet& meshlet, const float camera_position[3]);
+	// true if the bounding sphere is completely behind one of the planes. planes are
+	// (a, b, c, d) with a * x + b * y + c * z + d >= 0 inside
+	static bool IsOutsideFrustum(const Meshlet& meshlet, const float planes[6][4]);
+	// append a command for every meshlet that survives both tests. first_index and base_vertex
+	// locate the mesh's indices and vertices inside the bound buffers
+	static MeshletCullStats Cull(const std::vector<Meshlet>& meshlets, const float camera_position[3], const float planes[6][4],
+		unsigned int first_index, int base_vertex, std::vector<DrawElementsIndirectCommand>& commands);
+};
+
+#endif // !MESHLET_BUILDER_H
\ No newline at end of file
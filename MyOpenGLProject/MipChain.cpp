@@ -0,0 +1,575 @@
+#include "MipChain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "CpuFeatures.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_CHAIN_SSE2
+// the AVX2 kernels are built in MipChainAvx2.cpp and picked at runtime
+#define MIP_CHAIN_AVX2
+#include <emmintrin.h>
+#include "MipChainAvx2.h"
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MIP_CHAIN_NEON
+#include <arm_neon.h>
+#endif
+#if defined(_MSC_VER)
+// the v142 compiler may fuse a * b + c in the scalar code (under /arch:AVX2 or higher), which
+// would round differently from the vector kernels' separate multiply and add
+#pragma fp_contract(off)
+#endif
+
+// Kaiser window parameters (same defaults as NVIDIA's texture tools)
+static const float kKaiserRadius = 3.0f;
+static const float kKaiserAlpha = 4.0f;
+
+// ---------------------------------------------------------------------------------------------
+// sRGB conversion, shared by all code paths so they quantize identically
+
+static const int kEncodeBuckets = 4096;
+
+struct SrgbTables
+{
+	float to_linear[256];
+	// linear value at which the encoded sRGB value rounds up to the next code
+	float thresholds[256];
+	// first candidate code for each linear bucket, refined with the thresholds. a bucket is
+	// narrower than the gap between two thresholds, so the candidate is at most one code too
+	// low and the vector encoders get away with a single comparison. 3 bytes of padding let
+	// them gather the entries as 32-bit values
+	unsigned char bucket_start[kEncodeBuckets + 4];
+
+	SrgbTables()
+	{
+		for (int i = 0; i < 256; i++)
+			to_linear[i] = Decode(i / 255.0f);
+		for (int i = 0; i < 255; i++)
+			thresholds[i] = Decode((i + 0.5f) / 255.0f);
+		thresholds[255] = 2.0f;
+		int code = 0;
+		for (int b = 0; b <= kEncodeBuckets; b++)
+		{
+			while (code < 255 && thresholds[code] <= (float)b / kEncodeBuckets)
+				code++;
+			bucket_start[b] = (unsigned char)code;
+		}
+		bucket_start[kEncodeBuckets + 1] = bucket_start[kEncodeBuckets + 2] = bucket_start[kEncodeBuckets + 3] = 0;
+	}
+
+	static float Decode(float c)
+	{
+		return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+	}
+};
+
+static const SrgbTables& GetSrgbTables()
+{
+	static const SrgbTables kTables;
+	return kTables;
+}
+
+static unsigned char EncodeSrgb(float linear)
+{
+	const SrgbTables& tables = GetSrgbTables();
+	linear = std::min(std::max(linear, 0.0f), 1.0f);
+	int code = tables.bucket_start[(int)(linear * kEncodeBuckets)];
+	while (linear >= tables.thresholds[code])
+		code++;
+	return (unsigned char)code;
+}
+
+static unsigned char EncodeUnorm(float value)
+{
+	value = std::min(std::max(value, 0.0f), 1.0f);
+	return (unsigned char)(value * 255.0f + 0.5f);
+}
+
+// ---------------------------------------------------------------------------------------------
+// Kaiser filter weights, one tap list per destination coordinate
+
+struct FilterTaps
+{
+	int count;                 // taps per destination coordinate
+	std::vector<int> index;    // clamped source coordinates, count per destination coordinate
+	std::vector<float> weight; // normalized weights, count per destination coordinate
+};
+
+static float BesselI0(float x)
+{
+	// power series, converges quickly for the small arguments used here
+	float sum = 1.0f, term = 1.0f, half_x = x * 0.5f;
+	for (int k = 1; k < 32; k++)
+	{
+		term *= (half_x / k) * (half_x / k);
+		sum += term;
+		if (term < sum * 1e-8f)
+			break;
+	}
+	return sum;
+}
+
+static float Kaiser(float x)
+{
+	float sinc = std::fabs(x) < 1e-6f ? 1.0f : std::sin(3.14159265f * x) / (3.14159265f * x);
+	float t = x / kKaiserRadius;
+	if (t * t >= 1.0f)
+		return 0.0f;
+	return sinc * BesselI0(kKaiserAlpha * std::sqrt(1.0f - t * t)) / BesselI0(kKaiserAlpha);
+}
+
+static FilterTaps MakeKaiserTaps(int src_size, int dst_size)
+{
+	FilterTaps taps;
+	float scale = (float)src_size / dst_size;
+	float support = kKaiserRadius * scale;
+	taps.count = (int)std::ceil(support * 2.0f) + 1;
+	taps.index.resize((size_t)taps.count * dst_size);
+	taps.weight.resize((size_t)taps.count * dst_size);
+
+	for (int d = 0; d < dst_size; d++)
+	{
+		float center = (d + 0.5f) * scale - 0.5f;
+		int first = (int)std::floor(center - support) + 1;
+		float total = 0.0f;
+		for (int t = 0; t < taps.count; t++)
+		{
+			float w = Kaiser((first + t - center) / scale);
+			taps.index[(size_t)d * taps.count + t] = std::min(std::max(first + t, 0), src_size - 1);
+			taps.weight[(size_t)d * taps.count + t] = w;
+			total += w;
+		}
+		for (int t = 0; t < taps.count; t++)
+			taps.weight[(size_t)d * taps.count + t] /= total;
+	}
+	return taps;
+}
+
+// ---------------------------------------------------------------------------------------------
+// float vectors: kFloatLanes floats, one RGBA pixel. MipChainAvx2 does two per vector
+
+#if defined(MIP_CHAIN_SSE2)
+typedef __m128 Floats;
+static const int kFloatLanes = 4;
+static inline Floats LoadF(const float* p) { return _mm_loadu_ps(p); }
+static inline void StoreF(float* p, Floats v) { _mm_storeu_ps(p, v); }
+static inline Floats AddF(Floats a, Floats b) { return _mm_add_ps(a, b); }
+static inline Floats MulF(Floats a, Floats b) { return _mm_mul_ps(a, b); }
+static inline Floats SplatF(float v) { return _mm_set1_ps(v); }
+#elif defined(MIP_CHAIN_NEON)
+typedef float32x4_t Floats;
+static const int kFloatLanes = 4;
+static inline Floats LoadF(const float* p) { return vld1q_f32(p); }
+static inline void StoreF(float* p, Floats v) { vst1q_f32(p, v); }
+static inline Floats AddF(Floats a, Floats b) { return vaddq_f32(a, b); }
+static inline Floats MulF(Floats a, Floats b) { return vmulq_f32(a, b); }
+static inline Floats SplatF(float v) { return vdupq_n_f32(v); }
+#else
+struct Floats { float v[4]; };
+static const int kFloatLanes = 4;
+static inline Floats LoadF(const float* p) { Floats r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+static inline void StoreF(float* p, Floats v) { std::memcpy(p, v.v, sizeof(v.v)); }
+static inline Floats AddF(Floats a, Floats b) { for (int i = 0; i < 4; i++) a.v[i] += b.v[i]; return a; }
+static inline Floats MulF(Floats a, Floats b) { for (int i = 0; i < 4; i++) a.v[i] *= b.v[i]; return a; }
+static inline Floats SplatF(float v) { Floats r = { { v, v, v, v } }; return r; }
+#endif
+
+static inline void LoadPixelPairs(const float* p, Floats& even, Floats& odd)
+{
+	even = LoadF(p);
+	odd = LoadF(p + 4);
+}
+
+// ---------------------------------------------------------------------------------------------
+// conversion between the RGBA8 levels and the float images the filters run on
+
+static void ToFloat(const unsigned char* rgba, size_t pixel_count, bool srgb, float* out, bool simd)
+{
+	const float* to_linear = GetSrgbTables().to_linear;
+	size_t count = pixel_count * 4, i = 0;
+	if (simd)
+	{
+#if defined(MIP_CHAIN_AVX2)
+		if (CpuFeatures::HasAvx2())
+			i = MipChainAvx2::ToFloat(rgba, count, srgb, to_linear, out);
+#endif
+#if defined(MIP_CHAIN_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		for (; i + 4 <= count; i += 4)
+		{
+			int texel;
+			std::memcpy(&texel, rgba + i, 4);
+			__m128i bytes = _mm_cvtsi32_si128(texel);
+			bytes = _mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero);
+			__m128 unorm = _mm_div_ps(_mm_cvtepi32_ps(bytes), _mm_set1_ps(255.0f));
+			if (srgb)
+			{
+				// no gather before AVX2, the three table lookups stay scalar
+				float alpha = _mm_cvtss_f32(_mm_shuffle_ps(unorm, unorm, _MM_SHUFFLE(3, 3, 3, 3)));
+				unorm = _mm_setr_ps(to_linear[rgba[i]], to_linear[rgba[i + 1]], to_linear[rgba[i + 2]], alpha);
+			}
+			_mm_storeu_ps(out + i, unorm);
+		}
+#endif
+	}
+	for (; i < count; i++)
+		out[i] = (srgb && (i & 3) != 3) ? to_linear[rgba[i]] : rgba[i] / 255.0f;
+}
+
+static void ToBytes(const float* values, size_t pixel_count, bool srgb, unsigned char* out, bool simd)
+{
+	size_t count = pixel_count * 4, i = 0;
+	if (simd)
+	{
+#if defined(MIP_CHAIN_AVX2)
+		if (CpuFeatures::HasAvx2())
+		{
+			const SrgbTables& tables = GetSrgbTables();
+			i = MipChainAvx2::ToBytes(values, count, srgb, tables.bucket_start, tables.thresholds, kEncodeBuckets, out);
+		}
+#endif
+#if defined(MIP_CHAIN_SSE2)
+		const SrgbTables& tables = GetSrgbTables();
+		const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 v = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(values + i), zero), one);
+			__m128i unorm = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+			__m128i words = _mm_packs_epi32(unorm, unorm);
+			int texel = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+			if (srgb)
+			{
+				// no gather before AVX2: the buckets are computed as a vector, the lookups stay scalar
+				float clamped[4];
+				int bucket[4];
+				_mm_storeu_ps(clamped, v);
+				_mm_storeu_si128((__m128i*)bucket, _mm_cvttps_epi32(_mm_mul_ps(v, _mm_set1_ps((float)kEncodeBuckets))));
+				texel &= (int)0xFF000000u;
+				for (int c = 0; c < 3; c++)
+				{
+					int code = tables.bucket_start[bucket[c]];
+					code += clamped[c] >= tables.thresholds[code] ? 1 : 0;
+					texel |= code << (8 * c);
+				}
+			}
+			std::memcpy(out + i, &texel, 4);
+		}
+#endif
+	}
+	for (; i < count; i++)
+		out[i] = (srgb && (i & 3) != 3) ? EncodeSrgb(values[i]) : EncodeUnorm(values[i]);
+}
+
+// ---------------------------------------------------------------------------------------------
+// kernels, each processes destination rows [row_begin, row_end)
+
+// 8-bit box filter for linear data: (a + b + c + d + 2) / 4, exact in every code path
+static void BoxRowsBytes(const unsigned char* src, int src_w, int src_h, unsigned char* dst, int dst_w,
+	size_t row_begin, size_t row_end, bool simd)
+{
+	for (size_t y = row_begin; y < row_end; y++)
+	{
+		const unsigned char* row0 = src + (size_t)std::min(2 * (int)y, src_h - 1) * src_w * 4;
+		const unsigned char* row1 = src + (size_t)std::min(2 * (int)y + 1, src_h - 1) * src_w * 4;
+		unsigned char* out = dst + y * dst_w * 4;
+		int x = 0;
+
+		// the vector loops need both source columns of every output pixel (always true unless src_w == 1)
+		if (simd && src_w > 1)
+		{
+#if defined(MIP_CHAIN_AVX2)
+			if (CpuFeatures::HasAvx2())
+				x = MipChainAvx2::BoxRowBytes(row0, row1, out, dst_w);
+#endif
+#if defined(MIP_CHAIN_SSE2)
+			for (; x + 4 <= dst_w; x += 4)
+			{
+				const __m128i zero = _mm_setzero_si128();
+				__m128i packed[2];
+				for (int half = 0; half < 2; half++)
+				{
+					__m128i a = _mm_loadu_si128((const __m128i*)(row0 + (2 * x + 4 * half) * 4));
+					__m128i b = _mm_loadu_si128((const __m128i*)(row1 + (2 * x + 4 * half) * 4));
+					// vertical sums, two source pixels per register
+					__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+					__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+					// horizontal neighbours
+					lo = _mm_add_epi16(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)));
+					hi = _mm_add_epi16(hi, _mm_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2)));
+					__m128i sum = _mm_unpacklo_epi64(lo, hi);
+					packed[half] = _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+				}
+				_mm_storeu_si128((__m128i*)(out + x * 4), _mm_packus_epi16(packed[0], packed[1]));
+			}
+#elif defined(MIP_CHAIN_NEON)
+			for (; x + 2 <= dst_w; x += 2)
+			{
+				uint8x16_t a = vld1q_u8(row0 + 2 * x * 4);
+				uint8x16_t b = vld1q_u8(row1 + 2 * x * 4);
+				uint16x8_t lo = vaddl_u8(vget_low_u8(a), vget_low_u8(b));
+				uint16x8_t hi = vaddl_u8(vget_high_u8(a), vget_high_u8(b));
+				uint16x4_t p0 = vadd_u16(vget_low_u16(lo), vget_high_u16(lo));
+				uint16x4_t p1 = vadd_u16(vget_low_u16(hi), vget_high_u16(hi));
+				// rounding shift: (sum + 2) >> 2
+				vst1_u8(out + x * 4, vrshrn_n_u16(vcombine_u16(p0, p1), 2));
+			}
+#endif
+		}
+
+		for (; x < dst_w; x++)
+		{
+			int x0 = std::min(2 * x, src_w - 1), x1 = std::min(2 * x + 1, src_w - 1);
+			for (int c = 0; c < 4; c++)
+			{
+				int sum = row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c];
+				out[x * 4 + c] = (unsigned char)((sum + 2) >> 2);
+			}
+		}
+	}
+}
+
+// float box filter on linear RGBA
+static void BoxRowsFloat(const float* src, int src_w, int src_h, float* dst, int dst_w,
+	size_t row_begin, size_t row_end, bool simd)
+{
+	for (size_t y = row_begin; y < row_end; y++)
+	{
+		const float* row0 = src + (size_t)std::min(2 * (int)y, src_h - 1) * src_w * 4;
+		const float* row1 = src + (size_t)std::min(2 * (int)y + 1, src_h - 1) * src_w * 4;
+		float* out = dst + y * dst_w * 4;
+		int x = 0;
+
+		// one output pixel per vector, split into the even and odd source columns
+		if (simd && src_w > 1)
+		{
+#if defined(MIP_CHAIN_AVX2)
+			if (CpuFeatures::HasAvx2())
+				x = MipChainAvx2::BoxRowFloat(row0, row1, out, dst_w);
+#endif
+			for (; x < dst_w; x++)
+			{
+				Floats even0, odd0, even1, odd1;
+				LoadPixelPairs(row0 + x * 8, even0, odd0);
+				LoadPixelPairs(row1 + x * 8, even1, odd1);
+				StoreF(out + x * 4, MulF(AddF(AddF(AddF(even0, odd0), even1), odd1), SplatF(0.25f)));
+			}
+		}
+
+		for (; x < dst_w; x++)
+		{
+			int x0 = std::min(2 * x, src_w - 1) * 4, x1 = std::min(2 * x + 1, src_w - 1) * 4;
+			for (int c = 0; c < 4; c++)
+				out[x * 4 + c] = (((row0[x0 + c] + row0[x1 + c]) + row1[x0 + c]) + row1[x1 + c]) * 0.25f;
+		}
+	}
+}
+
+// one separable filter pass along x (stride 4 floats) or y (stride one row)
+static void FilterRows(const float* src, int src_w, float* dst, int dst_w, const FilterTaps& taps,
+	bool along_x, size_t row_begin, size_t row_end, bool simd)
+{
+	for (size_t y = row_begin; y < row_end; y++)
+	{
+		float* out = dst + y * dst_w * 4;
+		int x = 0;
+		if (simd && along_x)
+		{
+			// every output pixel has its own taps, one pixel per vector
+			const float* row = src + y * src_w * 4;
+#if defined(MIP_CHAIN_AVX2)
+			if (CpuFeatures::HasAvx2())
+				x = MipChainAvx2::FilterRowX(row, out, dst_w, taps.index.data(), taps.weight.data(), taps.count);
+#endif
+			for (; x < dst_w; x++)
+			{
+				size_t first = (size_t)x * taps.count;
+				Floats sum = SplatF(0.0f);
+				for (int t = 0; t < taps.count; t++)
+					sum = AddF(sum, MulF(LoadF(row + taps.index[first + t] * 4), SplatF(taps.weight[first + t])));
+				StoreF(out + x * 4, sum);
+			}
+		}
+		else if (simd)
+		{
+			// the whole row shares its taps, so the sums run along the row two vectors at a time
+			const int* index = &taps.index[y * taps.count];
+			const float* weight = &taps.weight[y * taps.count];
+			int count = dst_w * 4, i = 0;
+#if defined(MIP_CHAIN_AVX2)
+			if (CpuFeatures::HasAvx2())
+				i = MipChainAvx2::FilterRowY(src, (size_t)src_w * 4, out, count, index, weight, taps.count);
+#endif
+			for (; i + 2 * kFloatLanes <= count; i += 2 * kFloatLanes)
+			{
+				Floats sum0 = SplatF(0.0f), sum1 = SplatF(0.0f);
+				for (int t = 0; t < taps.count; t++)
+				{
+					const float* p = src + (size_t)index[t] * src_w * 4 + i;
+					Floats w = SplatF(weight[t]);
+					sum0 = AddF(sum0, MulF(LoadF(p), w));
+					sum1 = AddF(sum1, MulF(LoadF(p + kFloatLanes), w));
+				}
+				StoreF(out + i, sum0);
+				StoreF(out + i + kFloatLanes, sum1);
+			}
+			for (; i + kFloatLanes <= count; i += kFloatLanes)
+			{
+				Floats sum = SplatF(0.0f);
+				for (int t = 0; t < taps.count; t++)
+					sum = AddF(sum, MulF(LoadF(src + (size_t)index[t] * src_w * 4 + i), SplatF(weight[t])));
+				StoreF(out + i, sum);
+			}
+			x = i / 4;
+		}
+
+		for (; x < dst_w; x++)
+		{
+			int d = along_x ? x : (int)y;
+			const int* index = &taps.index[(size_t)d * taps.count];
+			const float* weight = &taps.weight[(size_t)d * taps.count];
+			float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			for (int t = 0; t < taps.count; t++)
+			{
+				const float* p = along_x ? src + (y * src_w + index[t]) * 4 : src + ((size_t)index[t] * src_w + x) * 4;
+				for (int c = 0; c < 4; c++)
+					sum[c] = sum[c] + p[c] * weight[t];
+			}
+			std::memcpy(out + x * 4, sum, sizeof(sum));
+		}
+	}
+}
+
+// ---------------------------------------------------------------------------------------------
+
+static void RunRows(ThreadPool* pool, size_t rows, const std::function<void(size_t, size_t)>& body)
+{
+	// a few rows per task keep the scheduling overhead small on the tiny levels
+	if (pool && rows > 8)
+		pool->ParallelFor(rows, std::max((size_t)4, rows / (pool->ThreadCount() * 4)), body);
+	else
+		body(0, rows);
+}
+
+static void BuildChain(const unsigned char* rgba, int width, int height, MipFilter filter, bool srgb,
+	std::vector<MipLevel>& levels, ThreadPool* pool, bool simd)
+{
+	levels.clear();
+	int level_count = MipChain::LevelCount(width, height);
+	if (level_count <= 1)
+		return;
+	levels.resize(level_count - 1);
+
+	// linear 8-bit data with a box filter never needs to leave the integer domain
+	if (filter == kMipFilterBox && !srgb)
+	{
+		const unsigned char* src = rgba;
+		int src_w = width, src_h = height;
+		for (size_t l = 0; l < levels.size(); l++)
+		{
+			MipLevel& level = levels[l];
+			level.width = std::max(1, src_w / 2);
+			level.height = std::max(1, src_h / 2);
+			level.pixels.resize((size_t)level.width * level.height * 4);
+			unsigned char* dst = level.pixels.data();
+			RunRows(pool, level.height, [=](size_t begin, size_t end)
+			{
+				BoxRowsBytes(src, src_w, src_h, dst, level.width, begin, end, simd);
+			});
+			src = dst;
+			src_w = level.width;
+			src_h = level.height;
+		}
+		return;
+	}
+
+	// everything else filters in float and only rounds the output, never the next level's input
+	std::vector<float> src((size_t)width * height * 4), dst, temp;
+	float* converted = src.data();
+	RunRows(pool, height, [=](size_t begin, size_t end)
+	{
+		ToFloat(rgba + begin * width * 4, (end - begin) * width, srgb, converted + begin * width * 4, simd);
+	});
+	int src_w = width, src_h = height;
+	for (size_t l = 0; l < levels.size(); l++)
+	{
+		MipLevel& level = levels[l];
+		int dst_w = level.width = std::max(1, src_w / 2);
+		int dst_h = level.height = std::max(1, src_h / 2);
+		dst.resize((size_t)dst_w * dst_h * 4);
+		const float* in = src.data();
+		float* out = dst.data();
+
+		if (filter == kMipFilterBox)
+		{
+			RunRows(pool, dst_h, [=](size_t begin, size_t end)
+			{
+				BoxRowsFloat(in, src_w, src_h, out, dst_w, begin, end, simd);
+			});
+		}
+		else
+		{
+			FilterTaps taps_x = MakeKaiserTaps(src_w, dst_w);
+			FilterTaps taps_y = MakeKaiserTaps(src_h, dst_h);
+			temp.resize((size_t)dst_w * src_h * 4);
+			float* mid = temp.data();
+			RunRows(pool, src_h, [=, &taps_x](size_t begin, size_t end)
+			{
+				FilterRows(in, src_w, mid, dst_w, taps_x, true, begin, end, simd);
+			});
+			RunRows(pool, dst_h, [=, &taps_y](size_t begin, size_t end)
+			{
+				FilterRows(mid, dst_w, out, dst_w, taps_y, false, begin, end, simd);
+			});
+		}
+
+		level.pixels.resize((size_t)dst_w * dst_h * 4);
+		unsigned char* bytes = level.pixels.data();
+		RunRows(pool, dst_h, [=](size_t begin, size_t end)
+		{
+			ToBytes(out + begin * dst_w * 4, (end - begin) * dst_w, srgb, bytes + begin * dst_w * 4, simd);
+		});
+		src.swap(dst);
+		src_w = dst_w;
+		src_h = dst_h;
+	}
+}
+
+void MipChain::Build(const unsigned char* rgba, int width, int height, MipFilter filter, bool srgb,
+	std::vector<MipLevel>& levels, ThreadPool* pool)
+{
+	BuildChain(rgba, width, height, filter, srgb, levels, pool, true);
+}
+
+void MipChain::BuildReference(const unsigned char* rgba, int width, int height, MipFilter filter, bool srgb,
+	std::vector<MipLevel>& levels)
+{
+	BuildChain(rgba, width, height, filter, srgb, levels, NULL, false);
+}
+
+int MipChain::LevelCount(int width, int height)
+{
+	int count = 1;
+	while (width > 1 || height > 1)
+	{
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+		count++;
+	}
+	return count;
+}
+
+const char* MipChain::SimdName()
+{
+#if defined(MIP_CHAIN_AVX2)
+	if (CpuFeatures::HasAvx2())
+		return "AVX2";
+#endif
+#if defined(MIP_CHAIN_SSE2)
+	return "SSE2";
+#elif defined(MIP_CHAIN_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,40 @@
+#ifndef MIP_CHAIN_H
+#define MIP_CHAIN_H
+
+#include <vector>
+#include "ThreadPool.h"
+
+enum MipFilter
+{
+	kMipFilterBox,    // 2x2 average
+	kMipFilterKaiser  // Kaiser windowed sinc, sharper and without the box filter's aliasing
+};
+
+// one downsampled RGBA8 level
+struct MipLevel
+{
+	int width;
+	int height;
+	std::vector<unsigned char> pixels;
+};
+
+// Builds mip chains on the CPU so uploads don't depend on glGenerateMipmap.
+// Kernels use SSE2/NEON where the compiler targets them and AVX2 where the CPU has it;
+// BuildReference is the plain C++ version they are verified against.
+class MipChain
+{
+public:
+	// build levels 1..N (down to 1x1) of an RGBA8 image, level 0 is the input itself.
+	// with srgb the color channels are filtered in linear space (alpha is always linear).
+	// rows of each level are split across the pool's workers if one is given
+	static void Build(const unsigned char* rgba, int width, int height, MipFilter filter, bool srgb,
+		std::vector<MipLevel>& levels, ThreadPool* pool = NULL);
+	static void BuildReference(const unsigned char* rgba, int width, int height, MipFilter filter, bool srgb,
+		std::vector<MipLevel>& levels);
+	// number of levels including level 0
+	static int LevelCount(int width, int height);
+	// name of the instruction set the kernels run with on this CPU
+	static const char* SimdName();
+};
+
+#endif // !MIP_CHAIN_H
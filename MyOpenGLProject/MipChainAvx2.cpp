@@ -0,0 +1,170 @@
+#include "MipChainAvx2.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+// the kernels must round like the scalar reference, one multiply and one add at a time
+#pragma fp_contract(off)
+#endif
+
+// pixel i of the vector from pixels[i], one value per pixel
+static inline __m256 LoadPixels(const float* pixel0, const float* pixel1)
+{
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(pixel0)), _mm_loadu_ps(pixel1), 1);
+}
+
+static inline __m256 SplatPixels(float value0, float value1)
+{
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(value0)), _mm_set1_ps(value1), 1);
+}
+
+// the even and the odd pixels of the 4 pixels at p
+static inline void LoadPixelPairs(const float* p, __m256& even, __m256& odd)
+{
+	__m256 a = _mm256_loadu_ps(p), b = _mm256_loadu_ps(p + 8);
+	even = _mm256_permute2f128_ps(a, b, 0x20);
+	odd = _mm256_permute2f128_ps(a, b, 0x31);
+}
+
+size_t MipChainAvx2::ToFloat(const unsigned char* rgba, size_t count, bool srgb, const float* to_linear, float* out)
+{
+	// two pixels per vector, the color channels looked up with a gather
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i bytes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(rgba + i)));
+		__m256 unorm = _mm256_div_ps(_mm256_cvtepi32_ps(bytes), _mm256_set1_ps(255.0f));
+		if (srgb)
+			unorm = _mm256_blend_ps(_mm256_i32gather_ps(to_linear, bytes, 4), unorm, 0x88);
+		_mm256_storeu_ps(out + i, unorm);
+	}
+	return i;
+}
+
+size_t MipChainAvx2::ToBytes(const float* values, size_t count, bool srgb, const unsigned char* bucket_start,
+	const float* thresholds, int bucket_count, unsigned char* out)
+{
+	// four pixels per iteration: clamp, then either round to unorm or look the sRGB code up
+	// with two gathers, bucket_start for the candidate and thresholds to correct it
+	const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m256i codes[2];
+		for (int half = 0; half < 2; half++)
+		{
+			__m256 v = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(values + i + 8 * half), zero), one);
+			__m256i unorm = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(v, _mm256_set1_ps(255.0f)), _mm256_set1_ps(0.5f)));
+			if (srgb)
+			{
+				__m256i bucket = _mm256_cvttps_epi32(_mm256_mul_ps(v, _mm256_set1_ps((float)bucket_count)));
+				__m256i code = _mm256_and_si256(_mm256_i32gather_epi32((const int*)bucket_start, bucket, 1), _mm256_set1_epi32(0xFF));
+				__m256 threshold = _mm256_i32gather_ps(thresholds, code, 4);
+				// the comparison mask is -1 where the code needs one more
+				code = _mm256_sub_epi32(code, _mm256_castps_si256(_mm256_cmp_ps(v, threshold, _CMP_GE_OQ)));
+				unorm = _mm256_blend_epi32(code, unorm, 0x88);
+			}
+			codes[half] = unorm;
+		}
+		// packs work per 128-bit lane, gather the four 32-bit groups of bytes back in order
+		__m256i words = _mm256_packus_epi32(codes[0], codes[1]);
+		__m256i bytes = _mm256_packus_epi16(words, words);
+		bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 1, 5, 0, 0, 0, 0));
+		_mm_storeu_si128((__m128i*)(out + i), _mm256_castsi256_si128(bytes));
+	}
+	return i;
+}
+
+int MipChainAvx2::BoxRowBytes(const unsigned char* row0, const unsigned char* row1, unsigned char* out, int dst_w)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	int x = 0;
+	for (; x + 8 <= dst_w; x += 8)
+	{
+		__m256i packed[2];
+		for (int half = 0; half < 2; half++)
+		{
+			__m256i a = _mm256_loadu_si256((const __m256i*)(row0 + (2 * x + 8 * half) * 4));
+			__m256i b = _mm256_loadu_si256((const __m256i*)(row1 + (2 * x + 8 * half) * 4));
+			__m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+			__m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+			lo = _mm256_add_epi16(lo, _mm256_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)));
+			hi = _mm256_add_epi16(hi, _mm256_shuffle_epi32(hi, _MM_SHUFFLE(1, 0, 3, 2)));
+			__m256i sum = _mm256_unpacklo_epi64(lo, hi);
+			packed[half] = _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(2)), 2);
+		}
+		// packs work per 128-bit lane, put the 64-bit pixel pairs back in order
+		__m256i result = _mm256_packus_epi16(packed[0], packed[1]);
+		result = _mm256_permute4x64_epi64(result, _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_si256((__m256i*)(out + x * 4), result);
+	}
+	return x;
+}
+
+int MipChainAvx2::BoxRowFloat(const float* row0, const float* row1, float* out, int dst_w)
+{
+	// two output pixels per vector, split into the even and odd source columns
+	int x = 0;
+	for (; x + 2 <= dst_w; x += 2)
+	{
+		__m256 even0, odd0, even1, odd1;
+		LoadPixelPairs(row0 + x * 8, even0, odd0);
+		LoadPixelPairs(row1 + x * 8, even1, odd1);
+		__m256 sum = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(even0, odd0), even1), odd1);
+		_mm256_storeu_ps(out + x * 4, _mm256_mul_ps(sum, _mm256_set1_ps(0.25f)));
+	}
+	return x;
+}
+
+int MipChainAvx2::FilterRowX(const float* row, float* out, int dst_w, const int* index, const float* weight, int tap_count)
+{
+	// two output pixels per vector, each half loading its own source pixel and weight
+	int x = 0;
+	for (; x + 2 <= dst_w; x += 2)
+	{
+		const int* index0 = index + (size_t)x * tap_count;
+		const int* index1 = index0 + tap_count;
+		const float* weight0 = weight + (size_t)x * tap_count;
+		const float* weight1 = weight0 + tap_count;
+		__m256 sum = _mm256_setzero_ps();
+		for (int t = 0; t < tap_count; t++)
+		{
+			__m256 pixels = LoadPixels(row + index0[t] * 4, row + index1[t] * 4);
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(pixels, SplatPixels(weight0[t], weight1[t])));
+		}
+		_mm256_storeu_ps(out + x * 4, sum);
+	}
+	return x;
+}
+
+int MipChainAvx2::FilterRowY(const float* src, size_t row_floats, float* out, int count, const int* index,
+	const float* weight, int tap_count)
+{
+	// the sums run along the row two vectors at a time
+	int i = 0;
+	for (; i + 16 <= count; i += 16)
+	{
+		__m256 sum0 = _mm256_setzero_ps(), sum1 = _mm256_setzero_ps();
+		for (int t = 0; t < tap_count; t++)
+		{
+			const float* p = src + (size_t)index[t] * row_floats + i;
+			__m256 w = _mm256_set1_ps(weight[t]);
+			sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(_mm256_loadu_ps(p), w));
+			sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(_mm256_loadu_ps(p + 8), w));
+		}
+		_mm256_storeu_ps(out + i, sum0);
+		_mm256_storeu_ps(out + i + 8, sum1);
+	}
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 sum = _mm256_setzero_ps();
+		for (int t = 0; t < tap_count; t++)
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(src + (size_t)index[t] * row_floats + i), _mm256_set1_ps(weight[t])));
+		_mm256_storeu_ps(out + i, sum);
+	}
+	return i;
+}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#error MipChainAvx2.cpp must be compiled with /arch:AVX2
+#endif
\ No newline at end of file
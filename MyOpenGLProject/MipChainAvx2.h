@@ -0,0 +1,29 @@
+#ifndef MIP_CHAIN_AVX2_H
+#define MIP_CHAIN_AVX2_H
+
+#include <cstddef>
+
+// MipChain's AVX2 kernels, two RGBA pixels per float vector. Only called when
+// CpuFeatures::HasAvx2() is true, see CpuFeatures.h. Each one works through a prefix of its
+// span and returns where it stopped; MipChain.cpp finishes the rest with its own loops
+class MipChainAvx2
+{
+public:
+	// count bytes to floats in [0, 1], the color channels through to_linear with srgb
+	static size_t ToFloat(const unsigned char* rgba, size_t count, bool srgb, const float* to_linear, float* out);
+	// count floats to bytes, the color channels encoded with MipChain.cpp's bucket_start (padded
+	// for 32-bit gathers) and thresholds tables with srgb
+	static size_t ToBytes(const float* values, size_t count, bool srgb, const unsigned char* bucket_start,
+		const float* thresholds, int bucket_count, unsigned char* out);
+	// 8-bit box filter of dst_w pixels from two source rows of at least 2 * dst_w pixels
+	static int BoxRowBytes(const unsigned char* row0, const unsigned char* row1, unsigned char* out, int dst_w);
+	static int BoxRowFloat(const float* row0, const float* row1, float* out, int dst_w);
+	// filter pass along x, output pixel x sums the tap_count pixels index[x * tap_count + t] of row
+	static int FilterRowX(const float* row, float* out, int dst_w, const int* index, const float* weight, int tap_count);
+	// filter pass along y over count floats, every float sums the same source rows
+	// src + index[t] * row_floats
+	static int FilterRowY(const float* src, size_t row_floats, float* out, int count, const int* index,
+		const float* weight, int tap_count);
+};
+
+#endif // !MIP_CHAIN_AVX2_H
\ No newline at end of file
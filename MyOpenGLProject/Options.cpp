@@ -0,0 +1,137 @@
+#include "Options.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+Options ParseOptions(int argc, char** argv)
+{
+	Options options;
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--headless") == 0)
+		{
+			options.headless = true;
+			// optional frame count right after the flag
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				options.frame_count = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--pack") == 0 && i + 1 < argc)
+		{
+			options.pack_path = argv[++i];
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				options.pack_directory = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--assets") == 0 && i + 1 < argc)
+		{
+			options.assets_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--compressed-textures") == 0)
+		{
+			options.compressed_textures = true;
+		}
+		else if (std::strcmp(argv[i], "--cook-on-load") == 0)
+		{
+			options.cook_on_load = true;
+		}
+		else if (std::strcmp(argv[i], "--verify-mips") == 0 && i + 1 < argc)
+		{
+			options.verify_mips_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--profile") == 0 && i + 1 < argc)
+		{
+			options.profile_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--sprites") == 0 && i + 1 < argc)
+		{
+			options.sprite_count = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+		{
+			options.batch_draws = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--mesh") == 0 && i + 1 < argc)
+		{
+			options.mesh_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--write-mesh") == 0 && i + 1 < argc)
+		{
+			options.write_mesh_path = argv[++i];
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				options.write_mesh_size = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--meshlets") == 0 && i + 1 < argc)
+		{
+			options.meshlet_segments = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--verify-meshlets") == 0)
+		{
+			options.verify_meshlets_segments = 64;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				options.verify_meshlets_segments = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--bench-mesh-opt") == 0)
+		{
+			options.bench_mesh_size = 300;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				options.bench_mesh_size = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--bench-cull") == 0)
+		{
+			options.bench_cull_count = 1000000;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				options.bench_cull_count = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--bench-sampler") == 0)
+		{
+			options.bench_sampler_count = 1000000;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				options.bench_sampler_count = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--bench-raster") == 0)
+		{
+			options.bench_raster_triangles = 10000;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				options.bench_raster_triangles = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--bench-upload") == 0)
+		{
+			options.bench_upload_size = 2048;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				options.bench_upload_size = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--bench-queue") == 0)
+		{
+			options.bench_queue_draws = 10000;
+			if (i + 1 < argc && argv[i + 1][0] != '-')
+				options.bench_queue_draws = std::atoi(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--golden") == 0 && i + 1 < argc)
+		{
+			options.golden_path = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--update-golden") == 0)
+		{
+			options.update_golden = true;
+		}
+		else if (std::strcmp(argv[i], "--golden-machine") == 0 && i + 1 < argc)
+		{
+			options.golden_machine = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--verify-decoder") == 0)
+		{
+			while (i + 1 < argc && argv[i + 1][0] != '-')
+				options.verify_decoder_paths.push_back(argv[++i]);
+		}
+		else if (std::strcmp(argv[i], "--cook") == 0)
+		{
+			while (i + 1 < argc && argv[i + 1][0] != '-')
+				options.cook_paths.push_back(argv[++i]);
+		}
+		else
+		{
+			std::cout << "Unknown option: " << argv[i] << std::endl;
+		}
+	}
+	return options;
+}
\ No newline at end of file
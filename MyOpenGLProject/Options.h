@@ -0,0 +1,72 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <cstddef>
+#include <vector>
+
+// size of the window and of the offscreen target, the golden references are rendered at this size
+const int kWindowWidth = 640;
+const int kWindowHeight = 480;
+
+// command line options
+// --headless [frames]: render the given number of frames into an offscreen framebuffer and exit.
+//     without an OpenGL context the container scene is rendered on the CPU instead
+// --cook <images...>: write the compressed texture cache (.ktx2) for the given images and exit
+// --pack <pack> [directory]: pack all assets of the directory (default: current) into one file and exit
+// --assets <pack>: load shaders and textures from an asset pack instead of loose files
+// --compressed-textures: upload the fresh .ktx2 files written by --cook instead of decoding the images
+// --cook-on-load: with --compressed-textures, cook the images without a fresh .ktx2 file while loading them
+// --verify-mips <image>: check the SIMD mip chain builder against the scalar reference and exit
+// --verify-decoder <images...>: decode the images with the parallel decoder and stb_image, check they match and exit
+// --profile <trace.json>: print CPU/GPU frame time statistics on exit and write a Chrome trace
+// --sprites <count>: draw that many instanced quads over the container with a single draw call
+// --batch <draws>: draw that many mixed meshes in two material buckets with multi-draw indirect
+// --mesh <path>: stream a mesh file in on worker threads and draw it over the container
+// --write-mesh <path> [size]: write a size x size grid in the binary mesh format and exit
+// --meshlets <segments>: draw a sphere split into meshlets, culling backfacing and off-screen ones every frame
+// --verify-meshlets [segments]: build meshlets for a sphere, check their bounds and culled triangle counts and exit
+// --bench-mesh-opt [size]: optimize a shuffled size x size grid mesh, print ACMR/ATVR before and after and exit
+// --bench-queue [draws]: compare state changes and sort time of unsorted and sorted render queues and exit
+// --bench-cull [objects]: frustum cull that many spheres and boxes with the SIMD kernels, check them against the scalar reference and exit
+// --bench-sampler [samples]: sample every format, filter and wrap mode with the SIMD kernels, check them against the scalar reference and exit
+// --bench-raster [triangles]: draw the scene with that many extra triangles on the CPU at 1920x1080, single and multithreaded, and exit
+// --bench-upload [size]: convert a size x size image for upload in every layout with the SIMD kernels, check them against the scalar reference and exit
+// --golden <directory>: compare the software rendered scenes (or with --headless, the last GL frame, which has its
+//     own container.gl reference) against the references in the directory, exit with an error on any regression
+// --update-golden: with --golden, write the references from the current images and timings instead
+// --golden-machine <class>: with --golden, also check (or record) the frame times in timings.<class>.txt, one file
+//     per kind of machine. without it the frame times are only printed
+struct Options
+{
+	bool headless = false;
+	int frame_count = 100;
+	std::vector<const char*> cook_paths;
+	const char* pack_path = NULL;
+	const char* pack_directory = ".";
+	const char* assets_path = NULL;
+	bool compressed_textures = false;
+	bool cook_on_load = false;
+	const char* verify_mips_path = NULL;
+	std::vector<const char*> verify_decoder_paths;
+	const char* profile_path = NULL;
+	int bench_queue_draws = 0;
+	int bench_mesh_size = 0;
+	int bench_cull_count = 0;
+	int bench_sampler_count = 0;
+	int bench_raster_triangles = 0;
+	int bench_upload_size = 0;
+	int sprite_count = 0;
+	int batch_draws = 0;
+	const char* mesh_path = NULL;
+	const char* write_mesh_path = NULL;
+	int write_mesh_size = 256;
+	int meshlet_segments = 0;
+	int verify_meshlets_segments = 0;
+	const char* golden_path = NULL;
+	bool update_golden = false;
+	const char* golden_machine = NULL;
+};
+
+Options ParseOptions(int argc, char** argv);
+
+#endif // !OPTIONS_H
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "PixelReadback.h"
+
+#include <cstring>
+#include <iostream>
+
+PixelReadback::PixelReadback(GLState& state, int width, int height, int slot_count)
+	: width_(width), height_(height), slots_(slot_count), head_(0), tail_(0), pending_(0)
+{
+	for (size_t i = 0; i < slots_.size(); i++)
+	{
+		glGenBuffers(1, &slots_[i].buffer);
+		state.BindBuffer(GL_PIXEL_PACK_BUFFER, slots_[i].buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width_ * height_ * 4, NULL, GL_STREAM_READ);
+		slots_[i].fence = 0;
+		slots_[i].frame = 0;
+	}
+	// with a pack buffer bound, every other glReadPixels would write into it
+	state.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+PixelReadback::~PixelReadback()
+{
+	for (size_t i = 0; i < slots_.size(); i++)
+	{
+		if (slots_[i].fence)
+			glDeleteSync(slots_[i].fence);
+		glDeleteBuffers(1, &slots_[i].buffer);
+	}
+}
+
+bool PixelReadback::Request(GLState& state, int frame)
+{
+	if (pending_ == slots_.size())
+		return false;
+	Slot& slot = slots_[head_];
+	state.BindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	// into the bound pack buffer, so this only queues the copy
+	glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	state.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.frame = frame;
+	head_ = (head_ + 1) % slots_.size();
+	pending_++;
+	return true;
+}
+
+bool PixelReadback::TryGet(GLState& state, std::vector<unsigned char>& pixels, int& frame)
+{
+	if (pending_ == 0)
+		return false;
+	GLenum status = glClientWaitSync(slots_[tail_].fence, 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED)
+		return false;
+	Collect(state, pixels, frame);
+	return true;
+}
+
+bool PixelReadback::Get(GLState& state, std::vector<unsigned char>& pixels, int& frame)
+{
+	if (pending_ == 0)
+		return false;
+	GLenum status;
+	do
+	{
+		status = glClientWaitSync(slots_[tail_].fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+	} while (status == GL_TIMEOUT_EXPIRED);
+	Collect(state, pixels, frame);
+	return true;
+}
+
+void PixelReadback::Collect(GLState& state, std::vector<unsigned char>& pixels, int& frame)
+{
+	Slot& slot = slots_[tail_];
+	glDeleteSync(slot.fence);
+	slot.fence = 0;
+	frame = slot.frame;
+
+	size_t size = (size_t)width_ * height_ * 4;
+	pixels.resize(size);
+	state.BindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)size, GL_MAP_READ_BIT);
+	if (mapped)
+	{
+		std::memcpy(pixels.data(), mapped, size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	else
+	{
+		std::cout << "ERROR::PIXEL_READBACK::MAP_FAILED" << std::endl;
+		std::memset(pixels.data(), 0, size);
+	}
+	state.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	tail_ = (tail_ + 1) % slots_.size();
+	pending_--;
+}
\ No newline at end of file
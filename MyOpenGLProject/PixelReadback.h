@@ -0,0 +1,48 @@
+#ifndef PIXEL_READBACK_H
+#define PIXEL_READBACK_H
+
+#include <GL/glew.h> // include glew to get all the required OpenGL headers
+
+#include <vector>
+#include "GLState.h"
+
+// Reads the bound framebuffer back without stalling the pipeline. glReadPixels goes into one
+// of a ring of pixel pack buffers and returns immediately; the pixels are mapped frames later,
+// once the fence placed behind the read has signaled.
+class PixelReadback
+{
+public:
+	PixelReadback(GLState& state, int width, int height, int slot_count = 3);
+	~PixelReadback();
+	PixelReadback(const PixelReadback&) = delete;
+	PixelReadback& operator=(const PixelReadback&) = delete;
+
+	// start reading the RGBA8 pixels of the current read framebuffer, tagged with frame.
+	// false if every slot still holds a read that hasn't been collected
+	bool Request(GLState& state, int frame);
+	// collect the oldest read if the GPU has finished it. rows start at the bottom
+	bool TryGet(GLState& state, std::vector<unsigned char>& pixels, int& frame);
+	// collect the oldest read, waiting for it if necessary. false if nothing is pending
+	bool Get(GLState& state, std::vector<unsigned char>& pixels, int& frame);
+	size_t PendingCount() const { return pending_; }
+
+private:
+	struct Slot
+	{
+		unsigned int buffer;
+		GLsync fence;
+		int frame;
+	};
+
+	void Collect(GLState& state, std::vector<unsigned char>& pixels, int& frame);
+
+	int width_;
+	int height_;
+	std::vector<Slot> slots_;
+	// the next slot to read into, and the oldest pending one
+	size_t head_;
+	size_t tail_;
+	size_t pending_;
+};
+
+#endif // !PIXEL_READBACK_H
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+
+// GPU scopes show up on their own track in the trace
+static const int kGpuTrack = 1000;
+// keep long runs from growing without bound, statistics keep counting past this
+static const size_t kMaxEvents = 1 << 20;
+
+Profiler::Profiler(int gpu_latency_frames)
+	: origin_(std::chrono::steady_clock::now()), frame_index_(0), gpu_scope_open_(false),
+	frame_start_us_(0.0), gpu_stalls_(0)
+{
+	gpu_frames_.resize(gpu_latency_frames + 1);
+	for (size_t i = 0; i < gpu_frames_.size(); i++)
+	{
+		gpu_frames_[i].used = 0;
+		gpu_frames_[i].pending = false;
+	}
+}
+
+Profiler::~Profiler()
+{
+	for (size_t f = 0; f < gpu_frames_.size(); f++)
+	{
+		for (size_t q = 0; q < gpu_frames_[f].queries.size(); q++)
+			glDeleteQueries(1, &gpu_frames_[f].queries[q].id);
+	}
+}
+
+double Profiler::Now() const
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - origin_).count();
+}
+
+void Profiler::BeginFrame()
+{
+	frame_start_us_ = Now();
+	// the slot is reused after gpu_latency_frames, by then its results are normally available
+	GpuFrame& frame = gpu_frames_[frame_index_ % gpu_frames_.size()];
+	if (frame.pending && !ResolveGpuFrame(frame, false))
+	{
+		gpu_stalls_++;
+		ResolveGpuFrame(frame, true);
+	}
+	frame.used = 0;
+}
+
+void Profiler::EndFrame()
+{
+	double end_us = Now();
+	cpu_frame_ms_.push_back((end_us - frame_start_us_) / 1000.0);
+	Event event = { "frame", frame_start_us_, end_us - frame_start_us_, TrackOfCurrentThread() };
+	AddEvent(event);
+
+	GpuFrame& frame = gpu_frames_[frame_index_ % gpu_frames_.size()];
+	frame.pending = frame.used > 0;
+	frame_index_++;
+
+	// pick up whatever older frames the GPU has finished, oldest first
+	for (size_t age = gpu_frames_.size() - 1; age >= 1; age--)
+	{
+		if (frame_index_ < age)
+			continue;
+		GpuFrame& older = gpu_frames_[(frame_index_ - age) % gpu_frames_.size()];
+		if (older.pending && !ResolveGpuFrame(older, false))
+			break;
+	}
+}
+
+void Profiler::RecordCpu(const char* name, double start_us, double end_us)
+{
+	Event event = { name, start_us, end_us - start_us, TrackOfCurrentThread() };
+	AddEvent(event);
+}
+
+void Profiler::BeginGpu(const char* name)
+{
+	if (gpu_scope_open_)
+	{
+		std::cout << "ERROR::PROFILER::NESTED_GPU_SCOPE " << name << std::endl;
+		return;
+	}
+	GpuFrame& frame = gpu_frames_[frame_index_ % gpu_frames_.size()];
+	if (frame.used == frame.queries.size())
+	{
+		GpuQuery query = { 0, NULL, 0.0 };
+		glGenQueries(1, &query.id);
+		frame.queries.push_back(query);
+	}
+	GpuQuery& query = frame.queries[frame.used++];
+	query.name = name;
+	query.cpu_start_us = Now();
+	glBeginQuery(GL_TIME_ELAPSED, query.id);
+	gpu_scope_open_ = true;
+}
+
+void Profiler::EndGpu()
+{
+	if (!gpu_scope_open_)
+		return;
+	glEndQuery(GL_TIME_ELAPSED);
+	gpu_scope_open_ = false;
+}
+
+bool Profiler::ResolveGpuFrame(GpuFrame& frame, bool wait)
+{
+	// queries finish in order, if the last one is available all of them are
+	if (!wait)
+	{
+		unsigned int available = 0;
+		glGetQueryObjectuiv(frame.queries[frame.used - 1].id, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			return false;
+	}
+
+	double frame_ns = 0.0;
+	for (size_t q = 0; q < frame.used; q++)
+	{
+		GLuint64 elapsed_ns = 0;
+		glGetQueryObjectui64v(frame.queries[q].id, GL_QUERY_RESULT, &elapsed_ns);
+		frame_ns += (double)elapsed_ns;
+		// the GPU start time is unknown with elapsed-time queries, the CPU submit time stands in
+		Event event = { frame.queries[q].name, frame.queries[q].cpu_start_us, elapsed_ns / 1000.0, kGpuTrack };
+		AddEvent(event);
+	}
+	gpu_frame_ms_.push_back(frame_ns / 1e6);
+	frame.pending = false;
+	return true;
+}
+
+int Profiler::TrackOfCurrentThread()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	std::thread::id id = std::this_thread::get_id();
+	for (size_t i = 0; i < threads_.size(); i++)
+	{
+		if (threads_[i] == id)
+			return (int)i;
+	}
+	threads_.push_back(id);
+	return (int)threads_.size() - 1;
+}
+
+void Profiler::AddEvent(const Event& event)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (events_.size() < kMaxEvents)
+		events_.push_back(event);
+}
+
+Profiler::Stats Profiler::ComputeStats(std::vector<double> samples_ms)
+{
+	Stats stats = { samples_ms.size(), 0.0, 0.0, 0.0, 0.0 };
+	if (samples_ms.empty())
+		return stats;
+	std::sort(samples_ms.begin(), samples_ms.end());
+	double sum = 0.0;
+	for (size_t i = 0; i < samples_ms.size(); i++)
+		sum += samples_ms[i];
+	stats.min_ms = samples_ms.front();
+	stats.max_ms = samples_ms.back();
+	stats.avg_ms = sum / samples_ms.size();
+	// nearest-rank percentile
+	size_t rank = (size_t)(0.99 * samples_ms.size() + 0.999999);
+	stats.p99_ms = samples_ms[std::min(std::max(rank, (size_t)1), samples_ms.size()) - 1];
+	return stats;
+}
+
+Profiler::Stats Profiler::CpuFrameStats() const
+{
+	return ComputeStats(cpu_frame_ms_);
+}
+
+Profiler::Stats Profiler::GpuFrameStats() const
+{
+	return ComputeStats(gpu_frame_ms_);
+}
+
+void Profiler::PrintSummary(std::ostream& out) const
+{
+	const char* kLabels[2] = { "CPU", "GPU" };
+	Stats stats[2] = { CpuFrameStats(), GpuFrameStats() };
+	for (int i = 0; i < 2; i++)
+	{
+		out << kLabels[i] << " frame: " << stats[i].count << " frames, min " << stats[i].min_ms
+			<< " ms, avg " << stats[i].avg_ms << " ms, p99 " << stats[i].p99_ms
+			<< " ms, max " << stats[i].max_ms << " ms" << std::endl;
+	}
+	if (gpu_stalls_ > 0)
+		out << "GPU readback stalls: " << gpu_stalls_ << std::endl;
+	// a frame is GPU bound when the GPU needs longer for it than the CPU
+	if (stats[0].count > 0 && stats[1].count > 0)
+		out << (stats[1].avg_ms > stats[0].avg_ms ? "GPU bound" : "CPU bound") << std::endl;
+}
+
+bool Profiler::WriteChromeTrace(const char* path) const
+{
+	std::ofstream file(path, std::ios::trunc);
+	if (!file)
+		return false;
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	file << "{\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << kGpuTrack << ",\"args\":{\"name\":\"GPU\"}}";
+	for (size_t i = 0; i < threads_.size(); i++)
+	{
+		file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i
+			<< ",\"args\":{\"name\":\"" << (i == 0 ? "main" : "worker") << "\"}}";
+	}
+	file.precision(3);
+	file << std::fixed;
+	for (size_t i = 0; i < events_.size(); i++)
+	{
+		// names are string literals from the call sites, no escaping needed
+		const Event& event = events_[i];
+		file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.track
+			<< ",\"ts\":" << event.start_us << ",\"dur\":" << event.duration_us << "}";
+	}
+	file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return file.good();
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <GL/glew.h> // include glew to get all the required OpenGL headers
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Frame profiler: CPU scopes timed with a steady clock, GPU scopes timed with GL_TIME_ELAPSED
+// queries. Queries live in a ring of per-frame slots and are read back a few frames later
+// once the driver reports them available, so the CPU never waits on the GPU.
+class Profiler
+{
+public:
+	// min/avg/p99/max over all recorded frames, in milliseconds
+	struct Stats
+	{
+		size_t count;
+		double min_ms;
+		double avg_ms;
+		double p99_ms;
+		double max_ms;
+	};
+
+	// frames the GPU results may lag behind before the CPU has to wait for them
+	explicit Profiler(int gpu_latency_frames = 3);
+	~Profiler();
+	Profiler(const Profiler&) = delete;
+	Profiler& operator=(const Profiler&) = delete;
+
+	void BeginFrame();
+	void EndFrame();
+
+	// microseconds since the profiler was created
+	double Now() const;
+	// thread safe, CPU scopes may be recorded from worker threads
+	void RecordCpu(const char* name, double start_us, double end_us);
+	// GL thread only; GL_TIME_ELAPSED queries can't overlap, so GPU scopes must not nest
+	void BeginGpu(const char* name);
+	void EndGpu();
+
+	Stats CpuFrameStats() const;
+	Stats GpuFrameStats() const;
+	// frames whose GPU results were not ready in time and had to be waited for
+	size_t GpuStalls() const { return gpu_stalls_; }
+	void PrintSummary(std::ostream& out) const;
+	// chrome://tracing / Perfetto compatible JSON
+	bool WriteChromeTrace(const char* path) const;
+
+private:
+	struct Event
+	{
+		const char* name;
+		double start_us;
+		double duration_us;
+		int track;
+	};
+
+	struct GpuQuery
+	{
+		unsigned int id;
+		const char* name;
+		double cpu_start_us;
+	};
+
+	// the queries issued during one frame
+	struct GpuFrame
+	{
+		std::vector<GpuQuery> queries;
+		size_t used;
+		bool pending;
+	};
+
+	// fetch the results of one frame, waiting for them only if wait is true
+	bool ResolveGpuFrame(GpuFrame& frame, bool wait);
+	int TrackOfCurrentThread();
+	void AddEvent(const Event& event);
+	static Stats ComputeStats(std::vector<double> samples_ms);
+
+	std::chrono::steady_clock::time_point origin_;
+	std::vector<GpuFrame> gpu_frames_;
+	size_t frame_index_;
+	bool gpu_scope_open_;
+	double frame_start_us_;
+	std::vector<double> cpu_frame_ms_;
+	std::vector<double> gpu_frame_ms_;
+	size_t gpu_stalls_;
+
+	mutable std::mutex mutex_;
+	std::vector<Event> events_;
+	std::vector<std::thread::id> threads_;
+};
+
+// RAII CPU scope: PROFILE_SCOPE(profiler, "name") times the rest of the enclosing block
+class CpuScope
+{
+public:
+	CpuScope(Profiler& profiler, const char* name) : profiler_(profiler), name_(name), start_us_(profiler.Now()) {}
+	~CpuScope() { profiler_.RecordCpu(name_, start_us_, profiler_.Now()); }
+	CpuScope(const CpuScope&) = delete;
+	CpuScope& operator=(const CpuScope&) = delete;
+
+private:
+	Profiler& profiler_;
+	const char* name_;
+	double start_us_;
+};
+
+// RAII GPU scope, must not be nested inside another GPU scope
+class GpuScope
+{
+public:
+	GpuScope(Profiler& profiler, const char* name) : profiler_(profiler) { profiler_.BeginGpu(name); }
+	~GpuScope() { profiler_.EndGpu(); }
+	GpuScope(const GpuScope&) = delete;
+	GpuScope& operator=(const GpuScope&) = delete;
+
+private:
+	Profiler& profiler_;
+};
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(profiler, name) CpuScope PROFILER_CONCAT(profile_scope_, __LINE__)(profiler, name)
+#define PROFILE_GPU_SCOPE(profiler, name) GpuScope PROFILER_CONCAT(profile_gpu_scope_, __LINE__)(profiler, name)
+
+#endif // !PROFILER_H
\ No newline at end of file
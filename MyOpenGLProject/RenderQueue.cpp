@@ -0,0 +1,135 @@
+#include "RenderQueue.h"
+
+#include <cstring>
+
+// radix sort digit width
+static const int kRadixBits = 8;
+static const int kRadixSize = 1 << kRadixBits;
+
+unsigned long long RenderQueue::MakeKey(int layer, unsigned int program, unsigned int texture_set,
+	unsigned int vertex_array, float depth)
+{
+	if (depth < 0.0f)
+		depth = 0.0f;
+	if (depth > 1.0f)
+		depth = 1.0f;
+	unsigned long long quantized_depth = (unsigned long long)(depth * 0xFFFFF);
+	return ((unsigned long long)(layer & 0xF) << 60)
+		| ((unsigned long long)(program & 0xFFF) << 48)
+		| ((unsigned long long)(texture_set & 0xFFFF) << 32)
+		| ((unsigned long long)(vertex_array & 0xFFF) << 20)
+		| quantized_depth;
+}
+
+unsigned int RenderQueue::TextureSetId(const unsigned int* textures, int count)
+{
+	// FNV-1a over the texture names, folded to 16 bits
+	unsigned int hash = 2166136261u;
+	for (int i = 0; i < count; i++)
+	{
+		hash ^= textures[i];
+		hash *= 16777619u;
+	}
+	return (hash >> 16) ^ (hash & 0xFFFF);
+}
+
+void RenderQueue::AssignKey(DrawItem& item, int layer, float depth)
+{
+	item.key = MakeKey(layer, item.program, TextureSetId(item.textures, item.texture_count), item.vertex_array, depth);
+}
+
+void RenderQueue::Sort()
+{
+	size_t count = items_.size();
+	if (count < 2)
+		return;
+
+	// sort (key, index) pairs, the draws themselves are moved once at the end
+	keys_.resize(count);
+	keys_scratch_.resize(count);
+	order_.resize(count);
+	order_scratch_.resize(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		keys_[i] = items_[i].key;
+		order_[i] = (unsigned int)i;
+	}
+
+	// one histogram per digit, all built in a single pass over the keys
+	static const int kPasses = 64 / kRadixBits;
+	size_t histograms[kPasses][kRadixSize];
+	std::memset(histograms, 0, sizeof(histograms));
+	for (size_t i = 0; i < count; i++)
+	{
+		unsigned long long key = keys_[i];
+		for (int pass = 0; pass < kPasses; pass++)
+			histograms[pass][(key >> (pass * kRadixBits)) & (kRadixSize - 1)]++;
+	}
+
+	for (int pass = 0; pass < kPasses; pass++)
+	{
+		size_t* histogram = histograms[pass];
+		// every key has the same digit here, the pass would not move anything
+		if (histogram[(keys_[0] >> (pass * kRadixBits)) & (kRadixSize - 1)] == count)
+			continue;
+
+		size_t offset = 0;
+		for (int d = 0; d < kRadixSize; d++)
+		{
+			size_t digit_count = histogram[d];
+			histogram[d] = offset;
+			offset += digit_count;
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t destination = histogram[(keys_[i] >> (pass * kRadixBits)) & (kRadixSize - 1)]++;
+			keys_scratch_[destination] = keys_[i];
+			order_scratch_[destination] = order_[i];
+		}
+		keys_.swap(keys_scratch_);
+		order_.swap(order_scratch_);
+	}
+
+	items_scratch_.resize(count);
+	for (size_t i = 0; i < count; i++)
+		items_scratch_[i] = items_[order_[i]];
+	items_.swap(items_scratch_);
+}
+
+void RenderQueue::Execute(GLState& state) const
+{
+	for (size_t i = 0; i < items_.size(); i++)
+	{
+		const DrawItem& item = items_[i];
+		state.UseProgram(item.program);
+		for (int t = 0; t < item.texture_count; t++)
+			state.BindTexture(t, GL_TEXTURE_2D, item.textures[t]);
+		state.BindVertexArray(item.vertex_array);
+		glDrawElementsBaseVertex(item.mode, item.index_count, item.index_type, (void*)item.index_offset, item.base_vertex);
+	}
+}
+
+SubmissionStats RenderQueue::CountStateChanges() const
+{
+	SubmissionStats stats = { items_.size(), 0, 0, 0 };
+	// same rules as GLState: the first draw pays for everything it binds
+	unsigned int program = 0xFFFFFFFFu;
+	unsigned int vertex_array = 0xFFFFFFFFu;
+	unsigned int textures[DrawItem::kMaxTextures];
+	for (int t = 0; t < DrawItem::kMaxTextures; t++)
+		textures[t] = 0xFFFFFFFFu;
+	for (size_t i = 0; i < items_.size(); i++)
+	{
+		const DrawItem& item = items_[i];
+		stats.program_changes += item.program != program ? 1 : 0;
+		program = item.program;
+		for (int t = 0; t < item.texture_count; t++)
+		{
+			stats.texture_changes += item.textures[t] != textures[t] ? 1 : 0;
+			textures[t] = item.textures[t];
+		}
+		stats.vertex_array_changes += item.vertex_array != vertex_array ? 1 : 0;
+		vertex_array = item.vertex_array;
+	}
+	return stats;
+}
\ No newline at end of file
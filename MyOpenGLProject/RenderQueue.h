@@ -0,0 +1,73 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <GL/glew.h> // include glew to get all the required OpenGL headers
+
+#include <vector>
+#include "GLState.h"
+
+// one indexed draw and the state it needs
+struct DrawItem
+{
+	static const int kMaxTextures = 4;
+
+	unsigned long long key;
+	unsigned int program;
+	unsigned int vertex_array;
+	// bound to units 0..texture_count-1
+	unsigned int textures[kMaxTextures];
+	int texture_count;
+	GLenum mode;
+	int index_count;
+	GLenum index_type;
+	size_t index_offset;
+	// added to every index, lets meshes share one vertex buffer
+	int base_vertex;
+};
+
+// number of state changes a sequence of draws needs
+struct SubmissionStats
+{
+	size_t draws;
+	size_t program_changes;
+	size_t texture_changes;
+	size_t vertex_array_changes;
+
+	size_t StateChanges() const { return program_changes + texture_changes + vertex_array_changes; }
+};
+
+// Collects the draws of a frame, sorts them by a 64-bit key and submits them in that order,
+// so draws sharing a program, textures and VAO end up next to each other.
+// Key layout, most significant first:
+//   layer 4 bits | program 12 bits | texture set 16 bits | vertex array 12 bits | depth 20 bits
+class RenderQueue
+{
+public:
+	static unsigned long long MakeKey(int layer, unsigned int program, unsigned int texture_set,
+		unsigned int vertex_array, float depth);
+	// 16 bit hash of the textures of a draw, collisions only cost sort quality
+	static unsigned int TextureSetId(const unsigned int* textures, int count);
+	// fill in the key from the draw's own state; depth is in [0, 1], smaller depths sort first
+	static void AssignKey(DrawItem& item, int layer, float depth);
+
+	void Clear() { items_.clear(); }
+	void Submit(const DrawItem& item) { items_.push_back(item); }
+	size_t Size() const { return items_.size(); }
+	// least significant digit radix sort on the keys, stable
+	void Sort();
+	// issue every draw in the current order through the state cache
+	void Execute(GLState& state) const;
+	// count the state changes the current order needs, without touching GL
+	SubmissionStats CountStateChanges() const;
+
+private:
+	std::vector<DrawItem> items_;
+	// scratch space for Sort, kept to avoid allocating every frame
+	std::vector<unsigned long long> keys_;
+	std::vector<unsigned long long> keys_scratch_;
+	std::vector<unsigned int> order_;
+	std::vector<unsigned int> order_scratch_;
+	std::vector<DrawItem> items_scratch_;
+};
+
+#endif // !RENDER_QUEUE_H
\ No newline at end of file
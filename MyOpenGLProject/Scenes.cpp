@@ -0,0 +1,118 @@
+#include "Scenes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "ImageDecoder.h"
+#include "UploadConverter.h"
+#include "stb_image.h"
+
+const float kRectangleVertices[32] = {
+	 1.0f,  1.0f, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f,
+	 1.0f, -1.0f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f,
+	-1.0f, -1.0f, 0.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f,
+	-1.0f,  1.0f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f
+};
+const unsigned int kRectangleIndices[6] = { 0, 1, 3, 1, 2, 3 };
+
+void BuildFloorScene(int quad_count, std::vector<float>& vertices, std::vector<unsigned int>& indices)
+{
+	// a grid of quads on the y = 0 plane, 20 units across
+	int columns = 1;
+	while (columns * columns < quad_count)
+		columns++;
+	const float kFloorSize = 20.0f;
+	float cell = kFloorSize / columns;
+	for (int q = 0; q < quad_count; q++)
+	{
+		float x = -kFloorSize * 0.5f + cell * (q % columns);
+		float z = -kFloorSize * 0.5f + cell * (q / columns);
+		unsigned int first = (unsigned int)(vertices.size() / 8);
+		const float kCorners[4][2] = { { 1.0f, 1.0f }, { 1.0f, 0.0f }, { 0.0f, 0.0f }, { 0.0f, 1.0f } };
+		for (int c = 0; c < 4; c++)
+		{
+			// a small gap between the quads, each shows the whole texture
+			float vertex[8] = { x + cell * (0.05f + 0.9f * kCorners[c][0]), 0.0f, z + cell * (0.05f + 0.9f * kCorners[c][1]),
+				1.0f, 1.0f, 1.0f, kCorners[c][0], kCorners[c][1] };
+			vertices.insert(vertices.end(), vertex, vertex + 8);
+		}
+		unsigned int quad[6] = { first, first + 1, first + 3, first + 1, first + 2, first + 3 };
+		indices.insert(indices.end(), quad, quad + 6);
+	}
+}
+
+Matrix4 FloorViewProjection(int width, int height)
+{
+	Camera camera(60.0f, (float)width / height, 0.1f, 100.0f);
+	const float kEye[3] = { 0.0f, 3.0f, 8.0f };
+	const float kTarget[3] = { 0.0f, 0.0f, -2.0f };
+	const float kUp[3] = { 0.0f, 1.0f, 0.0f };
+	camera.LookAt(kEye, kTarget, kUp);
+	return camera.ViewProjection();
+}
+
+void BuildSphere(int segments, float radius, const float center[3], std::vector<float>& vertices, std::vector<unsigned int>& indices)
+{
+	// rings from the top pole to the bottom one, the seam vertices are duplicated for the texture coords
+	const float kPi = 3.14159265f;
+	int rings = std::max(2, segments / 2);
+	vertices.clear();
+	indices.clear();
+	for (int r = 0; r <= rings; r++)
+	{
+		float theta = kPi * r / rings;
+		for (int s = 0; s <= segments; s++)
+		{
+			float phi = 2.0f * kPi * s / segments;
+			float normal[3] = { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+			float vertex[8] = {
+				center[0] + normal[0] * radius, center[1] + normal[1] * radius, center[2] + normal[2] * radius,
+				normal[0] * 0.5f + 0.5f, normal[1] * 0.5f + 0.5f, normal[2] * 0.5f + 0.5f,
+				(float)s / segments, (float)r / rings
+			};
+			vertices.insert(vertices.end(), vertex, vertex + 8);
+		}
+	}
+	// counterclockwise seen from outside, the triangles touching a pole would be degenerate halves
+	for (int r = 0; r < rings; r++)
+	{
+		for (int s = 0; s < segments; s++)
+		{
+			unsigned int top = r * (segments + 1) + s;
+			unsigned int bottom = top + segments + 1;
+			if (r > 0)
+			{
+				unsigned int triangle[3] = { top, top + 1, bottom };
+				indices.insert(indices.end(), triangle, triangle + 3);
+			}
+			if (r < rings - 1)
+			{
+				unsigned int triangle[3] = { top + 1, bottom + 1, bottom };
+				indices.insert(indices.end(), triangle, triangle + 3);
+			}
+		}
+	}
+}
+
+bool LoadSoftwareTexture(const char* path, MipLevel& image, std::vector<MipLevel>& mips, TextureSampler& sampler)
+{
+	int channels;
+	unsigned char* pixels = ImageDecoder::LoadFile(path, image.width, image.height, channels, 0, false, NULL);
+	if (!pixels)
+	{
+		std::cout << "Failed to load texture " << path << std::endl;
+		sampler.SetLevels(kSamplerRGBA8, NULL, 0);
+		return false;
+	}
+	// RGBA with the rows bottom up, like the textures the GL path uploads
+	image.pixels.resize((size_t)image.width * image.height * 4);
+	UploadConverter::Convert(pixels, image.width, image.height, channels, image.pixels.data(), kUploadRGBA,
+		kUploadStraightAlpha, true);
+	stbi_image_free(pixels);
+	// the same mip chain, GL_LINEAR_MIPMAP_LINEAR and GL_REPEAT, as TextureLoader sets them
+	MipChain::Build(image.pixels.data(), image.width, image.height, kMipFilterBox, true, mips);
+	sampler.SetMipChain(image.pixels.data(), image.width, image.height, mips);
+	sampler.SetFilter(kSamplerTrilinear);
+	sampler.SetWrap(kSamplerRepeat, kSamplerRepeat);
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#ifndef SCENES_H
+#define SCENES_H
+
+#include <vector>
+#include "Camera.h"
+#include "MipChain.h"
+#include "TextureSampler.h"
+
+// Geometry and textures shared by the renderer and the command line tools. Vertices are 8
+// floats: position, color and texture coordinates.
+
+// the container rectangle, the same scene the GL path draws
+extern const float kRectangleVertices[32];
+extern const unsigned int kRectangleIndices[6];
+
+// a grid of quad_count quads on the y = 0 plane, 20 units across
+void BuildFloorScene(int quad_count, std::vector<float>& vertices, std::vector<unsigned int>& indices);
+// the floor seen from above and in front, so texture coordinates need the perspective correction
+Matrix4 FloorViewProjection(int width, int height);
+// a UV sphere with segments around and segments / 2 rings, colored by its normals
+void BuildSphere(int segments, float radius, const float center[3], std::vector<float>& vertices, std::vector<unsigned int>& indices);
+// decode an image into image and its mip chain and point the sampler at them, filtered and
+// wrapped like the textures TextureLoader uploads. an unreadable image leaves the sampler empty
+bool LoadSoftwareTexture(const char* path, MipLevel& image, std::vector<MipLevel>& mips, TextureSampler& sampler);
+
+#endif // !SCENES_H
\ No newline at end of file
@@ -1,49 +1,105 @@
 #include "Shader.h"
 
+#include <cstdio>
+#include <cstring>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// program binary cache file layout: header followed by the driver blob
+struct ProgramBinaryHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned long long key;
+	unsigned int format;
+	unsigned int length;
+};
+
+static const char kProgramBinaryMagic[4] = { 'G', 'L', 'P', 'B' };
+static const unsigned int kProgramBinaryVersion = 1;
+
+std::string Shader::binary_cache_dir_ = "shader_cache";
+
 Shader::Shader(const char* kVertexPath, const char* kFragmentPath)
 {
 	std::string vertex_code;
 	std::string fragment_code;
-	std::ifstream v_shader_file;
-	std::ifstream f_shader_file;
+	if (!ReadSource(kVertexPath, vertex_code) || !ReadSource(kFragmentPath, fragment_code))
+		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
 
+	// a warm start loads the linked program straight from the cache and skips compilation
+	unsigned long long cache_key = ProgramCacheKey(vertex_code.data(), vertex_code.size(), fragment_code.data(), fragment_code.size());
+	id_ = LoadProgramBinary(cache_key);
+	if (id_ == 0)
+	{
+		unsigned int vertex = CompileStage(GL_VERTEX_SHADER, vertex_code.data(), vertex_code.size());
+		unsigned int fragment = CompileStage(GL_FRAGMENT_SHADER, fragment_code.data(), fragment_code.size());
+		id_ = LinkProgram(vertex, fragment);
+		FinishProgram(id_, vertex, fragment, cache_key);
+	}
+
+	CacheUniforms();
+}
+
+Shader::Shader(unsigned int program_id)
+	: id_(program_id)
+{
+	CacheUniforms();
+}
+
+bool Shader::ReadSource(const char* path, std::string& code)
+{
+	std::ifstream shader_file;
 	// ensure ifstream objects can throw exceptions:
-	v_shader_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	f_shader_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+	shader_file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
 
 	try
 	{
-		// open files
-		v_shader_file.open(kVertexPath);
-		f_shader_file.open(kFragmentPath);
-		std::stringstream v_shader_stream, f_shader_stream;
-		// read file's buffer contents into streams
-		v_shader_stream << v_shader_file.rdbuf();
-		f_shader_stream << f_shader_file.rdbuf();
-		// close file handlers
-		v_shader_file.close();
-		f_shader_file.close();
-		// convert stream into string
-		vertex_code = v_shader_stream.str();
-		fragment_code = f_shader_stream.str();
+		// open file and read its contents straight into the string
+		shader_file.open(path, std::ios::binary);
+		shader_file.seekg(0, std::ios::end);
+		code.resize((size_t)shader_file.tellg());
+		shader_file.seekg(0, std::ios::beg);
+		if (!code.empty())
+			shader_file.read(&code[0], code.size());
+		shader_file.close();
 	}
-	catch (std::ifstream::failure e)
+	catch (const std::ifstream::failure&)
 	{
-		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+		return false;
 	}
+	return true;
+}
 
-	const char* kVShaderCode = vertex_code.c_str();
-	const char* kFShaderCode = fragment_code.c_str();
+unsigned int Shader::CompileStage(GLenum type, const char* code, size_t length)
+{
+	// explicit length, the code does not have to be zero terminated (e.g. a span into an asset pack)
+	GLint code_length = (GLint)length;
+	unsigned int shader = glCreateShader(type);
+	glShaderSource(shader, 1, &code, &code_length);
+	glCompileShader(shader);
+	return shader;
+}
 
-	// compile shaders
-	unsigned int vertex, fragment;
+unsigned int Shader::LinkProgram(unsigned int vertex, unsigned int fragment)
+{
+	unsigned int program = glCreateProgram();
+	glAttachShader(program, vertex);
+	glAttachShader(program, fragment);
+	if (ProgramBinarySupported())
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glLinkProgram(program);
+	return program;
+}
+
+bool Shader::FinishProgram(unsigned int program, unsigned int vertex, unsigned int fragment, unsigned long long cache_key)
+{
 	int success;
 	char info_log[512];
 
-	// vertex shader
-	vertex = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertex, 1, &kVShaderCode, NULL);
-	glCompileShader(vertex);
 	// print compile errors if any
 	glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
 	if (!success)
@@ -51,12 +107,6 @@ Shader::Shader(const char* kVertexPath, const char* kFragmentPath)
 		glGetShaderInfoLog(vertex, 512, NULL, info_log);
 		std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << info_log << std::endl;
 	}
-
-	// fragment shader
-	fragment = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragment, 1, &kFShaderCode, NULL);
-	glCompileShader(fragment);
-	// print compile errors if any
 	glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
 	if (!success)
 	{
@@ -64,22 +114,22 @@ Shader::Shader(const char* kVertexPath, const char* kFragmentPath)
 		std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << info_log << std::endl;
 	}
 
-	// shader program
-	id_ = glCreateProgram();
-	glAttachShader(id_, vertex);
-	glAttachShader(id_, fragment);
-	glLinkProgram(id_);
 	// print linking errors if any
-	glGetProgramiv(id_, GL_LINK_STATUS, &success);
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
 	if (!success)
 	{
-		glGetProgramInfoLog(id_, 512, NULL, info_log);
+		glGetProgramInfoLog(program, 512, NULL, info_log);
 		std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << info_log << std::endl;
 	}
+	else
+	{
+		SaveProgramBinary(program, cache_key);
+	}
 
 	// delete the shaders as they're linked into the program
 	glDeleteShader(vertex);
 	glDeleteShader(fragment);
+	return success != 0;
 }
 
 void Shader::Use()
@@ -87,15 +137,242 @@ void Shader::Use()
 	glUseProgram(id_);
 }
 
+int Shader::GetUniformLocation(const char* name) const
+{
+	if (!uniforms_.empty())
+	{
+		unsigned int hash = HashName(name);
+		size_t mask = uniforms_.size() - 1;
+		for (size_t i = hash & mask; uniforms_[i].location != -1; i = (i + 1) & mask)
+		{
+			if (uniforms_[i].hash == hash && uniforms_[i].name == name)
+				return uniforms_[i].location;
+		}
+	}
+	// only the first element of a uniform array is reflected, let the driver resolve the others
+	if (std::strchr(name, '[') != NULL)
+		return glGetUniformLocation(id_, name);
+	return -1;
+}
+
 void Shader::SetBool(const std::string& name, bool value) const
 {
-	glUniform1i(glGetUniformLocation(id_, name.c_str()), (int)value);
+	SetBool(GetUniformLocation(name.c_str()), value);
 }
 void Shader::SetInt(const std::string& name, int value) const
 {
-	glUniform1i(glGetUniformLocation(id_, name.c_str()), value);
+	SetInt(GetUniformLocation(name.c_str()), value);
 }
 void Shader::SetFloat(const std::string& name, float value) const
 {
-	glUniform1f(glGetUniformLocation(id_, name.c_str()), value);
+	SetFloat(GetUniformLocation(name.c_str()), value);
+}
+
+void Shader::SetBool(const char* name, bool value) const
+{
+	SetBool(GetUniformLocation(name), value);
+}
+void Shader::SetInt(const char* name, int value) const
+{
+	SetInt(GetUniformLocation(name), value);
+}
+void Shader::SetFloat(const char* name, float value) const
+{
+	SetFloat(GetUniformLocation(name), value);
+}
+void Shader::SetMat4(const char* name, const float* value) const
+{
+	SetMat4(GetUniformLocation(name), value);
+}
+
+void Shader::SetBool(int location, bool value) const
+{
+	glUniform1i(location, (int)value);
+}
+void Shader::SetInt(int location, int value) const
+{
+	glUniform1i(location, value);
+}
+void Shader::SetFloat(int location, float value) const
+{
+	glUniform1f(location, value);
+}
+void Shader::SetMat4(int location, const float* value) const
+{
+	glUniformMatrix4fv(location, 1, GL_FALSE, value);
+}
+
+void Shader::CacheUniforms()
+{
+	uniforms_.clear();
+
+	int uniform_count = 0;
+	int max_name_length = 0;
+	glGetProgramiv(id_, GL_ACTIVE_UNIFORMS, &uniform_count);
+	glGetProgramiv(id_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+	if (uniform_count <= 0)
+		return;
+
+	// arrays take two slots, keep the load factor at or below 1/2 so probe sequences stay short
+	size_t capacity = 8;
+	while (capacity < (size_t)uniform_count * 4)
+		capacity *= 2;
+	uniforms_.assign(capacity, UniformSlot{ 0, -1, std::string() });
+	size_t mask = capacity - 1;
+
+	std::vector<char> name(max_name_length + 1);
+	for (int u = 0; u < uniform_count; u++)
+	{
+		int size;
+		GLenum type;
+		int length = 0;
+		glGetActiveUniform(id_, u, (GLsizei)name.size(), &length, &size, &type, name.data());
+		std::string uniform_name(name.data(), length);
+		// uniforms in blocks report no location and are not set through glUniform*
+		int location = glGetUniformLocation(id_, uniform_name.c_str());
+		if (location == -1)
+			continue;
+		// arrays are reported as "name[0]", make them reachable as "name" too
+		std::vector<std::string> keys(1, uniform_name);
+		size_t bracket = uniform_name.find("[0]");
+		if (bracket != std::string::npos && bracket + 3 == uniform_name.size())
+			keys.push_back(uniform_name.substr(0, bracket));
+
+		for (size_t k = 0; k < keys.size(); k++)
+		{
+			unsigned int hash = HashName(keys[k].c_str());
+			size_t i = hash & mask;
+			while (uniforms_[i].location != -1)
+				i = (i + 1) & mask;
+			uniforms_[i] = UniformSlot{ hash, location, keys[k] };
+		}
+	}
+}
+
+unsigned int Shader::HashName(const char* name)
+{
+	// FNV-1a
+	unsigned int hash = 2166136261u;
+	for (; *name; name++)
+	{
+		hash ^= (unsigned char)*name;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+unsigned long long Shader::ProgramCacheKey(const char* vertex_code, size_t vertex_length, const char* fragment_code, size_t fragment_length)
+{
+	// binaries are only valid for the exact driver that produced them
+	const char* kDriver[3] = {
+		(const char*)glGetString(GL_VENDOR),
+		(const char*)glGetString(GL_RENDERER),
+		(const char*)glGetString(GL_VERSION)
+	};
+
+	// FNV-1a over the sources and driver strings, each part terminated by a zero byte
+	unsigned long long hash = 14695981039346656037ull;
+	auto mix = [&hash](const char* data, size_t length)
+	{
+		for (size_t i = 0; i < length; i++)
+		{
+			hash ^= (unsigned char)data[i];
+			hash *= 1099511628211ull;
+		}
+		// terminating zero byte
+		hash *= 1099511628211ull;
+	};
+	mix(vertex_code, vertex_length);
+	mix(fragment_code, fragment_length);
+	for (int i = 0; i < 3; i++)
+		mix(kDriver[i] ? kDriver[i] : "", kDriver[i] ? std::strlen(kDriver[i]) : 0);
+	return hash;
+}
+
+std::string Shader::ProgramCachePath(unsigned long long key)
+{
+	char file_name[32];
+	std::snprintf(file_name, sizeof(file_name), "%016llx.bin", key);
+	return binary_cache_dir_ + "/" + file_name;
+}
+
+bool Shader::ProgramBinarySupported()
+{
+	if (!GLEW_ARB_get_program_binary)
+		return false;
+	int format_count = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+	return format_count > 0;
+}
+
+unsigned int Shader::LoadProgramBinary(unsigned long long key)
+{
+	if (binary_cache_dir_.empty() || !ProgramBinarySupported())
+		return 0;
+
+	std::ifstream file(ProgramCachePath(key).c_str(), std::ios::binary);
+	if (!file)
+		return 0;
+	ProgramBinaryHeader header;
+	if (!file.read((char*)&header, sizeof(header))
+		|| std::memcmp(header.magic, kProgramBinaryMagic, 4) != 0
+		|| header.version != kProgramBinaryVersion
+		|| header.key != key)
+		return 0;
+	// a truncated or corrupt file can claim any length, check it before allocating
+	std::streamoff body_start = file.tellg();
+	file.seekg(0, std::ios::end);
+	std::streamoff body_size = file.tellg() - body_start;
+	file.seekg(body_start);
+	if (header.length == 0 || (std::streamoff)header.length > body_size)
+		return 0;
+	std::vector<char> binary(header.length);
+	if (!file.read(binary.data(), binary.size()))
+		return 0;
+
+	unsigned int program = glCreateProgram();
+	glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+	// the driver may reject the binary (e.g. after an update), fall back to compiling from source
+	int success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+void Shader::SaveProgramBinary(unsigned int program, unsigned long long key)
+{
+	if (binary_cache_dir_.empty() || !ProgramBinarySupported())
+		return;
+
+	int length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+#ifdef _WIN32
+	_mkdir(binary_cache_dir_.c_str());
+#else
+	mkdir(binary_cache_dir_.c_str(), 0755);
+#endif
+	std::ofstream file(ProgramCachePath(key).c_str(), std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		std::cout << "ERROR::SHADER::PROGRAM::BINARY_CACHE_NOT_WRITABLE" << std::endl;
+		return;
+	}
+	ProgramBinaryHeader header;
+	std::memcpy(header.magic, kProgramBinaryMagic, 4);
+	header.version = kProgramBinaryVersion;
+	header.key = key;
+	header.format = format;
+	header.length = (unsigned int)length;
+	file.write((const char*)&header, sizeof(header));
+	file.write(binary.data(), length);
 }
\ No newline at end of file
@@ -7,21 +7,70 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
 class Shader
 {
 public:
 	// the program ID
 	unsigned int id_;
+	// directory that holds linked program binaries, an empty string disables the cache
+	static std::string binary_cache_dir_;
 
 	// constructor reads and builds the shader
 	Shader(const char* kVertexPath, const char* kFragmentPath);
+	// adopt an already linked program (see ShaderCompiler)
+	explicit Shader(unsigned int program_id);
 	// use/activate the shader
 	void Use();
+	// look up the location (handle) of an active uniform, -1 if the program has no such uniform.
+	// resolve handles once and pass them to the setters below to skip the name lookup entirely
+	int GetUniformLocation(const char* name) const;
 	// utility uniform functions
 	void SetBool(const std::string &name, bool value) const;
 	void SetInt(const std::string &name, int value) const;
 	void SetFloat(const std::string &name, float value) const;
+	void SetBool(const char* name, bool value) const;
+	void SetInt(const char* name, int value) const;
+	void SetFloat(const char* name, float value) const;
+	void SetBool(int location, bool value) const;
+	void SetInt(int location, int value) const;
+	void SetFloat(int location, float value) const;
+	// 16 floats, column-major (see Matrix4)
+	void SetMat4(const char* name, const float* value) const;
+	void SetMat4(int location, const float* value) const;
+
+private:
+	friend class ShaderCompiler;
+
+	// one slot of the uniform table, an empty slot has location -1
+	struct UniformSlot
+	{
+		unsigned int hash;
+		int location;
+		std::string name;
+	};
+
+	// open addressing hash table of all active uniforms, size is a power of two
+	std::vector<UniformSlot> uniforms_;
+
+	// reflect the active uniforms of the linked program into uniforms_
+	void CacheUniforms();
+	static unsigned int HashName(const char* name);
+
+	// program binary cache, keyed by the sources and the driver that produced the binary
+	static unsigned long long ProgramCacheKey(const char* vertex_code, size_t vertex_length, const char* fragment_code, size_t fragment_length);
+	static std::string ProgramCachePath(unsigned long long key);
+	static bool ProgramBinarySupported();
+	static unsigned int LoadProgramBinary(unsigned long long key);
+	static void SaveProgramBinary(unsigned int program, unsigned long long key);
+
+	// build steps, split up so compiles and links can be issued without waiting on the driver
+	static bool ReadSource(const char* path, std::string& code);
+	static unsigned int CompileStage(GLenum type, const char* code, size_t length);
+	static unsigned int LinkProgram(unsigned int vertex, unsigned int fragment);
+	// query compile/link status, print errors, save the binary and delete the stage objects
+	static bool FinishProgram(unsigned int program, unsigned int vertex, unsigned int fragment, unsigned long long cache_key);
 };
 
 #endif // !SHADER_H
\ No newline at end of file
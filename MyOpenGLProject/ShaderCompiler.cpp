@@ -0,0 +1,103 @@
+#include "ShaderCompiler.h"
+
+ShaderCompiler::ShaderCompiler()
+	: parallel_(false)
+{
+	// let the driver pick as many compiler threads as it likes
+	if (GLEW_KHR_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+		parallel_ = true;
+	}
+	else if (GLEW_ARB_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+		parallel_ = true;
+	}
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+	// programs that were never picked up are still owned by the compiler
+	for (size_t i = 0; i < jobs_.size(); i++)
+	{
+		if (jobs_[i].finished)
+			continue;
+		glDeleteShader(jobs_[i].vertex);
+		glDeleteShader(jobs_[i].fragment);
+		glDeleteProgram(jobs_[i].program);
+	}
+}
+
+ShaderCompiler::Handle ShaderCompiler::Submit(const char* kVertexPath, const char* kFragmentPath)
+{
+	std::string vertex_code;
+	std::string fragment_code;
+	if (!Shader::ReadSource(kVertexPath, vertex_code) || !Shader::ReadSource(kFragmentPath, fragment_code))
+		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
+	return Submit(vertex_code.data(), vertex_code.size(), fragment_code.data(), fragment_code.size());
+}
+
+ShaderCompiler::Handle ShaderCompiler::Submit(const AssetPack& pack, const char* vertex_name, const char* fragment_name)
+{
+	AssetSpan vertex = pack.Find(vertex_name);
+	AssetSpan fragment = pack.Find(fragment_name);
+	if (vertex.IsEmpty() || fragment.IsEmpty())
+		std::cout << "ERROR::SHADER::NOT_IN_ASSET_PACK" << std::endl;
+	return Submit(vertex.IsEmpty() ? "" : vertex.AsChars(), vertex.size, fragment.IsEmpty() ? "" : fragment.AsChars(), fragment.size);
+}
+
+ShaderCompiler::Handle ShaderCompiler::Submit(const char* vertex_code, size_t vertex_length, const char* fragment_code, size_t fragment_length)
+{
+	Job job;
+	job.vertex = 0;
+	job.fragment = 0;
+	job.cache_key = Shader::ProgramCacheKey(vertex_code, vertex_length, fragment_code, fragment_length);
+	job.finished = false;
+	// cached binaries are loaded right away, there is nothing left for the driver to do
+	job.program = Shader::LoadProgramBinary(job.cache_key);
+	if (job.program == 0)
+	{
+		// no status queries here, they would wait for the compile to finish
+		job.vertex = Shader::CompileStage(GL_VERTEX_SHADER, vertex_code, vertex_length);
+		job.fragment = Shader::CompileStage(GL_FRAGMENT_SHADER, fragment_code, fragment_length);
+		job.program = Shader::LinkProgram(job.vertex, job.fragment);
+	}
+
+	jobs_.push_back(job);
+	return jobs_.size() - 1;
+}
+
+bool ShaderCompiler::IsReady(Handle handle) const
+{
+	const Job& job = jobs_[handle];
+	if (job.finished || job.vertex == 0 || !parallel_)
+		return true;
+	int completed = 0;
+	glGetProgramiv(job.program, GL_COMPLETION_STATUS_KHR, &completed);
+	return completed != 0;
+}
+
+Shader ShaderCompiler::Get(Handle handle)
+{
+	Job& job = jobs_[handle];
+	if (!job.finished)
+	{
+		// program binaries are already linked and checked
+		if (job.vertex != 0)
+			Shader::FinishProgram(job.program, job.vertex, job.fragment, job.cache_key);
+		job.finished = true;
+	}
+	return Shader(job.program);
+}
+
+size_t ShaderCompiler::PendingCount() const
+{
+	size_t pending = 0;
+	for (size_t i = 0; i < jobs_.size(); i++)
+	{
+		if (!IsReady(i))
+			pending++;
+	}
+	return pending;
+}
@@ -0,0 +1,51 @@
+#ifndef SHADER_COMPILER_H
+#define SHADER_COMPILER_H
+
+#include <GL/glew.h> // include glew to get all the required OpenGL headers
+
+#include <vector>
+#include "AssetPack.h"
+#include "Shader.h"
+
+// Issues compiles and links for many programs up front and lets the driver work on them
+// in parallel (KHR_parallel_shader_compile) instead of blocking after every stage.
+class ShaderCompiler
+{
+public:
+	// future-like ticket for a submitted program
+	typedef size_t Handle;
+
+	ShaderCompiler();
+	~ShaderCompiler();
+	ShaderCompiler(const ShaderCompiler&) = delete;
+	ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+
+	// read the sources and issue compile + link, returns without waiting on the driver
+	Handle Submit(const char* kVertexPath, const char* kFragmentPath);
+	// same, with the sources taken directly from an asset pack
+	Handle Submit(const AssetPack& pack, const char* vertex_name, const char* fragment_name);
+	Handle Submit(const char* vertex_code, size_t vertex_length, const char* fragment_code, size_t fragment_length);
+	// non-blocking poll; without parallel compile support this is always true and Get() blocks
+	bool IsReady(Handle handle) const;
+	// wait for the program, report compile/link errors and hand back the Shader
+	Shader Get(Handle handle);
+	// number of submitted programs that are not ready yet
+	size_t PendingCount() const;
+	// true if the driver compiles in the background
+	bool IsParallel() const { return parallel_; }
+
+private:
+	struct Job
+	{
+		unsigned int vertex;
+		unsigned int fragment;
+		unsigned int program;
+		unsigned long long cache_key;
+		bool finished;
+	};
+
+	std::vector<Job> jobs_;
+	bool parallel_;
+};
+
+#endif // !SHADER_COMPILER_H
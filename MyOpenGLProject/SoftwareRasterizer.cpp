@@ -0,0 +1,531 @@
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include "CpuFeatures.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARE_RASTERIZER_SSE2
+// the AVX2 kernels are built in SoftwareRasterizerAvx2.cpp and picked at runtime
+#define SOFTWARE_RASTERIZER_AVX2
+#include <emmintrin.h>
+#include "SoftwareRasterizerAvx2.h"
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SOFTWARE_RASTERIZER_NEON
+#include <arm_neon.h>
+#endif
+
+// floats per vertex in the interleaved layout: position, color, texture coords
+static const size_t kVertexFloats = 8;
+static const size_t kTextureCoordOffset = 6;
+// vertices per vertex stage task and triangles per setup task
+static const size_t kVertexGrain = 4096;
+static const size_t kTrianglesPerChunk = 512;
+// pixels per edge function evaluation, the AVX2 width
+static const int kSpanWidth = 8;
+// a triangle clipped by the near and far planes has at most five corners
+static const int kMaxClippedVertices = 5;
+
+static unsigned long long PackRange(size_t begin, size_t end)
+{
+	return (unsigned long long)begin | ((unsigned long long)end << 32);
+}
+
+static size_t RangeBegin(unsigned long long range)
+{
+	return (size_t)(range & 0xFFFFFFFFull);
+}
+
+static size_t RangeEnd(unsigned long long range)
+{
+	return (size_t)(range >> 32);
+}
+
+static unsigned char ToUnorm8(float value)
+{
+	return (unsigned char)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height, ThreadPool* pool)
+	: width_(width), height_(height), pool_(pool), chunk_count_(0),
+	tile_ranges_(pool ? pool->ThreadCount() + 1 : 1)
+{
+	tiles_x_ = (width + kTileSize - 1) / kTileSize;
+	tiles_y_ = (height + kTileSize - 1) / kTileSize;
+	color_.resize((size_t)width * height * 4);
+}
+
+void SoftwareRasterizer::Clear(float red, float green, float blue, float alpha)
+{
+	const unsigned char kColor[4] = { ToUnorm8(red), ToUnorm8(green), ToUnorm8(blue), ToUnorm8(alpha) };
+	unsigned char* pixels = color_.data();
+	size_t pixel_count = (size_t)width_ * height_;
+	for (size_t i = 0; i < pixel_count; i++)
+	{
+		for (int c = 0; c < 4; c++)
+			pixels[i * 4 + c] = kColor[c];
+	}
+}
+
+void SoftwareRasterizer::Draw(const float* vertices, size_t vertex_count, const unsigned int* indices, size_t index_count,
+	const TextureSampler& texture1, const TextureSampler& texture2, const Matrix4& view_projection)
+{
+	// vertex stage, gl_Position = viewProjection * vec4(aPos, 1.0)
+	clip_vertices_.resize(vertex_count);
+	auto transform = [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const float* vertex = vertices + i * kVertexFloats;
+			view_projection.Transform(vertex, clip_vertices_[i].position);
+			clip_vertices_[i].uv[0] = vertex[kTextureCoordOffset];
+			clip_vertices_[i].uv[1] = vertex[kTextureCoordOffset + 1];
+		}
+	};
+	if (pool_ && vertex_count > kVertexGrain)
+		pool_->ParallelFor(vertex_count, kVertexGrain, transform);
+	else
+		transform(0, vertex_count);
+
+	// setup and binning, every chunk keeps its own bins so submission order survives
+	size_t triangle_count = index_count / 3;
+	chunk_count_ = (triangle_count + kTrianglesPerChunk - 1) / kTrianglesPerChunk;
+	if (chunks_.size() < chunk_count_)
+		chunks_.resize(chunk_count_);
+	size_t tile_count = (size_t)tiles_x_ * tiles_y_;
+	auto setup = [&](size_t begin, size_t end)
+	{
+		for (size_t c = begin; c < end; c++)
+		{
+			SetupChunk& chunk = chunks_[c];
+			chunk.triangles.clear();
+			chunk.bins.resize(tile_count);
+			for (size_t t = 0; t < tile_count; t++)
+				chunk.bins[t].clear();
+			SetupTriangles(chunk, indices, c * kTrianglesPerChunk, std::min(triangle_count, (c + 1) * kTrianglesPerChunk));
+		}
+	};
+	if (pool_ && chunk_count_ > 1)
+		pool_->ParallelFor(chunk_count_, 1, setup);
+	else
+		setup(0, chunk_count_);
+
+	RunTiles(texture1, texture2);
+}
+
+// distance of a clip space vertex to the near (z = -w) or far (z = w) plane, positive inside
+static float DepthPlaneDistance(const float position[4], int plane)
+{
+	return plane == 0 ? position[3] + position[2] : position[3] - position[2];
+}
+
+void SoftwareRasterizer::SetupTriangles(SetupChunk& chunk, const unsigned int* indices, size_t first_triangle, size_t end_triangle)
+{
+	size_t vertex_count = clip_vertices_.size();
+	for (size_t t = first_triangle; t < end_triangle; t++)
+	{
+		const unsigned int* triangle = indices + t * 3;
+		if (triangle[0] >= vertex_count || triangle[1] >= vertex_count || triangle[2] >= vertex_count)
+			continue;
+		const ClipVertex* corners[3] = { &clip_vertices_[triangle[0]], &clip_vertices_[triangle[1]], &clip_vertices_[triangle[2]] };
+
+		// trivially rejected when all corners are outside one of the clip planes
+		int outside_all = 0x3F;
+		int outside_any = 0;
+		for (int i = 0; i < 3; i++)
+		{
+			const float* p = corners[i]->position;
+			int outside = (p[0] < -p[3] ? 1 : 0) | (p[0] > p[3] ? 2 : 0) | (p[1] < -p[3] ? 4 : 0)
+				| (p[1] > p[3] ? 8 : 0) | (p[2] < -p[3] ? 16 : 0) | (p[2] > p[3] ? 32 : 0);
+			outside_all &= outside;
+			outside_any |= outside;
+		}
+		if (outside_all != 0)
+			continue;
+		// x and y need no clipping, the bounding box is limited to the viewport instead
+		if ((outside_any & (16 | 32)) == 0)
+		{
+			AddTriangle(chunk, *corners[0], *corners[1], *corners[2]);
+			continue;
+		}
+
+		// Sutherland-Hodgman against the near and far planes, then a fan over the polygon
+		ClipVertex polygon[2][kMaxClippedVertices];
+		int count = 3;
+		for (int i = 0; i < 3; i++)
+			polygon[0][i] = *corners[i];
+		int current = 0;
+		for (int plane = 0; plane < 2 && count > 0; plane++)
+		{
+			const ClipVertex* in = polygon[current];
+			ClipVertex* out = polygon[1 - current];
+			int out_count = 0;
+			for (int i = 0; i < count; i++)
+			{
+				const ClipVertex& a = in[i];
+				const ClipVertex& b = in[(i + 1) % count];
+				float distance_a = DepthPlaneDistance(a.position, plane);
+				float distance_b = DepthPlaneDistance(b.position, plane);
+				if (distance_a >= 0.0f)
+					out[out_count++] = a;
+				if ((distance_a >= 0.0f) != (distance_b >= 0.0f))
+				{
+					float weight = distance_a / (distance_a - distance_b);
+					ClipVertex& split = out[out_count++];
+					for (int k = 0; k < 4; k++)
+						split.position[k] = a.position[k] + (b.position[k] - a.position[k]) * weight;
+					for (int k = 0; k < 2; k++)
+						split.uv[k] = a.uv[k] + (b.uv[k] - a.uv[k]) * weight;
+				}
+			}
+			count = out_count;
+			current = 1 - current;
+		}
+		for (int i = 1; i + 1 < count; i++)
+			AddTriangle(chunk, polygon[current][0], polygon[current][i], polygon[current][i + 1]);
+	}
+}
+
+void SoftwareRasterizer::AddTriangle(SetupChunk& chunk, const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2)
+{
+	const ClipVertex* corners[3] = { &v0, &v1, &v2 };
+	double x[3], y[3], inv_w[3], u_over_w[3], v_over_w[3];
+	for (int i = 0; i < 3; i++)
+	{
+		const float* p = corners[i]->position;
+		if (!(p[3] > 0.0f))
+			return;
+		// perspective divide and viewport transform, window y goes up like in GL
+		inv_w[i] = 1.0 / p[3];
+		x[i] = (p[0] * inv_w[i] * 0.5 + 0.5) * width_;
+		y[i] = (p[1] * inv_w[i] * 0.5 + 0.5) * height_;
+		u_over_w[i] = corners[i]->uv[0] * inv_w[i];
+		v_over_w[i] = corners[i]->uv[1] * inv_w[i];
+	}
+
+	// twice the signed area, both windings are drawn: clockwise triangles are flipped around
+	double area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+	if (!(area != 0.0) || !std::isfinite(area))
+		return;
+	if (area < 0.0)
+	{
+		std::swap(x[1], x[2]);
+		std::swap(y[1], y[2]);
+		std::swap(inv_w[1], inv_w[2]);
+		std::swap(u_over_w[1], u_over_w[2]);
+		std::swap(v_over_w[1], v_over_w[2]);
+		area = -area;
+	}
+
+	// pixels whose centers lie within the bounds, clamped to the viewport
+	TriangleSetup setup;
+	double min_x = std::min(std::min(x[0], x[1]), x[2]);
+	double max_x = std::max(std::max(x[0], x[1]), x[2]);
+	double min_y = std::min(std::min(y[0], y[1]), y[2]);
+	double max_y = std::max(std::max(y[0], y[1]), y[2]);
+	setup.min_x = (int)std::max(0.0, std::ceil(min_x - 0.5));
+	setup.max_x = (int)std::min(width_ - 1.0, std::floor(max_x - 0.5));
+	setup.min_y = (int)std::max(0.0, std::ceil(min_y - 0.5));
+	setup.max_y = (int)std::min(height_ - 1.0, std::floor(max_y - 0.5));
+	if (setup.min_x > setup.max_x || setup.min_y > setup.max_y)
+		return;
+
+	// edge i runs from corner i to the next and is positive inside. it is evaluated relative to the
+	// center of the bounding box's first pixel, which keeps the values small and precise
+	double origin_x = setup.min_x + 0.5;
+	double origin_y = setup.min_y + 0.5;
+	double edge_a[3], edge_b[3], edge_c[3];
+	for (int i = 0; i < 3; i++)
+	{
+		int next = (i + 1) % 3;
+		edge_a[i] = y[i] - y[next];
+		edge_b[i] = x[next] - x[i];
+		edge_c[i] = edge_a[i] * (origin_x - x[i]) + edge_b[i] * (origin_y - y[i]);
+		setup.edge_a[i] = (float)edge_a[i];
+		setup.edge_b[i] = (float)edge_b[i];
+		setup.edge_c[i] = (float)edge_c[i];
+		// of two triangles sharing an edge exactly one has it as its own
+		setup.owns_edge[i] = edge_a[i] > 0.0 || (edge_a[i] == 0.0 && edge_b[i] < 0.0);
+	}
+
+	// attributes are planes through the corners, the weight of a corner is the edge opposite to it
+	const double* attributes[3] = { inv_w, u_over_w, v_over_w };
+	float* planes[3] = { setup.inv_w, setup.u_over_w, setup.v_over_w };
+	for (int a = 0; a < 3; a++)
+	{
+		const double* value = attributes[a];
+		planes[a][0] = (float)((edge_a[1] * value[0] + edge_a[2] * value[1] + edge_a[0] * value[2]) / area);
+		planes[a][1] = (float)((edge_b[1] * value[0] + edge_b[2] * value[1] + edge_b[0] * value[2]) / area);
+		planes[a][2] = (float)((edge_c[1] * value[0] + edge_c[2] * value[1] + edge_c[0] * value[2]) / area);
+	}
+
+	unsigned int index = (unsigned int)chunk.triangles.size();
+	chunk.triangles.push_back(setup);
+
+	// bin into every tile the bounds touch, skipping tiles entirely outside one of the edges
+	int first_tile_x = setup.min_x / kTileSize, last_tile_x = setup.max_x / kTileSize;
+	int first_tile_y = setup.min_y / kTileSize, last_tile_y = setup.max_y / kTileSize;
+	bool single_tile = first_tile_x == last_tile_x && first_tile_y == last_tile_y;
+	for (int tile_y = first_tile_y; tile_y <= last_tile_y; tile_y++)
+	{
+		for (int tile_x = first_tile_x; tile_x <= last_tile_x; tile_x++)
+		{
+			bool overlaps = true;
+			if (!single_tile)
+			{
+				double x_low = std::max(setup.min_x, tile_x * kTileSize) - setup.min_x;
+				double x_high = std::min(setup.max_x, tile_x * kTileSize + kTileSize - 1) - setup.min_x;
+				double y_low = std::max(setup.min_y, tile_y * kTileSize) - setup.min_y;
+				double y_high = std::min(setup.max_y, tile_y * kTileSize + kTileSize - 1) - setup.min_y;
+				for (int i = 0; i < 3 && overlaps; i++)
+				{
+					// the pixel center furthest inside this edge
+					double best = edge_a[i] * (edge_a[i] > 0.0 ? x_high : x_low) + edge_b[i] * (edge_b[i] > 0.0 ? y_high : y_low) + edge_c[i];
+					overlaps = best >= 0.0;
+				}
+			}
+			if (overlaps)
+				chunk.bins[(size_t)tile_y * tiles_x_ + tile_x].push_back(index);
+		}
+	}
+}
+
+void SoftwareRasterizer::RunTiles(const TextureSampler& texture1, const TextureSampler& texture2)
+{
+	// every worker starts on its own contiguous share of the tiles
+	size_t tile_count = (size_t)tiles_x_ * tiles_y_;
+	size_t worker_count = tile_ranges_.size();
+	for (size_t w = 0; w < worker_count; w++)
+		tile_ranges_[w].store(PackRange(tile_count * w / worker_count, tile_count * (w + 1) / worker_count));
+
+	auto work = [&](size_t worker)
+	{
+		std::atomic<unsigned long long>& own = tile_ranges_[worker];
+		for (;;)
+		{
+			// take the next tile from the front of the own range
+			unsigned long long range = own.load();
+			size_t begin = RangeBegin(range);
+			if (begin < RangeEnd(range))
+			{
+				if (own.compare_exchange_weak(range, PackRange(begin + 1, RangeEnd(range))))
+					RasterizeTile(begin, texture1, texture2);
+				continue;
+			}
+
+			// out of work: steal the back half of the largest range left. thieves only touch
+			// ranges that are not empty, so the own empty range can be replaced with a plain store
+			size_t victim = worker_count;
+			size_t largest = 0;
+			for (size_t w = 0; w < worker_count; w++)
+			{
+				unsigned long long other = tile_ranges_[w].load();
+				if (RangeEnd(other) - RangeBegin(other) > largest)
+				{
+					largest = RangeEnd(other) - RangeBegin(other);
+					victim = w;
+				}
+			}
+			if (victim == worker_count)
+				return;
+			unsigned long long other = tile_ranges_[victim].load();
+			size_t other_begin = RangeBegin(other), other_end = RangeEnd(other);
+			if (other_begin >= other_end)
+				continue;
+			size_t middle = other_begin + (other_end - other_begin) / 2;
+			if (tile_ranges_[victim].compare_exchange_strong(other, PackRange(other_begin, middle)))
+				own.store(PackRange(middle, other_end));
+		}
+	};
+
+	if (!pool_)
+	{
+		work(0);
+		return;
+	}
+	// one chunk per worker. a worker whose chunk starts late finds its tiles already stolen
+	pool_->ParallelFor(worker_count, 1, [&](size_t begin, size_t end)
+	{
+		for (size_t w = begin; w < end; w++)
+			work(w);
+	});
+}
+
+void SoftwareRasterizer::RasterizeTile(size_t tile, const TextureSampler& texture1, const TextureSampler& texture2)
+{
+	int tile_x = (int)(tile % tiles_x_) * kTileSize;
+	int tile_y = (int)(tile / tiles_x_) * kTileSize;
+	for (size_t c = 0; c < chunk_count_; c++)
+	{
+		const SetupChunk& chunk = chunks_[c];
+		const std::vector<unsigned int>& bin = chunk.bins[tile];
+		for (size_t i = 0; i < bin.size(); i++)
+			RasterizeTriangle(chunk.triangles[bin[i]], tile_x, tile_y, texture1, texture2);
+	}
+}
+
+void SoftwareRasterizer::RasterizeTriangle(const TriangleSetup& triangle, int tile_x, int tile_y,
+	const TextureSampler& texture1, const TextureSampler& texture2)
+{
+	int x_begin = std::max(triangle.min_x, tile_x);
+	int x_end = std::min(triangle.max_x, tile_x + kTileSize - 1);
+	int y_begin = std::max(triangle.min_y, tile_y);
+	int y_end = std::min(triangle.max_y, tile_y + kTileSize - 1);
+
+#if defined(SOFTWARE_RASTERIZER_AVX2)
+	const bool avx2 = CpuFeatures::HasAvx2();
+#endif
+#if defined(SOFTWARE_RASTERIZER_SSE2)
+	const __m128 kLanes = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	const __m128 kZero = _mm_setzero_ps();
+	__m128 step[3];
+	for (int i = 0; i < 3; i++)
+		step[i] = _mm_mul_ps(_mm_set1_ps(triangle.edge_a[i]), kLanes);
+#elif defined(SOFTWARE_RASTERIZER_NEON)
+	const float kLaneValues[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+	const float32x4_t kLanes = vld1q_f32(kLaneValues);
+	const float32x4_t kZero = vdupq_n_f32(0.0f);
+	float32x4_t step[3];
+	for (int i = 0; i < 3; i++)
+		step[i] = vmulq_n_f32(kLanes, triangle.edge_a[i]);
+#endif
+
+	for (int y = y_begin; y <= y_end; y++)
+	{
+		float row = (float)(y - triangle.min_y);
+		for (int x = x_begin; x <= x_end; x += kSpanWidth)
+		{
+			// edge values at the first pixel of the span
+			float column = (float)(x - triangle.min_x);
+			float base[3];
+			for (int i = 0; i < 3; i++)
+				base[i] = triangle.edge_a[i] * column + triangle.edge_b[i] * row + triangle.edge_c[i];
+
+			unsigned int mask = 0;
+#if defined(SOFTWARE_RASTERIZER_AVX2)
+			if (avx2)
+				mask = SoftwareRasterizerAvx2::CoverSpan(base, triangle.edge_a, triangle.owns_edge);
+			else
+#endif
+#if defined(SOFTWARE_RASTERIZER_SSE2)
+			for (int half = 0; half < 2; half++)
+			{
+				__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+				for (int i = 0; i < 3; i++)
+				{
+					__m128 edge = _mm_add_ps(_mm_set1_ps(base[i] + triangle.edge_a[i] * (half * 4)), step[i]);
+					inside = _mm_and_ps(inside, triangle.owns_edge[i] ? _mm_cmpge_ps(edge, kZero) : _mm_cmpgt_ps(edge, kZero));
+				}
+				mask |= (unsigned int)_mm_movemask_ps(inside) << (half * 4);
+			}
+#elif defined(SOFTWARE_RASTERIZER_NEON)
+			for (int half = 0; half < 2; half++)
+			{
+				uint32x4_t inside = vdupq_n_u32(0xFFFFFFFFu);
+				for (int i = 0; i < 3; i++)
+				{
+					float32x4_t edge = vaddq_f32(vdupq_n_f32(base[i] + triangle.edge_a[i] * (half * 4)), step[i]);
+					inside = vandq_u32(inside, triangle.owns_edge[i] ? vcgeq_f32(edge, kZero) : vcgtq_f32(edge, kZero));
+				}
+				unsigned int lanes[4];
+				vst1q_u32(lanes, inside);
+				mask |= ((lanes[0] & 1) | (lanes[1] & 2) | (lanes[2] & 4) | (lanes[3] & 8)) << (half * 4);
+			}
+#else
+			for (int lane = 0; lane < kSpanWidth; lane++)
+			{
+				bool inside = true;
+				for (int i = 0; i < 3; i++)
+				{
+					float edge = base[i] + triangle.edge_a[i] * lane;
+					inside = inside && (triangle.owns_edge[i] ? edge >= 0.0f : edge > 0.0f);
+				}
+				mask |= inside ? 1u << lane : 0u;
+			}
+#endif
+			// drop the lanes past the end of the bounds
+			if (x_end - x + 1 < kSpanWidth)
+				mask &= (1u << (x_end - x + 1)) - 1;
+			if (mask != 0)
+				ShadeSpan(triangle, x, y, mask, texture1, texture2);
+		}
+	}
+}
+
+void SoftwareRasterizer::ShadeSpan(const TriangleSetup& triangle, int x, int y, unsigned int mask,
+	const TextureSampler& texture1, const TextureSampler& texture2)
+{
+	// perspective correct texture coords: u/w and v/w over 1/w
+	float u[kSpanWidth], v[kSpanWidth], w[kSpanWidth];
+	float column = (float)(x - triangle.min_x);
+	float row = (float)(y - triangle.min_y);
+#if defined(SOFTWARE_RASTERIZER_AVX2)
+	if (CpuFeatures::HasAvx2())
+		SoftwareRasterizerAvx2::InterpolateSpan(triangle.inv_w, triangle.u_over_w, triangle.v_over_w, column, row, u, v, w);
+	else
+#endif
+	for (int lane = 0; lane < kSpanWidth; lane++)
+	{
+		float px = column + lane;
+		w[lane] = 1.0f / (triangle.inv_w[0] * px + triangle.inv_w[1] * row + triangle.inv_w[2]);
+		u[lane] = (triangle.u_over_w[0] * px + triangle.u_over_w[1] * row + triangle.u_over_w[2]) * w[lane];
+		v[lane] = (triangle.v_over_w[0] * px + triangle.v_over_w[1] * row + triangle.v_over_w[2]) * w[lane];
+	}
+
+	// mipmapped textures need the level of detail, from the screen space derivatives of the
+	// texture coords: d(u) = (d(u/w) - u * d(1/w)) * w
+	const TextureSampler* textures[2] = { &texture1, &texture2 };
+	float lod[2][kSpanWidth];
+	for (int t = 0; t < 2; t++)
+	{
+		if (textures[t]->Filter() != kSamplerTrilinear)
+			continue;
+		for (int lane = 0; lane < kSpanWidth; lane++)
+		{
+			float du_dx = (triangle.u_over_w[0] - u[lane] * triangle.inv_w[0]) * w[lane];
+			float dv_dx = (triangle.v_over_w[0] - v[lane] * triangle.inv_w[0]) * w[lane];
+			float du_dy = (triangle.u_over_w[1] - u[lane] * triangle.inv_w[1]) * w[lane];
+			float dv_dy = (triangle.v_over_w[1] - v[lane] * triangle.inv_w[1]) * w[lane];
+			lod[t][lane] = textures[t]->Lod(du_dx, dv_dx, du_dy, dv_dy);
+		}
+	}
+
+	// lanes outside the triangle are sampled too, their colors are dropped below
+	SamplerColors first, second;
+	texture1.Sample(u, v, lod[0], kSpanWidth, first);
+	texture2.Sample(u, v, lod[1], kSpanWidth, second);
+
+	// FragColor = mix(texture(texture1, TexCoord), texture(texture2, TexCoord), 0.5)
+	unsigned char* pixels = &color_[((size_t)y * width_ + x) * 4];
+#if defined(SOFTWARE_RASTERIZER_AVX2)
+	if (CpuFeatures::HasAvx2())
+	{
+		SoftwareRasterizerAvx2::StoreSpan(first, second, mask, pixels);
+		return;
+	}
+#endif
+	for (int lane = 0; lane < kSpanWidth; lane++)
+	{
+		if ((mask & (1u << lane)) == 0)
+			continue;
+		pixels[lane * 4] = ToUnorm8(first.red[lane] * 0.5f + second.red[lane] * 0.5f);
+		pixels[lane * 4 + 1] = ToUnorm8(first.green[lane] * 0.5f + second.green[lane] * 0.5f);
+		pixels[lane * 4 + 2] = ToUnorm8(first.blue[lane] * 0.5f + second.blue[lane] * 0.5f);
+		pixels[lane * 4 + 3] = ToUnorm8(first.alpha[lane] * 0.5f + second.alpha[lane] * 0.5f);
+	}
+}
+
+const char* SoftwareRasterizer::SimdName()
+{
+#if defined(SOFTWARE_RASTERIZER_AVX2)
+	if (CpuFeatures::HasAvx2())
+		return "AVX2";
+#endif
+#if defined(SOFTWARE_RASTERIZER_SSE2)
+	return "SSE2";
+#elif defined(SOFTWARE_RASTERIZER_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
\ No newline at end of file
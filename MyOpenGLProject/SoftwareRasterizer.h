@@ -0,0 +1,90 @@
+#ifndef SOFTWARE_RASTERIZER_H
+#define SOFTWARE_RASTERIZER_H
+
+#include <atomic>
+#include <vector>
+#include "Camera.h"
+#include "TextureSampler.h"
+#include "ThreadPool.h"
+
+// CPU backend for the shader.vert/shader.frag pipeline, for machines without a GPU.
+// Takes the interleaved 8-float vertices (position, color, texture coords) and 32-bit indices
+// of Source.cpp, transforms them by the view-projection matrix, clips against the near and far
+// planes and bins the triangles into kTileSize tiles. Tiles are then rasterized in parallel with
+// half-space edge functions (8 pixels at a time with AVX2, 4 with SSE2) and shaded with
+// mix(texture(texture1, uv), texture(texture2, uv), 0.5), sampling 8 pixels per TextureSampler
+// call (bilinear with repeat wrapping matches the GL path's texture parameters). Triangles are drawn in submission order without depth test or culling, like the
+// GL path. The color buffer is RGBA8 with row 0 at the bottom, as glReadPixels returns it.
+class SoftwareRasterizer
+{
+public:
+	static const int kTileSize = 64;
+
+	// without a pool everything runs on the calling thread
+	SoftwareRasterizer(int width, int height, ThreadPool* pool = NULL);
+
+	void Clear(float red, float green, float blue, float alpha);
+	void Draw(const float* vertices, size_t vertex_count, const unsigned int* indices, size_t index_count,
+		const TextureSampler& texture1, const TextureSampler& texture2, const Matrix4& view_projection);
+
+	int Width() const { return width_; }
+	int Height() const { return height_; }
+	const unsigned char* Pixels() const { return color_.data(); }
+	// name of the instruction set the edge function loops run with on this CPU
+	static const char* SimdName();
+
+private:
+	// a vertex after the vertex stage, in clip space
+	struct ClipVertex
+	{
+		float position[4];
+		float uv[2];
+	};
+
+	// a triangle ready for rasterization: edge functions and attribute planes in screen space,
+	// where a plane gives value = dx * x + dy * y + c at pixel centers
+	struct TriangleSetup
+	{
+		float edge_a[3];
+		float edge_b[3];
+		float edge_c[3];
+		// whether pixel centers exactly on the edge belong to this triangle (top-left rule)
+		bool owns_edge[3];
+		float inv_w[3];
+		float u_over_w[3];
+		float v_over_w[3];
+		int min_x, min_y, max_x, max_y;
+	};
+
+	// triangles binned by one setup task, in submission order
+	struct SetupChunk
+	{
+		std::vector<TriangleSetup> triangles;
+		// per tile, indices into triangles
+		std::vector<std::vector<unsigned int> > bins;
+	};
+
+	void SetupTriangles(SetupChunk& chunk, const unsigned int* indices, size_t first_triangle, size_t end_triangle);
+	void AddTriangle(SetupChunk& chunk, const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2);
+	void RasterizeTile(size_t tile, const TextureSampler& texture1, const TextureSampler& texture2);
+	void RasterizeTriangle(const TriangleSetup& triangle, int tile_x, int tile_y,
+		const TextureSampler& texture1, const TextureSampler& texture2);
+	void ShadeSpan(const TriangleSetup& triangle, int x, int y, unsigned int mask,
+		const TextureSampler& texture1, const TextureSampler& texture2);
+	// tiles handed out in per-worker ranges, idle workers steal half of the largest range left
+	void RunTiles(const TextureSampler& texture1, const TextureSampler& texture2);
+
+	int width_;
+	int height_;
+	int tiles_x_;
+	int tiles_y_;
+	ThreadPool* pool_;
+	std::vector<unsigned char> color_;
+	std::vector<ClipVertex> clip_vertices_;
+	std::vector<SetupChunk> chunks_;
+	size_t chunk_count_;
+	// [begin, end) of the tiles each worker still owns, packed as begin | end << 32
+	std::vector<std::atomic<unsigned long long> > tile_ranges_;
+};
+
+#endif // !SOFTWARE_RASTERIZER_H
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "SoftwareRasterizerAvx2.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+unsigned int SoftwareRasterizerAvx2::CoverSpan(const float base[3], const float edge_a[3], const bool owns_edge[3])
+{
+	const __m256 kLanes = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+	const __m256 kZero = _mm256_setzero_ps();
+	__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+	for (int i = 0; i < 3; i++)
+	{
+		__m256 edge = _mm256_add_ps(_mm256_set1_ps(base[i]), _mm256_mul_ps(_mm256_set1_ps(edge_a[i]), kLanes));
+		inside = _mm256_and_ps(inside, owns_edge[i] ? _mm256_cmp_ps(edge, kZero, _CMP_GE_OQ) : _mm256_cmp_ps(edge, kZero, _CMP_GT_OQ));
+	}
+	return (unsigned int)_mm256_movemask_ps(inside);
+}
+
+void SoftwareRasterizerAvx2::InterpolateSpan(const float inv_w[3], const float u_over_w[3], const float v_over_w[3],
+	float column, float row, float* u, float* v, float* w)
+{
+	__m256 px = _mm256_add_ps(_mm256_set1_ps(column), _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f));
+	__m256 py = _mm256_set1_ps(row);
+	__m256 inv_w8 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(inv_w[0]), px),
+		_mm256_mul_ps(_mm256_set1_ps(inv_w[1]), py)), _mm256_set1_ps(inv_w[2]));
+	__m256 u_over_w8 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(u_over_w[0]), px),
+		_mm256_mul_ps(_mm256_set1_ps(u_over_w[1]), py)), _mm256_set1_ps(u_over_w[2]));
+	__m256 v_over_w8 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(v_over_w[0]), px),
+		_mm256_mul_ps(_mm256_set1_ps(v_over_w[1]), py)), _mm256_set1_ps(v_over_w[2]));
+	__m256 w8 = _mm256_div_ps(_mm256_set1_ps(1.0f), inv_w8);
+	_mm256_storeu_ps(w, w8);
+	_mm256_storeu_ps(u, _mm256_mul_ps(u_over_w8, w8));
+	_mm256_storeu_ps(v, _mm256_mul_ps(v_over_w8, w8));
+}
+
+void SoftwareRasterizerAvx2::StoreSpan(const SamplerColors& first, const SamplerColors& second, unsigned int mask, unsigned char* pixels)
+{
+	// mix, convert and pack all 8 pixels, then store the covered ones
+	const float* firsts[4] = { first.red, first.green, first.blue, first.alpha };
+	const float* seconds[4] = { second.red, second.green, second.blue, second.alpha };
+	const __m256 kHalf = _mm256_set1_ps(0.5f);
+	__m256i packed = _mm256_setzero_si256();
+	for (int c = 0; c < 4; c++)
+	{
+		__m256 mixed = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(firsts[c]), kHalf), _mm256_mul_ps(_mm256_loadu_ps(seconds[c]), kHalf));
+		mixed = _mm256_min_ps(_mm256_max_ps(mixed, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+		__m256i bytes = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(mixed, _mm256_set1_ps(255.0f)), kHalf));
+		packed = _mm256_or_si256(packed, _mm256_sllv_epi32(bytes, _mm256_set1_epi32(c * 8)));
+	}
+	const __m256i kLaneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	__m256i covered = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32((int)mask), kLaneBits), kLaneBits);
+	_mm256_maskstore_epi32((int*)pixels, covered, packed);
+}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#error SoftwareRasterizerAvx2.cpp must be compiled with /arch:AVX2
+#endif
\ No newline at end of file
@@ -0,0 +1,22 @@
+#ifndef SOFTWARE_RASTERIZER_AVX2_H
+#define SOFTWARE_RASTERIZER_AVX2_H
+
+#include "TextureSampler.h"
+
+// SoftwareRasterizer's AVX2 kernels for one span of 8 pixels. Only called when
+// CpuFeatures::HasAvx2() is true, see CpuFeatures.h
+class SoftwareRasterizerAvx2
+{
+public:
+	// bit i set if pixel i is inside all three edges, whose values at the first pixel are base
+	// and grow by edge_a per pixel. owns_edge keeps pixels exactly on the edge
+	static unsigned int CoverSpan(const float base[3], const float edge_a[3], const bool owns_edge[3]);
+	// perspective correct texture coords and w from the attribute planes (dx, dy, c), the first
+	// pixel at column, row
+	static void InterpolateSpan(const float inv_w[3], const float u_over_w[3], const float v_over_w[3],
+		float column, float row, float* u, float* v, float* w);
+	// mix(first, second, 0.5) as RGBA8 into the pixels whose bit is set in mask
+	static void StoreSpan(const SamplerColors& first, const SamplerColors& second, unsigned int mask, unsigned char* pixels);
+};
+
+#endif // !SOFTWARE_RASTERIZER_AVX2_H
\ No newline at end of file
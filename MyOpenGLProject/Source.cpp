@@ -1,29 +1,62 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "AssetPack.h"
+#include "BufferAllocator.h"
+#include "Camera.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
 #include "Shader.h"
+#include "ShaderCompiler.h"
+#include "TextureLoader.h"
+#include "VertexFormat.h"
+#include "Framebuffer.h"
+#include "GLState.h"
+#include "GoldenTest.h"
+#include "InstancedRenderer.h"
+#include "MeshBatcher.h"
+#include "MeshLoader.h"
+#include "MeshletBuilder.h"
+#include "MeshOptimizer.h"
+#include "Options.h"
+#include "PixelReadback.h"
+#include "Scenes.h"
+#include "Tools.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+void FillBatchDemo(MeshBatcher& batcher, GLState& state, int draw_count);
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
-int main(void)
+int main(int argc, char** argv)
 {
     GLFWwindow* window;
+    Options options = ParseOptions(argc, argv);
+
+    // command line tools run instead of the renderer, without a GL context
+    int tool_exit_code;
+    if (RunTool(options, tool_exit_code))
+        return tool_exit_code;
 
     /* Initialize the library */
     if (!glfwInit())
-        return -1;
+        return options.headless ? RenderHeadlessSoftware(options) : -1;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    // in headless mode the window only exists to own the context, it is never shown or swapped
+    if (options.headless)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
     /* Create a windowed mode window and its OpenGL context */
-    window = glfwCreateWindow(640, 480, "Hello World", NULL, NULL);
+    window = glfwCreateWindow(kWindowWidth, kWindowHeight, "Hello World", NULL, NULL);
     if (!window)
     {
         glfwTerminate();
-        return -1;
+        return options.headless ? RenderHeadlessSoftware(options) : -1;
     }
 
     /* Make the window's context current */
@@ -34,58 +67,47 @@ int main(void)
         std::cout << "Error!" << std::endl;
     std::cout << glGetString(GL_VERSION) << std::endl;
 
-    Shader my_shader("shader.vert", "shader.frag");
-    
-    // generate and bind texture object
-    unsigned int texture1, texture2;
-    
-    // texture 1
-    // ---------
-    glGenTextures(1, &texture1);
-    glBindTexture(GL_TEXTURE_2D, texture1);
-    // set the texture wrapping/filtering options (on the currently bounded texture object)
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // load and generate the texture
-    int width, height, nr_channels;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load("container.jpg", &width, &height, &nr_channels, 0);
-
-    if (data)
-    {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    }
-    else
-    {
-        std::cout << "Failed to load texture" << std::endl;
-    }
-    stbi_image_free(data);
+    // GPU timings are read back a few frames late, the profiler never waits for the GPU
+    Profiler* profiler = new Profiler();
+    // per-frame state changes go through the cache, which drops the ones that change nothing
+    GLState gl_state;
+    // draws are collected every frame and submitted sorted by program, textures and VAO
+    RenderQueue render_queue;
 
-    // texture 2
-    // ---------
-    glGenTextures(1, &texture2);
-    glBindTexture(GL_TEXTURE_2D, texture2);
-    // set the texture wrapping/filtering options (on the currently bounded texture object)
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    // load and generate the texture
-    data = stbi_load("container2.jpg", &width, &height, &nr_channels, 0);
+    // the asset pack is mapped once, shaders and textures are read straight out of the mapping
+    AssetPack asset_pack;
+    if (options.assets_path && !asset_pack.Open(options.assets_path))
+        std::cout << "Failed to open asset pack " << options.assets_path << ", using loose files" << std::endl;
 
-    if (data)
+    // the driver compiles the program while the textures below are being loaded
+    ShaderCompiler shader_compiler;
+    ShaderCompiler::Handle shader_handle = asset_pack.IsOpen()
+        ? shader_compiler.Submit(asset_pack, "shader.vert", "shader.frag")
+        : shader_compiler.Submit("shader.vert", "shader.frag");
+    ShaderCompiler::Handle sprite_shader_handle = 0;
+    if (options.sprite_count > 0)
+    {
+        sprite_shader_handle = asset_pack.IsOpen()
+            ? shader_compiler.Submit(asset_pack, "shader.vert", "instanced.frag")
+            : shader_compiler.Submit("shader.vert", "instanced.frag");
+    }
+    
+    // textures are decoded on worker threads and show a placeholder until they are uploaded
+    TextureLoader* texture_loader = new TextureLoader();
+    texture_loader->SetStateCache(&gl_state);
+    // compressed textures are lossy, they are only used when asked for
+    texture_loader->SetTextureCache(options.compressed_textures, options.cook_on_load);
+    unsigned int texture1, texture2;
+    if (asset_pack.IsOpen())
     {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        texture1 = texture_loader->Load(asset_pack, "container.jpg");
+        texture2 = texture_loader->Load(asset_pack, "container2.jpg");
     }
     else
     {
-        std::cout << "Failed to load texture" << std::endl;
+        texture1 = texture_loader->Load("container.jpg");
+        texture2 = texture_loader->Load("container2.jpg");
     }
-    stbi_image_free(data);
 
     // Rectangle
     float vertices[] = {
@@ -101,33 +123,71 @@ int main(void)
         1, 2, 3,
     };
 
-    unsigned int vao, vbo, ebo;
+    // 16 bytes per vertex on the GPU: half positions, RGBA8 colors, unorm16 texture coords
+    VertexFormat vertex_format;
+    vertex_format.Add(0, 3, kVertexHalf).Add(1, 3, kVertexUnorm8).Add(2, 2, kVertexUnorm16);
+    std::vector<unsigned char> packed_vertices = vertex_format.Pack(vertices, 4);
+
+    // vertex and index data of all meshes is carved out of a few large buffers
+    BufferAllocator* buffer_allocator = new BufferAllocator(1 << 20);
+    BufferAllocator::Handle vertex_handle = buffer_allocator->Allocate(gl_state, packed_vertices.size(), packed_vertices.data());
+    BufferAllocator::Handle index_handle = buffer_allocator->Allocate(gl_state, sizeof(indices), indices);
+    BufferAllocation vertex_allocation = buffer_allocator->Get(vertex_handle);
+    BufferAllocation index_allocation = buffer_allocator->Get(index_handle);
+    // the attributes point at the start of the page, the draw selects the mesh by base vertex.
+    // this and the VAOs below would have to be set up again after buffer_allocator->Defragment()
+    int base_vertex;
+    if (!buffer_allocator->BaseVertex(vertex_handle, vertex_format.Stride(), base_vertex))
+    {
+        glfwTerminate();
+        return -1;
+    }
+
+    // non-instanced draws read their instance attributes from this one-instance buffer
+    unsigned int identity_instance = InstancedRenderer::CreateIdentityInstance(gl_state);
+
+    unsigned int vao;
 
     // Vertex Array Object
     glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    gl_state.BindVertexArray(vao);
 
     // Vertex Buffer Object
-    glGenBuffers(1, &vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+    gl_state.BindBuffer(GL_ARRAY_BUFFER, vertex_allocation.buffer);
 
     // Element Buffer Object
-    glGenBuffers(1, &ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    gl_state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_allocation.buffer);
 
-    // position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    // position, color and texture attributes
+    vertex_format.Apply();
 
-    // color attribute
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    // instance attributes: no offset, unit scale, layer 0
+    InstancedRenderer::ApplyIdentityInstance(gl_state, identity_instance);
 
-    // texture attribute
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    // sprites: copies of the rectangle in a grid, each showing one layer of a texture array
+    InstancedRenderer* sprites = NULL;
+    unsigned int sprite_array = 0;
+    if (options.sprite_count > 0)
+    {
+        const char* kSpriteImages[] = { "container.jpg", "container2.jpg" };
+        sprite_array = InstancedRenderer::LoadTextureArray(gl_state, asset_pack.IsOpen() ? &asset_pack : NULL, kSpriteImages, 2, 256, 256);
+        sprites = new InstancedRenderer(gl_state, vertex_format, vertex_allocation.buffer, index_allocation.buffer,
+            sizeof(indices) / sizeof(indices[0]), index_allocation.offset, base_vertex, options.sprite_count);
+        int columns = 1;
+        while (columns * columns < options.sprite_count)
+            columns++;
+        float size = 2.0f / columns;
+        for (int i = 0; i < options.sprite_count; i++)
+        {
+            // the rectangle spans [-1, 1], scaling by less than half a cell leaves a gap
+            QuadInstance instance;
+            instance.offset_x = -1.0f + size * (i % columns + 0.5f);
+            instance.offset_y = -1.0f + size * (i / columns + 0.5f);
+            instance.scale_x = instance.scale_y = size * 0.4f;
+            instance.layer = (float)(i % 2);
+            sprites->Add(instance);
+        }
+    }
 
     /*
     Swizzling:
@@ -141,26 +201,223 @@ int main(void)
     vec4 otherResult = vec4(result.xyz, 1.0);
     */
 
+    Shader my_shader = shader_compiler.Get(shader_handle);
     my_shader.Use();
     my_shader.SetInt("texture1", 0);
     my_shader.SetInt("texture2", 1);
+    // the scene is authored in clip space, 3D content would use a Camera's ViewProjection() here
+    Matrix4 view_projection = Matrix4::Identity();
+    my_shader.SetMat4("viewProjection", view_projection.m);
+    // heterogeneous meshes merged into megabuffers, one indirect multi-draw per bucket
+    MeshBatcher* batcher = NULL;
+    if (options.batch_draws > 0)
+    {
+        batcher = new MeshBatcher(gl_state, vertex_format, 4096, 8192, options.batch_draws);
+        FillBatchDemo(*batcher, gl_state, options.batch_draws);
+        std::cout << "Mesh batcher: " << (batcher->IsMultiDrawSupported() ? "multi-draw indirect" : "CPU fallback") << std::endl;
+    }
 
-    /* Loop until the user closes the window */
-    while (!glfwWindowShouldClose(window))
+    // the mesh is read and decompressed on worker threads straight into mapped buffers
+    MeshLoader* mesh_loader = NULL;
+    MeshLoader::Handle mesh_handle = 0;
+    if (options.mesh_path)
     {
-        /* Render here */
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        mesh_loader = new MeshLoader(identity_instance);
+        mesh_handle = asset_pack.IsOpen()
+            ? mesh_loader->Load(asset_pack, options.mesh_path)
+            : mesh_loader->Load(options.mesh_path);
+    }
 
-        // bind texture
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture1);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, texture2);
+    // a sphere split into meshlets, in the container's vertex format and buffers. it reaches past
+    // the right edge of the screen, so both culling tests have meshlets to drop
+    unsigned int meshlet_vao = 0;
+    std::vector<Meshlet> meshlets;
+    std::vector<DrawElementsIndirectCommand> meshlet_commands;
+    unsigned int meshlet_first_index = 0;
+    int meshlet_base_vertex = 0;
+    if (options.meshlet_segments > 0)
+    {
+        const float kSphereCenter[3] = { 0.6f, 0.0f, 0.0f };
+        std::vector<float> sphere_vertices;
+        std::vector<unsigned int> sphere_indices;
+        BuildSphere(options.meshlet_segments, 0.7f, kSphereCenter, sphere_vertices, sphere_indices);
+        size_t sphere_vertex_count = sphere_vertices.size() / 8;
+        MeshOptimizer::OptimizeVertexCache(sphere_indices.data(), sphere_indices.size(), sphere_vertex_count);
+        MeshletBuilder::Build(sphere_indices.data(), sphere_indices.size(), sphere_vertices.data(), 8, sphere_vertex_count, meshlets);
+
+        std::vector<unsigned char> packed_sphere = vertex_format.Pack(sphere_vertices.data(), sphere_vertex_count);
+        BufferAllocator::Handle sphere_vertex_handle = buffer_allocator->Allocate(gl_state, packed_sphere.size(), packed_sphere.data());
+        BufferAllocator::Handle sphere_index_handle = buffer_allocator->Allocate(gl_state, sphere_indices.size() * sizeof(unsigned int), sphere_indices.data());
+        if (sphere_vertex_handle == BufferAllocator::kInvalidHandle || sphere_index_handle == BufferAllocator::kInvalidHandle)
+        {
+            std::cout << "Sphere with " << options.meshlet_segments << " segments does not fit in a buffer page" << std::endl;
+        }
+        else if (buffer_allocator->BaseVertex(sphere_vertex_handle, vertex_format.Stride(), meshlet_base_vertex))
+        {
+            // same setup as the container: attributes at the start of the page, base vertex per draw
+            BufferAllocation sphere_vertex_allocation = buffer_allocator->Get(sphere_vertex_handle);
+            BufferAllocation sphere_index_allocation = buffer_allocator->Get(sphere_index_handle);
+            meshlet_first_index = (unsigned int)(sphere_index_allocation.offset / sizeof(unsigned int));
+            glGenVertexArrays(1, &meshlet_vao);
+            gl_state.BindVertexArray(meshlet_vao);
+            gl_state.BindBuffer(GL_ARRAY_BUFFER, sphere_vertex_allocation.buffer);
+            gl_state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, sphere_index_allocation.buffer);
+            vertex_format.Apply();
+            InstancedRenderer::ApplyIdentityInstance(gl_state, identity_instance);
+            std::cout << "Meshlets: " << meshlets.size() << " for " << sphere_indices.size() / 3 << " triangles" << std::endl;
+        }
+    }
+
+    unsigned int sprite_program = 0;
+    if (sprites)
+    {
+        Shader sprite_shader = shader_compiler.Get(sprite_shader_handle);
+        sprite_shader.Use();
+        sprite_shader.SetInt("sprites", 0);
+        sprite_shader.SetMat4("viewProjection", view_projection.m);
+        sprite_program = sprite_shader.id_;
+    }
 
-        // render container
-        glBindVertexArray(vao);
-        glDrawElements(GL_TRIANGLES, sizeof(indices), GL_UNSIGNED_INT, 0);
+    // offscreen render target for headless mode
+    Framebuffer* offscreen = NULL;
+    if (options.headless)
+    {
+        offscreen = new Framebuffer(gl_state, kWindowWidth, kWindowHeight);
+        offscreen->Bind(gl_state);
+        // every frame should show the final textures, not the placeholders
+        texture_loader->Finish();
+        if (mesh_loader)
+            mesh_loader->Finish(gl_state);
+    }
+    // golden checks read the frames back through pixel pack buffers, a few frames behind
+    PixelReadback* readback = NULL;
+    std::vector<unsigned char> readback_pixels;
+    int readback_frame = -1;
+    if (options.headless && options.golden_path)
+        readback = new PixelReadback(gl_state, kWindowWidth, kWindowHeight);
+
+    int frame = 0;
+    int exit_code = 0;
+    double start_time = glfwGetTime();
+
+    /* Loop until the user closes the window (or all headless frames are rendered) */
+    while (options.headless ? frame < options.frame_count : !glfwWindowShouldClose(window))
+    {
+        profiler->BeginFrame();
+        {
+            PROFILE_SCOPE(*profiler, "texture upload");
+            // hand over whatever the texture workers finished since the last frame
+            texture_loader->Update();
+        }
+        if (mesh_loader)
+        {
+            PROFILE_SCOPE(*profiler, "mesh upload");
+            mesh_loader->Update(gl_state);
+        }
+
+        {
+            PROFILE_SCOPE(*profiler, "render");
+            PROFILE_GPU_SCOPE(*profiler, "render");
+
+            /* Render here */
+            gl_state.ClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            // render container
+            DrawItem container;
+            container.program = my_shader.id_;
+            container.vertex_array = vao;
+            container.textures[0] = texture1;
+            container.textures[1] = texture2;
+            container.texture_count = 2;
+            container.mode = GL_TRIANGLES;
+            container.index_count = sizeof(indices) / sizeof(indices[0]);
+            container.index_type = GL_UNSIGNED_INT;
+            container.index_offset = index_allocation.offset;
+            container.base_vertex = base_vertex;
+            RenderQueue::AssignKey(container, 0, 0.0f);
+
+            render_queue.Clear();
+            render_queue.Submit(container);
+
+            // the streamed mesh goes on top of the container once its buffers are filled
+            LoadedMesh mesh = mesh_loader ? mesh_loader->Get(mesh_handle) : LoadedMesh();
+            if (mesh_loader && mesh.ready)
+            {
+                DrawItem mesh_item = container;
+                mesh_item.vertex_array = mesh.vertex_array;
+                mesh_item.index_count = mesh.index_count;
+                mesh_item.index_type = mesh.index_type;
+                mesh_item.index_offset = 0;
+                mesh_item.base_vertex = 0;
+                RenderQueue::AssignKey(mesh_item, 1, 0.0f);
+                render_queue.Submit(mesh_item);
+            }
+            render_queue.Sort();
+            render_queue.Execute(gl_state);
+
+            // only the meshlets that survive culling are drawn, all of them with one call
+            if (meshlet_vao)
+            {
+                // the identity view-projection is an orthographic view down +z, so the viewer sits far
+                // away on -z and the frustum is the clip space cube
+                const float kViewer[3] = { 0.0f, 0.0f, -1000.0f };
+                float clip_planes[6][4];
+                Camera::ExtractFrustumPlanes(view_projection, clip_planes);
+                meshlet_commands.clear();
+                MeshletBuilder::Cull(meshlets, kViewer, clip_planes, meshlet_first_index, meshlet_base_vertex, meshlet_commands);
+                std::vector<GLsizei> counts(meshlet_commands.size());
+                std::vector<void*> offsets(meshlet_commands.size());
+                std::vector<GLint> base_vertices(meshlet_commands.size());
+                for (size_t c = 0; c < meshlet_commands.size(); c++)
+                {
+                    counts[c] = (GLsizei)meshlet_commands[c].count;
+                    offsets[c] = (void*)(meshlet_commands[c].first_index * sizeof(unsigned int));
+                    base_vertices[c] = meshlet_commands[c].base_vertex;
+                }
+                gl_state.UseProgram(my_shader.id_);
+                gl_state.BindTexture(0, GL_TEXTURE_2D, texture1);
+                gl_state.BindTexture(1, GL_TEXTURE_2D, texture2);
+                gl_state.BindVertexArray(meshlet_vao);
+                if (!meshlet_commands.empty())
+                    glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(), (GLsizei)counts.size(), base_vertices.data());
+            }
+
+            // bucket 0 and 1 use the container textures in opposite order
+            if (batcher)
+            {
+                unsigned int bucket_textures[2][2] = { { texture1, texture2 }, { texture2, texture1 } };
+                gl_state.UseProgram(my_shader.id_);
+                for (int b = 0; b < (int)batcher->BucketCount(); b++)
+                {
+                    gl_state.BindTexture(0, GL_TEXTURE_2D, bucket_textures[b][0]);
+                    gl_state.BindTexture(1, GL_TEXTURE_2D, bucket_textures[b][1]);
+                    batcher->Draw(gl_state, b);
+                }
+            }
+
+            // every sprite in one draw call
+            if (sprites)
+                sprites->Draw(gl_state, sprite_program, sprite_array);
+        }
+        profiler->EndFrame();
+
+        if (readback)
+        {
+            // collect whatever finished without waiting, only block when every slot is still in flight
+            while (readback->TryGet(gl_state, readback_pixels, readback_frame))
+                ;
+            if (!readback->Request(gl_state, frame))
+            {
+                readback->Get(gl_state, readback_pixels, readback_frame);
+                readback->Request(gl_state, frame);
+            }
+        }
+        frame++;
+
+        // nothing to present offscreen, skip the swap and the event processing
+        if (options.headless)
+            continue;
 
         /* Swap front and back buffers */
         // front buffer contains the final output image that is shown at the screen
@@ -172,14 +429,122 @@ int main(void)
         glfwPollEvents();
     }
 
+    if (options.headless)
+    {
+        // wait for the GPU so the timing covers the actual rendering, not just command submission
+        glFinish();
+        double elapsed_ms = (glfwGetTime() - start_time) * 1000.0;
+        double frame_ms = elapsed_ms / (frame > 0 ? frame : 1);
+        std::cout << "Rendered " << frame << " frames in " << elapsed_ms << " ms ("
+            << frame_ms << " ms/frame)" << std::endl;
+
+        if (readback)
+        {
+            while (readback->Get(gl_state, readback_pixels, readback_frame))
+                ;
+            GoldenTest golden(options.golden_path, options.update_golden, options.golden_machine);
+            // the GL frame has its own reference, recorded from a GL run: the driver's rasterization and
+            // filtering differ from the software rasterizer's. compressed textures differ from both
+            if (options.sprite_count > 0 || options.batch_draws > 0 || options.mesh_path || options.meshlet_segments > 0)
+                std::cout << "Golden image skipped, only the container scene has a reference" << std::endl;
+            else if (options.compressed_textures)
+                std::cout << "Golden image skipped, the reference is rendered with uncompressed textures" << std::endl;
+            else if (readback_frame >= 0)
+                golden.CheckImage("container.gl", readback_pixels.data(), kWindowWidth, kWindowHeight);
+            golden.CheckTiming("container.gl", frame_ms);
+            exit_code = golden.Finish() ? 0 : -1;
+            delete readback;
+        }
+        delete offscreen;
+    }
+
+    if (options.profile_path)
+    {
+        profiler->PrintSummary(std::cout);
+        gl_state.PrintCounters(std::cout);
+        buffer_allocator->PrintStats(std::cout);
+        if (profiler->WriteChromeTrace(options.profile_path))
+            std::cout << "Wrote trace " << options.profile_path << std::endl;
+        else
+            std::cout << "Failed to write trace " << options.profile_path << std::endl;
+    }
+
     // de-allocate all resources 
     glDeleteVertexArrays(1, &vao);
-    glDeleteBuffers(1, &vbo);
-    glDeleteBuffers(1, &ebo);
+    glDeleteVertexArrays(1, &meshlet_vao);
+    glDeleteTextures(1, &texture1);
+    glDeleteTextures(1, &texture2);
+    delete texture_loader;
+    delete sprites;
+    delete batcher;
+    delete mesh_loader;
+    delete buffer_allocator;
+    glDeleteBuffers(1, &identity_instance);
+    glDeleteTextures(1, &sprite_array);
+    delete profiler;
 
     // clear all previously allocated glfw sources
     glfwTerminate();
-    return 0;
+    return exit_code;
+}
+
+void FillBatchDemo(MeshBatcher& batcher, GLState& state, int draw_count)
+{
+    // three meshes of different sizes in the interleaved position/color/texcoord layout
+    const int kHexagonSides = 6;
+    float triangle_vertices[] = {
+        0.0f,  1.0f, 0.0f,   1.0f, 0.0f, 0.0f,   0.5f, 1.0f,
+       -1.0f, -1.0f, 0.0f,   0.0f, 1.0f, 0.0f,   0.0f, 0.0f,
+        1.0f, -1.0f, 0.0f,   0.0f, 0.0f, 1.0f,   1.0f, 0.0f
+    };
+    unsigned int triangle_indices[] = { 0, 1, 2 };
+    float quad_vertices[] = {
+        1.0f,  1.0f, 0.0f,   1.0f, 0.0f, 0.0f,   1.0f, 1.0f,
+        1.0f, -1.0f, 0.0f,   0.0f, 1.0f, 0.0f,   1.0f, 0.0f,
+       -1.0f, -1.0f, 0.0f,   0.0f, 0.0f, 1.0f,   0.0f, 0.0f,
+       -1.0f,  1.0f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f
+    };
+    unsigned int quad_indices[] = { 0, 1, 3, 1, 2, 3 };
+    float hexagon_vertices[(kHexagonSides + 1) * 8];
+    unsigned int hexagon_indices[kHexagonSides * 3];
+    for (int v = 0; v <= kHexagonSides; v++)
+    {
+        // vertex 0 is the center, the others go around it
+        float angle = (v - 1) * 6.2831853f / kHexagonSides;
+        float x = v == 0 ? 0.0f : std::cos(angle);
+        float y = v == 0 ? 0.0f : std::sin(angle);
+        float vertex[8] = { x, y, 0.0f,   1.0f, 1.0f, 1.0f,   x * 0.5f + 0.5f, y * 0.5f + 0.5f };
+        std::memcpy(&hexagon_vertices[v * 8], vertex, sizeof(vertex));
+    }
+    for (int t = 0; t < kHexagonSides; t++)
+    {
+        hexagon_indices[t * 3] = 0;
+        hexagon_indices[t * 3 + 1] = 1 + t;
+        hexagon_indices[t * 3 + 2] = 1 + (t + 1) % kHexagonSides;
+    }
+    int meshes[3] = {
+        batcher.AddMesh(state, triangle_vertices, 3, triangle_indices, 3),
+        batcher.AddMesh(state, quad_vertices, 4, quad_indices, 6),
+        batcher.AddMesh(state, hexagon_vertices, kHexagonSides + 1, hexagon_indices, kHexagonSides * 3)
+    };
+
+    // a grid of draws cycling through the meshes, alternating between the two buckets
+    int columns = 1;
+    while (columns * columns < draw_count)
+        columns++;
+    float size = 2.0f / columns;
+    batcher.Clear();
+    for (int i = 0; i < draw_count; i++)
+    {
+        QuadInstance instance;
+        instance.offset_x = -1.0f + size * (i % columns + 0.5f);
+        instance.offset_y = -1.0f + size * (i / columns + 0.5f);
+        instance.scale_x = instance.scale_y = size * 0.4f;
+        instance.layer = 0.0f;
+        batcher.AddDraw(i % 2, meshes[i % 3], instance);
+    }
+    // the scene doesn't move, one upload serves every frame
+    batcher.Upload(state);
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
@@ -0,0 +1,94 @@
+#include "StreamBuffer.h"
+
+#include <iostream>
+
+StreamBuffer::StreamBuffer(GLState& state, GLenum target, size_t region_size, int region_count)
+	: target_(target), region_size_(region_size), region_(0), head_(0), mapped_(NULL), staging_offset_(0), stalls_(0)
+{
+	fences_.resize(region_count, (GLsync)0);
+	glGenBuffers(1, &buffer_);
+	state.BindBuffer(target_, buffer_);
+	if (GLEW_ARB_buffer_storage)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(target_, region_size_ * region_count, NULL, flags);
+		mapped_ = (unsigned char*)glMapBufferRange(target_, 0, region_size_ * region_count, flags);
+		if (!mapped_)
+			std::cout << "ERROR::STREAM_BUFFER::PERSISTENT_MAP_FAILED" << std::endl;
+	}
+	if (!mapped_)
+	{
+		// one region is enough when every upload gets new storage
+		fences_.resize(1);
+		glBufferData(target_, region_size_, NULL, GL_STREAM_DRAW);
+	}
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	for (size_t i = 0; i < fences_.size(); i++)
+	{
+		if (fences_[i])
+			glDeleteSync(fences_[i]);
+	}
+	// deleting the buffer also unmaps it
+	glDeleteBuffers(1, &buffer_);
+}
+
+void* StreamBuffer::Map(size_t size, size_t alignment, size_t& offset)
+{
+	if (!mapped_)
+	{
+		// orphaning gives every upload a fresh buffer, so it can always start at 0
+		if (size > region_size_)
+			return NULL;
+		staging_.resize(size);
+		staging_offset_ = offset = 0;
+		return staging_.data();
+	}
+
+	size_t start = (head_ + alignment - 1) / alignment * alignment;
+	if (start + size > region_size_)
+		return NULL;
+	head_ = start + size;
+	offset = region_ * region_size_ + start;
+	return mapped_ + offset;
+}
+
+void StreamBuffer::Unmap(GLState& state)
+{
+	// coherent persistent mappings need no flush
+	if (mapped_ || staging_.empty())
+		return;
+	state.BindBuffer(target_, buffer_);
+	glBufferData(target_, region_size_, NULL, GL_STREAM_DRAW);
+	glBufferSubData(target_, staging_offset_, staging_.size(), staging_.data());
+	staging_.clear();
+}
+
+void StreamBuffer::EndFrame()
+{
+	if (!mapped_)
+		return;
+	if (fences_[region_])
+		glDeleteSync(fences_[region_]);
+	fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	region_ = (region_ + 1) % fences_.size();
+	head_ = 0;
+	GLsync fence = fences_[region_];
+	if (!fence)
+		return;
+	// the GPU is normally frames ahead of this point, only wait when it isn't
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+	{
+		stalls_++;
+		do
+		{
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		} while (status == GL_TIMEOUT_EXPIRED);
+	}
+	glDeleteSync(fence);
+	fences_[region_] = 0;
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <GL/glew.h> // include glew to get all the required OpenGL headers
+
+#include <vector>
+#include "GLState.h"
+
+// Ring of buffer regions for data written by the CPU every frame. With ARB_buffer_storage
+// the buffer is mapped once, persistently and coherently, and the CPU writes straight into
+// the region of the current frame while the GPU still reads the regions of earlier frames.
+// A fence per region keeps the CPU from overwriting a region before the GPU is done with it.
+// Older contexts get a staging copy that is uploaded into freshly orphaned storage instead.
+class StreamBuffer
+{
+public:
+	StreamBuffer(GLState& state, GLenum target, size_t region_size, int region_count = 3);
+	~StreamBuffer();
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+	// reserve size bytes in the current region and return where to write them, NULL if the
+	// region is full. offset receives the position inside the buffer object to draw from
+	void* Map(size_t size, size_t alignment, size_t& offset);
+	// make the bytes of the last Map visible to the GPU, draw from them before the next Map
+	void Unmap(GLState& state);
+	// fence the current region and move on to the next one, waiting for it if the GPU still reads it
+	void EndFrame();
+
+	unsigned int Buffer() const { return buffer_; }
+	bool IsPersistent() const { return mapped_ != NULL; }
+	// frames that had to wait for the GPU to release their region
+	size_t StallCount() const { return stalls_; }
+
+private:
+	GLenum target_;
+	unsigned int buffer_;
+	size_t region_size_;
+	std::vector<GLsync> fences_;
+	size_t region_;
+	// write position inside the current region
+	size_t head_;
+	unsigned char* mapped_;
+	// orphaning fallback: bytes of the last Map and where they go
+	std::vector<unsigned char> staging_;
+	size_t staging_offset_;
+	size_t stalls_;
+};
+
+#endif // !STREAM_BUFFER_H
\ No newline at end of file
@@ -0,0 +1,419 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "MipChain.h"
+#include "stb_image.h"
+
+// KTX2 constants, see the Khronos KTX 2.0 and Data Format specifications
+static const unsigned char kKtx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const unsigned int kVkFormatBc1RgbUnorm = 131;
+static const unsigned int kVkFormatBc1RgbSrgb = 132;
+static const unsigned int kVkFormatBc3Unorm = 137;
+static const unsigned int kVkFormatBc3Srgb = 138;
+static const unsigned int kDfModelBc1a = 128;
+static const unsigned int kDfModelBc3 = 130;
+static const unsigned int kDfChannelColor = 0;
+static const unsigned int kDfChannelAlpha = 15;
+static const unsigned int kDfPrimariesBt709 = 1;
+static const unsigned int kDfTransferLinear = 1;
+static const unsigned int kDfTransferSrgb = 2;
+// standard orientation key: "ru" means rows go up (flipped for OpenGL), "rd" rows go down
+static const char kOrientationKey[] = "KTXorientation";
+
+struct Ktx2Header
+{
+	unsigned char identifier[12];
+	unsigned int vk_format;
+	unsigned int type_size;
+	unsigned int pixel_width;
+	unsigned int pixel_height;
+	unsigned int pixel_depth;
+	unsigned int layer_count;
+	unsigned int face_count;
+	unsigned int level_count;
+	unsigned int supercompression_scheme;
+	unsigned int dfd_byte_offset;
+	unsigned int dfd_byte_length;
+	unsigned int kvd_byte_offset;
+	unsigned int kvd_byte_length;
+	unsigned long long sgd_byte_offset;
+	unsigned long long sgd_byte_length;
+};
+
+struct Ktx2LevelIndex
+{
+	unsigned long long byte_offset;
+	unsigned long long byte_length;
+	unsigned long long uncompressed_byte_length;
+};
+
+static size_t AlignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+static unsigned short PackRgb565(int r, int g, int b)
+{
+	return (unsigned short)(((r * 31 + 127) / 255) << 11 | ((g * 63 + 127) / 255) << 5 | ((b * 31 + 127) / 255));
+}
+
+static void UnpackRgb565(unsigned short c, int rgb[3])
+{
+	int r = c >> 11, g = (c >> 5) & 63, b = c & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+// BC1 color block: inset bounding box endpoints, 4-color mode, nearest palette entry per texel
+static void EncodeColorBlock(const unsigned char block[16][4], unsigned char out[8])
+{
+	int lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			lo[c] = std::min(lo[c], (int)block[i][c]);
+			hi[c] = std::max(hi[c], (int)block[i][c]);
+		}
+	}
+	// pull the endpoints in by 1/16 of the range, the box corners are rarely hit exactly
+	for (int c = 0; c < 3; c++)
+	{
+		int inset = (hi[c] - lo[c]) >> 4;
+		lo[c] += inset;
+		hi[c] -= inset;
+	}
+
+	unsigned short color0 = PackRgb565(hi[0], hi[1], hi[2]);
+	unsigned short color1 = PackRgb565(lo[0], lo[1], lo[2]);
+	unsigned int indices = 0;
+	if (color0 < color1)
+		std::swap(color0, color1);
+	if (color0 != color1)
+	{
+		int palette[4][3];
+		UnpackRgb565(color0, palette[0]);
+		UnpackRgb565(color1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0, best_error = 1 << 30;
+			for (int p = 0; p < 4; p++)
+			{
+				int dr = block[i][0] - palette[p][0], dg = block[i][1] - palette[p][1], db = block[i][2] - palette[p][2];
+				int error = dr * dr + dg * dg + db * db;
+				if (error < best_error)
+				{
+					best_error = error;
+					best = p;
+				}
+			}
+			indices |= (unsigned int)best << (2 * i);
+		}
+	}
+
+	out[0] = (unsigned char)(color0 & 0xFF);
+	out[1] = (unsigned char)(color0 >> 8);
+	out[2] = (unsigned char)(color1 & 0xFF);
+	out[3] = (unsigned char)(color1 >> 8);
+	for (int i = 0; i < 4; i++)
+		out[4 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+// BC3 alpha block: min/max endpoints in 8-value mode, 3-bit indices
+static void EncodeAlphaBlock(const unsigned char block[16][4], unsigned char out[8])
+{
+	int lo = 255, hi = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		lo = std::min(lo, (int)block[i][3]);
+		hi = std::max(hi, (int)block[i][3]);
+	}
+	out[0] = (unsigned char)hi;
+	out[1] = (unsigned char)lo;
+
+	unsigned long long indices = 0;
+	if (hi != lo)
+	{
+		int palette[8];
+		palette[0] = hi;
+		palette[1] = lo;
+		for (int p = 1; p < 7; p++)
+			palette[p + 1] = ((7 - p) * hi + p * lo) / 7;
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0, best_error = 1 << 30;
+			for (int p = 0; p < 8; p++)
+			{
+				int error = std::abs(block[i][3] - palette[p]);
+				if (error < best_error)
+				{
+					best_error = error;
+					best = p;
+				}
+			}
+			indices |= (unsigned long long)best << (3 * i);
+		}
+	}
+	for (int i = 0; i < 6; i++)
+		out[2 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+std::string TextureCache::CachePath(const char* source_path)
+{
+	return std::string(source_path) + ".ktx2";
+}
+
+bool TextureCache::IsFresh(const char* source_path)
+{
+	struct stat source_info, cache_info;
+	if (stat(CachePath(source_path).c_str(), &cache_info) != 0)
+		return false;
+	// a cache without its source (e.g. shipped alone) is always usable
+	if (stat(source_path, &source_info) != 0)
+		return true;
+	return cache_info.st_mtime >= source_info.st_mtime;
+}
+
+void TextureCache::Cook(const unsigned char* pixels, int width, int height, int channels, bool flipped, CompressedImage& image)
+{
+	bool has_alpha = channels == 2 || channels == 4;
+	size_t block_size = has_alpha ? 16 : 8;
+	image.gl_format = has_alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	// the color is sRGB encoded (the mips are filtered that way too), readers must decode it as such.
+	// GL still gets the non-sRGB formats, like the uncompressed uploads
+	image.vk_format = has_alpha ? kVkFormatBc3Srgb : kVkFormatBc1RgbSrgb;
+	image.flipped = flipped;
+	image.levels.clear();
+	image.data.clear();
+
+	// expand to RGBA once so every level works on the same layout
+	std::vector<unsigned char> level((size_t)width * height * 4);
+	for (size_t i = 0; i < (size_t)width * height; i++)
+	{
+		const unsigned char* p = pixels + i * channels;
+		unsigned char* q = &level[i * 4];
+		q[0] = p[0];
+		q[1] = channels >= 3 ? p[1] : p[0];
+		q[2] = channels >= 3 ? p[2] : p[0];
+		q[3] = channels == 4 ? p[3] : (channels == 2 ? p[1] : 255);
+	}
+
+	// gamma-correct box filtered chain, level 0 is the source itself
+	std::vector<MipLevel> mips;
+	MipChain::Build(level.data(), width, height, kMipFilterBox, true, mips);
+
+	for (size_t l = 0; l <= mips.size(); l++)
+	{
+		const unsigned char* rgba = l == 0 ? level.data() : mips[l - 1].pixels.data();
+		int level_width = l == 0 ? width : mips[l - 1].width;
+		int level_height = l == 0 ? height : mips[l - 1].height;
+		int blocks_x = (level_width + 3) / 4, blocks_y = (level_height + 3) / 4;
+		CompressedLevel info = { level_width, level_height, image.data.size(), blocks_x * blocks_y * block_size };
+		image.data.resize(info.offset + info.size);
+		unsigned char* out = &image.data[info.offset];
+
+		for (int by = 0; by < blocks_y; by++)
+		{
+			for (int bx = 0; bx < blocks_x; bx++)
+			{
+				// gather the 4x4 block, clamping at the right/top edges
+				unsigned char block[16][4];
+				for (int i = 0; i < 16; i++)
+				{
+					int x = std::min(bx * 4 + (i & 3), level_width - 1);
+					int y = std::min(by * 4 + (i >> 2), level_height - 1);
+					std::memcpy(block[i], &rgba[((size_t)y * level_width + x) * 4], 4);
+				}
+				if (has_alpha)
+				{
+					EncodeAlphaBlock(block, out);
+					out += 8;
+				}
+				EncodeColorBlock(block, out);
+				out += 8;
+			}
+		}
+		image.levels.push_back(info);
+	}
+}
+
+bool TextureCache::CookFile(const char* source_path, bool flip_vertically)
+{
+	int width, height, channels;
+	stbi_set_flip_vertically_on_load_thread(flip_vertically);
+	unsigned char* pixels = stbi_load(source_path, &width, &height, &channels, 0);
+	if (!pixels)
+		return false;
+	CompressedImage image;
+	Cook(pixels, width, height, channels, flip_vertically, image);
+	stbi_image_free(pixels);
+	return Write(CachePath(source_path).c_str(), image);
+}
+
+static bool IsBc3(unsigned int vk_format)
+{
+	return vk_format == kVkFormatBc3Unorm || vk_format == kVkFormatBc3Srgb;
+}
+
+static bool IsSrgb(unsigned int vk_format)
+{
+	return vk_format == kVkFormatBc1RgbSrgb || vk_format == kVkFormatBc3Srgb;
+}
+
+bool TextureCache::Write(const char* path, const CompressedImage& image)
+{
+	bool bc3 = IsBc3(image.vk_format);
+	size_t block_size = bc3 ? 16 : 8;
+	unsigned int level_count = (unsigned int)image.levels.size();
+
+	// data format descriptor: one basic block with one sample per compressed channel
+	unsigned int sample_count = bc3 ? 2 : 1;
+	std::vector<unsigned int> dfd;
+	dfd.push_back(4 + 24 + 16 * sample_count);                  // dfdTotalSize
+	dfd.push_back(0);                                           // vendorId, descriptorType
+	dfd.push_back(2 | (24 + 16 * sample_count) << 16);          // versionNumber, descriptorBlockSize
+	unsigned int transfer = IsSrgb(image.vk_format) ? kDfTransferSrgb : kDfTransferLinear;
+	dfd.push_back((bc3 ? kDfModelBc3 : kDfModelBc1a) | kDfPrimariesBt709 << 8 | transfer << 16);
+	dfd.push_back(3 | 3 << 8);                                  // texelBlockDimension 4x4
+	dfd.push_back((unsigned int)block_size);                    // bytesPlane0
+	dfd.push_back(0);
+	for (unsigned int s = 0; s < sample_count; s++)
+	{
+		unsigned int channel = (bc3 && s == 0) ? kDfChannelAlpha : kDfChannelColor;
+		dfd.push_back((s * 64) | 63 << 16 | channel << 24);      // bitOffset, bitLength - 1, channelType
+		dfd.push_back(0);                                       // samplePosition
+		dfd.push_back(0);                                       // sampleLower
+		dfd.push_back(0xFFFFFFFF);                              // sampleUpper
+	}
+
+	// key/value data: orientation only
+	std::string orientation = image.flipped ? "ru" : "rd";
+	unsigned int kv_length = (unsigned int)(sizeof(kOrientationKey) + orientation.size() + 1);
+	std::vector<unsigned char> kvd(AlignUp(4 + kv_length, 4), 0);
+	std::memcpy(&kvd[0], &kv_length, 4);
+	std::memcpy(&kvd[4], kOrientationKey, sizeof(kOrientationKey));
+	std::memcpy(&kvd[4 + sizeof(kOrientationKey)], orientation.c_str(), orientation.size() + 1);
+
+	Ktx2Header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.identifier, kKtx2Identifier, sizeof(kKtx2Identifier));
+	header.vk_format = image.vk_format;
+	header.type_size = 1;
+	header.pixel_width = image.levels[0].width;
+	header.pixel_height = image.levels[0].height;
+	header.face_count = 1;
+	header.level_count = level_count;
+	header.dfd_byte_offset = (unsigned int)(sizeof(Ktx2Header) + level_count * sizeof(Ktx2LevelIndex));
+	header.dfd_byte_length = (unsigned int)(dfd.size() * 4);
+	header.kvd_byte_offset = header.dfd_byte_offset + header.dfd_byte_length;
+	header.kvd_byte_length = (unsigned int)kvd.size();
+
+	// the spec stores level data from the smallest mip to the largest
+	std::vector<Ktx2LevelIndex> level_index(level_count);
+	size_t offset = header.kvd_byte_offset + header.kvd_byte_length;
+	for (unsigned int l = level_count; l-- > 0;)
+	{
+		offset = AlignUp(offset, block_size);
+		level_index[l].byte_offset = offset;
+		level_index[l].byte_length = image.levels[l].size;
+		level_index[l].uncompressed_byte_length = image.levels[l].size;
+		offset += image.levels[l].size;
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)level_index.data(), level_count * sizeof(Ktx2LevelIndex));
+	file.write((const char*)dfd.data(), dfd.size() * 4);
+	file.write((const char*)kvd.data(), kvd.size());
+	size_t written = header.kvd_byte_offset + header.kvd_byte_length;
+	for (unsigned int l = level_count; l-- > 0;)
+	{
+		static const char kPadding[16] = { 0 };
+		file.write(kPadding, level_index[l].byte_offset - written);
+		file.write((const char*)&image.data[image.levels[l].offset], image.levels[l].size);
+		written = level_index[l].byte_offset + level_index[l].byte_length;
+	}
+	return file.good();
+}
+
+bool TextureCache::Read(const char* path, CompressedImage& image)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+	std::vector<unsigned char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return Read(contents.data(), contents.size(), image);
+}
+
+bool TextureCache::IsKtx2(const unsigned char* contents, size_t size)
+{
+	return size >= sizeof(kKtx2Identifier) && std::memcmp(contents, kKtx2Identifier, sizeof(kKtx2Identifier)) == 0;
+}
+
+bool TextureCache::Read(const unsigned char* contents, size_t size, CompressedImage& image)
+{
+	Ktx2Header header;
+	if (size < sizeof(header))
+		return false;
+	std::memcpy(&header, contents, sizeof(header));
+	if (std::memcmp(header.identifier, kKtx2Identifier, sizeof(kKtx2Identifier)) != 0
+		|| (header.vk_format != kVkFormatBc1RgbUnorm && header.vk_format != kVkFormatBc1RgbSrgb
+			&& !IsBc3(header.vk_format))
+		|| header.supercompression_scheme != 0 || header.level_count == 0 || header.level_count > 32
+		|| header.pixel_depth != 0 || header.layer_count > 1 || header.face_count != 1)
+		return false;
+	size_t level_index_end = sizeof(header) + header.level_count * sizeof(Ktx2LevelIndex);
+	if (size < level_index_end || (size_t)header.kvd_byte_offset + header.kvd_byte_length > size)
+		return false;
+
+	bool bc3 = IsBc3(header.vk_format);
+	image.gl_format = bc3 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	image.vk_format = header.vk_format;
+
+	// files without an orientation key use the KTX default, rows going down
+	image.flipped = false;
+	size_t kv = header.kvd_byte_offset, kvd_end = (size_t)header.kvd_byte_offset + header.kvd_byte_length;
+	while (kv + 4 <= kvd_end)
+	{
+		unsigned int kv_length;
+		std::memcpy(&kv_length, &contents[kv], 4);
+		if (kv + 4 + kv_length > kvd_end)
+			break;
+		const char* key = (const char*)&contents[kv + 4];
+		size_t key_length = strnlen(key, kv_length);
+		if (key_length + 3 <= kv_length && std::strcmp(key, kOrientationKey) == 0)
+			image.flipped = std::strncmp(key + key_length + 1, "ru", 2) == 0;
+		kv = AlignUp(kv + 4 + kv_length, 4);
+	}
+
+	image.levels.resize(header.level_count);
+	image.data.clear();
+	size_t block_size = bc3 ? 16 : 8;
+	for (unsigned int l = 0; l < header.level_count; l++)
+	{
+		Ktx2LevelIndex index;
+		std::memcpy(&index, &contents[sizeof(header) + l * sizeof(Ktx2LevelIndex)], sizeof(index));
+		CompressedLevel& level = image.levels[l];
+		level.width = std::max(1u, header.pixel_width >> l);
+		level.height = std::max(1u, header.pixel_height >> l);
+		level.offset = image.data.size();
+		level.size = (size_t)((level.width + 3) / 4) * ((level.height + 3) / 4) * block_size;
+		if (index.byte_length != level.size || index.byte_offset + index.byte_length > size)
+			return false;
+		image.data.insert(image.data.end(), contents + index.byte_offset, contents + index.byte_offset + index.byte_length);
+	}
+	return true;
+}
@@ -0,0 +1,50 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <GL/glew.h> // include glew to get all the required OpenGL headers
+
+#include <string>
+#include <vector>
+
+// one mip level inside CompressedImage::data
+struct CompressedLevel
+{
+	int width;
+	int height;
+	size_t offset;
+	size_t size;
+};
+
+// block-compressed texture with its full mip chain, level 0 is the largest
+struct CompressedImage
+{
+	GLenum gl_format;
+	unsigned int vk_format;
+	bool flipped;
+	std::vector<CompressedLevel> levels;
+	std::vector<unsigned char> data;
+};
+
+// Cooks source images into BC1 (RGB) / BC3 (RGBA) with a precomputed mip chain and keeps
+// them in a KTX2 file next to the source ("container.jpg" -> "container.jpg.ktx2"),
+// so later runs can skip image decoding and upload straight with glCompressedTexImage2D.
+class TextureCache
+{
+public:
+	static std::string CachePath(const char* source_path);
+	// true if the cache file exists and is not older than the source image
+	static bool IsFresh(const char* source_path);
+
+	// compress 8-bit pixels (1-4 channels) and build all mip levels
+	static void Cook(const unsigned char* pixels, int width, int height, int channels, bool flipped, CompressedImage& image);
+	// decode the source with stb_image, cook it and write the cache file
+	static bool CookFile(const char* source_path, bool flip_vertically);
+
+	static bool Write(const char* path, const CompressedImage& image);
+	static bool Read(const char* path, CompressedImage& image);
+	static bool Read(const unsigned char* contents, size_t size, CompressedImage& image);
+	// true if the data starts with the KTX2 identifier
+	static bool IsKtx2(const unsigned char* contents, size_t size);
+};
+
+#endif // !TEXTURE_CACHE_H
@@ -0,0 +1,330 @@
+#include "TextureLoader.h"
+
+#include <cstring>
+#include <iostream>
+#include "ImageDecoder.h"
+#include "UploadConverter.h"
+#include "stb_image.h"
+
+// room for this many decoded images in flight between the workers and the GL thread
+static const size_t kDecodedQueueCapacity = 256;
+
+TextureLoader::TextureLoader(unsigned int worker_count, int pbo_count)
+	: workers_(worker_count), decoded_(kDecodedQueueCapacity), next_upload_(0), stalled_(NULL), pending_(0),
+	use_texture_cache_(false), cook_missing_(false), stopping_(false), state_(NULL)
+{
+	upload_ring_.resize(pbo_count);
+	for (size_t i = 0; i < upload_ring_.size(); i++)
+	{
+		glGenBuffers(1, &upload_ring_[i].pbo);
+		upload_ring_[i].size = 0;
+		upload_ring_[i].fence = 0;
+	}
+}
+
+TextureLoader::~TextureLoader()
+{
+	// nothing drains the queue any more: workers drop what they decode instead of waiting for
+	// room, then they are waited for before releasing whatever they produced
+	stopping_ = true;
+	workers_.WaitIdle();
+	DecodedImage* image = stalled_;
+	while (image || decoded_.TryPop(image))
+	{
+		delete image;
+		image = NULL;
+	}
+	for (size_t i = 0; i < upload_ring_.size(); i++)
+	{
+		if (upload_ring_[i].fence)
+			glDeleteSync(upload_ring_[i].fence);
+		glDeleteBuffers(1, &upload_ring_[i].pbo);
+	}
+}
+
+void TextureLoader::SetTextureCache(bool use_cache, bool cook_missing)
+{
+	if (use_cache && !GLEW_EXT_texture_compression_s3tc)
+		std::cout << "ERROR::TEXTURE_LOADER::NO_S3TC, uploading the textures uncompressed" << std::endl;
+	use_texture_cache_ = use_cache && GLEW_EXT_texture_compression_s3tc;
+	cook_missing_ = use_texture_cache_ && cook_missing;
+}
+
+unsigned int TextureLoader::Load(const char* path, bool flip_vertically)
+{
+	AssetSpan from_disk = { NULL, 0 };
+	return Submit(path, from_disk, flip_vertically);
+}
+
+unsigned int TextureLoader::Load(const AssetPack& pack, const char* name, bool flip_vertically)
+{
+	AssetSpan source = { NULL, 0 };
+	if (use_texture_cache_)
+		source = pack.Find(TextureCache::CachePath(name).c_str());
+	if (source.IsEmpty())
+		source = pack.Find(name);
+	if (source.IsEmpty())
+		std::cout << "ERROR::TEXTURE_LOADER::NOT_IN_ASSET_PACK " << name << std::endl;
+	return Submit(name, source, flip_vertically);
+}
+
+unsigned int TextureLoader::Submit(const char* path, AssetSpan source, bool flip_vertically)
+{
+	// 2x2 checkerboard shown until the real image is uploaded
+	static const unsigned char kPlaceholder[] = {
+		255, 0, 255, 255,   0, 0, 0, 255,
+		0, 0, 0, 255,   255, 0, 255, 255
+	};
+
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	BindTexture(texture);
+	SetDefaultParameters();
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 2, 0, GL_RGBA, GL_UNSIGNED_BYTE, kPlaceholder);
+
+	DecodedImage* image = new DecodedImage();
+	image->texture = texture;
+	image->path = path;
+	image->source = source;
+	image->width = image->height = 0;
+	image->is_compressed = false;
+	pending_++;
+	workers_.Enqueue([this, image, flip_vertically] { Decode(image, flip_vertically); });
+	return texture;
+}
+
+void TextureLoader::Decode(DecodedImage* image, bool flip_vertically)
+{
+	if (!stopping_)
+	{
+		if (image->source.size > 0)
+			DecodeSpan(image, flip_vertically);
+		else
+			DecodeFile(image, flip_vertically);
+	}
+	// the GL thread drains the queue every frame, so a full queue only means waiting a little
+	while (!decoded_.TryPush(image))
+	{
+		if (stopping_)
+		{
+			delete image;
+			return;
+		}
+		std::this_thread::yield();
+	}
+}
+
+void TextureLoader::DecodeFile(DecodedImage* image, bool flip_vertically)
+{
+	// a fresh cache file with the right orientation needs no decoding at all
+	const char* path = image->path.c_str();
+	if (use_texture_cache_ && TextureCache::IsFresh(path)
+		&& TextureCache::Read(TextureCache::CachePath(path).c_str(), image->compressed)
+		&& image->compressed.flipped == flip_vertically)
+	{
+		image->is_compressed = true;
+	}
+	else
+	{
+		// baseline JPEGs are split over the other workers, everything else goes to stb_image.
+		// uncompressed images are flipped while they are converted for upload
+		int channels;
+		unsigned char* data = ImageDecoder::LoadFile(path, image->width, image->height, channels, 0,
+			cook_missing_ && flip_vertically, &workers_);
+		if (!data)
+			return;
+		if (cook_missing_)
+		{
+			// no fresh cache yet: cook the image so the next start can skip the decode
+			TextureCache::Cook(data, image->width, image->height, channels, flip_vertically, image->compressed);
+			if (!TextureCache::Write(TextureCache::CachePath(path).c_str(), image->compressed))
+				std::cout << "ERROR::TEXTURE_LOADER::CACHE_NOT_WRITABLE " << path << std::endl;
+			image->is_compressed = true;
+		}
+		else
+		{
+			BuildMips(image, data, channels, flip_vertically);
+		}
+		stbi_image_free(data);
+	}
+}
+
+void TextureLoader::BuildMips(DecodedImage* image, const unsigned char* pixels, int channels, bool flip_vertically)
+{
+	// this runs on a worker already, the other workers help out with the rows. one pass expands
+	// the decoded pixels to the BGRA texels the driver copies as they are and flips them for GL;
+	// the box filter treats BGRA like RGBA
+	image->pixels.resize((size_t)image->width * image->height * 4);
+	UploadConverter::Convert(pixels, image->width, image->height, channels, image->pixels.data(), kUploadBGRA,
+		kUploadStraightAlpha, flip_vertically, &workers_);
+	MipChain::Build(image->pixels.data(), image->width, image->height, kMipFilterBox, true, image->mips, &workers_);
+}
+
+void TextureLoader::DecodeSpan(DecodedImage* image, bool flip_vertically)
+{
+	const AssetSpan& source = image->source;
+	if (TextureCache::IsKtx2(source.data, source.size))
+	{
+		// the pack is read only, a cooked image with the wrong orientation can't be used
+		image->is_compressed = TextureCache::Read(source.data, source.size, image->compressed)
+			&& image->compressed.flipped == flip_vertically;
+		return;
+	}
+	int channels;
+	unsigned char* data = ImageDecoder::Load(source.data, source.size, image->width, image->height, channels, 0,
+		false, &workers_);
+	if (data)
+		BuildMips(image, data, channels, flip_vertically);
+	stbi_image_free(data);
+}
+
+void TextureLoader::Update(int max_uploads)
+{
+	for (int uploads = 0; uploads < max_uploads; uploads++)
+	{
+		DecodedImage* image = stalled_;
+		stalled_ = NULL;
+		if (!image && !decoded_.TryPop(image))
+			return;
+
+		bool decoded = !image->pixels.empty() || image->is_compressed;
+		if (decoded && !Upload(image))
+		{
+			// every pixel buffer is still being read, try again next frame
+			stalled_ = image;
+			return;
+		}
+		if (!decoded)
+			std::cout << "Failed to load texture " << image->path << std::endl;
+
+		delete image;
+		pending_--;
+	}
+}
+
+void TextureLoader::Finish()
+{
+	while (pending_ > 0)
+	{
+		Update(1);
+		if (pending_ > 0)
+			std::this_thread::yield();
+	}
+}
+
+bool TextureLoader::Upload(DecodedImage* image)
+{
+	UploadBuffer& buffer = upload_ring_[next_upload_];
+	if (buffer.fence)
+	{
+		// zero timeout: never stall the render thread on the GPU
+		GLenum status = glClientWaitSync(buffer.fence, 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			return false;
+		glDeleteSync(buffer.fence);
+		buffer.fence = 0;
+	}
+
+	size_t size = image->is_compressed ? image->compressed.data.size() : image->pixels.size();
+	for (size_t l = 0; !image->is_compressed && l < image->mips.size(); l++)
+		size += image->mips[l].pixels.size();
+
+	BindUnpackBuffer(buffer.pbo);
+	// orphan the previous storage, growing the buffer if this image is larger
+	if (size > buffer.size)
+		buffer.size = size;
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, buffer.size, NULL, GL_STREAM_DRAW);
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (mapped)
+	{
+		if (image->is_compressed)
+		{
+			std::memcpy(mapped, image->compressed.data.data(), size);
+		}
+		else
+		{
+			// level 0 followed by the CPU-built mip levels
+			unsigned char* out = (unsigned char*)mapped;
+			std::memcpy(out, image->pixels.data(), image->pixels.size());
+			out += image->pixels.size();
+			for (size_t l = 0; l < image->mips.size(); l++)
+			{
+				std::memcpy(out, image->mips[l].pixels.data(), image->mips[l].pixels.size());
+				out += image->mips[l].pixels.size();
+			}
+		}
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+
+	BindTexture(image->texture);
+	// the smallest mip levels are narrower than 4 bytes per row
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (!mapped)
+		std::cout << "ERROR::TEXTURE_LOADER::PBO_MAP_FAILED" << std::endl;
+	else if (image->is_compressed)
+		UploadCompressed(image->compressed);
+	else
+		UploadLevels(image);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	BindUnpackBuffer(0);
+
+	buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	next_upload_ = (next_upload_ + 1) % upload_ring_.size();
+	return true;
+}
+
+void TextureLoader::UploadLevels(const DecodedImage* image)
+{
+	size_t offset = 0;
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image->width, image->height, 0, GL_BGRA, GL_UNSIGNED_BYTE, (const void*)offset);
+	offset += image->pixels.size();
+	for (size_t l = 0; l < image->mips.size(); l++)
+	{
+		const MipLevel& level = image->mips[l];
+		glTexImage2D(GL_TEXTURE_2D, (GLint)l + 1, GL_RGBA8, level.width, level.height, 0, GL_BGRA, GL_UNSIGNED_BYTE, (const void*)offset);
+		offset += level.pixels.size();
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)image->mips.size());
+	// the placeholder had no levels to sample between, the real image does
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+}
+
+void TextureLoader::UploadCompressed(const CompressedImage& image)
+{
+	// every level comes straight out of the bound pixel buffer
+	for (size_t l = 0; l < image.levels.size(); l++)
+	{
+		const CompressedLevel& level = image.levels[l];
+		glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)l, image.gl_format, level.width, level.height, 0,
+			(GLsizei)level.size, (const void*)level.offset);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)image.levels.size() - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+}
+
+void TextureLoader::SetDefaultParameters()
+{
+	// set the texture wrapping/filtering options (on the currently bounded texture object)
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+
+void TextureLoader::BindTexture(unsigned int texture)
+{
+	// uploads go through whichever unit is active, the cache has to know what replaced its binding
+	if (state_)
+		state_->BindTexture(GL_TEXTURE_2D, texture);
+	else
+		glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void TextureLoader::BindUnpackBuffer(unsigned int buffer)
+{
+	if (state_)
+		state_->BindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+	else
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+}
\ No newline at end of file
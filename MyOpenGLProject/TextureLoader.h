@@ -0,0 +1,101 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <GL/glew.h> // include glew to get all the required OpenGL headers
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+#include "GLState.h"
+#include "LockFreeQueue.h"
+#include "MipChain.h"
+#include "TextureCache.h"
+#include "ThreadPool.h"
+
+// Decodes images on worker threads and uploads them on the GL thread through a ring of
+// pixel buffer objects. Textures are usable immediately and show a placeholder until
+// their pixels have arrived. Images are uploaded uncompressed unless the KTX2 texture cache
+// is switched on (see SetTextureCache).
+class TextureLoader
+{
+public:
+	// 0 workers starts one per hardware thread
+	explicit TextureLoader(unsigned int worker_count = 0, int pbo_count = 3);
+	~TextureLoader();
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	// create the texture object with the placeholder image and queue the file for decoding
+	unsigned int Load(const char* path, bool flip_vertically = true);
+	// same, decoding from the pack's mapping (the pack must stay open until the texture is uploaded).
+	// a cooked "<name>.ktx2" in the pack is preferred over the source image
+	unsigned int Load(const AssetPack& pack, const char* name, bool flip_vertically = true);
+	// GL thread, once per frame: upload up to max_uploads decoded images
+	void Update(int max_uploads = 4);
+	// GL thread: block until every queued texture has been decoded and uploaded
+	void Finish();
+	// number of textures that are still waiting for their pixels
+	size_t PendingCount() const { return pending_; }
+	// route texture and buffer binds through the renderer's state cache so it stays in sync
+	void SetStateCache(GLState* state) { state_ = state; }
+	// off by default, call before the first Load. with use_cache, fresh .ktx2 files (see --cook) are
+	// uploaded as they are instead of decoding the source. with cook_missing as well, images without
+	// one are cooked to lossy BC1/BC3 on the worker and the cache file is written next to them.
+	// ignored without S3TC support
+	void SetTextureCache(bool use_cache, bool cook_missing);
+
+private:
+	// decoded pixels travelling from a worker to the GL thread. either pixels holds BGRA8 level 0
+	// (with the remaining levels in mips) or compressed holds a block-compressed mip chain;
+	// both are empty if decoding failed
+	struct DecodedImage
+	{
+		unsigned int texture;
+		std::string path;
+		// encoded file contents when loading from an asset pack, NULL when loading from disk
+		AssetSpan source;
+		int width;
+		int height;
+		std::vector<unsigned char> pixels;
+		std::vector<MipLevel> mips;
+		bool is_compressed;
+		CompressedImage compressed;
+	};
+
+	// one pixel buffer of the upload ring, fence marks when the GPU is done reading it
+	struct UploadBuffer
+	{
+		unsigned int pbo;
+		size_t size;
+		GLsync fence;
+	};
+
+	unsigned int Submit(const char* path, AssetSpan source, bool flip_vertically);
+	void Decode(DecodedImage* image, bool flip_vertically);
+	void DecodeFile(DecodedImage* image, bool flip_vertically);
+	void DecodeSpan(DecodedImage* image, bool flip_vertically);
+	void BuildMips(DecodedImage* image, const unsigned char* pixels, int channels, bool flip_vertically);
+	// returns false if the next ring buffer is still in use by the GPU
+	bool Upload(DecodedImage* image);
+	void UploadLevels(const DecodedImage* image);
+	void UploadCompressed(const CompressedImage& image);
+	static void SetDefaultParameters();
+	void BindTexture(unsigned int texture);
+	void BindUnpackBuffer(unsigned int buffer);
+
+	ThreadPool workers_;
+	LockFreeQueue<DecodedImage*> decoded_;
+	std::vector<UploadBuffer> upload_ring_;
+	size_t next_upload_;
+	// an image that was dequeued but could not be uploaded yet
+	DecodedImage* stalled_;
+	size_t pending_;
+	bool use_texture_cache_;
+	bool cook_missing_;
+	// set by the destructor, workers stop decoding and drop images the full queue can't take
+	std::atomic<bool> stopping_;
+	GLState* state_;
+};
+
+#endif // !TEXTURE_LOADER_H
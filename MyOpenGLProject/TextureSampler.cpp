@@ -0,0 +1,417 @@
+#include "TextureSampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include "CpuFeatures.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURE_SAMPLER_SSE2
+// the AVX2 kernel is built in TextureSamplerAvx2.cpp and picked at runtime
+#define TEXTURE_SAMPLER_AVX2
+#include <emmintrin.h>
+#include "TextureSamplerAvx2.h"
+#endif
+#if defined(_MSC_VER)
+// the scalar steps below must not be contracted to FMAs, the vector kernels round each operation
+#pragma fp_contract(off)
+#endif
+
+static const float kByteScale = 1.0f / 255.0f;
+
+// ---------------------------------------------------------------------------------------------
+// scalar steps, the vector kernels repeat them operation for operation
+
+// bring a texture coordinate into the range its wrap mode handles on whole texels
+static float WrapCoordinate(float u, SamplerWrap wrap)
+{
+	if (wrap == kSamplerRepeat)
+		return u - std::floor(u);
+	if (wrap == kSamplerMirror)
+		return u - 2.0f * std::floor(u * 0.5f);
+	return std::min(std::max(u, -1.0f), 2.0f);
+}
+
+static int FloorToInt(float s)
+{
+	// NaN would be undefined behavior, WrapTexel clamps whatever comes out
+	return s == s ? (int)std::floor(s) : 0;
+}
+
+// texel index along one axis, always inside [0, size)
+static int WrapTexel(int x, int size, SamplerWrap wrap)
+{
+	if (wrap == kSamplerRepeat)
+	{
+		if (x < 0)
+			x += size;
+		else if (x >= size)
+			x -= size;
+	}
+	else if (wrap == kSamplerMirror)
+	{
+		if (x < 0)
+			x += 2 * size;
+		else if (x >= 2 * size)
+			x -= 2 * size;
+		if (x >= size)
+			x = 2 * size - 1 - x;
+	}
+	return std::min(std::max(x, 0), size - 1);
+}
+
+static void FetchTexel(SamplerFormat format, const SamplerLevel& level, int x, int y, float rgba[4])
+{
+	size_t index = (size_t)y * level.width + x;
+	if (format == kSamplerFloat)
+	{
+		const float* texel = (const float*)level.pixels + index * 4;
+		for (int c = 0; c < 4; c++)
+			rgba[c] = texel[c];
+	}
+	else if (format == kSamplerRGBA8)
+	{
+		const unsigned char* texel = (const unsigned char*)level.pixels + index * 4;
+		for (int c = 0; c < 4; c++)
+			rgba[c] = texel[c] * kByteScale;
+	}
+	else
+	{
+		const unsigned char* texel = (const unsigned char*)level.pixels + index * 3;
+		for (int c = 0; c < 3; c++)
+			rgba[c] = texel[c] * kByteScale;
+		rgba[3] = 1.0f;
+	}
+}
+
+// clamped level of detail, NaN picks the base level
+static float ClampLevel(float lod, float max_level)
+{
+	return lod > 0.0f ? std::min(lod, max_level) : 0.0f;
+}
+
+// ---------------------------------------------------------------------------------------------
+// SSE2: 4 samples at a time. SSE2 has no gathers, no floor and no 32-bit multiply, so only the
+// arithmetic is vectorized and the texels are loaded one by one
+
+#if defined(TEXTURE_SAMPLER_SSE2)
+static __m128 Floor4(__m128 x)
+{
+	__m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+	__m128 floored = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.0f)));
+	// from 2^23 on every float is an integer already, and may not fit in an int
+	__m128 magnitude = _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+	__m128 integral = _mm_cmpge_ps(magnitude, _mm_set1_ps(8388608.0f));
+	return _mm_or_ps(_mm_and_ps(integral, x), _mm_andnot_ps(integral, floored));
+}
+
+static __m128 WrapCoordinate4(__m128 u, SamplerWrap wrap)
+{
+	if (wrap == kSamplerRepeat)
+		return _mm_sub_ps(u, Floor4(u));
+	if (wrap == kSamplerMirror)
+		return _mm_sub_ps(u, _mm_mul_ps(_mm_set1_ps(2.0f), Floor4(_mm_mul_ps(u, _mm_set1_ps(0.5f)))));
+	return _mm_min_ps(_mm_max_ps(u, _mm_set1_ps(-1.0f)), _mm_set1_ps(2.0f));
+}
+
+static __m128i Select4(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static __m128i WrapTexel4(__m128i x, int size, SamplerWrap wrap)
+{
+	const __m128i kZero = _mm_setzero_si128();
+	__m128i n = _mm_set1_epi32(size);
+	if (wrap == kSamplerRepeat)
+	{
+		x = _mm_add_epi32(x, _mm_and_si128(_mm_cmpgt_epi32(kZero, x), n));
+		x = _mm_sub_epi32(x, _mm_andnot_si128(_mm_cmpgt_epi32(n, x), n));
+	}
+	else if (wrap == kSamplerMirror)
+	{
+		__m128i period = _mm_set1_epi32(2 * size);
+		x = _mm_add_epi32(x, _mm_and_si128(_mm_cmpgt_epi32(kZero, x), period));
+		x = _mm_sub_epi32(x, _mm_andnot_si128(_mm_cmpgt_epi32(period, x), period));
+		x = Select4(_mm_cmpgt_epi32(n, x), x, _mm_sub_epi32(_mm_set1_epi32(2 * size - 1), x));
+	}
+	x = Select4(_mm_cmpgt_epi32(kZero, x), kZero, x);
+	__m128i last = _mm_set1_epi32(size - 1);
+	return Select4(_mm_cmpgt_epi32(x, last), last, x);
+}
+
+static void Fetch4(SamplerFormat format, const SamplerLevel& level, __m128i x, __m128i y, __m128 rgba[4])
+{
+	int xs[4], ys[4];
+	_mm_storeu_si128((__m128i*)xs, x);
+	_mm_storeu_si128((__m128i*)ys, y);
+	float texels[4][4];
+	for (int lane = 0; lane < 4; lane++)
+		FetchTexel(format, level, xs[lane], ys[lane], texels[lane]);
+	for (int c = 0; c < 4; c++)
+		rgba[c] = _mm_setr_ps(texels[0][c], texels[1][c], texels[2][c], texels[3][c]);
+}
+
+static void SampleLevel4(const SamplerLevel& level, SamplerFormat format, bool nearest, SamplerWrap wrap_s, SamplerWrap wrap_t,
+	__m128 u, __m128 v, __m128 rgba[4])
+{
+	__m128 s = _mm_mul_ps(WrapCoordinate4(u, wrap_s), _mm_set1_ps((float)level.width));
+	__m128 t = _mm_mul_ps(WrapCoordinate4(v, wrap_t), _mm_set1_ps((float)level.height));
+	if (nearest)
+	{
+		__m128i x = WrapTexel4(_mm_cvttps_epi32(Floor4(s)), level.width, wrap_s);
+		__m128i y = WrapTexel4(_mm_cvttps_epi32(Floor4(t)), level.height, wrap_t);
+		Fetch4(format, level, x, y, rgba);
+		return;
+	}
+
+	const __m128 kHalf = _mm_set1_ps(0.5f);
+	const __m128i kOne = _mm_set1_epi32(1);
+	s = _mm_sub_ps(s, kHalf);
+	t = _mm_sub_ps(t, kHalf);
+	__m128 s_floor = Floor4(s);
+	__m128 t_floor = Floor4(t);
+	__m128 s_weight = _mm_sub_ps(s, s_floor);
+	__m128 t_weight = _mm_sub_ps(t, t_floor);
+	__m128i x = _mm_cvttps_epi32(s_floor);
+	__m128i y = _mm_cvttps_epi32(t_floor);
+	__m128i x0 = WrapTexel4(x, level.width, wrap_s);
+	__m128i x1 = WrapTexel4(_mm_add_epi32(x, kOne), level.width, wrap_s);
+	__m128i y0 = WrapTexel4(y, level.height, wrap_t);
+	__m128i y1 = WrapTexel4(_mm_add_epi32(y, kOne), level.height, wrap_t);
+
+	__m128 texels[4][4];
+	Fetch4(format, level, x0, y0, texels[0]);
+	Fetch4(format, level, x1, y0, texels[1]);
+	Fetch4(format, level, x0, y1, texels[2]);
+	Fetch4(format, level, x1, y1, texels[3]);
+	for (int c = 0; c < 4; c++)
+	{
+		__m128 bottom = _mm_add_ps(texels[0][c], _mm_mul_ps(_mm_sub_ps(texels[1][c], texels[0][c]), s_weight));
+		__m128 top = _mm_add_ps(texels[2][c], _mm_mul_ps(_mm_sub_ps(texels[3][c], texels[2][c]), s_weight));
+		rgba[c] = _mm_add_ps(bottom, _mm_mul_ps(_mm_sub_ps(top, bottom), t_weight));
+	}
+}
+#endif
+
+// ---------------------------------------------------------------------------------------------
+
+TextureSampler::TextureSampler()
+	: format_(kSamplerRGBA8), filter_(kSamplerBilinear), wrap_s_(kSamplerRepeat), wrap_t_(kSamplerRepeat)
+{
+}
+
+void TextureSampler::SetLevels(SamplerFormat format, const SamplerLevel* levels, int level_count)
+{
+	format_ = format;
+	levels_.assign(levels, levels + level_count);
+}
+
+void TextureSampler::SetMipChain(const unsigned char* rgba, int width, int height, const std::vector<MipLevel>& chain)
+{
+	std::vector<SamplerLevel> levels(1 + chain.size());
+	levels[0].width = width;
+	levels[0].height = height;
+	levels[0].pixels = rgba;
+	for (size_t l = 0; l < chain.size(); l++)
+	{
+		levels[l + 1].width = chain[l].width;
+		levels[l + 1].height = chain[l].height;
+		levels[l + 1].pixels = chain[l].pixels.data();
+	}
+	SetLevels(kSamplerRGBA8, levels.data(), (int)levels.size());
+}
+
+void TextureSampler::SetWrap(SamplerWrap wrap_s, SamplerWrap wrap_t)
+{
+	wrap_s_ = wrap_s;
+	wrap_t_ = wrap_t;
+}
+
+float TextureSampler::Lod(float du_dx, float dv_dx, float du_dy, float dv_dy) const
+{
+	if (levels_.empty())
+		return 0.0f;
+	// the longer of the pixel's two footprint axes, in texels of the base level
+	float width = (float)levels_[0].width;
+	float height = (float)levels_[0].height;
+	float along_x = (du_dx * width) * (du_dx * width) + (dv_dx * height) * (dv_dx * height);
+	float along_y = (du_dy * width) * (du_dy * width) + (dv_dy * height) * (dv_dy * height);
+	return 0.5f * std::log2(std::max(along_x, along_y));
+}
+
+void TextureSampler::SampleLevelScalar(const SamplerLevel& level, float u, float v, float rgba[4]) const
+{
+	float s = WrapCoordinate(u, wrap_s_) * (float)level.width;
+	float t = WrapCoordinate(v, wrap_t_) * (float)level.height;
+	if (filter_ == kSamplerNearest)
+	{
+		FetchTexel(format_, level, WrapTexel(FloorToInt(s), level.width, wrap_s_), WrapTexel(FloorToInt(t), level.height, wrap_t_), rgba);
+		return;
+	}
+
+	s = s - 0.5f;
+	t = t - 0.5f;
+	float s_floor = std::floor(s);
+	float t_floor = std::floor(t);
+	float s_weight = s - s_floor;
+	float t_weight = t - t_floor;
+	int x = FloorToInt(s_floor);
+	int y = FloorToInt(t_floor);
+	int x0 = WrapTexel(x, level.width, wrap_s_);
+	int x1 = WrapTexel(x + 1, level.width, wrap_s_);
+	int y0 = WrapTexel(y, level.height, wrap_t_);
+	int y1 = WrapTexel(y + 1, level.height, wrap_t_);
+
+	float texels[4][4];
+	FetchTexel(format_, level, x0, y0, texels[0]);
+	FetchTexel(format_, level, x1, y0, texels[1]);
+	FetchTexel(format_, level, x0, y1, texels[2]);
+	FetchTexel(format_, level, x1, y1, texels[3]);
+	for (int c = 0; c < 4; c++)
+	{
+		float bottom = texels[0][c] + (texels[1][c] - texels[0][c]) * s_weight;
+		float top = texels[2][c] + (texels[3][c] - texels[2][c]) * s_weight;
+		rgba[c] = bottom + (top - bottom) * t_weight;
+	}
+}
+
+void TextureSampler::SampleScalar(float u, float v, const float* lod, float rgba[4]) const
+{
+	if (levels_.empty())
+	{
+		rgba[0] = rgba[1] = rgba[2] = 0.0f;
+		rgba[3] = 1.0f;
+		return;
+	}
+	if (filter_ != kSamplerTrilinear || !lod)
+	{
+		SampleLevelScalar(levels_[0], u, v, rgba);
+		return;
+	}
+
+	// blend the two levels around the level of detail
+	int max_level = (int)levels_.size() - 1;
+	float level = ClampLevel(*lod, (float)max_level);
+	int first = (int)level;
+	float weight = level - (float)first;
+	float next[4];
+	SampleLevelScalar(levels_[first], u, v, rgba);
+	SampleLevelScalar(levels_[std::min(first + 1, max_level)], u, v, next);
+	for (int c = 0; c < 4; c++)
+		rgba[c] = rgba[c] + (next[c] - rgba[c]) * weight;
+}
+
+void TextureSampler::SampleReference(const float* u, const float* v, const float* lod, int count, SamplerColors& colors) const
+{
+	count = std::min(count, kMaxSamples);
+	for (int i = 0; i < count; i++)
+	{
+		float rgba[4];
+		SampleScalar(u[i], v[i], lod ? lod + i : NULL, rgba);
+		colors.red[i] = rgba[0];
+		colors.green[i] = rgba[1];
+		colors.blue[i] = rgba[2];
+		colors.alpha[i] = rgba[3];
+	}
+}
+
+void TextureSampler::Sample(const float* u, const float* v, const float* lod, int count, SamplerColors& colors) const
+{
+	count = std::min(count, kMaxSamples);
+	int i = 0;
+	float* channels[4] = { colors.red, colors.green, colors.blue, colors.alpha };
+	bool nearest = filter_ == kSamplerNearest;
+	bool trilinear = filter_ == kSamplerTrilinear && lod;
+	int max_level = (int)levels_.size() - 1;
+
+	if (levels_.empty())
+	{
+		for (; i < count; i++)
+		{
+			colors.red[i] = colors.green[i] = colors.blue[i] = 0.0f;
+			colors.alpha[i] = 1.0f;
+		}
+		return;
+	}
+
+	// with trilinear filtering the kernels handle groups whose samples all blend the same two
+	// levels, which is the usual case for neighboring pixels. other groups go one by one
+	{
+#if defined(TEXTURE_SAMPLER_AVX2)
+		while (CpuFeatures::HasAvx2())
+		{
+			i = TextureSamplerAvx2::Sample(levels_.data(), max_level, format_, nearest, wrap_s_, wrap_t_, u, v,
+				trilinear ? lod : NULL, i, count, channels);
+			if (i + 8 > count)
+				break;
+			for (int lane = i; lane < i + 8; lane++)
+			{
+				float single[4];
+				SampleScalar(u[lane], v[lane], lod + lane, single);
+				for (int c = 0; c < 4; c++)
+					channels[c][lane] = single[c];
+			}
+			i += 8;
+		}
+#endif
+#if defined(TEXTURE_SAMPLER_SSE2)
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 u4 = _mm_loadu_ps(u + i);
+			__m128 v4 = _mm_loadu_ps(v + i);
+			__m128 rgba[4];
+			if (!trilinear)
+			{
+				SampleLevel4(levels_[0], format_, nearest, wrap_s_, wrap_t_, u4, v4, rgba);
+			}
+			else
+			{
+				__m128 lod4 = _mm_loadu_ps(lod + i);
+				__m128 level = _mm_and_ps(_mm_cmpgt_ps(lod4, _mm_setzero_ps()), _mm_min_ps(lod4, _mm_set1_ps((float)max_level)));
+				__m128i first = _mm_cvttps_epi32(level);
+				int first_level = _mm_cvtsi128_si32(first);
+				if (_mm_movemask_epi8(_mm_cmpeq_epi32(first, _mm_set1_epi32(first_level))) != 0xFFFF)
+				{
+					for (int lane = i; lane < i + 4; lane++)
+					{
+						float single[4];
+						SampleScalar(u[lane], v[lane], lod + lane, single);
+						for (int c = 0; c < 4; c++)
+							channels[c][lane] = single[c];
+					}
+					continue;
+				}
+				__m128 weight = _mm_sub_ps(level, _mm_cvtepi32_ps(first));
+				__m128 next[4];
+				SampleLevel4(levels_[first_level], format_, false, wrap_s_, wrap_t_, u4, v4, rgba);
+				SampleLevel4(levels_[std::min(first_level + 1, max_level)], format_, false, wrap_s_, wrap_t_, u4, v4, next);
+				for (int c = 0; c < 4; c++)
+					rgba[c] = _mm_add_ps(rgba[c], _mm_mul_ps(_mm_sub_ps(next[c], rgba[c]), weight));
+			}
+			for (int c = 0; c < 4; c++)
+				_mm_storeu_ps(channels[c] + i, rgba[c]);
+		}
+#endif
+	}
+
+	for (; i < count; i++)
+	{
+		float rgba[4];
+		SampleScalar(u[i], v[i], trilinear ? lod + i : NULL, rgba);
+		for (int c = 0; c < 4; c++)
+			channels[c][i] = rgba[c];
+	}
+}
+
+const char* TextureSampler::SimdName()
+{
+#if defined(TEXTURE_SAMPLER_AVX2)
+	if (CpuFeatures::HasAvx2())
+		return "AVX2";
+#endif
+#if defined(TEXTURE_SAMPLER_SSE2)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#ifndef TEXTURE_SAMPLER_H
+#define TEXTURE_SAMPLER_H
+
+#include <vector>
+#include "MipChain.h"
+
+enum SamplerFormat
+{
+	kSamplerRGB8,   // 3 bytes per texel, alpha reads as 1
+	kSamplerRGBA8,
+	kSamplerFloat   // RGBA, 4 floats per texel, returned unclamped
+};
+
+enum SamplerFilter
+{
+	kSamplerNearest,   // GL_NEAREST on level 0
+	kSamplerBilinear,  // GL_LINEAR on level 0
+	kSamplerTrilinear  // GL_LINEAR_MIPMAP_LINEAR
+};
+
+enum SamplerWrap
+{
+	kSamplerRepeat,  // GL_REPEAT
+	kSamplerClamp,   // GL_CLAMP_TO_EDGE
+	kSamplerMirror   // GL_MIRRORED_REPEAT
+};
+
+// one mip level, rows from the bottom up like a GL texture. the sampler doesn't copy the pixels
+struct SamplerLevel
+{
+	int width;
+	int height;
+	const void* pixels;
+};
+
+// colors of one Sample call, one array per channel
+struct SamplerColors
+{
+	float red[16];
+	float green[16];
+	float blue[16];
+	float alpha[16];
+};
+
+// CPU version of GLSL texture() for image processing, golden image tests and the software
+// rasterizer. Sample takes up to kMaxSamples coordinates at once and evaluates them 8 at a time
+// with AVX2 gathers (4 at a time with SSE2 arithmetic and scalar loads); SampleReference is the
+// scalar version they are verified against and gives exactly the same results. Coordinates that
+// are not finite give unspecified colors but never read outside the image.
+class TextureSampler
+{
+public:
+	static const int kMaxSamples = 16;
+
+	// without levels every sample is opaque black, like an incomplete GL texture
+	TextureSampler();
+
+	// levels[0] is the base level, each following one half the size of the previous
+	void SetLevels(SamplerFormat format, const SamplerLevel* levels, int level_count);
+	// an RGBA8 image and the levels MipChain::Build made from it
+	void SetMipChain(const unsigned char* rgba, int width, int height, const std::vector<MipLevel>& chain);
+	void SetFilter(SamplerFilter filter) { filter_ = filter; }
+	SamplerFilter Filter() const { return filter_; }
+	void SetWrap(SamplerWrap wrap_s, SamplerWrap wrap_t);
+
+	// colors at (u[i], v[i]) for i < count <= kMaxSamples. lod is only read with trilinear
+	// filtering, NULL samples level 0
+	void Sample(const float* u, const float* v, const float* lod, int count, SamplerColors& colors) const;
+	void SampleReference(const float* u, const float* v, const float* lod, int count, SamplerColors& colors) const;
+	// GL's level of detail for the texture coordinate derivatives along x and y
+	float Lod(float du_dx, float dv_dx, float du_dy, float dv_dy) const;
+	int LevelCount() const { return (int)levels_.size(); }
+	// name of the instruction set the kernels run with on this CPU
+	static const char* SimdName();
+
+private:
+	void SampleScalar(float u, float v, const float* lod, float rgba[4]) const;
+	void SampleLevelScalar(const SamplerLevel& level, float u, float v, float rgba[4]) const;
+
+	SamplerFormat format_;
+	SamplerFilter filter_;
+	SamplerWrap wrap_s_;
+	SamplerWrap wrap_t_;
+	std::vector<SamplerLevel> levels_;
+};
+
+#endif // !TEXTURE_SAMPLER_H
\ No newline at end of file
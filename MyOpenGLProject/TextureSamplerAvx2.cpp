@@ -0,0 +1,160 @@
+#include "TextureSamplerAvx2.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+#if defined(_MSC_VER)
+// the kernels must round like SampleReference, one multiply and one add at a time
+#pragma fp_contract(off)
+#endif
+
+// same as TextureSampler.cpp
+static const float kByteScale = 1.0f / 255.0f;
+
+static __m256 WrapCoordinate8(__m256 u, SamplerWrap wrap)
+{
+	if (wrap == kSamplerRepeat)
+		return _mm256_sub_ps(u, _mm256_floor_ps(u));
+	if (wrap == kSamplerMirror)
+		return _mm256_sub_ps(u, _mm256_mul_ps(_mm256_set1_ps(2.0f), _mm256_floor_ps(_mm256_mul_ps(u, _mm256_set1_ps(0.5f)))));
+	return _mm256_min_ps(_mm256_max_ps(u, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(2.0f));
+}
+
+static __m256i WrapTexel8(__m256i x, int size, SamplerWrap wrap)
+{
+	const __m256i kZero = _mm256_setzero_si256();
+	__m256i n = _mm256_set1_epi32(size);
+	if (wrap == kSamplerRepeat)
+	{
+		x = _mm256_add_epi32(x, _mm256_and_si256(_mm256_cmpgt_epi32(kZero, x), n));
+		x = _mm256_sub_epi32(x, _mm256_andnot_si256(_mm256_cmpgt_epi32(n, x), n));
+	}
+	else if (wrap == kSamplerMirror)
+	{
+		__m256i period = _mm256_set1_epi32(2 * size);
+		x = _mm256_add_epi32(x, _mm256_and_si256(_mm256_cmpgt_epi32(kZero, x), period));
+		x = _mm256_sub_epi32(x, _mm256_andnot_si256(_mm256_cmpgt_epi32(period, x), period));
+		__m256i mirrored = _mm256_sub_epi32(_mm256_set1_epi32(2 * size - 1), x);
+		x = _mm256_blendv_epi8(mirrored, x, _mm256_cmpgt_epi32(n, x));
+	}
+	return _mm256_min_epi32(_mm256_max_epi32(x, kZero), _mm256_set1_epi32(size - 1));
+}
+
+static void Fetch8(SamplerFormat format, const SamplerLevel& level, __m256i index, __m256 rgba[4])
+{
+	if (format == kSamplerFloat)
+	{
+		__m256i first = _mm256_slli_epi32(index, 2);
+		for (int c = 0; c < 4; c++)
+			rgba[c] = _mm256_i32gather_ps((const float*)level.pixels, _mm256_add_epi32(first, _mm256_set1_epi32(c)), 4);
+		return;
+	}
+
+	const __m256 kScale = _mm256_set1_ps(kByteScale);
+	const __m256i kByteMask = _mm256_set1_epi32(0xFF);
+	__m256i texel;
+	if (format == kSamplerRGBA8)
+	{
+		texel = _mm256_i32gather_epi32((const int*)level.pixels, index, 4);
+	}
+	else if ((size_t)level.width * level.height < 2)
+	{
+		// a single 3 byte texel has no neighbour to borrow a fourth byte from
+		const unsigned char* p = (const unsigned char*)level.pixels;
+		texel = _mm256_set1_epi32(p[0] | p[1] << 8 | p[2] << 16);
+	}
+	else
+	{
+		// 4 bytes are gathered for every 3 byte texel. they start one byte early (except for the
+		// first texel) so that the last texel's gather stays inside the image
+		__m256i after_first = _mm256_cmpgt_epi32(index, _mm256_setzero_si256());
+		__m256i offset = _mm256_add_epi32(_mm256_add_epi32(index, _mm256_add_epi32(index, index)), after_first);
+		texel = _mm256_i32gather_epi32((const int*)level.pixels, offset, 1);
+		texel = _mm256_srlv_epi32(texel, _mm256_and_si256(after_first, _mm256_set1_epi32(8)));
+	}
+	rgba[0] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(texel, kByteMask)), kScale);
+	rgba[1] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(texel, 8), kByteMask)), kScale);
+	rgba[2] = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(texel, 16), kByteMask)), kScale);
+	rgba[3] = format == kSamplerRGBA8 ? _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(texel, 24)), kScale) : _mm256_set1_ps(1.0f);
+}
+
+static void SampleLevel8(const SamplerLevel& level, SamplerFormat format, bool nearest, SamplerWrap wrap_s, SamplerWrap wrap_t,
+	__m256 u, __m256 v, __m256 rgba[4])
+{
+	__m256i width = _mm256_set1_epi32(level.width);
+	__m256 s = _mm256_mul_ps(WrapCoordinate8(u, wrap_s), _mm256_set1_ps((float)level.width));
+	__m256 t = _mm256_mul_ps(WrapCoordinate8(v, wrap_t), _mm256_set1_ps((float)level.height));
+	if (nearest)
+	{
+		__m256i x = WrapTexel8(_mm256_cvttps_epi32(_mm256_floor_ps(s)), level.width, wrap_s);
+		__m256i y = WrapTexel8(_mm256_cvttps_epi32(_mm256_floor_ps(t)), level.height, wrap_t);
+		Fetch8(format, level, _mm256_add_epi32(_mm256_mullo_epi32(y, width), x), rgba);
+		return;
+	}
+
+	const __m256 kHalf = _mm256_set1_ps(0.5f);
+	const __m256i kOne = _mm256_set1_epi32(1);
+	s = _mm256_sub_ps(s, kHalf);
+	t = _mm256_sub_ps(t, kHalf);
+	__m256 s_floor = _mm256_floor_ps(s);
+	__m256 t_floor = _mm256_floor_ps(t);
+	__m256 s_weight = _mm256_sub_ps(s, s_floor);
+	__m256 t_weight = _mm256_sub_ps(t, t_floor);
+	__m256i x = _mm256_cvttps_epi32(s_floor);
+	__m256i y = _mm256_cvttps_epi32(t_floor);
+	__m256i x0 = WrapTexel8(x, level.width, wrap_s);
+	__m256i x1 = WrapTexel8(_mm256_add_epi32(x, kOne), level.width, wrap_s);
+	__m256i row0 = _mm256_mullo_epi32(WrapTexel8(y, level.height, wrap_t), width);
+	__m256i row1 = _mm256_mullo_epi32(WrapTexel8(_mm256_add_epi32(y, kOne), level.height, wrap_t), width);
+
+	__m256 texels[4][4];
+	Fetch8(format, level, _mm256_add_epi32(row0, x0), texels[0]);
+	Fetch8(format, level, _mm256_add_epi32(row0, x1), texels[1]);
+	Fetch8(format, level, _mm256_add_epi32(row1, x0), texels[2]);
+	Fetch8(format, level, _mm256_add_epi32(row1, x1), texels[3]);
+	for (int c = 0; c < 4; c++)
+	{
+		__m256 bottom = _mm256_add_ps(texels[0][c], _mm256_mul_ps(_mm256_sub_ps(texels[1][c], texels[0][c]), s_weight));
+		__m256 top = _mm256_add_ps(texels[2][c], _mm256_mul_ps(_mm256_sub_ps(texels[3][c], texels[2][c]), s_weight));
+		rgba[c] = _mm256_add_ps(bottom, _mm256_mul_ps(_mm256_sub_ps(top, bottom), t_weight));
+	}
+}
+
+int TextureSamplerAvx2::Sample(const SamplerLevel* levels, int max_level, SamplerFormat format, bool nearest,
+	SamplerWrap wrap_s, SamplerWrap wrap_t, const float* u, const float* v, const float* lod,
+	int first, int count, float* const channels[4])
+{
+	int i = first;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 u8 = _mm256_loadu_ps(u + i);
+		__m256 v8 = _mm256_loadu_ps(v + i);
+		__m256 rgba[4];
+		if (!lod)
+		{
+			SampleLevel8(levels[0], format, nearest, wrap_s, wrap_t, u8, v8, rgba);
+		}
+		else
+		{
+			__m256 lod8 = _mm256_loadu_ps(lod + i);
+			__m256 level = _mm256_and_ps(_mm256_cmp_ps(lod8, _mm256_setzero_ps(), _CMP_GT_OQ), _mm256_min_ps(lod8, _mm256_set1_ps((float)max_level)));
+			__m256i first_levels = _mm256_cvttps_epi32(level);
+			int first_level = _mm256_cvtsi256_si32(first_levels);
+			if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(first_levels, _mm256_set1_epi32(first_level))) != -1)
+				break;
+			int next_level = first_level < max_level ? first_level + 1 : max_level;
+			__m256 weight = _mm256_sub_ps(level, _mm256_cvtepi32_ps(first_levels));
+			__m256 next[4];
+			SampleLevel8(levels[first_level], format, false, wrap_s, wrap_t, u8, v8, rgba);
+			SampleLevel8(levels[next_level], format, false, wrap_s, wrap_t, u8, v8, next);
+			for (int c = 0; c < 4; c++)
+				rgba[c] = _mm256_add_ps(rgba[c], _mm256_mul_ps(_mm256_sub_ps(next[c], rgba[c]), weight));
+		}
+		for (int c = 0; c < 4; c++)
+			_mm256_storeu_ps(channels[c] + i, rgba[c]);
+	}
+	return i;
+}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#error TextureSamplerAvx2.cpp must be compiled with /arch:AVX2
+#endif
\ No newline at end of file
@@ -0,0 +1,19 @@
+#ifndef TEXTURE_SAMPLER_AVX2_H
+#define TEXTURE_SAMPLER_AVX2_H
+
+#include "TextureSampler.h"
+
+// TextureSampler's AVX2 kernel, 8 samples at a time with gathered texels. Only called when
+// CpuFeatures::HasAvx2() is true, see CpuFeatures.h
+class TextureSamplerAvx2
+{
+public:
+	// samples the groups of 8 from first on into channels (red, green, blue, alpha), from
+	// levels[0], or with lod blending the two levels around it. stops when fewer than 8 samples
+	// are left or at a group whose samples don't all blend the same two levels, and returns where
+	static int Sample(const SamplerLevel* levels, int max_level, SamplerFormat format, bool nearest,
+		SamplerWrap wrap_s, SamplerWrap wrap_t, const float* u, const float* v, const float* lod,
+		int first, int count, float* const channels[4]);
+};
+
+#endif // !TEXTURE_SAMPLER_AVX2_H
\ No newline at end of file
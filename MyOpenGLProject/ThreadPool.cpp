@@ -0,0 +1,117 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned int thread_count)
+	: active_(0), stopping_(false)
+{
+	if (thread_count == 0)
+		thread_count = std::thread::hardware_concurrency();
+	if (thread_count == 0)
+		thread_count = 1;
+	for (unsigned int i = 0; i < thread_count; i++)
+		workers_.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+	}
+	task_available_.notify_all();
+	for (size_t i = 0; i < workers_.size(); i++)
+		workers_[i].join();
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		tasks_.push_back(std::move(task));
+	}
+	task_available_.notify_one();
+}
+
+void ThreadPool::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	idle_.wait(lock, [this] { return tasks_.empty() && active_ == 0; });
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body)
+{
+	if (count == 0)
+		return;
+	if (grain == 0)
+		grain = 1;
+	size_t chunk_count = (count + grain - 1) / grain;
+
+	// shared with the helper tasks, which may only start after this call has returned
+	struct State
+	{
+		std::atomic<size_t> next_chunk;
+		std::atomic<size_t> done_chunks;
+		std::mutex mutex;
+		std::condition_variable finished;
+	};
+	std::shared_ptr<State> state = std::make_shared<State>();
+	state->next_chunk = 0;
+	state->done_chunks = 0;
+	// body is only touched while a chunk is taken, and this call doesn't return before all chunks are done
+	const std::function<void(size_t, size_t)>* kBody = &body;
+
+	auto run = [state, kBody, count, grain, chunk_count]
+	{
+		for (;;)
+		{
+			size_t chunk = state->next_chunk.fetch_add(1);
+			if (chunk >= chunk_count)
+				return;
+			size_t begin = chunk * grain;
+			(*kBody)(begin, std::min(count, begin + grain));
+			if (state->done_chunks.fetch_add(1) + 1 == chunk_count)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->finished.notify_all();
+			}
+		}
+	};
+
+	size_t helpers = std::min(workers_.size(), chunk_count - 1);
+	for (size_t i = 0; i < helpers; i++)
+		Enqueue(run);
+	run();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&state, chunk_count] { return state->done_chunks.load() == chunk_count; });
+}
+
+void ThreadPool::WorkerLoop()
+{
+	for (;;)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			task_available_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+			// drain the queue before shutting down
+			if (tasks_.empty())
+				return;
+			task = std::move(tasks_.front());
+			tasks_.pop_front();
+			active_++;
+		}
+
+		task();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			active_--;
+			if (tasks_.empty() && active_ == 0)
+				idle_.notify_all();
+		}
+	}
+}
@@ -0,0 +1,42 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads pulling tasks from a shared FIFO.
+class ThreadPool
+{
+public:
+	// 0 starts one worker per hardware thread
+	explicit ThreadPool(unsigned int thread_count = 0);
+	// finishes the queued tasks, then joins the workers
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void Enqueue(std::function<void()> task);
+	// block until the queue is empty and no task is running
+	void WaitIdle();
+	// run body(begin, end) over [0, count) in chunks of grain items and wait for all of them.
+	// the calling thread works on chunks too, so this is safe to call from inside a task
+	void ParallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+	unsigned int ThreadCount() const { return (unsigned int)workers_.size(); }
+
+private:
+	void WorkerLoop();
+
+	std::vector<std::thread> workers_;
+	std::deque<std::function<void()>> tasks_;
+	std::mutex mutex_;
+	std::condition_variable task_available_;
+	std::condition_variable idle_;
+	size_t active_;
+	bool stopping_;
+};
+
+#endif // !THREAD_POOL_H
@@ -0,0 +1,43 @@
+#include "Tools.h"
+
+#include "GoldenTest.h"
+
+struct Tool
+{
+	bool (*selected)(const Options& options);
+	int (*run)(const Options& options);
+};
+
+static const Tool kTools[] = {
+	{ [](const Options& o) { return !o.cook_paths.empty(); }, [](const Options& o) { return CookTextures(o.cook_paths); } },
+	{ [](const Options& o) { return o.verify_mips_path != NULL; }, [](const Options& o) { return VerifyMipChain(o.verify_mips_path); } },
+	{ [](const Options& o) { return !o.verify_decoder_paths.empty(); }, [](const Options& o) { return VerifyImageDecoder(o.verify_decoder_paths); } },
+	{ [](const Options& o) { return o.bench_queue_draws > 0; }, [](const Options& o) { return BenchmarkRenderQueue(o.bench_queue_draws); } },
+	{ [](const Options& o) { return o.bench_mesh_size > 0; }, [](const Options& o) { return BenchmarkMeshOptimizer(o.bench_mesh_size); } },
+	{ [](const Options& o) { return o.bench_cull_count > 0; }, [](const Options& o) { return BenchmarkFrustumCuller(o.bench_cull_count); } },
+	{ [](const Options& o) { return o.bench_sampler_count > 0; }, [](const Options& o) { return BenchmarkTextureSampler(o.bench_sampler_count); } },
+	{ [](const Options& o) { return o.bench_raster_triangles > 0; }, [](const Options& o) { return BenchmarkSoftwareRasterizer(o.bench_raster_triangles); } },
+	{ [](const Options& o) { return o.bench_upload_size > 0; }, [](const Options& o) { return BenchmarkUploadConverter(o.bench_upload_size); } },
+	// with --headless the golden check runs on the last GL frame instead, in main
+	{ [](const Options& o) { return o.golden_path != NULL && !o.headless; }, [](const Options& o)
+		{
+			GoldenTest golden(o.golden_path, o.update_golden, o.golden_machine);
+			return RunSoftwareGoldenTests(golden);
+		} },
+	{ [](const Options& o) { return o.write_mesh_path != NULL; }, [](const Options& o) { return WriteGridMesh(o.write_mesh_path, o.write_mesh_size); } },
+	{ [](const Options& o) { return o.verify_meshlets_segments > 0; }, [](const Options& o) { return VerifyMeshlets(o.verify_meshlets_segments); } },
+	{ [](const Options& o) { return o.pack_path != NULL; }, [](const Options& o) { return PackAssets(o.pack_path, o.pack_directory); } }
+};
+
+bool RunTool(const Options& options, int& exit_code)
+{
+	for (size_t t = 0; t < sizeof(kTools) / sizeof(kTools[0]); t++)
+	{
+		if (kTools[t].selected(options))
+		{
+			exit_code = kTools[t].run(options);
+			return true;
+		}
+	}
+	return false;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef TOOLS_H
+#define TOOLS_H
+
+#include <vector>
+#include "Options.h"
+
+class GoldenTest;
+
+// Command line modes that run instead of the renderer. Each one checks, measures or converts
+// something without a GL context and returns the process exit code.
+
+// the tool the options select, in the order they take precedence. false if there is none
+bool RunTool(const Options& options, int& exit_code);
+
+// asset tools
+int CookTextures(const std::vector<const char*>& image_paths);
+int PackAssets(const char* pack_path, const char* directory);
+int WriteGridMesh(const char* path, int grid_size);
+
+// SIMD kernels against their scalar references, plus timings
+int VerifyMipChain(const char* image_path);
+int VerifyImageDecoder(const std::vector<const char*>& image_paths);
+int VerifyMeshlets(int segments);
+int BenchmarkFrustumCuller(int object_count);
+int BenchmarkTextureSampler(int sample_count);
+int BenchmarkUploadConverter(int size);
+
+// benchmarks
+int BenchmarkRenderQueue(int draw_count);
+int BenchmarkMeshOptimizer(int grid_size);
+int BenchmarkSoftwareRasterizer(int triangle_count);
+
+// the software rendered golden scenes, and --headless on a machine without a GL context
+int RunSoftwareGoldenTests(GoldenTest& golden);
+int RenderHeadlessSoftware(const Options& options);
+
+#endif // !TOOLS_H
\ No newline at end of file
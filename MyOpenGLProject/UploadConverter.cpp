@@ -0,0 +1,286 @@
+#include "UploadConverter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "CpuFeatures.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UPLOAD_CONVERTER_SSE2
+// the AVX2 kernels (and the SSSE3 shuffles) are built in UploadConverterAvx2.cpp and picked at runtime
+#define UPLOAD_CONVERTER_AVX2
+#include <emmintrin.h>
+#include "UploadConverterAvx2.h"
+#endif
+
+// pixels of the top row parked on the stack while an in-place flip converts the bottom row
+static const int kChunkPixels = 256;
+
+// ---------------------------------------------------------------------------------------------
+// premultiplication, shared by all code paths so they round identically
+
+static const int kEncodeBuckets = 4096;
+
+struct SrgbTables
+{
+	// 16-bit linear value of every code
+	unsigned int to_linear[256];
+	// 16-bit linear value from which the encoded sRGB value rounds up to the next code
+	unsigned int thresholds[256];
+	// first candidate code for each linear bucket, refined with the thresholds
+	unsigned char bucket_start[kEncodeBuckets];
+
+	SrgbTables()
+	{
+		for (int i = 0; i < 256; i++)
+			to_linear[i] = (unsigned int)std::lround(Decode(i / 255.0) * 65535.0);
+		for (int i = 0; i < 255; i++)
+			thresholds[i] = (unsigned int)std::lround(Decode((i + 0.5) / 255.0) * 65535.0);
+		thresholds[255] = 0x10000;
+		int code = 0;
+		for (int b = 0; b < kEncodeBuckets; b++)
+		{
+			while (thresholds[code] <= (unsigned int)b * (0x10000 / kEncodeBuckets))
+				code++;
+			bucket_start[b] = (unsigned char)code;
+		}
+	}
+
+	static double Decode(double c)
+	{
+		return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+	}
+};
+
+static const SrgbTables& GetSrgbTables()
+{
+	static const SrgbTables kTables;
+	return kTables;
+}
+
+// round(c * a / 255), exact for every pair of bytes
+static inline unsigned int MultiplyUnorm(unsigned int c, unsigned int a)
+{
+	unsigned int t = c * a + 128;
+	return (t + (t >> 8)) >> 8;
+}
+
+static inline unsigned int MultiplySrgb(const SrgbTables& tables, unsigned int c, unsigned int a)
+{
+	unsigned int linear = (tables.to_linear[c] * a + 127) / 255;
+	unsigned int code = tables.bucket_start[linear / (0x10000 / kEncodeBuckets)];
+	while (linear >= tables.thresholds[code])
+		code++;
+	return code;
+}
+
+// ---------------------------------------------------------------------------------------------
+// kernels, each converts one row of count pixels. source and destination may be the same
+// memory for 4 channels, every pixel is read before it is written
+
+static void ConvertPixels(const unsigned char* src, unsigned char* dst, int count, int channels,
+	UploadOrder order, UploadAlpha alpha)
+{
+	const SrgbTables& tables = GetSrgbTables();
+	const int red = order == kUploadBGRA ? 2 : 0;
+	for (int i = 0; i < count; i++, src += channels, dst += 4)
+	{
+		// gray is replicated into the color channels, like stb_image does
+		unsigned int r = src[0], g = src[0], b = src[0], a = 255;
+		if (channels >= 3)
+		{
+			g = src[1];
+			b = src[2];
+		}
+		if (channels == 2 || channels == 4)
+			a = src[channels - 1];
+		if (a != 255 && alpha == kUploadPremultiplied)
+		{
+			r = MultiplyUnorm(r, a);
+			g = MultiplyUnorm(g, a);
+			b = MultiplyUnorm(b, a);
+		}
+		else if (a != 255 && alpha == kUploadPremultipliedSrgb)
+		{
+			r = MultiplySrgb(tables, r, a);
+			g = MultiplySrgb(tables, g, a);
+			b = MultiplySrgb(tables, b, a);
+		}
+		dst[red] = (unsigned char)r;
+		dst[1] = (unsigned char)g;
+		dst[2 - red] = (unsigned char)b;
+		dst[3] = (unsigned char)a;
+	}
+}
+
+#if defined(UPLOAD_CONVERTER_SSE2)
+static inline __m128i SwapRedBlue(__m128i texels)
+{
+	const __m128i green_alpha = _mm_set1_epi32((int)0xFF00FF00);
+	__m128i red_blue = _mm_andnot_si128(green_alpha, texels);
+	return _mm_or_si128(_mm_and_si128(texels, green_alpha),
+		_mm_or_si128(_mm_slli_epi32(red_blue, 16), _mm_srli_epi32(red_blue, 16)));
+}
+
+static inline __m128i Premultiply(__m128i texels)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i half = _mm_set1_epi16(128);
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+	__m128i lo = _mm_unpacklo_epi8(texels, zero);
+	__m128i hi = _mm_unpackhi_epi8(texels, zero);
+	__m128i alpha_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	__m128i alpha_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	// MultiplyUnorm on 16-bit lanes, c * a + 128 still fits
+	lo = _mm_add_epi16(_mm_mullo_epi16(lo, alpha_lo), half);
+	hi = _mm_add_epi16(_mm_mullo_epi16(hi, alpha_hi), half);
+	lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+	hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+	// alpha itself stays as it was
+	return _mm_or_si128(_mm_andnot_si128(alpha_mask, _mm_packus_epi16(lo, hi)), _mm_and_si128(texels, alpha_mask));
+}
+
+static inline bool IsOpaque(__m128i texels)
+{
+	__m128i alpha = _mm_or_si128(texels, _mm_set1_epi32(0x00FFFFFF));
+	return _mm_movemask_epi8(_mm_cmpeq_epi32(alpha, _mm_set1_epi32(-1))) == 0xFFFF;
+}
+#endif
+
+static void ConvertRow(const unsigned char* src, unsigned char* dst, int width, int channels,
+	UploadOrder order, UploadAlpha alpha, bool simd)
+{
+	int x = 0;
+	if (simd && channels == 3)
+	{
+		// RGB has no alpha to premultiply with, only the expansion and byte order matter. SSE2
+		// has no byte shuffle, so these pixels go through ConvertPixels without AVX2
+#if defined(UPLOAD_CONVERTER_AVX2)
+		if (CpuFeatures::HasAvx2())
+			x = UploadConverterAvx2::ExpandRgb(src, dst, width, order);
+#endif
+	}
+	else if (simd && channels == 4)
+	{
+		// translucent texels on the sRGB path need the table lookups, their vectors go through
+		// ConvertPixels. opaque ones are unchanged by premultiplication either way
+#if defined(UPLOAD_CONVERTER_AVX2)
+		while (CpuFeatures::HasAvx2())
+		{
+			x = UploadConverterAvx2::ConvertRgba(src, dst, x, width, order, alpha);
+			if (x + 8 > width)
+				break;
+			ConvertPixels(src + x * 4, dst + x * 4, 8, 4, order, alpha);
+			x += 8;
+		}
+#endif
+#if defined(UPLOAD_CONVERTER_SSE2)
+		for (; x + 4 <= width; x += 4)
+		{
+			__m128i texels = _mm_loadu_si128((const __m128i*)(src + x * 4));
+			if (alpha == kUploadPremultiplied)
+			{
+				texels = Premultiply(texels);
+			}
+			else if (alpha == kUploadPremultipliedSrgb && !IsOpaque(texels))
+			{
+				ConvertPixels(src + x * 4, dst + x * 4, 4, 4, order, alpha);
+				continue;
+			}
+			if (order == kUploadBGRA)
+				texels = SwapRedBlue(texels);
+			_mm_storeu_si128((__m128i*)(dst + x * 4), texels);
+		}
+#endif
+	}
+	ConvertPixels(src + x * channels, dst + x * 4, width - x, channels, order, alpha);
+}
+
+// ---------------------------------------------------------------------------------------------
+
+static void RunRows(ThreadPool* pool, size_t rows, const std::function<void(size_t, size_t)>& body)
+{
+	// a few rows per task keep the scheduling overhead small on small images
+	if (pool && rows > 8)
+		pool->ParallelFor(rows, std::max((size_t)4, rows / (pool->ThreadCount() * 4)), body);
+	else
+		body(0, rows);
+}
+
+static void ConvertImage(const unsigned char* source, int width, int height, int channels, unsigned char* destination,
+	UploadOrder order, UploadAlpha alpha, bool flip_vertically, ThreadPool* pool, bool simd)
+{
+	RunRows(pool, height, [=](size_t begin, size_t end)
+	{
+		for (size_t y = begin; y < end; y++)
+		{
+			size_t out_y = flip_vertically ? height - 1 - y : y;
+			ConvertRow(source + y * width * channels, destination + out_y * width * 4, width, channels, order, alpha, simd);
+		}
+	});
+}
+
+void UploadConverter::Convert(const unsigned char* source, int width, int height, int channels, unsigned char* destination,
+	UploadOrder order, UploadAlpha alpha, bool flip_vertically, ThreadPool* pool)
+{
+	ConvertImage(source, width, height, channels, destination, order, alpha, flip_vertically, pool, true);
+}
+
+void UploadConverter::ConvertReference(const unsigned char* source, int width, int height, int channels,
+	unsigned char* destination, UploadOrder order, UploadAlpha alpha, bool flip_vertically)
+{
+	ConvertImage(source, width, height, channels, destination, order, alpha, flip_vertically, NULL, false);
+}
+
+void UploadConverter::ConvertInPlace(unsigned char* rgba, int width, int height, UploadOrder order, UploadAlpha alpha,
+	bool flip_vertically, ThreadPool* pool)
+{
+	if (!flip_vertically)
+	{
+		if (order == kUploadRGBA && alpha == kUploadStraightAlpha)
+			return;
+		RunRows(pool, height, [=](size_t begin, size_t end)
+		{
+			for (size_t y = begin; y < end; y++)
+				ConvertRow(rgba + y * width * 4, rgba + y * width * 4, width, 4, order, alpha, true);
+		});
+		return;
+	}
+
+	// row pairs from the outside in: a chunk of the top row is converted onto the stack, the
+	// bottom row's chunk into its place, and the stack copy goes to the bottom row
+	RunRows(pool, ((size_t)height + 1) / 2, [=](size_t begin, size_t end)
+	{
+		unsigned char chunk[kChunkPixels * 4];
+		for (size_t y = begin; y < end; y++)
+		{
+			unsigned char* top = rgba + y * width * 4;
+			unsigned char* bottom = rgba + (height - 1 - y) * width * 4;
+			if (top == bottom)
+			{
+				ConvertRow(top, top, width, 4, order, alpha, true);
+				continue;
+			}
+			for (int x = 0; x < width; x += kChunkPixels)
+			{
+				int count = std::min(kChunkPixels, width - x);
+				ConvertRow(top + x * 4, chunk, count, 4, order, alpha, true);
+				ConvertRow(bottom + x * 4, top + x * 4, count, 4, order, alpha, true);
+				std::memcpy(bottom + x * 4, chunk, (size_t)count * 4);
+			}
+		}
+	});
+}
+
+const char* UploadConverter::SimdName()
+{
+#if defined(UPLOAD_CONVERTER_AVX2)
+	if (CpuFeatures::HasAvx2())
+		return "AVX2";
+#endif
+#if defined(UPLOAD_CONVERTER_SSE2)
+	return "SSE2";
+#else
+	return "scalar";
+#endif
+}
\ No newline at end of file
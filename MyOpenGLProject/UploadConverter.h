@@ -0,0 +1,42 @@
+#ifndef UPLOAD_CONVERTER_H
+#define UPLOAD_CONVERTER_H
+
+#include "ThreadPool.h"
+
+// byte order of the 4-byte texels handed to glTexImage2D
+enum UploadOrder
+{
+	kUploadRGBA,
+	kUploadBGRA  // GL_BGRA, what most drivers store internally and copy without a swizzle
+};
+
+enum UploadAlpha
+{
+	kUploadStraightAlpha,
+	kUploadPremultiplied,     // color * alpha on the stored values
+	kUploadPremultipliedSrgb  // color * alpha in linear space, for sRGB encoded color
+};
+
+// Prepares decoded pixels for upload in one pass over the image: gray, gray + alpha, RGB or
+// RGBA rows are expanded to 4-byte RGBA or BGRA texels, premultiplied and flipped bottom row
+// first as they are written, instead of stb_image flipping row by row and the driver expanding
+// 3-byte pixels on its side. RGB expansion uses AVX2/SSSE3 byte shuffles on CPUs with AVX2,
+// RGBA swizzling and premultiplication SSE2/AVX2; ConvertReference is the plain C++ version they are checked against.
+// Every path computes the same integer results.
+class UploadConverter
+{
+public:
+	// width x height pixels of channels (1-4) bytes, rows tightly packed, into 4-byte texels at
+	// destination (which must not overlap the source). rows are split across the pool if one is given
+	static void Convert(const unsigned char* source, int width, int height, int channels, unsigned char* destination,
+		UploadOrder order, UploadAlpha alpha, bool flip_vertically, ThreadPool* pool = NULL);
+	static void ConvertReference(const unsigned char* source, int width, int height, int channels,
+		unsigned char* destination, UploadOrder order, UploadAlpha alpha, bool flip_vertically);
+	// same for an RGBA image converted where it is; flipping swaps row pairs as it converts them
+	static void ConvertInPlace(unsigned char* rgba, int width, int height, UploadOrder order, UploadAlpha alpha,
+		bool flip_vertically, ThreadPool* pool = NULL);
+	// name of the instruction set the kernels run with on this CPU
+	static const char* SimdName();
+};
+
+#endif // !UPLOAD_CONVERTER_H
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "UploadConverterAvx2.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+// byte shuffles of four packed RGB pixels into RGBA or BGRA texels, -1 leaves the alpha byte zero
+static const signed char kExpandShuffles[2][16] = {
+	{ 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1 },
+	{ 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1 }
+};
+static const signed char kSwapShuffle[16] = { 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 };
+
+static inline __m256i SwapRedBlue(__m256i texels)
+{
+	return _mm256_shuffle_epi8(texels, _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)kSwapShuffle)));
+}
+
+// MultiplyUnorm of UploadConverter.cpp on 16-bit lanes, c * a + 128 still fits
+static inline __m256i Premultiply(__m256i texels)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i half = _mm256_set1_epi16(128);
+	const __m256i alpha_mask = _mm256_set1_epi32((int)0xFF000000);
+	// unpacks and packs both work per 128-bit lane, so the texels come back in order
+	__m256i lo = _mm256_unpacklo_epi8(texels, zero);
+	__m256i hi = _mm256_unpackhi_epi8(texels, zero);
+	__m256i alpha_lo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	__m256i alpha_hi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+	lo = _mm256_add_epi16(_mm256_mullo_epi16(lo, alpha_lo), half);
+	hi = _mm256_add_epi16(_mm256_mullo_epi16(hi, alpha_hi), half);
+	lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+	hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+	// alpha itself stays as it was
+	return _mm256_or_si256(_mm256_andnot_si256(alpha_mask, _mm256_packus_epi16(lo, hi)),
+		_mm256_and_si256(texels, alpha_mask));
+}
+
+static inline bool IsOpaque(__m256i texels)
+{
+	__m256i alpha = _mm256_or_si256(texels, _mm256_set1_epi32(0x00FFFFFF));
+	return _mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, _mm256_set1_epi32(-1))) == -1;
+}
+
+int UploadConverterAvx2::ExpandRgb(const unsigned char* src, unsigned char* dst, int width, UploadOrder order)
+{
+	int x = 0;
+	{
+		// spread 24 bytes over the two lanes, 4 pixels each. the 32-byte load reads 8 bytes
+		// past them, so the loop stops while 11 pixels are left
+		const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 0, 3, 4, 5, 0);
+		const __m256i shuffle = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)kExpandShuffles[order]));
+		const __m256i opaque = _mm256_set1_epi32((int)0xFF000000);
+		for (; x + 11 <= width; x += 8)
+		{
+			__m256i rgb = _mm256_loadu_si256((const __m256i*)(src + x * 3));
+			__m256i texels = _mm256_shuffle_epi8(_mm256_permutevar8x32_epi32(rgb, lanes), shuffle);
+			_mm256_storeu_si256((__m256i*)(dst + x * 4), _mm256_or_si256(texels, opaque));
+		}
+	}
+	{
+		// 16 pixels from three loads, realigned so each register starts at a pixel
+		const __m128i shuffle = _mm_loadu_si128((const __m128i*)kExpandShuffles[order]);
+		const __m128i opaque = _mm_set1_epi32((int)0xFF000000);
+		for (; x + 16 <= width; x += 16)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i*)(src + x * 3));
+			__m128i b = _mm_loadu_si128((const __m128i*)(src + x * 3 + 16));
+			__m128i c = _mm_loadu_si128((const __m128i*)(src + x * 3 + 32));
+			__m128i* out = (__m128i*)(dst + x * 4);
+			_mm_storeu_si128(out, _mm_or_si128(_mm_shuffle_epi8(a, shuffle), opaque));
+			_mm_storeu_si128(out + 1, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), shuffle), opaque));
+			_mm_storeu_si128(out + 2, _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), shuffle), opaque));
+			_mm_storeu_si128(out + 3, _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(c, 4), shuffle), opaque));
+		}
+	}
+	return x;
+}
+
+int UploadConverterAvx2::ConvertRgba(const unsigned char* src, unsigned char* dst, int x, int width, UploadOrder order,
+	UploadAlpha alpha)
+{
+	for (; x + 8 <= width; x += 8)
+	{
+		__m256i texels = _mm256_loadu_si256((const __m256i*)(src + x * 4));
+		if (alpha == kUploadPremultiplied)
+			texels = Premultiply(texels);
+		else if (alpha == kUploadPremultipliedSrgb && !IsOpaque(texels))
+			break;
+		if (order == kUploadBGRA)
+			texels = SwapRedBlue(texels);
+		_mm256_storeu_si256((__m256i*)(dst + x * 4), texels);
+	}
+	return x;
+}
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#error UploadConverterAvx2.cpp must be compiled with /arch:AVX2
+#endif
\ No newline at end of file
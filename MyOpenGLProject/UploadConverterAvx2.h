@@ -0,0 +1,20 @@
+#ifndef UPLOAD_CONVERTER_AVX2_H
+#define UPLOAD_CONVERTER_AVX2_H
+
+#include "UploadConverter.h"
+
+// UploadConverter's AVX2 kernels, with the SSSE3 byte shuffles that come with it. Only called
+// when CpuFeatures::HasAvx2() is true, see CpuFeatures.h. Both work through a prefix of the
+// row and return where they stopped; UploadConverter.cpp converts the rest
+class UploadConverterAvx2
+{
+public:
+	// expand packed RGB pixels to opaque texels in the given byte order
+	static int ExpandRgb(const unsigned char* src, unsigned char* dst, int width, UploadOrder order);
+	// swizzle and premultiply RGBA texels from x on. on the sRGB path it also stops at the first
+	// group of 8 with translucent texels, those need UploadConverter.cpp's table lookups
+	static int ConvertRgba(const unsigned char* src, unsigned char* dst, int x, int width, UploadOrder order,
+		UploadAlpha alpha);
+};
+
+#endif // !UPLOAD_CONVERTER_AVX2_H
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "Tools.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+#include "ImageDecoder.h"
+#include "JpegDecoder.h"
+#include "ThreadPool.h"
+#include "stb_image.h"
+
+int VerifyImageDecoder(const std::vector<const char*>& image_paths)
+{
+	const int kRuns = 5;
+	ThreadPool pool;
+	int failures = 0;
+	std::cout << "Image decoder, " << JpegDecoder::SimdName() << " kernels, " << pool.ThreadCount() << " threads" << std::endl;
+	for (size_t p = 0; p < image_paths.size(); p++)
+	{
+		std::ifstream file(image_paths[p], std::ios::binary);
+		std::vector<unsigned char> contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		if (contents.empty())
+		{
+			std::cout << "Failed to read " << image_paths[p] << std::endl;
+			failures++;
+			continue;
+		}
+		JpegDecoder jpeg;
+		bool parallel = jpeg.ReadHeader(contents.data(), contents.size());
+
+		// every channel count stbi_load supports here, both orientations
+		size_t mismatches = 0;
+		const int kChannels[4] = { 0, 1, 3, 4 };
+		for (int c = 0; c < 4; c++)
+		{
+			for (int flip = 0; flip <= 1; flip++)
+			{
+				int width = 0, height = 0, channels = 0, reference_width = 0, reference_height = 0, reference_channels = 0;
+				unsigned char* pixels = ImageDecoder::Load(contents.data(), contents.size(), width, height, channels,
+					kChannels[c], flip != 0, &pool);
+				stbi_set_flip_vertically_on_load_thread(flip);
+				unsigned char* reference = stbi_load_from_memory(contents.data(), (int)contents.size(),
+					&reference_width, &reference_height, &reference_channels, kChannels[c]);
+				// a file stb_image can't load must fail with the parallel decoder too
+				bool same = !pixels && !reference;
+				if (pixels && reference && width == reference_width && height == reference_height && channels == reference_channels)
+				{
+					size_t size = (size_t)width * height * (kChannels[c] ? kChannels[c] : channels);
+					same = std::equal(pixels, pixels + size, reference);
+				}
+				mismatches += same ? 0 : 1;
+				stbi_image_free(pixels);
+				stbi_image_free(reference);
+			}
+		}
+
+		// RGBA as the texture loader asks for it, best of a few runs
+		double decoder_ms = 1e9, stb_ms = 1e9;
+		int width = 0, height = 0, channels = 0;
+		for (int run = 0; run < kRuns; run++)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			stbi_image_free(ImageDecoder::Load(contents.data(), contents.size(), width, height, channels, 4, true, &pool));
+			std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+			stbi_set_flip_vertically_on_load_thread(1);
+			stbi_image_free(stbi_load_from_memory(contents.data(), (int)contents.size(), &width, &height, &channels, 4));
+			std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+			decoder_ms = std::min(decoder_ms, std::chrono::duration<double, std::milli>(middle - start).count());
+			stb_ms = std::min(stb_ms, std::chrono::duration<double, std::milli>(end - middle).count());
+		}
+		std::cout << "  " << image_paths[p] << " " << width << "x" << height << ", ";
+		if (parallel)
+			std::cout << "parallel JPEG, " << jpeg.IntervalCount() << " restart intervals";
+		else
+			std::cout << "stb_image fallback";
+		std::cout << ": " << decoder_ms << " ms (stb_image " << stb_ms << " ms), " << (mismatches == 0 ? "OK" : "MISMATCH") << std::endl;
+		failures += mismatches == 0 ? 0 : 1;
+	}
+	return failures == 0 ? 0 : -1;
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "Tools.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "MeshletBuilder.h"
+#include "MeshOptimizer.h"
+#include "Scenes.h"
+
+int VerifyMeshlets(int segments)
+{
+	const float kOrigin[3] = { 0.0f, 0.0f, 0.0f };
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+	BuildSphere(segments, 1.0f, kOrigin, vertices, indices);
+	size_t vertex_count = vertices.size() / 8;
+	size_t triangle_count = indices.size() / 3;
+	MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), vertex_count);
+	std::vector<Meshlet> meshlets;
+	std::vector<unsigned int> original_indices = indices;
+	MeshletBuilder::Build(indices.data(), indices.size(), vertices.data(), 8, vertex_count, meshlets);
+	std::cout << "Meshlets, sphere of " << triangle_count << " triangles: " << meshlets.size() << " meshlets" << std::endl;
+
+	// unit normal of a triangle and how far a point is in front of it
+	auto normal_of = [&](size_t t, float* normal)
+	{
+		const float* a = &vertices[indices[t * 3] * 8];
+		const float* b = &vertices[indices[t * 3 + 1] * 8];
+		const float* c = &vertices[indices[t * 3 + 2] * 8];
+		float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+		normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+		normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+		float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		for (int k = 0; k < 3; k++)
+			normal[k] /= length;
+	};
+	auto is_backfacing = [&](size_t t, const float* camera)
+	{
+		float normal[3];
+		normal_of(t, normal);
+		const float* a = &vertices[indices[t * 3] * 8];
+		return normal[0] * (a[0] - camera[0]) + normal[1] * (a[1] - camera[1]) + normal[2] * (a[2] - camera[2]) >= -1e-4f;
+	};
+
+	// the meshlets cover the triangles in order, stay within the limits and bound their vertices
+	int failures = 0;
+	size_t next_index = 0;
+	for (size_t m = 0; m < meshlets.size(); m++)
+	{
+		const Meshlet& meshlet = meshlets[m];
+		std::vector<unsigned int> used(indices.begin() + meshlet.first_index, indices.begin() + meshlet.first_index + meshlet.triangle_count * 3);
+		std::sort(used.begin(), used.end());
+		size_t distinct = std::unique(used.begin(), used.end()) - used.begin();
+		bool valid = meshlet.first_index == next_index && meshlet.triangle_count <= MeshletBuilder::kMaxTriangles
+			&& distinct == meshlet.vertex_count && distinct <= MeshletBuilder::kMaxVertices;
+		for (size_t i = 0; i < distinct; i++)
+		{
+			const float* position = &vertices[used[i] * 8];
+			float offset[3] = { position[0] - meshlet.center[0], position[1] - meshlet.center[1], position[2] - meshlet.center[2] };
+			valid = valid && std::sqrt(offset[0] * offset[0] + offset[1] * offset[1] + offset[2] * offset[2]) <= meshlet.radius + 1e-5f;
+		}
+		// every triangle has to face outwards, or the sphere itself is wrong
+		for (size_t t = meshlet.first_index / 3; t < meshlet.first_index / 3 + meshlet.triangle_count; t++)
+		{
+			float normal[3];
+			normal_of(t, normal);
+			const float* a = &vertices[indices[t * 3] * 8];
+			valid = valid && normal[0] * a[0] + normal[1] * a[1] + normal[2] * a[2] > 0.0f;
+		}
+		next_index = meshlet.first_index + meshlet.triangle_count * 3;
+		failures += valid ? 0 : 1;
+	}
+	// reordering must keep every triangle, with its winding
+	std::vector<std::vector<unsigned int> > before, after;
+	for (size_t t = 0; t < triangle_count; t++)
+	{
+		before.push_back(std::vector<unsigned int>(original_indices.begin() + t * 3, original_indices.begin() + t * 3 + 3));
+		after.push_back(std::vector<unsigned int>(indices.begin() + t * 3, indices.begin() + t * 3 + 3));
+	}
+	std::sort(before.begin(), before.end());
+	std::sort(after.begin(), after.end());
+	if (next_index != indices.size() || before != after)
+		failures++;
+	std::cout << "  structure: " << (failures == 0 ? "OK" : "INVALID") << std::endl;
+
+	// every culled triangle must really be backfacing or outside, and from far away at least a
+	// third of the backfacing triangles have to go. meshlets near the silhouette always stay,
+	// so this is only checked once the sphere has enough meshlets to have an inside
+	struct CullCase
+	{
+		const char* name;
+		float camera[3];
+		float box_min_x;
+		float min_culled_fraction;
+	};
+	const CullCase kCases[] = {
+		{ "far front    ", { 0.0f, 0.0f, -1000.0f }, -2.0f, 1.0f / 3.0f },
+		{ "far side     ", { 1000.0f, 0.0f, 0.0f }, -2.0f, 1.0f / 3.0f },
+		{ "near         ", { 0.0f, 0.0f, -3.0f }, -2.0f, 0.0f },
+		{ "near, clipped", { 0.3f, 0.2f, -2.0f }, 0.25f, 0.0f },
+		{ "inside       ", { 0.0f, 0.0f, 0.0f }, -2.0f, 0.0f }
+	};
+	for (size_t c = 0; c < sizeof(kCases) / sizeof(kCases[0]); c++)
+	{
+		const CullCase& test = kCases[c];
+		// a box around the sphere, optionally cutting off everything left of box_min_x
+		const float planes[6][4] = {
+			{ 1.0f, 0.0f, 0.0f, -test.box_min_x }, { -1.0f, 0.0f, 0.0f, 2.0f },
+			{ 0.0f, 1.0f, 0.0f, 2.0f }, { 0.0f, -1.0f, 0.0f, 2.0f },
+			{ 0.0f, 0.0f, 1.0f, 2.0f }, { 0.0f, 0.0f, -1.0f, 2.0f }
+		};
+		std::vector<DrawElementsIndirectCommand> commands;
+		MeshletCullStats stats = MeshletBuilder::Cull(meshlets, test.camera, planes, 0, 0, commands);
+
+		size_t backfacing = 0, wrongly_culled = 0;
+		for (size_t t = 0; t < triangle_count; t++)
+			backfacing += is_backfacing(t, test.camera) ? 1 : 0;
+		for (size_t m = 0; m < meshlets.size(); m++)
+		{
+			const Meshlet& meshlet = meshlets[m];
+			bool outside = MeshletBuilder::IsOutsideFrustum(meshlet, planes);
+			bool culled = outside || MeshletBuilder::IsBackfacing(meshlet, test.camera);
+			for (size_t t = meshlet.first_index / 3; culled && t < meshlet.first_index / 3 + meshlet.triangle_count; t++)
+			{
+				bool triangle_outside = true;
+				for (int k = 0; k < 3; k++)
+					triangle_outside = triangle_outside && vertices[indices[t * 3 + k] * 8] < test.box_min_x;
+				wrongly_culled += (outside ? triangle_outside : is_backfacing(t, test.camera)) ? 0 : 1;
+			}
+		}
+		bool counts_match = stats.visible_triangles + stats.backfacing_triangles + stats.outside_triangles == triangle_count
+			&& commands.size() == stats.visible_meshlets;
+		bool enough = meshlets.size() < 16 || stats.backfacing_triangles >= test.min_culled_fraction * backfacing;
+		bool passed = wrongly_culled == 0 && counts_match && enough;
+		std::cout << "  " << test.name << ": " << stats.visible_triangles << " visible, " << stats.backfacing_triangles
+			<< " culled as backfacing (of " << backfacing << "), " << stats.outside_triangles << " outside, "
+			<< (passed ? "OK" : "FAILED") << std::endl;
+		failures += passed ? 0 : 1;
+	}
+	return failures == 0 ? 0 : -1;
+}
\ No newline at end of file
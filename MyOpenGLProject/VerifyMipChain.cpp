@@ -0,0 +1,53 @@
+#include "Tools.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "MipChain.h"
+#include "ThreadPool.h"
+#include "stb_image.h"
+
+int VerifyMipChain(const char* image_path)
+{
+	int width, height, channels;
+	unsigned char* pixels = stbi_load(image_path, &width, &height, &channels, 4);
+	if (!pixels)
+	{
+		std::cout << "Failed to load texture " << image_path << std::endl;
+		return -1;
+	}
+
+	ThreadPool pool;
+	int failures = 0;
+	std::cout << "Mip chain " << width << "x" << height << ", " << MipChain::SimdName()
+		<< " kernels, " << pool.ThreadCount() << " threads" << std::endl;
+	for (int filter = kMipFilterBox; filter <= kMipFilterKaiser; filter++)
+	{
+		for (int srgb = 0; srgb <= 1; srgb++)
+		{
+			std::vector<MipLevel> fast, reference;
+			// no GLFW timer here, this mode runs without initializing GLFW
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			MipChain::Build(pixels, width, height, (MipFilter)filter, srgb != 0, fast, &pool);
+			std::chrono::steady_clock::time_point middle = std::chrono::steady_clock::now();
+			MipChain::BuildReference(pixels, width, height, (MipFilter)filter, srgb != 0, reference);
+			std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+			double fast_ms = std::chrono::duration<double, std::milli>(middle - start).count();
+			double reference_ms = std::chrono::duration<double, std::milli>(end - middle).count();
+
+			// every kernel performs the same operations in the same order, results must match exactly
+			size_t mismatches = fast.size() == reference.size() ? 0 : 1;
+			for (size_t l = 0; mismatches == 0 && l < fast.size(); l++)
+			{
+				for (size_t i = 0; i < fast[l].pixels.size(); i++)
+					mismatches += fast[l].pixels[i] != reference[l].pixels[i] ? 1 : 0;
+			}
+			std::cout << (filter == kMipFilterBox ? "  box   " : "  kaiser") << (srgb ? " srgb  " : " linear")
+				<< ": " << fast_ms << " ms (reference " << reference_ms << " ms), "
+				<< (mismatches == 0 ? "OK" : "MISMATCH") << std::endl;
+			failures += mismatches == 0 ? 0 : 1;
+		}
+	}
+	stbi_image_free(pixels);
+	return failures == 0 ? 0 : -1;
+}
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "VertexFormat.h"
+
+#include <cmath>
+#include <cstring>
+
+// bytes one component takes, 0 for the packed 32-bit types
+static size_t ComponentSize(VertexType type)
+{
+	switch (type)
+	{
+	case kVertexFloat:
+		return 4;
+	case kVertexHalf:
+	case kVertexUnorm16:
+		return 2;
+	case kVertexUnorm8:
+	case kVertexSnorm8:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static size_t AttributeSize(const VertexAttribute& attribute)
+{
+	size_t component_size = ComponentSize(attribute.type);
+	return component_size ? component_size * attribute.components : 4;
+}
+
+static float Clamp(float value, float low, float high)
+{
+	return value < low ? low : (value > high ? high : value);
+}
+
+VertexFormat::VertexFormat()
+	: stride_(0), source_floats_(0)
+{
+}
+
+VertexFormat& VertexFormat::Add(int location, int components, VertexType type)
+{
+	VertexAttribute attribute;
+	attribute.location = location;
+	attribute.components = components;
+	attribute.type = type;
+	attribute.offset = stride_;
+	attributes_.push_back(attribute);
+	stride_ = (stride_ + AttributeSize(attribute) + 3) & ~(size_t)3;
+	source_floats_ += components;
+	return *this;
+}
+
+void VertexFormat::Apply(size_t base_offset) const
+{
+	for (size_t a = 0; a < attributes_.size(); a++)
+	{
+		const VertexAttribute& attribute = attributes_[a];
+		void* offset = (void*)(base_offset + attribute.offset);
+		switch (attribute.type)
+		{
+		case kVertexFloat:
+			glVertexAttribPointer(attribute.location, attribute.components, GL_FLOAT, GL_FALSE, (GLsizei)stride_, offset);
+			break;
+		case kVertexHalf:
+			glVertexAttribPointer(attribute.location, attribute.components, GL_HALF_FLOAT, GL_FALSE, (GLsizei)stride_, offset);
+			break;
+		case kVertexUnorm8:
+			glVertexAttribPointer(attribute.location, attribute.components, GL_UNSIGNED_BYTE, GL_TRUE, (GLsizei)stride_, offset);
+			break;
+		case kVertexSnorm8:
+			glVertexAttribPointer(attribute.location, attribute.components, GL_BYTE, GL_TRUE, (GLsizei)stride_, offset);
+			break;
+		case kVertexUnorm16:
+			glVertexAttribPointer(attribute.location, attribute.components, GL_UNSIGNED_SHORT, GL_TRUE, (GLsizei)stride_, offset);
+			break;
+		case kVertexSnorm10_10_10_2:
+			// the packed type always has 4 components
+			glVertexAttribPointer(attribute.location, 4, GL_INT_2_10_10_10_REV, GL_TRUE, (GLsizei)stride_, offset);
+			break;
+		}
+		glEnableVertexAttribArray(attribute.location);
+	}
+}
+
+std::vector<unsigned char> VertexFormat::Pack(const float* source, size_t vertex_count) const
+{
+	std::vector<unsigned char> packed(vertex_count * stride_, 0);
+	for (size_t v = 0; v < vertex_count; v++)
+	{
+		const float* in = source + v * source_floats_;
+		unsigned char* vertex = &packed[v * stride_];
+		for (size_t a = 0; a < attributes_.size(); a++)
+		{
+			const VertexAttribute& attribute = attributes_[a];
+			unsigned char* out = vertex + attribute.offset;
+			for (int c = 0; c < attribute.components && attribute.type != kVertexSnorm10_10_10_2; c++)
+			{
+				float value = in[c];
+				switch (attribute.type)
+				{
+				case kVertexFloat:
+					std::memcpy(out + c * 4, &value, 4);
+					break;
+				case kVertexHalf:
+				{
+					unsigned short half = FloatToHalf(value);
+					std::memcpy(out + c * 2, &half, 2);
+					break;
+				}
+				case kVertexUnorm8:
+					out[c] = (unsigned char)std::floor(Clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+					break;
+				case kVertexSnorm8:
+					out[c] = (unsigned char)(signed char)std::floor(Clamp(value, -1.0f, 1.0f) * 127.0f + 0.5f);
+					break;
+				case kVertexUnorm16:
+				{
+					unsigned short unorm = (unsigned short)std::floor(Clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+					std::memcpy(out + c * 2, &unorm, 2);
+					break;
+				}
+				default:
+					break;
+				}
+			}
+			if (attribute.type == kVertexSnorm10_10_10_2)
+			{
+				// x in the lowest bits, two's complement fields
+				static const int kBits[4] = { 10, 10, 10, 2 };
+				unsigned int word = 0, shift = 0;
+				for (int c = 0; c < 4; c++)
+				{
+					int max = (1 << (kBits[c] - 1)) - 1;
+					float value = c < attribute.components ? Clamp(in[c], -1.0f, 1.0f) : 0.0f;
+					int quantized = (int)std::floor(value * max + 0.5f);
+					word |= ((unsigned int)quantized & ((1u << kBits[c]) - 1)) << shift;
+					shift += kBits[c];
+				}
+				std::memcpy(out, &word, 4);
+			}
+			else if (attribute.type == kVertexUnorm8 && attribute.components == 3)
+			{
+				// the padding byte reads as opaque alpha if the attribute is ever widened to 4
+				out[3] = 255;
+			}
+			in += attribute.components;
+		}
+	}
+	return packed;
+}
+
+unsigned short VertexFormat::FloatToHalf(float value)
+{
+	unsigned int bits;
+	std::memcpy(&bits, &value, 4);
+	unsigned int sign = (bits >> 16) & 0x8000;
+	unsigned int magnitude = bits & 0x7FFFFFFF;
+
+	// NaN stays NaN, everything too large becomes infinity
+	if (magnitude > 0x7F800000)
+		return (unsigned short)(sign | 0x7E00);
+	if (magnitude >= 0x477FF000)
+		return (unsigned short)(sign | 0x7C00);
+	// normal half: rebias the exponent and round the mantissa to nearest even
+	if (magnitude >= 0x38800000)
+	{
+		unsigned int rounded = magnitude - 0x38000000 + 0xFFF + ((magnitude >> 13) & 1);
+		return (unsigned short)(sign | (rounded >> 13));
+	}
+	// subnormal half or zero
+	if (magnitude < 0x33000000)
+		return (unsigned short)sign;
+	unsigned int exponent = magnitude >> 23;
+	unsigned int mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+	unsigned int shift = 126 - exponent;
+	unsigned int half = mantissa >> shift;
+	unsigned int remainder = mantissa & ((1u << shift) - 1);
+	unsigned int midpoint = 1u << (shift - 1);
+	if (remainder > midpoint || (remainder == midpoint && (half & 1)))
+		half++;
+	return (unsigned short)(sign | half);
+}
+
+float VertexFormat::HalfToFloat(unsigned short value)
+{
+	unsigned int sign = (unsigned int)(value & 0x8000) << 16;
+	unsigned int exponent = (value >> 10) & 0x1F;
+	unsigned int mantissa = value & 0x3FF;
+	unsigned int bits;
+	if (exponent == 0x1F)
+	{
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	}
+	else if (exponent != 0)
+	{
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+	else
+	{
+		// subnormal: the value is mantissa * 2^-24
+		float result = std::ldexp((float)mantissa, -24);
+		return sign ? -result : result;
+	}
+	float result;
+	std::memcpy(&result, &bits, 4);
+	return result;
+}
\ No newline at end of file
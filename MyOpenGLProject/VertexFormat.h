@@ -0,0 +1,64 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <GL/glew.h> // include glew to get all the required OpenGL headers
+
+#include <vector>
+
+// storage type of one vertex attribute
+enum VertexType
+{
+	kVertexFloat,
+	// 16-bit float, exact for small integers and about 3 decimal digits otherwise
+	kVertexHalf,
+	// [0, 1] in 8 bits per component
+	kVertexUnorm8,
+	// [-1, 1] in 8 bits per component
+	kVertexSnorm8,
+	// [0, 1] in 16 bits per component, texture coordinates outside that range are clamped
+	kVertexUnorm16,
+	// [-1, 1] in 10 bits for x, y, z and 2 bits for w, packed into 32 bits (normals, tangents)
+	kVertexSnorm10_10_10_2
+};
+
+// one attribute of a vertex format
+struct VertexAttribute
+{
+	int location;
+	// number of floats read from the source vertex, missing components of packed types are 0
+	int components;
+	VertexType type;
+	size_t offset;
+};
+
+// Describes an interleaved vertex layout and configures the vertex attributes from it,
+// so no offsets have to be written by hand. Pack converts float vertices (the attributes'
+// components back to back, in declaration order) into the layout.
+class VertexFormat
+{
+public:
+	VertexFormat();
+
+	// append an attribute, offsets are kept 4-byte aligned as GL prefers
+	VertexFormat& Add(int location, int components, VertexType type);
+	size_t Stride() const { return stride_; }
+	// number of floats per source vertex for Pack
+	int SourceFloats() const { return source_floats_; }
+	const std::vector<VertexAttribute>& Attributes() const { return attributes_; }
+
+	// set and enable every attribute of the bound VAO, reading the buffer bound to
+	// GL_ARRAY_BUFFER starting at base_offset bytes
+	void Apply(size_t base_offset = 0) const;
+	// convert vertex_count float vertices into this layout
+	std::vector<unsigned char> Pack(const float* source, size_t vertex_count) const;
+
+	static unsigned short FloatToHalf(float value);
+	static float HalfToFloat(unsigned short value);
+
+private:
+	std::vector<VertexAttribute> attributes_;
+	size_t stride_;
+	int source_floats_;
+};
+
+#endif // !VERTEX_FORMAT_H
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec3 ourColor;
+in vec2 TexCoord;
+flat in float Layer;
+
+uniform sampler2DArray sprites;
+
+void main()
+{
+    FragColor = texture(sprites, vec3(TexCoord, Layer));
+}
\ No newline at end of file
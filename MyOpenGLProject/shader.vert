@@ -3,13 +3,22 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
 layout (location = 2) in vec2 aTexCoord;
+// per-instance data (see InstancedRenderer): xy offset, zw scale, and the texture array layer.
+// non-instanced draws read them from a one-instance identity buffer (see CreateIdentityInstance)
+layout (location = 3) in vec4 aOffsetScale;
+layout (location = 4) in float aLayer;
+
+// camera transform (see Camera), identity for geometry that is already in clip space
+uniform mat4 viewProjection;
 
 out vec3 ourColor;
 out vec2 TexCoord;
+flat out float Layer;
 
 void main()
 {
-	gl_Position = vec4(aPos, 1.0);
+	gl_Position = viewProjection * vec4(aPos.xy * aOffsetScale.zw + aOffsetScale.xy, aPos.z, 1.0);
 	ourColor = aColor;
 	TexCoord = aTexCoord;
+	Layer = aLayer;
 }
\ No newline at end of file